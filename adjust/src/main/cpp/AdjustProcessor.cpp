@@ -3,10 +3,11 @@
 #include <android/log.h>
 #include <vector>
 #include <thread>
-#include <queue>
 #include <condition_variable>
 #include <atomic>
 #include <functional>
+#include <new>
+#include <type_traits>
 #include <cmath>
 #include <algorithm>
 #include <chrono>
@@ -14,10 +15,34 @@
 #include <cstring>
 #include <string>
 #include <cstdint>
+#include <array>
+#include <utility>
+#include <memory>
 
 #include "adjust_common.h"
+#include "adjust_stats.h"
+#include "adjust_analysis.h"
+#include "adjust_local.h"
+#include "adjust_cache.h"
+#include "adjust_lut.h"
+#include "adjust_fixed.h"
+#include "adjust_cost.h"
+#include "adjust_curves.h"
+#include "adjust_denoise.h"
+#include "adjust_arena.h"
+#include "adjust_yuv.h"
+#include "adjust_memory.h"
+#include "adjust_pipeline.h"
+#include "adjust_resample.h"
+#include "adjust_geometry.h"
+#include "adjust_thumbcache.h"
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #define LOG_TAG "TAG5"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
@@ -28,21 +53,27 @@ static inline void DeleteLocalRefSafely(JNIEnv *env, jobject obj) {
 }
 
 // =============================================================
-// 🎨 LUT 3D TABLE SUPPORT
+// 🎨 LUT 3D TABLE SUPPORT (Lut3D + parser .cube / Hald: adjust_lut.h)
 // =============================================================
-struct Lut3D {
-    int32_t size = 0;
-    std::vector<float> data; // size^3 * 3
-    bool valid() const {
-        const size_t need = static_cast<size_t>(size) * static_cast<size_t>(size) * static_cast<size_t>(size) * 3u;
-        return size > 0 && data.size() == need;
+// .lutz: đọc nguyên file (vài chục KB) rồi giải nén thẳng ra layout packed
+static bool loadLutzBytes(std::vector<uint8_t> &bytes, const std::string &path, Lut3D &lut) {
+    std::string err;
+    if (!decodeLutz(bytes.data(), bytes.size(), lut, &err)) {
+        LOGE("Invalid .lutz (%s): %s", err.c_str(), path.c_str());
+        return false;
     }
-};
+    LOGI("✅ LUT loaded from %s (size=%d, %zu bytes)", path.c_str(), lut.size, bytes.size());
+    return true;
+}
 
 static bool loadTableFile(JNIEnv *env, jobject context, const std::string &path, Lut3D &lut) {
+    std::string err;
+
     // 1️⃣ Try open from normal file
-    std::ifstream f(path, std::ios::binary);
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
     if (f.is_open()) {
+        const auto fileBytes = static_cast<uint64_t>(f.tellg());
+        f.seekg(0);
         uint32_t header[2];
         f.read(reinterpret_cast<char *>(header), sizeof(header));
         if (!f) {
@@ -50,7 +81,27 @@ static bool loadTableFile(JNIEnv *env, jobject context, const std::string &path,
             return false;
         }
 
-        lut.size = static_cast<int32_t>(header[0]);
+        if (isLutzHeader(reinterpret_cast<const uint8_t *>(header), sizeof(header))) {
+            if (fileBytes > kLutzMaxFileBytes) {
+                LOGE("Unexpected .lutz size: %s", path.c_str());
+                return false;
+            }
+            std::vector<uint8_t> bytes(static_cast<size_t>(fileBytes));
+            f.seekg(0);
+            f.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            if (!f) {
+                LOGE("Failed to read LUT: %s", path.c_str());
+                return false;
+            }
+            return loadLutzBytes(bytes, path, lut);
+        }
+
+        // Header phải khớp độ dài file trước khi cấp phát
+        lut.size = validateTableHeader(header, fileBytes, &err);
+        if (lut.size == 0) {
+            LOGE("Invalid LUT header (%s): %s", err.c_str(), path.c_str());
+            return false;
+        }
         const size_t count = static_cast<size_t>(lut.size) * lut.size * lut.size * 3u;
         lut.data.resize(count);
         f.read(reinterpret_cast<char *>(lut.data.data()), count * sizeof(float));
@@ -58,6 +109,7 @@ static bool loadTableFile(JNIEnv *env, jobject context, const std::string &path,
 
         if (lut.valid()) {
             LOGI("✅ LUT loaded from file: %s (size=%d)", path.c_str(), lut.size);
+            packLut(lut, true);
             return true;
         }
         LOGE("Invalid LUT content in file: %s", path.c_str());
@@ -81,6 +133,13 @@ static bool loadTableFile(JNIEnv *env, jobject context, const std::string &path,
     }
 
     AAsset *asset = AAssetManager_open(mgr, path.c_str(), AASSET_MODE_STREAMING);
+    // Filter có sẵn giờ nằm trong assets dạng .lutz; lutPath cũ (đã lưu trong preset / lịch sử) vẫn là .table
+    static constexpr char kTableExt[] = ".table";
+    const size_t extLen = sizeof(kTableExt) - 1u;
+    if (!asset && path.size() > extLen && path.compare(path.size() - extLen, extLen, kTableExt) == 0) {
+        const std::string lutzPath = path.substr(0, path.size() - extLen) + ".lutz";
+        asset = AAssetManager_open(mgr, lutzPath.c_str(), AASSET_MODE_STREAMING);
+    }
     if (!asset) {
         LOGE("LUT not found in assets: %s", path.c_str());
         return false;
@@ -93,7 +152,31 @@ static bool loadTableFile(JNIEnv *env, jobject context, const std::string &path,
         return false;
     }
 
-    lut.size = static_cast<int32_t>(header[0]);
+    const auto assetBytes = static_cast<uint64_t>(AAsset_getLength64(asset));
+    if (isLutzHeader(reinterpret_cast<const uint8_t *>(header), sizeof(header))) {
+        if (assetBytes > kLutzMaxFileBytes || assetBytes < sizeof(header)) {
+            LOGE("Unexpected .lutz size in asset: %s", path.c_str());
+            AAsset_close(asset);
+            return false;
+        }
+        std::vector<uint8_t> bytes(static_cast<size_t>(assetBytes));
+        std::memcpy(bytes.data(), header, sizeof(header));
+        const size_t rest = bytes.size() - sizeof(header);
+        const ssize_t got = AAsset_read(asset, bytes.data() + sizeof(header), rest);
+        AAsset_close(asset);
+        if (got != static_cast<ssize_t>(rest)) {
+            LOGE("Failed to read LUT data from asset: %s", path.c_str());
+            return false;
+        }
+        return loadLutzBytes(bytes, path, lut);
+    }
+
+    lut.size = validateTableHeader(header, assetBytes, &err);
+    if (lut.size == 0) {
+        LOGE("Invalid LUT header (%s) in asset: %s", err.c_str(), path.c_str());
+        AAsset_close(asset);
+        return false;
+    }
     const size_t count = static_cast<size_t>(lut.size) * lut.size * lut.size * 3u;
     lut.data.resize(count);
     const ssize_t bytesRead = AAsset_read(asset, lut.data.data(), count * sizeof(float));
@@ -106,12 +189,141 @@ static bool loadTableFile(JNIEnv *env, jobject context, const std::string &path,
 
     if (lut.valid()) {
         LOGI("✅ LUT loaded from assets/%s (size=%d)", path.c_str(), lut.size);
+        packLut(lut, true);
         return true;
     }
     LOGE("Invalid LUT data from asset: %s", path.c_str());
     return false;
 }
 
+// LUT cache theo path: kéo slider khi đang bật filter không đọc lại file + cấp phát bảng mỗi frame.
+// [0] = mới dùng nhất. Giữ qua clearCache() (preview thu nhỏ gọi mỗi frame); import (convert*) xoá toàn bộ.
+static constexpr size_t kLutCacheEntries = 2;
+
+struct CachedLut {
+    std::string path;
+    std::shared_ptr<const Lut3D> lut;
+};
+
+static std::mutex s_lutCacheMutex;
+static CachedLut s_lutCache[kLutCacheEntries];
+
+static std::shared_ptr<const Lut3D> acquireLut(JNIEnv *env, jobject context, const std::string &path) {
+    {
+        std::lock_guard<std::mutex> lock(s_lutCacheMutex);
+        for (size_t i = 0; i < kLutCacheEntries; ++i) {
+            if (s_lutCache[i].lut && s_lutCache[i].path == path) {
+                std::rotate(s_lutCache, s_lutCache + i, s_lutCache + i + 1);
+                return s_lutCache[0].lut;
+            }
+        }
+    }
+    auto lut = std::make_shared<Lut3D>();
+    if (!loadTableFile(env, context, path, *lut)) return nullptr;
+    std::lock_guard<std::mutex> lock(s_lutCacheMutex);
+    std::rotate(s_lutCache, s_lutCache + kLutCacheEntries - 1, s_lutCache + kLutCacheEntries);
+    s_lutCache[0].path = path;
+    s_lutCache[0].lut = lut;
+    return lut;
+}
+
+static void dropCachedLuts() {
+    std::lock_guard<std::mutex> lock(s_lutCacheMutex);
+    for (auto &e : s_lutCache) e = CachedLut{};
+}
+
+// =============================================================
+// 📊 Đăng ký các cache native với MemoryGovernor (budget chung, xem adjust_memory.h)
+// =============================================================
+static size_t lutBytes(const Lut3D &lut) {
+    return lut.data.capacity() * sizeof(float) + lut.packed.capacity() * sizeof(uint16_t);
+}
+
+static size_t lutCacheBytesLocked() {
+    size_t n = 0;
+    for (const auto &e : s_lutCache) {
+        if (e.lut) n += lutBytes(*e.lut);
+    }
+    return n;
+}
+
+// Mask của session thuộc về người dùng -> chỉ báo cáo. Số byte cập nhật sau mỗi lời gọi sửa session
+// (trên luồng gọi JNI), governor không bao giờ duyệt tile của 1 session đang được vẽ.
+static std::mutex s_sessionBytesMutex;
+static std::vector<std::pair<const LocalSession *, size_t>> s_sessionBytes;
+
+static void noteSessionBytes(const LocalSession *session, bool released = false) {
+    {
+        std::lock_guard<std::mutex> lock(s_sessionBytesMutex);
+        auto it = std::find_if(s_sessionBytes.begin(), s_sessionBytes.end(),
+                               [session](const auto &e) { return e.first == session; });
+        if (released) {
+            if (it != s_sessionBytes.end()) s_sessionBytes.erase(it);
+            return;
+        }
+        const size_t bytes = session->bytes();
+        if (it != s_sessionBytes.end()) it->second = bytes;
+        else s_sessionBytes.emplace_back(session, bytes);
+    }
+    memoryGovernor().enforce(); // mask lớn lên -> ép các cache dựng lại được
+}
+
+class ScratchIdleConsumer final : public MemoryConsumer {
+public:
+    size_t bytes() const override { return scratchArena().retainedBytes(); }
+    void trim(size_t keepBytes) override { scratchArena().trim(keepBytes); }
+};
+
+class RenderCacheConsumer final : public MemoryConsumer {
+public:
+    size_t bytes() const override { return renderCache().bytesUsed(); }
+    void trim(size_t keepBytes) override { renderCache().trim(keepBytes); }
+};
+
+class LutCacheConsumer final : public MemoryConsumer {
+public:
+    size_t bytes() const override {
+        std::lock_guard<std::mutex> lock(s_lutCacheMutex);
+        return lutCacheBytesLocked();
+    }
+    // Bỏ từ entry ít dùng nhất; render đang giữ shared_ptr vẫn dùng tiếp được
+    void trim(size_t keepBytes) override {
+        std::lock_guard<std::mutex> lock(s_lutCacheMutex);
+        for (size_t i = kLutCacheEntries; i-- > 0 && lutCacheBytesLocked() > keepBytes;) {
+            s_lutCache[i] = CachedLut{};
+        }
+    }
+};
+
+class LocalSessionConsumer final : public MemoryConsumer {
+public:
+    size_t bytes() const override {
+        std::lock_guard<std::mutex> lock(s_sessionBytesMutex);
+        size_t n = 0;
+        for (const auto &e : s_sessionBytes) n += e.second;
+        return n;
+    }
+    void trim(size_t) override {}
+    bool evictable() const override { return false; }
+};
+
+static void registerMemoryConsumers() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        static ScratchIdleConsumer scratch;
+        static RenderCacheConsumer render;
+        static LutCacheConsumer luts;
+        static LocalSessionConsumer sessions;
+        MemoryGovernor &g = memoryGovernor();
+        g.attach(MEM_SCRATCH_IDLE, &scratch);
+        g.attach(MEM_RENDER_CACHE, &render);
+        g.attach(MEM_LUT_CACHE, &luts);
+        g.attach(MEM_LOCAL_SESSIONS, &sessions);
+    });
+}
+
+// Trilinear trên layout packed (uint16 unorm, 4 kênh / đỉnh): nội suy ở thang 0..65535,
+// nhân kLutUnormScale 1 lần ở cuối.
 static inline void sampleLUT(const Lut3D &lut, float r, float g, float b,
                              float &rr, float &gg, float &bb) {
     const int32_t S = lut.size;
@@ -124,149 +336,349 @@ static inline void sampleLUT(const Lut3D &lut, float r, float g, float b,
     const int32_t r0 = static_cast<int32_t>(floorf(rf));
     const int32_t g0 = static_cast<int32_t>(floorf(gf));
     const int32_t b0 = static_cast<int32_t>(floorf(bf));
-    const int32_t r1 = std::min<int32_t>(r0 + 1, S - 1);
-    const int32_t g1 = std::min<int32_t>(g0 + 1, S - 1);
-    const int32_t b1 = std::min<int32_t>(b0 + 1, S - 1);
 
     const float wr = rf - static_cast<float>(r0);
     const float wg = gf - static_cast<float>(g0);
     const float wb = bf - static_cast<float>(b0);
 
-    auto idx = [&](int32_t ir, int32_t ig, int32_t ib) -> size_t {
-        return (static_cast<size_t>(ir) * static_cast<size_t>(S) + static_cast<size_t>(ig)) * static_cast<size_t>(S) + static_cast<size_t>(ib);
+    // Bước (tính bằng uint16) sang đỉnh kế tiếp theo từng trục; 0 ở biên trên
+    const size_t dr = (r0 < S - 1) ? static_cast<size_t>(S) * static_cast<size_t>(S) * 4u : 0u;
+    const size_t dg = (g0 < S - 1) ? static_cast<size_t>(S) * 4u : 0u;
+    const size_t db = (b0 < S - 1) ? 4u : 0u;
+    const uint16_t *c000 = lut.packed.data()
+                           + ((static_cast<size_t>(r0) * static_cast<size_t>(S) + static_cast<size_t>(g0))
+                              * static_cast<size_t>(S) + static_cast<size_t>(b0)) * 4u;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    // 1 lần vld1 (8 byte) / đỉnh, nội suy cả 3 kênh trong 1 thanh ghi
+    const auto corner = [](const uint16_t *c) { return vcvtq_f32_u32(vmovl_u16(vld1_u16(c))); };
+    const auto lerp = [](float32x4_t x, float32x4_t y, float w) { return vmlaq_n_f32(vmulq_n_f32(x, 1.0f - w), y, w); };
+    const float32x4_t c00 = lerp(corner(c000), corner(c000 + db), wb);
+    const float32x4_t c01 = lerp(corner(c000 + dg), corner(c000 + dg + db), wb);
+    const float32x4_t c10 = lerp(corner(c000 + dr), corner(c000 + dr + db), wb);
+    const float32x4_t c11 = lerp(corner(c000 + dr + dg), corner(c000 + dr + dg + db), wb);
+    const float32x4_t out = vmulq_n_f32(lerp(lerp(c00, c01, wg), lerp(c10, c11, wg), wr), kLutUnormScale);
+    rr = vgetq_lane_f32(out, 0);
+    gg = vgetq_lane_f32(out, 1);
+    bb = vgetq_lane_f32(out, 2);
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const auto corner = [zero](const uint16_t *c) {
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(c)), zero));
     };
-
-    const size_t i000 = idx(r0, g0, b0) * 3u;
-    const size_t i001 = idx(r0, g0, b1) * 3u;
-    const size_t i010 = idx(r0, g1, b0) * 3u;
-    const size_t i011 = idx(r0, g1, b1) * 3u;
-    const size_t i100 = idx(r1, g0, b0) * 3u;
-    const size_t i101 = idx(r1, g0, b1) * 3u;
-    const size_t i110 = idx(r1, g1, b0) * 3u;
-    const size_t i111 = idx(r1, g1, b1) * 3u;
-
-    const float c000r = lut.data[i000 + 0], c000g = lut.data[i000 + 1], c000b = lut.data[i000 + 2];
-    const float c001r = lut.data[i001 + 0], c001g = lut.data[i001 + 1], c001b = lut.data[i001 + 2];
-    const float c010r = lut.data[i010 + 0], c010g = lut.data[i010 + 1], c010b = lut.data[i010 + 2];
-    const float c011r = lut.data[i011 + 0], c011g = lut.data[i011 + 1], c011b = lut.data[i011 + 2];
-    const float c100r = lut.data[i100 + 0], c100g = lut.data[i100 + 1], c100b = lut.data[i100 + 2];
-    const float c101r = lut.data[i101 + 0], c101g = lut.data[i101 + 1], c101b = lut.data[i101 + 2];
-    const float c110r = lut.data[i110 + 0], c110g = lut.data[i110 + 1], c110b = lut.data[i110 + 2];
-    const float c111r = lut.data[i111 + 0], c111g = lut.data[i111 + 1], c111b = lut.data[i111 + 2];
-
-    // along b
-    const float c00r = c000r * (1.0f - wb) + c001r * wb;
-    const float c00g = c000g * (1.0f - wb) + c001g * wb;
-    const float c00b = c000b * (1.0f - wb) + c001b * wb;
-
-    const float c01r = c010r * (1.0f - wb) + c011r * wb;
-    const float c01g = c010g * (1.0f - wb) + c011g * wb;
-    const float c01b = c010b * (1.0f - wb) + c011b * wb;
-
-    const float c10r = c100r * (1.0f - wb) + c101r * wb;
-    const float c10g = c100g * (1.0f - wb) + c101g * wb;
-    const float c10b = c100b * (1.0f - wb) + c101b * wb;
-
-    const float c11r = c110r * (1.0f - wb) + c111r * wb;
-    const float c11g = c110g * (1.0f - wb) + c111g * wb;
-    const float c11b = c110b * (1.0f - wb) + c111b * wb;
-
-    // along g
-    const float c0r = c00r * (1.0f - wg) + c01r * wg;
-    const float c0g = c00g * (1.0f - wg) + c01g * wg;
-    const float c0b = c00b * (1.0f - wg) + c01b * wg;
-
-    const float c1r = c10r * (1.0f - wg) + c11r * wg;
-    const float c1g = c10g * (1.0f - wg) + c11g * wg;
-    const float c1b = c10b * (1.0f - wg) + c11b * wg;
-
-    // along r
-    rr = c0r * (1.0f - wr) + c1r * wr;
-    gg = c0g * (1.0f - wr) + c1g * wr;
-    bb = c0b * (1.0f - wr) + c1b * wr;
+    const auto lerp = [](__m128 x, __m128 y, float w) {
+        return _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(1.0f - w)), _mm_mul_ps(y, _mm_set1_ps(w)));
+    };
+    const __m128 c00 = lerp(corner(c000), corner(c000 + db), wb);
+    const __m128 c01 = lerp(corner(c000 + dg), corner(c000 + dg + db), wb);
+    const __m128 c10 = lerp(corner(c000 + dr), corner(c000 + dr + db), wb);
+    const __m128 c11 = lerp(corner(c000 + dr + dg), corner(c000 + dr + dg + db), wb);
+    float out[4];
+    _mm_storeu_ps(out, _mm_mul_ps(lerp(lerp(c00, c01, wg), lerp(c10, c11, wg), wr), _mm_set1_ps(kLutUnormScale)));
+    rr = out[0];
+    gg = out[1];
+    bb = out[2];
+#else
+    const auto lerp = [](float x, float y, float w) { return x * (1.0f - w) + y * w; };
+    const uint16_t *c001 = c000 + db, *c010 = c000 + dg, *c011 = c010 + db;
+    const uint16_t *c100 = c000 + dr, *c101 = c100 + db, *c110 = c100 + dg, *c111 = c110 + db;
+    float out[3];
+    for (size_t ch = 0; ch < 3; ++ch) {
+        const float c00 = lerp(c000[ch], c001[ch], wb);
+        const float c01 = lerp(c010[ch], c011[ch], wb);
+        const float c10 = lerp(c100[ch], c101[ch], wb);
+        const float c11 = lerp(c110[ch], c111[ch], wb);
+        out[ch] = lerp(lerp(c00, c01, wg), lerp(c10, c11, wg), wr) * kLutUnormScale;
+    }
+    rr = out[0];
+    gg = out[1];
+    bb = out[2];
+#endif
 }
 
 // --- extern modules (must match your project)
 extern void applyLightAdjust(float &r, float &g, float &b, const AdjustParams &p);
+extern void applyCurveAdjust(float &r, float &g, float &b, const AdjustParams &p);
 extern "C" void applyHSLAdjust(float &r, float &g, float &b, const AdjustParams &p);
 extern void applyColorAdjust(float &rf, float &gf, float &bf, const AdjustParams &p);
 extern void applyDetailAdjust(float &rf, float &gf, float &bf, float x, float y, float width, float height, const AdjustParams &p);
 extern "C" void applyVignetteAt(float &rf, float &gf, float &bf, float x, float y, float w, float h, const AdjustParams &p);
-extern "C" void applyGrainAt(float &rf, float &gf, float &bf, const AdjustParams &p);
+extern "C" void applyGrainAt(float &rf, float &gf, float &bf, float x, float y, const AdjustParams &p);
 
 // =============================================================
-// 🧵 ThreadPool
+// 🧵 ThreadPool (ưu tiên: interactive > thumbnail > export)
+// Mỗi lớp có hàng đợi riêng + giới hạn số worker chạy đồng thời (share). Worker rảnh luôn lấy
+// task của lớp cao nhất còn slot -> export đang chạy không chặn preview quá 1 task nhỏ.
+// Mỗi job chờ đúng các task của mình qua TaskGroup (không waitAll toàn pool).
 // =============================================================
+enum TaskPriority : int32_t {
+    PRIORITY_INTERACTIVE = 0,
+    PRIORITY_THUMBNAIL   = 1,
+    PRIORITY_EXPORT      = 2,
+    PRIORITY_COUNT       = 3,
+};
+
+class TaskGroup {
+public:
+    void add() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++pending_;
+    }
+
+    void done() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--pending_ == 0) cv_.notify_all();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+    // true = xong hết. Dùng cho vòng poll progress: thức dậy ngay khi task cuối xong,
+    // không phải chờ hết chu kỳ sleep (quan trọng với preview chỉ vài ms).
+    bool waitFor(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, timeout, [this] { return pending_ == 0; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int64_t pending_ = 0;
+};
+
+// Callable move-only, capture nằm trong buffer cố định của task: enqueue không cấp phát heap
+// (std::function chỉ có ~3 con trỏ inline, lambda của render capture nhiều hơn thế).
+class InlineTask {
+public:
+    static constexpr size_t kCapacity = 160;
+
+    InlineTask() = default;
+    template <typename F, typename Fn = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same<Fn, InlineTask>::value>>
+    explicit InlineTask(F &&fn) {
+        static_assert(sizeof(Fn) <= kCapacity, "capture quá lớn: gom vào struct rồi capture tham chiếu");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t), "capture căn lề quá lớn");
+        new (storage_) Fn(std::forward<F>(fn));
+        invoke_ = [](void *self) { (*static_cast<Fn *>(self))(); };
+        relocate_ = [](void *dst, void *src) {
+            auto *from = static_cast<Fn *>(src);
+            if (dst) new (dst) Fn(std::move(*from));
+            from->~Fn();
+        };
+    }
+    InlineTask(InlineTask &&o) noexcept { *this = std::move(o); }
+    InlineTask &operator=(InlineTask &&o) noexcept {
+        if (this != &o) {
+            reset();
+            if (o.relocate_) {
+                o.relocate_(storage_, o.storage_);
+                invoke_ = o.invoke_;
+                relocate_ = o.relocate_;
+                o.invoke_ = nullptr;
+                o.relocate_ = nullptr;
+            }
+        }
+        return *this;
+    }
+    InlineTask(const InlineTask &) = delete;
+    InlineTask &operator=(const InlineTask &) = delete;
+    ~InlineTask() { reset(); }
+
+    void operator()() { invoke_(storage_); }
+
+private:
+    void reset() {
+        if (relocate_) relocate_(nullptr, storage_);
+        invoke_ = nullptr;
+        relocate_ = nullptr;
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[kCapacity];
+    void (*invoke_)(void *) = nullptr;
+    void (*relocate_)(void *, void *) = nullptr;
+};
+
 class ThreadPool {
 public:
-    explicit ThreadPool(size_t n) { start(n); }
+    explicit ThreadPool(size_t n) : size_(n) {
+        for (size_t &s : share_) s = n;
+        start(n);
+    }
     ~ThreadPool() { stopAll(); }
 
-    void enqueue(std::function<void()> task) {
+    size_t size() const { return size_; }
+
+    // Số worker tối đa được chạy task của lớp `prio` cùng lúc (>= 1)
+    void setShare(TaskPriority prio, size_t maxWorkers) {
         {
             std::lock_guard<std::mutex> lock(mutex_);
-            tasks_.push(std::move(task));
+            share_[prio] = std::clamp<size_t>(maxWorkers, 1, size_);
         }
-        cv_.notify_one();
+        cv_.notify_all();
     }
 
-    void waitAll() {
-        std::unique_lock<std::mutex> lock(waitMutex_);
-        waitCv_.wait(lock, [this] { return active_ == 0 && tasks_.empty(); });
+    template <typename F>
+    void enqueue(F &&task, TaskPriority prio = PRIORITY_INTERACTIVE, TaskGroup *group = nullptr) {
+        if (group) group->add();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queues_[prio].push(Task{InlineTask(std::forward<F>(task)), group});
+        }
+        cv_.notify_one();
     }
 
 private:
+    struct Task {
+        InlineTask fn;
+        TaskGroup *group = nullptr;
+    };
+
+    // Hàng đợi vòng: chỉ cấp phát khi đầy (x2), sau warm-up push/pop không đụng heap (std::queue = deque thì có)
+    class TaskRing {
+    public:
+        bool empty() const { return count_ == 0; }
+        Task &front() { return slots_[head_]; }
+        void push(Task &&t) {
+            if (count_ == slots_.size()) grow();
+            slots_[(head_ + count_) % slots_.size()] = std::move(t);
+            ++count_;
+        }
+        void pop() {
+            slots_[head_] = Task{};
+            head_ = (head_ + 1) % slots_.size();
+            --count_;
+        }
+
+    private:
+        void grow() {
+            std::vector<Task> bigger(std::max<size_t>(16, slots_.size() * 2));
+            for (size_t i = 0; i < count_; ++i) bigger[i] = std::move(slots_[(head_ + i) % slots_.size()]);
+            slots_.swap(bigger);
+            head_ = 0;
+        }
+
+        std::vector<Task> slots_;
+        size_t head_ = 0;
+        size_t count_ = 0;
+    };
+
+    size_t size_ = 0;
     std::vector<std::thread> workers_;
-    std::queue<std::function<void()>> tasks_;
+    TaskRing queues_[PRIORITY_COUNT];
+    size_t running_[PRIORITY_COUNT] = {0, 0, 0};
+    size_t share_[PRIORITY_COUNT] = {0, 0, 0};
     std::mutex mutex_;
     std::condition_variable cv_;
     std::atomic<bool> stop_{false};
-    std::atomic<int32_t> active_{0};
-    std::mutex waitMutex_;
-    std::condition_variable waitCv_;
+
+    // Gọi khi đang giữ mutex_
+    int32_t pickable() const {
+        for (int32_t c = 0; c < PRIORITY_COUNT; ++c) {
+            if (!queues_[c].empty() && running_[c] < share_[c]) return c;
+        }
+        return -1;
+    }
+
+    bool hasQueued() const {
+        for (const auto &q : queues_) if (!q.empty()) return true;
+        return false;
+    }
 
     void start(size_t n) {
         for (size_t i = 0; i < n; ++i) {
             workers_.emplace_back([this] {
                 while (true) {
-                    std::function<void()> task;
+                    Task task;
+                    int32_t cls;
                     {
                         std::unique_lock<std::mutex> lock(mutex_);
-                        cv_.wait(lock, [this] { return stop_.load() || !tasks_.empty(); });
-                        if (stop_.load() && tasks_.empty()) return;
-                        task = std::move(tasks_.front());
-                        tasks_.pop();
-                        active_.fetch_add(1, std::memory_order_relaxed);
+                        // Dừng chỉ khi mọi hàng đợi đã rỗng: job đang chờ TaskGroup luôn được chạy đủ các dải
+                        cv_.wait(lock, [this] { return pickable() >= 0 || (stop_.load() && !hasQueued()); });
+                        cls = pickable();
+                        if (cls < 0) return;
+                        task = std::move(queues_[cls].front());
+                        queues_[cls].pop();
+                        ++running_[cls];
                     }
-                    try { task(); } catch (...) {}
+                    try { task.fn(); } catch (...) {}
+                    if (task.group) task.group->done();
+                    bool more;
                     {
-                        std::lock_guard<std::mutex> lk(waitMutex_);
-                        active_.fetch_sub(1, std::memory_order_relaxed);
-                        if (active_.load(std::memory_order_relaxed) == 0 && tasks_.empty()) {
-                            waitCv_.notify_all();
-                        }
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        --running_[cls];
+                        more = hasQueued();
                     }
+                    // Slot của lớp vừa xong được giải phóng -> đánh thức worker đang chờ lớp đó
+                    if (more) cv_.notify_all();
                 }
             });
         }
     }
 
     void stopAll() {
-        stop_.store(true);
+        {
+            // Đặt cờ dưới mutex_: worker vừa kiểm tra predicate xong không bỏ lỡ notify rồi ngủ mãi
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_.store(true);
+        }
         cv_.notify_all();
         for (auto &t: workers_) if (t.joinable()) t.join();
-        std::lock_guard<std::mutex> lock(mutex_);
-        while (!tasks_.empty()) tasks_.pop();
     }
 };
 
 // =============================================================
 // 🌍 Globals
 // =============================================================
-static ThreadPool *gPool = nullptr;
+// Mỗi entry JNI giữ 1 shared_ptr trong suốt lần gọi: releasePool chỉ bỏ ref toàn cục,
+// pool bị huỷ (drain + join) khi render cuối cùng đang dùng nó trả ref
+static std::shared_ptr<ThreadPool> gPool;
+static std::mutex s_poolMutex;
+static size_t s_thumbnailShare = 0; // 0 = mặc định (n - 1)
+static size_t s_exportShare = 0;    // 0 = mặc định (n / 2)
 static std::atomic<uint64_t> s_lastHash{0ull};
 static std::string s_lastLutPath; // cache LUT path đã apply gần nhất
 
+// Lớp ưu tiên của luồng JNI đang gọi (Kotlin đặt qua AdjustProcessor.withPriority)
+static thread_local TaskPriority t_priority = PRIORITY_INTERACTIVE;
+
+static void applySharesLocked() {
+    const size_t n = gPool->size();
+    gPool->setShare(PRIORITY_INTERACTIVE, n);
+    gPool->setShare(PRIORITY_THUMBNAIL, s_thumbnailShare ? s_thumbnailShare : (n > 1 ? n - 1 : 1));
+    gPool->setShare(PRIORITY_EXPORT, s_exportShare ? s_exportShare : std::max<size_t>(1, n / 2));
+}
+
+static std::shared_ptr<ThreadPool> ensurePool() {
+    registerMemoryConsumers();
+    std::lock_guard<std::mutex> lock(s_poolMutex);
+    if (!gPool) {
+        const unsigned int hw = std::thread::hardware_concurrency();
+        const unsigned int n  = std::max(2u, (hw > 0 ? hw / 2 : 2u));
+        gPool = std::make_shared<ThreadPool>(static_cast<size_t>(n));
+        applySharesLocked();
+    }
+    return gPool;
+}
+
+// Số hàng mỗi task: interactive chia đều theo số thread; lớp thấp hơn chia nhỏ (~kLowPriorityTaskPixels)
+// để worker quay lại hàng đợi thường xuyên và nhường chỗ cho preview.
+static constexpr int32_t kLowPriorityTaskPixels = 128 * 1024;
+
+static int32_t taskBandRows(int32_t rows, int32_t width, TaskPriority prio) {
+    if (rows <= 0) return 1;
+    if (prio == PRIORITY_INTERACTIVE) {
+        const int32_t n = static_cast<int32_t>(std::max(1u, std::thread::hardware_concurrency()));
+        return (rows + n - 1) / n;
+    }
+    return std::clamp(kLowPriorityTaskPixels / std::max(width, 1), 1, rows);
+}
+
+static size_t taskCount(int32_t rows, int32_t band) {
+    return static_cast<size_t>((rows + band - 1) / band);
+}
+
 // =============================================================
 // ⚙️ JNI helpers
 // =============================================================
@@ -287,6 +699,14 @@ static jfloatArray getFloatArray(JNIEnv *env, jobject obj, const char *name) {
     return arr;
 }
 
+static jintArray getIntArray(JNIEnv *env, jobject obj, const char *name) {
+    jclass cls = env->GetObjectClass(obj);
+    jfieldID fid = env->GetFieldID(cls, name, "[I");
+    jintArray arr = fid ? static_cast<jintArray>(env->GetObjectField(obj, fid)) : nullptr;
+    DeleteLocalRefSafely(env, cls);
+    return arr;
+}
+
 static uint64_t getLongField(JNIEnv *env, jobject obj, const char *name) {
     jclass cls = env->GetObjectClass(obj);
     jfieldID fid = env->GetFieldID(cls, name, "J");
@@ -295,6 +715,118 @@ static uint64_t getLongField(JNIEnv *env, jobject obj, const char *name) {
     return v;
 }
 
+static int32_t getIntField(JNIEnv *env, jobject obj, const char *name) {
+    jclass cls = env->GetObjectClass(obj);
+    jfieldID fid = env->GetFieldID(cls, name, "I");
+    const int32_t v = fid ? static_cast<int32_t>(env->GetIntField(obj, fid)) : 0;
+    DeleteLocalRefSafely(env, cls);
+    return v;
+}
+
+static bool getBoolField(JNIEnv *env, jobject obj, const char *name) {
+    jclass cls = env->GetObjectClass(obj);
+    jfieldID fid = env->GetFieldID(cls, name, "Z");
+    const bool v = fid && env->GetBooleanField(obj, fid) == JNI_TRUE;
+    DeleteLocalRefSafely(env, cls);
+    return v;
+}
+
+// Địa chỉ native + dung lượng của field ByteBuffer (chỉ direct buffer; heap buffer -> nullptr)
+static uint8_t *getDirectBufferField(JNIEnv *env, jobject obj, const char *name, int64_t &capacity) {
+    jclass cls = env->GetObjectClass(obj);
+    jfieldID fid = env->GetFieldID(cls, name, "Ljava/nio/ByteBuffer;");
+    jobject buf = fid ? env->GetObjectField(obj, fid) : nullptr;
+    DeleteLocalRefSafely(env, cls);
+    capacity = 0;
+    if (!buf) return nullptr;
+    auto *addr = static_cast<uint8_t *>(env->GetDirectBufferAddress(buf));
+    if (addr) capacity = static_cast<int64_t>(env->GetDirectBufferCapacity(buf));
+    DeleteLocalRefSafely(env, buf);
+    return addr;
+}
+
+static void setIntArrayField(JNIEnv *env, jobject obj, const char *name, const jint *values, jsize len) {
+    jclass cls = env->GetObjectClass(obj);
+    jfieldID fid = env->GetFieldID(cls, name, "[I");
+    jintArray arr = fid ? static_cast<jintArray>(env->GetObjectField(obj, fid)) : nullptr;
+    if (arr && env->GetArrayLength(arr) >= len) env->SetIntArrayRegion(arr, 0, len, values);
+    DeleteLocalRefSafely(env, arr);
+    DeleteLocalRefSafely(env, cls);
+}
+
+static void setFloatField(JNIEnv *env, jobject obj, const char *name, float value) {
+    jclass cls = env->GetObjectClass(obj);
+    jfieldID fid = env->GetFieldID(cls, name, "F");
+    if (fid) env->SetFloatField(obj, fid, value);
+    DeleteLocalRefSafely(env, cls);
+}
+
+static void setFloatArrayField(JNIEnv *env, jobject obj, const char *name, const float *values, jsize len) {
+    jclass cls = env->GetObjectClass(obj);
+    jfieldID fid = env->GetFieldID(cls, name, "[F");
+    jfloatArray arr = fid ? static_cast<jfloatArray>(env->GetObjectField(obj, fid)) : nullptr;
+    if (arr && env->GetArrayLength(arr) >= len) env->SetFloatArrayRegion(arr, 0, len, values);
+    DeleteLocalRefSafely(env, arr);
+    DeleteLocalRefSafely(env, cls);
+}
+
+static void setLongField(JNIEnv *env, jobject obj, const char *name, int64_t value) {
+    jclass cls = env->GetObjectClass(obj);
+    jfieldID fid = env->GetFieldID(cls, name, "J");
+    if (fid) env->SetLongField(obj, fid, static_cast<jlong>(value));
+    DeleteLocalRefSafely(env, cls);
+}
+
+// Stats từng task, nằm trên buffer mượn từ scratchArena() (chỉ khi caller yêu cầu stats)
+static_assert(std::is_trivially_destructible<RenderStats>::value, "TaskStats không gọi destructor");
+static_assert(alignof(RenderStats) <= ScratchArena::kAlignment, "arena căn lề không đủ cho RenderStats");
+
+class TaskStats {
+public:
+    void init(size_t count) {
+        lease_ = scratchArena().borrow(count * sizeof(RenderStats));
+        slots_ = lease_.as<RenderStats>();
+        count_ = slots_ ? count : 0;
+        for (size_t i = 0; i < count_; ++i) new (&slots_[i]) RenderStats();
+    }
+
+    bool empty() const { return count_ == 0; }
+    RenderStats *slot(int32_t t) const { return empty() ? nullptr : &slots_[t]; }
+
+    // Gộp stats của các task (sau group.wait() -> không cần lock) vào slot 0
+    RenderStats &merge() {
+        RenderStats &total = slots_[0];
+        for (size_t i = 1; i < count_; ++i) total.merge(slots_[i]);
+        total.finalizeRange();
+        return total;
+    }
+
+private:
+    ScratchArena::Lease lease_;
+    RenderStats *slots_ = nullptr;
+    size_t count_ = 0;
+};
+
+// Ghi stats đã gộp sang RenderStats.kt
+static void publishStats(JNIEnv *env, jobject statsObj, const RenderStats &total) {
+    static const char *kHistFields[STATS_CHANNELS] = {"histR", "histG", "histB", "histL"};
+    jint buf[256];
+    for (int32_t c = 0; c < STATS_CHANNELS; ++c) {
+        for (int32_t i = 0; i < 256; ++i) buf[i] = static_cast<jint>(total.hist[c][i]);
+        setIntArrayField(env, statsObj, kHistFields[c], buf, 256);
+    }
+    jint mins[STATS_CHANNELS], maxs[STATS_CHANNELS];
+    for (int32_t c = 0; c < STATS_CHANNELS; ++c) {
+        mins[c] = total.minV[c];
+        maxs[c] = total.maxV[c];
+    }
+    setIntArrayField(env, statsObj, "min", mins, STATS_CHANNELS);
+    setIntArrayField(env, statsObj, "max", maxs, STATS_CHANNELS);
+    setLongField(env, statsObj, "clippedShadows", static_cast<int64_t>(total.clippedLow));
+    setLongField(env, statsObj, "clippedHighlights", static_cast<int64_t>(total.clippedHigh));
+    setLongField(env, statsObj, "pixelCount", static_cast<int64_t>(total.pixelCount));
+}
+
 static void loadParamsFromJava(JNIEnv *env, jobject paramsObj, AdjustParams &p) {
     if (!paramsObj) return;
 
@@ -322,6 +854,10 @@ static void loadParamsFromJava(JNIEnv *env, jobject paramsObj, AdjustParams &p)
     p.vignette = getFieldF(env, paramsObj, "vignette");
     p.grain    = getFieldF(env, paramsObj, "grain");
 
+    // Noise reduction
+    p.denoiseLuma   = getFieldF(env, paramsObj, "denoiseLuma");
+    p.denoiseChroma = getFieldF(env, paramsObj, "denoiseChroma");
+
     // HSL arrays
     jfloatArray hueArr = getFloatArray(env, paramsObj, "hslHue");
     jfloatArray satArr = getFloatArray(env, paramsObj, "hslSaturation");
@@ -349,11 +885,93 @@ static void loadParamsFromJava(JNIEnv *env, jobject paramsObj, AdjustParams &p)
     // clamp defensively
     p.lutAmount = clampf(p.lutAmount, 0.f, 1.f);
 
+    // --- Tone curves: FloatArray phẳng [x0, y0, x1, y1, ...] trong [0, 1] ---
+    static const char *kCurveFields[CURVE_COUNT] = {"curveMaster", "curveRed", "curveGreen", "curveBlue"};
+    for (int32_t i = 0; i < CURVE_COUNT; ++i) {
+        ToneCurve &c = p.curves[i];
+        c.count = 0;
+        jfloatArray arr = getFloatArray(env, paramsObj, kCurveFields[i]);
+        if (!arr) continue;
+        const jsize len = std::min<jsize>(env->GetArrayLength(arr), kCurveMaxPoints * 2);
+        float pts[kCurveMaxPoints * 2];
+        env->GetFloatArrayRegion(arr, 0, len, pts);
+        DeleteLocalRefSafely(env, arr);
+        c.count = len / 2;
+        for (int32_t k = 0; k < c.count; ++k) {
+            c.x[k] = pts[2 * k];
+            c.y[k] = pts[2 * k + 1];
+        }
+        normalizeCurve(c);
+    }
+
+    // --- Pipeline graph: IntArray id PipelineStage theo thứ tự áp, rỗng = mặc định ---
+    PipelineOrder order;
+    if (jintArray arr = getIntArray(env, paramsObj, "stageOrder")) {
+        const jsize len = std::min<jsize>(env->GetArrayLength(arr), STAGE_COUNT);
+        jint ids[STAGE_COUNT];
+        env->GetIntArrayRegion(arr, 0, len, ids);
+        DeleteLocalRefSafely(env, arr);
+        for (jsize i = 0; i < len; ++i) {
+            if (ids[i] >= 0 && ids[i] < STAGE_COUNT) order.stages[order.count++] = static_cast<uint8_t>(ids[i]);
+        }
+    }
+    p.order = normalizeOrder(order);
+
+    // --- Geometry: crop FloatArray [l, t, r, b] chuẩn hoá, rỗng = cả ảnh ---
+    GeometryParams &geo = p.geometry;
+    geo.straighten = std::clamp(getFieldF(env, paramsObj, "straighten"), -45.0f, 45.0f);
+    geo.quarterTurns = getIntField(env, paramsObj, "rotate90") & 3;
+    geo.flipH = getBoolField(env, paramsObj, "flipHorizontal");
+    geo.flipV = getBoolField(env, paramsObj, "flipVertical");
+    geo.interp = getIntField(env, paramsObj, "geometryInterpolation");
+    if (jfloatArray arr = getFloatArray(env, paramsObj, "crop")) {
+        if (env->GetArrayLength(arr) == 4) env->GetFloatArrayRegion(arr, 0, 4, geo.crop);
+        DeleteLocalRefSafely(env, arr);
+    }
+
     // Clamp input defensively
     p.vignette = clampf(p.vignette, 0.f, 1.f);
     p.grain    = std::max(0.f, p.grain);
+    p.denoiseLuma   = clampf(p.denoiseLuma, 0.f, 1.f);
+    p.denoiseChroma = clampf(p.denoiseChroma, 0.f, 1.f);
+
+    // Bảng 1D của LIGHT + curves: compile 1 lần ở đây thay vì mỗi pixel
+    prepareToneTables(p);
+}
+
+// Ghi vào `lutPath` (giữ capacity sẵn có -> xem ThreadLutPath)
+static void readLutPath(JNIEnv *env, jobject paramsObj, std::string &lutPath) {
+    lutPath.clear();
+    jclass cls = env->GetObjectClass(paramsObj);
+    jfieldID lutField = cls ? env->GetFieldID(cls, "lutPath", "Ljava/lang/String;") : nullptr;
+    if (lutField) {
+        jstring jstr = static_cast<jstring>(env->GetObjectField(paramsObj, lutField));
+        if (jstr) {
+            const char *cstr = env->GetStringUTFChars(jstr, nullptr);
+            if (cstr) { lutPath.assign(cstr); env->ReleaseStringUTFChars(jstr, cstr); }
+            DeleteLocalRefSafely(env, jstr);
+        }
+    }
+    DeleteLocalRefSafely(env, cls);
 }
 
+// p.lutPath mượn buffer string của luồng JNI trong suốt 1 render: path file (dài hơn SSO)
+// không cấp phát lại mỗi frame khi kéo slider. Khai báo SAU `p` để trả buffer trước khi p huỷ.
+class ThreadLutPath {
+public:
+    explicit ThreadLutPath(std::string &path) : path_(path) { path_.swap(spare()); }
+    ~ThreadLutPath() { path_.swap(spare()); }
+    ThreadLutPath(const ThreadLutPath &) = delete;
+    ThreadLutPath &operator=(const ThreadLutPath &) = delete;
+
+private:
+    static std::string &spare() {
+        static thread_local std::string s;
+        return s;
+    }
+    std::string &path_;
+};
+
 // =============================================================
 // 🧮 Hash (bao gồm LUT nếu có bật MASK_LUT)
 // =============================================================
@@ -382,12 +1000,25 @@ static uint64_t computeAdjustHash(const AdjustParams &p) {
     mix(bitsOfFloat(p.dehaze));
     mix(bitsOfFloat(p.vignette));
     mix(bitsOfFloat(p.grain));
+    mix(bitsOfFloat(p.denoiseLuma));
+    mix(bitsOfFloat(p.denoiseChroma));
     for (int i = 0; i < 8; ++i) {
         mix(bitsOfFloat(p.hslHue[i]));
         mix(bitsOfFloat(p.hslSaturation[i]));
         mix(bitsOfFloat(p.hslLuminance[i]));
     }
     mix(p.activeMask);
+    for (int32_t i = 0; i < p.order.count; ++i) mix(p.order.stages[i]);
+
+    if (p.activeMask & MASK_CURVES) {
+        for (const ToneCurve &c : p.curves) {
+            mix(static_cast<uint64_t>(c.count));
+            for (int32_t i = 0; i < c.count; ++i) {
+                mix(bitsOfFloat(c.x[i]));
+                mix(bitsOfFloat(c.y[i]));
+            }
+        }
+    }
 
     // 🔗 MIX LUT khi có bật MASK_LUT và có đường dẫn
     if ((p.activeMask & MASK_LUT) && !p.lutPath.empty()) {
@@ -421,8 +1052,13 @@ static bool isNoOp(const AdjustParams& p, bool hasLut) {
             if (!nearZero(p.hslHue[i]) || !nearZero(p.hslSaturation[i]) || !nearZero(p.hslLuminance[i]))
                 return false;
 
+    if (p.activeMask & MASK_CURVES)
+        for (const ToneCurve &c : p.curves)
+            if (!curveIsIdentity(c)) return false;
+
     if ((p.activeMask & MASK_VIGNETTE) && !nearZero(p.vignette)) return false;
     if ((p.activeMask & MASK_GRAIN) && !nearZero(p.grain))       return false;
+    if ((p.activeMask & MASK_DENOISE) && (!nearZero(p.denoiseLuma) || !nearZero(p.denoiseChroma))) return false;
 
     // 🔄 LUT chỉ có tác dụng khi amount khác 0
     if ((p.activeMask & MASK_LUT) && hasLut && !nearZero(p.lutAmount)) return false;
@@ -431,205 +1067,816 @@ static bool isNoOp(const AdjustParams& p, bool hasLut) {
 }
 
 // =============================================================
-// 🧮 processRange (adjust stage)
+// 🧮 Per-pixel stages (dùng chung cho full render, region render và streaming)
+// x/y/fullW/fullH luôn là toạ độ trong ảnh GỐC đầy đủ để vignette/grain
+// của 1 vùng crop khớp tuyệt đối với bản render toàn ảnh.
+//
+// kMask: tập stage biết lúc compile -> mọi `if (mask & MASK_*)` bị gập khỏi vòng lặp.
+// kDynamicMask: bản generic đọc mask lúc chạy, dùng cho các tổ hợp ít gặp.
 // =============================================================
-static void processRange(void *basePixels,
-                         int64_t start, int64_t end,
-                         int32_t width, int32_t height,
-                         size_t strideBytes,
-                         const AdjustParams &p,
-                         std::atomic<int64_t> &doneCounter,
-                         bool premultiplied) {
-    auto *base = reinterpret_cast<uint8_t *>(basePixels);
+static constexpr uint64_t kStageBits = MASK_LIGHT | MASK_COLOR | MASK_DETAIL | MASK_VIGNETTE
+                                       | MASK_GRAIN | MASK_HSL | MASK_LUT | MASK_CURVES;
+static constexpr uint64_t kDynamicMask = ~0ull;
+// Thứ tự stage khác mặc định (adjust_pipeline.h): kernel đi theo danh sách ctx.ops
+static constexpr uint64_t kOrderedMask = kDynamicMask - 1u;
+// MASK_DENOISE là stage không gian, chạy riêng trước kernel point-wise (xem denoiseBandInPlace)
+// nên không có trong kStageBits; cost model vẫn tính theo cả bit này.
+static constexpr uint64_t kCostBits = kStageBits | MASK_DENOISE;
+
+template <uint64_t kMask>
+static inline bool stageOn(uint64_t runtimeMask, uint64_t bit) {
+    return (kMask == kDynamicMask) ? (runtimeMask & bit) != 0 : (kMask & bit) != 0;
+}
 
-    for (int64_t idx = start; idx < end; ++idx) {
-        const int32_t y = static_cast<int32_t>(idx / width);
-        const int32_t x = static_cast<int32_t>(idx % width);
+struct RenderCtx {
+    const AdjustParams *p = nullptr;
+    const Lut3D *lut = nullptr;   // chỉ dùng khi MASK_LUT bật
+    float lutT = 1.f;             // lutAmount đã clamp
+    float fullW = 0.f, fullH = 0.f;
+    bool premultiplied = false;
+    const FixedPipeline *fixed = nullptr; // != nullptr -> dùng kernel số nguyên (xem useFixedPath)
+
+    // Pipeline graph (bindPipeline): ordered = true -> kernel kOrderedMask chạy `ops` theo thứ tự,
+    // preOps = nhóm point-wise đứng trước denoise (chạy trên input của denoise, kể cả halo)
+    bool ordered = false;
+    const uint8_t *ops = nullptr;
+    int32_t opCount = 0;
+    const uint8_t *preOps = nullptr;
+    int32_t preCount = 0;
+};
 
-        auto *row = reinterpret_cast<uint32_t *>(base + static_cast<size_t>(y) * strideBytes);
-        const uint32_t color = row[x];
+template <uint64_t kMask>
+static inline uint32_t adjustPixel(uint32_t color, float x, float y,
+                                   const RenderCtx &ctx,
+                                   RenderStats *stats) {
+    const AdjustParams &p = *ctx.p;
+    const uint64_t mask = p.activeMask;
+    const bool premultiplied = ctx.premultiplied;
+
+    const uint8_t au = static_cast<uint8_t>((color >> 24) & 0xFFu);
+    const uint8_t ru = static_cast<uint8_t>((color >> 16) & 0xFFu);
+    const uint8_t gu = static_cast<uint8_t>((color >>  8) & 0xFFu);
+    const uint8_t bu = static_cast<uint8_t>( color        & 0xFFu);
+
+    float a = static_cast<float>(au);
+    float r = static_cast<float>(ru);
+    float g = static_cast<float>(gu);
+    float b = static_cast<float>(bu);
+
+    // Un-premultiply if needed
+    if (premultiplied && a > 0.0f) {
+        const float af = a / 255.0f;
+        const float inv = (af > 0.0f ? (1.0f / af) : 0.0f);
+        r = std::min(255.0f, r * inv);
+        g = std::min(255.0f, g * inv);
+        b = std::min(255.0f, b * inv);
+    }
 
-        const uint8_t au = static_cast<uint8_t>((color >> 24) & 0xFFu);
-        const uint8_t ru = static_cast<uint8_t>((color >> 16) & 0xFFu);
-        const uint8_t gu = static_cast<uint8_t>((color >>  8) & 0xFFu);
-        const uint8_t bu = static_cast<uint8_t>( color        & 0xFFu);
+    // Curves đã gộp vào bảng của LIGHT khi LIGHT bật
+    if (stageOn<kMask>(mask, MASK_LIGHT))       applyLightAdjust(r, g, b, p);
+    else if (stageOn<kMask>(mask, MASK_CURVES)) applyCurveAdjust(r, g, b, p);
+    if (stageOn<kMask>(mask, MASK_HSL))   applyHSLAdjust(r, g, b, p);
+
+    r = std::clamp(r, 0.0f, 255.0f);
+    g = std::clamp(g, 0.0f, 255.0f);
+    b = std::clamp(b, 0.0f, 255.0f);
+
+    float rf = r / 255.0f;
+    float gf = g / 255.0f;
+    float bf = b / 255.0f;
+
+    if (stageOn<kMask>(mask, MASK_COLOR))    applyColorAdjust(rf, gf, bf, p);
+    if (stageOn<kMask>(mask, MASK_DETAIL))   applyDetailAdjust(rf, gf, bf, x, y, ctx.fullW, ctx.fullH, p);
+    if (stageOn<kMask>(mask, MASK_VIGNETTE)) applyVignetteAt(rf, gf, bf, x, y, ctx.fullW, ctx.fullH, p);
+    if (stageOn<kMask>(mask, MASK_GRAIN))    applyGrainAt(rf, gf, bf, x, y, p);
+
+    rf = std::clamp(rf, 0.0f, 1.0f);
+    gf = std::clamp(gf, 0.0f, 1.0f);
+    bf = std::clamp(bf, 0.0f, 1.0f);
+
+    // Stats đo trên giá trị output (straight alpha)
+    if (stats) {
+        stats->accumulateLanes(static_cast<uint8_t>(rf * 255.0f),
+                                static_cast<uint8_t>(gf * 255.0f),
+                                static_cast<uint8_t>(bf * 255.0f));
+    }
 
-        float a = static_cast<float>(au);
-        float r = static_cast<float>(ru);
-        float g = static_cast<float>(gu);
-        float b = static_cast<float>(bu);
+    // Re-premultiply if needed
+    float rout, gout, bout;
+    if (premultiplied && a > 0.0f) {
+        const float af = a / 255.0f;
+        rout = std::clamp(rf * 255.0f * af, 0.0f, 255.0f);
+        gout = std::clamp(gf * 255.0f * af, 0.0f, 255.0f);
+        bout = std::clamp(bf * 255.0f * af, 0.0f, 255.0f);
+    } else {
+        rout = rf * 255.0f;
+        gout = gf * 255.0f;
+        bout = bf * 255.0f;
+    }
 
-        // Un-premultiply if needed
-        if (premultiplied && a > 0.0f) {
-            const float af = a / 255.0f;
-            const float inv = (af > 0.0f ? (1.0f / af) : 0.0f);
-            r = std::min(255.0f, r * inv);
-            g = std::min(255.0f, g * inv);
-            b = std::min(255.0f, b * inv);
-        }
+    return (static_cast<uint32_t>(au) << 24)
+           | (static_cast<uint32_t>(static_cast<uint8_t>(rout)) << 16)
+           | (static_cast<uint32_t>(static_cast<uint8_t>(gout)) <<  8)
+           |  static_cast<uint32_t>(static_cast<uint8_t>(bout));
+}
 
-        if (p.activeMask & MASK_LIGHT) applyLightAdjust(r, g, b, p);
-        if (p.activeMask & MASK_HSL)   applyHSLAdjust(r, g, b, p);
+static inline uint32_t lutPixel(uint32_t c, const Lut3D &lut, float t,
+                                bool premultiplied, RenderStats *stats) {
+    const uint8_t a = static_cast<uint8_t>((c >> 24) & 0xFFu);
+    float r = static_cast<float>((c >> 16) & 0xFFu) / 255.0f;
+    float g = static_cast<float>((c >>  8) & 0xFFu) / 255.0f;
+    float b = static_cast<float>( c        & 0xFFu) / 255.0f;
+
+    float rOrig = r, gOrig = g, bOrig = b;
+
+    if (premultiplied && a > 0u) {
+        const float af  = static_cast<float>(a) / 255.0f;
+        const float inv = (af > 0.0f ? (1.0f / af) : 0.0f);
+        r = std::min(1.0f, r * inv);
+        g = std::min(1.0f, g * inv);
+        b = std::min(1.0f, b * inv);
+        rOrig = std::min(1.0f, rOrig * inv);
+        gOrig = std::min(1.0f, gOrig * inv);
+        bOrig = std::min(1.0f, bOrig * inv);
+    }
 
-        r = std::clamp(r, 0.0f, 255.0f);
-        g = std::clamp(g, 0.0f, 255.0f);
-        b = std::clamp(b, 0.0f, 255.0f);
+    float rr, gg, bb;
+    sampleLUT(lut, r, g, b, rr, gg, bb);
 
-        float rf = r / 255.0f;
-        float gf = g / 255.0f;
-        float bf = b / 255.0f;
-
-        if (p.activeMask & MASK_COLOR)    applyColorAdjust(rf, gf, bf, p);
-        if (p.activeMask & MASK_DETAIL)   applyDetailAdjust(rf, gf, bf, static_cast<float>(x), static_cast<float>(y), static_cast<float>(width), static_cast<float>(height), p);
-        if (p.activeMask & MASK_VIGNETTE) applyVignetteAt(rf, gf, bf, static_cast<float>(x), static_cast<float>(y), static_cast<float>(width), static_cast<float>(height), p);
-        if (p.activeMask & MASK_GRAIN)    applyGrainAt(rf, gf, bf, p);
-
-        rf = std::clamp(rf, 0.0f, 1.0f);
-        gf = std::clamp(gf, 0.0f, 1.0f);
-        bf = std::clamp(bf, 0.0f, 1.0f);
-
-        // Re-premultiply if needed
-        float rout, gout, bout;
-        if (premultiplied && a > 0.0f) {
-            const float af = a / 255.0f;
-            rout = std::clamp(rf * 255.0f * af, 0.0f, 255.0f);
-            gout = std::clamp(gf * 255.0f * af, 0.0f, 255.0f);
-            bout = std::clamp(bf * 255.0f * af, 0.0f, 255.0f);
-        } else {
-            rout = rf * 255.0f;
-            gout = gf * 255.0f;
-            bout = bf * 255.0f;
-        }
+    rr = std::clamp(rr, 0.0f, 1.0f);
+    gg = std::clamp(gg, 0.0f, 1.0f);
+    bb = std::clamp(bb, 0.0f, 1.0f);
 
-        row[x] = (static_cast<uint32_t>(au) << 24)
-                 | (static_cast<uint32_t>(static_cast<uint8_t>(rout)) << 16)
-                 | (static_cast<uint32_t>(static_cast<uint8_t>(gout)) <<  8)
-                 |  static_cast<uint32_t>(static_cast<uint8_t>(bout));
+    // blend theo lutAmount
+    rr = rOrig * (1.0f - t) + rr * t;
+    gg = gOrig * (1.0f - t) + gg * t;
+    bb = bOrig * (1.0f - t) + bb * t;
 
-        doneCounter.fetch_add(1, std::memory_order_relaxed);
+    if (stats) {
+        stats->accumulateLanes(static_cast<uint8_t>(rr * 255.0f),
+                                static_cast<uint8_t>(gg * 255.0f),
+                                static_cast<uint8_t>(bb * 255.0f));
     }
-}
-
-// =============================================================
-// 🎨 processLutRange (LUT stage, multi-thread)
-// =============================================================
-static void processLutRange(void *basePixels,
-                            int64_t start, int64_t end,
-                            int32_t width,
-                            size_t strideBytes,
-                            const AdjustParams &p,
-                            const Lut3D &lut,
-                            bool premultiplied) {
-    auto *base = reinterpret_cast<uint8_t *>(basePixels);
-    const float t = clampf(p.lutAmount, 0.f, 1.f);
 
-    for (int64_t idx = start; idx < end; ++idx) {
-        const int32_t y = static_cast<int32_t>(idx / width);
-        const int32_t x = static_cast<int32_t>(idx % width);
+    if (premultiplied && a > 0u) {
+        const float af = static_cast<float>(a) / 255.0f;
+        rr = std::clamp(rr * af, 0.0f, 1.0f);
+        gg = std::clamp(gg * af, 0.0f, 1.0f);
+        bb = std::clamp(bb * af, 0.0f, 1.0f);
+    }
 
-        auto *row = reinterpret_cast<uint32_t *>(base + static_cast<size_t>(y) * strideBytes);
-        const uint32_t c = row[x];
+    return (static_cast<uint32_t>(a) << 24)
+           | (static_cast<uint32_t>(static_cast<uint8_t>(rr * 255.0f)) << 16)
+           | (static_cast<uint32_t>(static_cast<uint8_t>(gg * 255.0f)) <<  8)
+           |  static_cast<uint32_t>(static_cast<uint8_t>(bb * 255.0f));
+}
 
-        const uint8_t a = static_cast<uint8_t>((c >> 24) & 0xFFu);
-        float r = static_cast<float>((c >> 16) & 0xFFu) / 255.0f;
-        float g = static_cast<float>((c >>  8) & 0xFFu) / 255.0f;
-        float b = static_cast<float>( c        & 0xFFu) / 255.0f;
+// Stage theo thứ tự tuỳ ý: giữ r/g/b thang 0..255 (straight alpha), clamp sau mỗi stage.
+// Trả giá 1 switch / stage / pixel nên chỉ dùng khi thứ tự khác mặc định (kernel specialize giữ nguyên).
+static inline uint32_t orderedPixel(uint32_t color, float x, float y, const RenderCtx &ctx,
+                                    const uint8_t *ops, int32_t opCount, RenderStats *stats) {
+    const AdjustParams &p = *ctx.p;
+    const bool premultiplied = ctx.premultiplied;
+    const uint8_t au = static_cast<uint8_t>((color >> 24) & 0xFFu);
+    float a = static_cast<float>(au);
+    float r = static_cast<float>((color >> 16) & 0xFFu);
+    float g = static_cast<float>((color >>  8) & 0xFFu);
+    float b = static_cast<float>( color        & 0xFFu);
+
+    if (premultiplied && a > 0.0f) {
+        const float inv = 255.0f / a;
+        r = std::min(255.0f, r * inv);
+        g = std::min(255.0f, g * inv);
+        b = std::min(255.0f, b * inv);
+    }
 
-        float rOrig = r, gOrig = g, bOrig = b;
+    // Stage thang 0..1: đổi thang, áp, clamp rồi đổi lại
+    auto unit = [&](auto &&stage) {
+        float rf = r / 255.0f, gf = g / 255.0f, bf = b / 255.0f;
+        stage(rf, gf, bf);
+        r = std::clamp(rf, 0.0f, 1.0f) * 255.0f;
+        g = std::clamp(gf, 0.0f, 1.0f) * 255.0f;
+        b = std::clamp(bf, 0.0f, 1.0f) * 255.0f;
+    };
 
-        if (premultiplied && a > 0u) {
-            const float af  = static_cast<float>(a) / 255.0f;
-            const float inv = (af > 0.0f ? (1.0f / af) : 0.0f);
-            r = std::min(1.0f, r * inv);
-            g = std::min(1.0f, g * inv);
-            b = std::min(1.0f, b * inv);
-            rOrig = std::min(1.0f, rOrig * inv);
-            gOrig = std::min(1.0f, gOrig * inv);
-            bOrig = std::min(1.0f, bOrig * inv);
+    for (int32_t i = 0; i < opCount; ++i) {
+        switch (ops[i]) {
+            case STAGE_LUT:
+                unit([&](float &rf, float &gf, float &bf) {
+                    float lr, lg, lb;
+                    sampleLUT(*ctx.lut, rf, gf, bf, lr, lg, lb);
+                    const float t = ctx.lutT;
+                    rf += (std::clamp(lr, 0.0f, 1.0f) - rf) * t;
+                    gf += (std::clamp(lg, 0.0f, 1.0f) - gf) * t;
+                    bf += (std::clamp(lb, 0.0f, 1.0f) - bf) * t;
+                });
+                break;
+            case STAGE_TONE:
+                if (p.activeMask & MASK_LIGHT) applyLightAdjust(r, g, b, p);
+                else applyCurveAdjust(r, g, b, p);
+                break;
+            case STAGE_HSL:
+                applyHSLAdjust(r, g, b, p);
+                break;
+            case STAGE_COLOR:
+                unit([&](float &rf, float &gf, float &bf) { applyColorAdjust(rf, gf, bf, p); });
+                break;
+            case STAGE_DETAIL:
+                unit([&](float &rf, float &gf, float &bf) { applyDetailAdjust(rf, gf, bf, x, y, ctx.fullW, ctx.fullH, p); });
+                break;
+            case STAGE_VIGNETTE:
+                unit([&](float &rf, float &gf, float &bf) { applyVignetteAt(rf, gf, bf, x, y, ctx.fullW, ctx.fullH, p); });
+                break;
+            case STAGE_GRAIN:
+                unit([&](float &rf, float &gf, float &bf) { applyGrainAt(rf, gf, bf, x, y, p); });
+                break;
+            default:
+                break;
         }
+        r = std::clamp(r, 0.0f, 255.0f);
+        g = std::clamp(g, 0.0f, 255.0f);
+        b = std::clamp(b, 0.0f, 255.0f);
+    }
 
-        float rr, gg, bb;
-        sampleLUT(lut, r, g, b, rr, gg, bb);
-
-        rr = std::clamp(rr, 0.0f, 1.0f);
-        gg = std::clamp(gg, 0.0f, 1.0f);
-        bb = std::clamp(bb, 0.0f, 1.0f);
-
-        // blend theo lutAmount
-        rr = rOrig * (1.0f - t) + rr * t;
-        gg = gOrig * (1.0f - t) + gg * t;
-        bb = bOrig * (1.0f - t) + bb * t;
-
-        if (premultiplied && a > 0u) {
-            const float af = static_cast<float>(a) / 255.0f;
-            rr = std::clamp(rr * af, 0.0f, 1.0f);
-            gg = std::clamp(gg * af, 0.0f, 1.0f);
-            bb = std::clamp(bb * af, 0.0f, 1.0f);
-        }
+    if (stats) {
+        stats->accumulateLanes(static_cast<uint8_t>(r), static_cast<uint8_t>(g), static_cast<uint8_t>(b));
+    }
+    if (premultiplied && a > 0.0f) {
+        const float af = a / 255.0f;
+        r = std::clamp(r * af, 0.0f, 255.0f);
+        g = std::clamp(g * af, 0.0f, 255.0f);
+        b = std::clamp(b * af, 0.0f, 255.0f);
+    }
+    return (static_cast<uint32_t>(au) << 24)
+           | (static_cast<uint32_t>(static_cast<uint8_t>(r)) << 16)
+           | (static_cast<uint32_t>(static_cast<uint8_t>(g)) <<  8)
+           |  static_cast<uint32_t>(static_cast<uint8_t>(b));
+}
 
-        row[x] = (static_cast<uint32_t>(a) << 24)
-                 | (static_cast<uint32_t>(static_cast<uint8_t>(rr * 255.0f)) << 16)
-                 | (static_cast<uint32_t>(static_cast<uint8_t>(gg * 255.0f)) <<  8)
-                 |  static_cast<uint32_t>(static_cast<uint8_t>(bb * 255.0f));
+// LUT -> adjust trên cùng 1 pixel (1 lần đọc/ghi bộ nhớ). Giữ lượng tử hoá 8-bit giữa
+// 2 stage để kết quả không đổi so với khi LUT còn là 1 pass riêng.
+template <uint64_t kMask>
+static inline uint32_t renderPixel(uint32_t c, float x, float y, const RenderCtx &ctx, RenderStats *stats) {
+    if constexpr (kMask == kOrderedMask) return orderedPixel(c, x, y, ctx, ctx.ops, ctx.opCount, stats);
+    const uint64_t mask = ctx.p->activeMask;
+    const bool lutOn = stageOn<kMask>(mask, MASK_LUT);
+    const bool adjustOn = (kMask == kDynamicMask)
+                          ? (mask & kStageBits & ~MASK_LUT) != 0
+                          : (kMask & ~MASK_LUT) != 0;
+
+    if (lutOn) c = lutPixel(c, *ctx.lut, ctx.lutT, ctx.premultiplied, adjustOn ? nullptr : stats);
+    if (adjustOn) {
+        c = adjustPixel<kMask>(c, x, y, ctx, stats);
+    } else if (!lutOn && stats) {
+        stats->accumulateLanes(static_cast<uint8_t>((c >> 16) & 0xFFu),
+                                static_cast<uint8_t>((c >> 8) & 0xFFu),
+                                static_cast<uint8_t>(c & 0xFFu));
     }
+    return c;
 }
 
 // =============================================================
-// 🔗 JNI: applyAdjustNative
+// 🧮 fusedRows (full render, in-place, 1 pass cho LUT + mọi adjust)
+// =============================================================
+template <uint64_t kMask>
+static void fusedRows(uint8_t *base, size_t strideBytes, int32_t width,
+                      int32_t y0, int32_t y1,
+                      const RenderCtx &ctx,
+                      std::atomic<int64_t> &doneCounter,
+                      RenderStats *stats) {
+    for (int32_t y = y0; y < y1; ++y) {
+        auto *row = reinterpret_cast<uint32_t *>(base + static_cast<size_t>(y) * strideBytes);
+        const float fy = static_cast<float>(y);
+        for (int32_t x = 0; x < width; ++x) {
+            row[x] = renderPixel<kMask>(row[x], static_cast<float>(x), fy, ctx, stats);
+        }
+        doneCounter.fetch_add(width, std::memory_order_relaxed);
+    }
+}
+
+// =============================================================
+// 🔍 regionRows (region-of-interest render)
+// Mỗi pixel output (dx, dy) ánh xạ về toạ độ nguồn (sx, sy) trong ảnh gốc:
+//   1:1 -> đọc thẳng (khớp bit-exact với full render),
+//   khác tỉ lệ -> bilinear trên pixel nguồn 8-bit.
+// =============================================================
+struct RegionMapping {
+    float left = 0.f, top = 0.f;     // góc vùng nguồn
+    float scaleX = 1.f, scaleY = 1.f; // source px / output px
+    int32_t srcW = 0, srcH = 0;
+    bool identity = false;           // 1:1 + toạ độ nguyên
+    int32_t srcOriginY = 0;          // hàng ảnh gốc ứng với hàng 0 của buffer src (streaming theo dải)
+    int32_t srcOriginX = 0;          // cột ảnh gốc ứng với cột 0 của buffer src (tile đã denoise)
+    bool presampled = false;         // src đã lấy mẫu sẵn theo kích thước output (khác tỉ lệ + denoise)
+    const GeometryTransform *geo = nullptr; // crop / xoay / lật: thay ánh xạ (left, top, scale) ở trên
+};
+
+static inline uint32_t sampleBilinear(const uint8_t *src, size_t srcStride, int32_t srcW, int32_t srcH,
+                                      float sx, float sy) {
+    sx = std::clamp(sx, 0.0f, static_cast<float>(srcW - 1));
+    sy = std::clamp(sy, 0.0f, static_cast<float>(srcH - 1));
+    const int32_t x0 = static_cast<int32_t>(sx);
+    const int32_t y0 = static_cast<int32_t>(sy);
+    const int32_t x1 = std::min(x0 + 1, srcW - 1);
+    const int32_t y1 = std::min(y0 + 1, srcH - 1);
+    const float fx = sx - static_cast<float>(x0);
+    const float fy = sy - static_cast<float>(y0);
+
+    const auto *r0 = reinterpret_cast<const uint32_t *>(src + static_cast<size_t>(y0) * srcStride);
+    const auto *r1 = reinterpret_cast<const uint32_t *>(src + static_cast<size_t>(y1) * srcStride);
+    const uint32_t c00 = r0[x0], c01 = r0[x1], c10 = r1[x0], c11 = r1[x1];
+
+    uint32_t out = 0;
+    for (uint32_t shift = 0; shift < 32; shift += 8) {
+        const float v00 = static_cast<float>((c00 >> shift) & 0xFFu);
+        const float v01 = static_cast<float>((c01 >> shift) & 0xFFu);
+        const float v10 = static_cast<float>((c10 >> shift) & 0xFFu);
+        const float v11 = static_cast<float>((c11 >> shift) & 0xFFu);
+        const float top = v00 + (v01 - v00) * fx;
+        const float bot = v10 + (v11 - v10) * fx;
+        const float v = top + (bot - top) * fy;
+        out |= static_cast<uint32_t>(std::clamp(v + 0.5f, 0.0f, 255.0f)) << shift;
+    }
+    return out;
+}
+
+// Lấy mẫu hàng output `dy` (khác tỉ lệ / geometry), chưa qua stage nào
+static void sampleRegionRow(const uint8_t *src, size_t srcStride, const RegionMapping &m, int32_t dy,
+                            uint32_t *out, int32_t dstW) {
+    if (m.geo) {
+        sampleGeometryRow(src, srcStride, m.srcW, m.srcH, *m.geo, dy, out, dstW);
+        return;
+    }
+    const float sy = m.top + (static_cast<float>(dy) + 0.5f) * m.scaleY - 0.5f;
+    for (int32_t dx = 0; dx < dstW; ++dx) {
+        const float sx = m.left + (static_cast<float>(dx) + 0.5f) * m.scaleX - 0.5f;
+        out[dx] = sampleBilinear(src, srcStride, m.srcW, m.srcH, sx, sy);
+    }
+}
+
+// Geometry: toạ độ vignette / grain theo khung crop (đơn vị pixel nguồn). Pixel rơi ngoài ảnh (alpha 0)
+// giữ trong suốt thay vì đi qua stage (LUT / tone sẽ tô màu lên pixel alpha 0 -> premultiplied sai).
+template <uint64_t kMask>
+static void geometryRenderRow(const uint32_t *in, uint32_t *out, int32_t dstW, int32_t dy,
+                              const GeometryTransform &g, const RenderCtx &ctx, RenderStats *stats) {
+    // Xoay / lật giữ nguyên độ dài -> scaleX/scaleY cũng là tỉ lệ khung crop / output
+    const float y = std::floor((static_cast<float>(dy) + 0.5f) * g.scaleY);
+    for (int32_t dx = 0; dx < dstW; ++dx) {
+        const uint32_t c = in[dx];
+        out[dx] = (c >> 24) == 0u ? 0u
+                : renderPixel<kMask>(c, std::floor((static_cast<float>(dx) + 0.5f) * g.scaleX), y, ctx, stats);
+    }
+}
+
+template <uint64_t kMask>
+static void regionRows(const uint8_t *src, size_t srcStride,
+                       uint8_t *dst, size_t dstStride, int32_t dstW,
+                       int32_t y0, int32_t y1,
+                       const RegionMapping &m,
+                       const RenderCtx &ctx,
+                       std::atomic<int64_t> &doneCounter,
+                       RenderStats *stats) {
+    for (int32_t dy = y0; dy < y1; ++dy) {
+        auto *out = reinterpret_cast<uint32_t *>(dst + static_cast<size_t>(dy) * dstStride);
+        const float sy = m.top + (static_cast<float>(dy) + 0.5f) * m.scaleY - 0.5f;
+
+        if (m.identity) {
+            const int32_t iy = static_cast<int32_t>(sy);
+            const auto *srcRow = reinterpret_cast<const uint32_t *>(src + static_cast<size_t>(iy - m.srcOriginY) * srcStride);
+            const int32_t ix0 = static_cast<int32_t>(m.left);
+            const uint32_t *px = srcRow + (ix0 - m.srcOriginX);
+            for (int32_t dx = 0; dx < dstW; ++dx) {
+                out[dx] = renderPixel<kMask>(px[dx], static_cast<float>(ix0 + dx), sy, ctx, stats);
+            }
+        } else {
+            const uint32_t *in = out;
+            if (m.presampled) in = reinterpret_cast<const uint32_t *>(src + static_cast<size_t>(dy) * srcStride);
+            else sampleRegionRow(src, srcStride, m, dy, out, dstW);
+            if (m.geo) {
+                geometryRenderRow<kMask>(in, out, dstW, dy, *m.geo, ctx, stats);
+            } else {
+                for (int32_t dx = 0; dx < dstW; ++dx) {
+                    const float sx = m.left + (static_cast<float>(dx) + 0.5f) * m.scaleX - 0.5f;
+                    out[dx] = renderPixel<kMask>(in[dx], std::floor(sx + 0.5f), std::floor(sy + 0.5f), ctx, stats);
+                }
+            }
+        }
+        doneCounter.fetch_add(dstW, std::memory_order_relaxed);
+    }
+}
+
+// =============================================================
+// 🗂️ Dispatch table: activeMask -> kernel đã specialize
+// Tổ hợp hay gặp (mọi tập con của LUT/LIGHT/HSL/COLOR/VIGNETTE, tức không DETAIL/GRAIN)
+// có bản riêng; còn lại dùng bản kDynamicMask.
+// =============================================================
+using FusedRowsFn = void (*)(uint8_t *, size_t, int32_t, int32_t, int32_t,
+                             const RenderCtx &, std::atomic<int64_t> &, RenderStats *);
+using RegionRowsFn = void (*)(const uint8_t *, size_t, uint8_t *, size_t, int32_t, int32_t, int32_t,
+                              const RegionMapping &, const RenderCtx &, std::atomic<int64_t> &, RenderStats *);
+
+static constexpr bool isCommonCombo(uint64_t mask) {
+    return (mask & (MASK_DETAIL | MASK_GRAIN)) == 0;
+}
+
+// LIGHT bật thì CURVES không tốn gì thêm trong kernel -> dùng chung bản không có CURVES
+static constexpr bool curvesFolded(uint64_t mask) {
+    return (mask & MASK_LIGHT) && (mask & MASK_CURVES);
+}
+
+template <uint64_t kMask>
+static constexpr FusedRowsFn pickFusedRows() {
+    if constexpr (curvesFolded(kMask)) return pickFusedRows<kMask & ~MASK_CURVES>();
+    else if constexpr (isCommonCombo(kMask)) return &fusedRows<kMask>;
+    else return &fusedRows<kDynamicMask>;
+}
+
+template <uint64_t kMask>
+static constexpr RegionRowsFn pickRegionRows() {
+    if constexpr (curvesFolded(kMask)) return pickRegionRows<kMask & ~MASK_CURVES>();
+    else if constexpr (isCommonCombo(kMask)) return &regionRows<kMask>;
+    else return &regionRows<kDynamicMask>;
+}
+
+template <size_t... I>
+static constexpr std::array<FusedRowsFn, sizeof...(I)> makeFusedTable(std::index_sequence<I...>) {
+    return {{pickFusedRows<static_cast<uint64_t>(I)>()...}};
+}
+
+template <size_t... I>
+static constexpr std::array<RegionRowsFn, sizeof...(I)> makeRegionTable(std::index_sequence<I...>) {
+    return {{pickRegionRows<static_cast<uint64_t>(I)>()...}};
+}
+
+static constexpr size_t kComboCount = static_cast<size_t>(kStageBits) + 1u;
+static const std::array<FusedRowsFn, kComboCount> kFusedRowsTable = makeFusedTable(std::make_index_sequence<kComboCount>{});
+static const std::array<RegionRowsFn, kComboCount> kRegionRowsTable = makeRegionTable(std::make_index_sequence<kComboCount>{});
+
+static FusedRowsFn selectFusedRows(const RenderCtx &ctx) {
+    const uint64_t mask = ctx.p->activeMask;
+    if (ctx.ordered) return &fusedRows<kOrderedMask>;
+    if (mask & ~kStageBits) return &fusedRows<kDynamicMask>;
+    return kFusedRowsTable[static_cast<size_t>(mask)];
+}
+
+static RegionRowsFn selectRegionRows(const RenderCtx &ctx) {
+    const uint64_t mask = ctx.p->activeMask;
+    if (ctx.ordered) return &regionRows<kOrderedMask>;
+    if (mask & ~kStageBits) return &regionRows<kDynamicMask>;
+    return kRegionRowsTable[static_cast<size_t>(mask)];
+}
+
+// Thứ tự mặc định -> kernel specialize như cũ; khác mặc định -> kernel kOrderedMask chạy nhóm sau denoise,
+// nhóm trước denoise gắn vào preOps (xem preSpatialRows)
+static void bindPipeline(RenderCtx &ctx, const PipelinePlan &plan) {
+    ctx.ordered = !plan.specialized;
+    if (!ctx.ordered) return;
+    const PipelineGroup *post = plan.post();
+    ctx.ops = post ? post->stages : nullptr;
+    ctx.opCount = post ? post->count : 0;
+    const PipelineGroup *pre = plan.pre();
+    ctx.preOps = pre ? pre->stages : nullptr;
+    ctx.preCount = pre ? pre->count : 0;
+}
+
+// =============================================================
+// 🔢 Fixed-point path (xem adjust_fixed.h)
+// AUTO: chỉ bật trên armeabi-v7a, nơi float (softfp) là nút cổ chai.
+// Mỗi lần render: chạy 1 bộ pixel thăm dò qua cả 2 đường, lệch > kFixedErrorBudget -> về float.
+// =============================================================
+static std::atomic<int32_t> s_fixedMode{FIXED_AUTO};
+static constexpr int32_t kFixedErrorBudget = 3;          // mức 8-bit, mọi kênh, từng stage
+static constexpr int32_t kFixedEndToEndBudget = 6;         // mức 8-bit, cả chuỗi LUT -> adjust (cái người dùng thấy)
+static constexpr int32_t kFixedProbePixels = 512;
+
+// Premultiplied: đo sau khi un-premultiply. 1 mức premultiplied ở alpha a = 255/a mức straight,
+// trừ đi 1 mức làm tròn mà chính việc lưu premultiplied đã có (cả đường float cũng chịu).
+static int32_t maxChannelDiff(const uint32_t *a, const uint32_t *b, int32_t count, bool premultiplied) {
+    int32_t maxErr = 0;
+    for (int32_t i = 0; i < count; ++i) {
+        const int32_t alpha = static_cast<int32_t>(a[i] >> 24);
+        for (uint32_t shift = 0; shift < 24; shift += 8) {
+            const int32_t d = static_cast<int32_t>((a[i] >> shift) & 0xFFu) - static_cast<int32_t>((b[i] >> shift) & 0xFFu);
+            int32_t err = std::abs(d);
+            if (premultiplied && alpha > 0 && alpha < 255 && err > 1) {
+                err = 1 + ((err - 1) * 255 + alpha / 2) / alpha;
+            }
+            maxErr = std::max(maxErr, err);
+        }
+    }
+    return maxErr;
+}
+
+struct FixedProbeError {
+    int32_t stage = 0;    // max theo từng stage, cùng input 8-bit cho cả 2 đường
+    int32_t endToEnd = 0; // chuỗi fixed (LUT -> adjust trên output của chính nó) so với chuỗi float
+};
+
+// Từng stage: bắt lỗi của chính phép tính số nguyên (budget chặt). Đầu-cuối: đường cong LIGHT có thể dốc
+// > 10 mức output / 1 mức input (contrast trong không gian linear), nên lệch 1 mức ở output LUT bị khuếch đại;
+// budget rộng hơn nhưng vẫn chặn để output armeabi-v7a không lệch thấy được so với ABI khác.
+static FixedProbeError fixedProbeError(const RenderCtx &ctx, const FixedPipeline &fp) {
+    uint32_t probe[kFixedProbePixels];
+    uint32_t seed = 0x9E3779B9u;
+    for (int32_t i = 0; i < kFixedProbePixels; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        uint32_t c = seed;
+        if (i < 256) {
+            // Dải xám đủ 256 mức: bắt lỗi của đường cong tone ở mọi mức
+            const uint32_t v = static_cast<uint32_t>(i);
+            c = (v << 16) | (v << 8) | v;
+        }
+        // Premultiplied: 1/4 số mẫu quét alpha 1..255 (kênh màu <= alpha). Alpha thấp là nơi
+        // un-premultiply số nguyên lệch nhiều nhất -> phải có trong probe thì mới rơi về float được.
+        uint32_t a = 255u;
+        if (ctx.premultiplied && (i & 3) == 3) {
+            a = 1u + static_cast<uint32_t>(i >> 2) * 2u;
+            const auto pm = [a](uint32_t v) { return (v * a + 127u) / 255u; };
+            c = (pm((c >> 16) & 0xFFu) << 16) | (pm((c >> 8) & 0xFFu) << 8) | pm(c & 0xFFu);
+        }
+        probe[i] = (a << 24) | (c & 0x00FFFFFFu);
+    }
+
+    uint32_t ref[kFixedProbePixels];
+    uint32_t out[kFixedProbePixels];
+    FixedProbeError err;
+    if (fp.lutOn && fp.adjustOn) {
+        // Đầu-cuối trước khi probe bị thay bằng output LUT của đường float bên dưới
+        for (int32_t i = 0; i < kFixedProbePixels; ++i) {
+            ref[i] = renderPixel<kDynamicMask>(probe[i], 0.f, 0.f, ctx, nullptr);
+        }
+        fixedProcessRow(fp, probe, out, kFixedProbePixels, nullptr);
+        // Đo trên giá trị lưu (premultiplied nếu có): đó là cái được blend lên màn hình
+        err.endToEnd = maxChannelDiff(ref, out, kFixedProbePixels, false);
+    }
+    int32_t &maxErr = err.stage;
+    if (fp.lutOn) {
+        for (int32_t i = 0; i < kFixedProbePixels; ++i) {
+            ref[i] = lutPixel(probe[i], *ctx.lut, ctx.lutT, ctx.premultiplied, nullptr);
+        }
+        fixedLutRow(fp, probe, out, kFixedProbePixels, nullptr);
+        maxErr = maxChannelDiff(ref, out, kFixedProbePixels, ctx.premultiplied);
+        std::copy(ref, ref + kFixedProbePixels, probe); // stage adjust nhận output LUT của đường float
+    }
+    if (fp.adjustOn) {
+        // Gọi thẳng stage adjust (không copy AdjustParams: lutPath dài -> cấp phát mỗi frame)
+        for (int32_t i = 0; i < kFixedProbePixels; ++i) {
+            ref[i] = adjustPixel<kDynamicMask>(probe[i], 0.f, 0.f, ctx, nullptr);
+        }
+        fixedAdjustRow(fp, probe, out, kFixedProbePixels, nullptr);
+        maxErr = std::max(maxErr, maxChannelDiff(ref, out, kFixedProbePixels, ctx.premultiplied));
+    }
+    if (!(fp.lutOn && fp.adjustOn)) err.endToEnd = err.stage; // 1 stage: đầu-cuối chính là stage đó
+    return err;
+}
+
+static bool useFixedPath(const RenderCtx &ctx, FixedPipeline &out) {
+    const int32_t mode = s_fixedMode.load(std::memory_order_relaxed);
+#if defined(__arm__)
+    const bool wanted = (mode != FIXED_OFF);
+#else
+    const bool wanted = (mode == FIXED_ON);
+#endif
+    if (!wanted || ctx.ordered || !fixedPathEligible(*ctx.p)) return false;
+
+    const bool lutOn = (ctx.p->activeMask & MASK_LUT) != 0;
+    if (!buildFixedPipeline(*ctx.p, lutOn ? ctx.lut : nullptr, ctx.lutT, ctx.premultiplied, out)) return false;
+    if (lutOn && !out.lutOn) return false;
+
+    const FixedProbeError err = fixedProbeError(ctx, out);
+    if (err.stage > kFixedErrorBudget || err.endToEnd > kFixedEndToEndBudget) {
+        LOGI("🔢 Fixed-point vượt error budget (stage %d > %d hoặc đầu-cuối %d > %d) -> float",
+             err.stage, kFixedErrorBudget, err.endToEnd, kFixedEndToEndBudget);
+        return false;
+    }
+    return true;
+}
+
+static void fixedFusedRows(uint8_t *base, size_t strideBytes, int32_t width,
+                           int32_t y0, int32_t y1,
+                           const RenderCtx &ctx,
+                           std::atomic<int64_t> &doneCounter,
+                           RenderStats *stats) {
+    for (int32_t y = y0; y < y1; ++y) {
+        auto *row = reinterpret_cast<uint32_t *>(base + static_cast<size_t>(y) * strideBytes);
+        fixedProcessRow(*ctx.fixed, row, row, width, stats);
+        doneCounter.fetch_add(width, std::memory_order_relaxed);
+    }
+}
+
+static void fixedRegionRows(const uint8_t *src, size_t srcStride,
+                            uint8_t *dst, size_t dstStride, int32_t dstW,
+                            int32_t y0, int32_t y1,
+                            const RegionMapping &m,
+                            const RenderCtx &ctx,
+                            std::atomic<int64_t> &doneCounter,
+                            RenderStats *stats) {
+    for (int32_t dy = y0; dy < y1; ++dy) {
+        auto *out = reinterpret_cast<uint32_t *>(dst + static_cast<size_t>(dy) * dstStride);
+        const float sy = m.top + (static_cast<float>(dy) + 0.5f) * m.scaleY - 0.5f;
+
+        if (m.identity) {
+            const int32_t iy = static_cast<int32_t>(sy);
+            const auto *srcRow = reinterpret_cast<const uint32_t *>(src + static_cast<size_t>(iy - m.srcOriginY) * srcStride);
+            fixedProcessRow(*ctx.fixed, srcRow + (static_cast<int32_t>(m.left) - m.srcOriginX), out, dstW, stats);
+        } else {
+            // Stage point-wise không phụ thuộc toạ độ -> lấy mẫu cả hàng rồi xử lý tại chỗ
+            const uint32_t *in = out;
+            if (m.presampled) in = reinterpret_cast<const uint32_t *>(src + static_cast<size_t>(dy) * srcStride);
+            else sampleRegionRow(src, srcStride, m, dy, out, dstW);
+            fixedProcessRow(*ctx.fixed, in, out, dstW, stats);
+            if (m.geo) {
+                // Alpha đi thẳng qua kernel: pixel ngoài ảnh (alpha 0) trả về trong suốt, xem geometryRenderRow
+                for (int32_t dx = 0; dx < dstW; ++dx) {
+                    if ((out[dx] >> 24) == 0u) out[dx] = 0u;
+                }
+            }
+        }
+        doneCounter.fetch_add(dstW, std::memory_order_relaxed);
+    }
+}
+
+// =============================================================
+// 🔇 Denoise (stage không gian, xem adjust_denoise.h)
+// Chạy trên dải của từng task TRƯỚC kernel point-wise, in-place theo strip:
+// hàng của dải khác đọc từ snapshot chụp trước khi render (task bên cạnh có thể đã ghi đè),
+// hàng của chính dải đã bị ghi đè đọc từ ring giữ `halo` hàng gốc cuối của strip trước.
+// =============================================================
+// Mọi buffer tạm của denoise mượn từ scratchArena(): kéo slider liên tục không cấp phát lại
+struct BandEdgeSnapshot {
+    int32_t width = 0;
+    ScratchArena::Lease slots;     // int32 mỗi hàng -> vị trí trong pixels, -1 = không chụp
+    ScratchArena::Lease pixels;
+
+    const uint32_t *row(int32_t y) const {
+        return pixels.as<uint32_t>() + static_cast<size_t>(slots.as<int32_t>()[y]) * static_cast<size_t>(width);
+    }
+};
+
+// Chụp các hàng trong [edge - halo, edge + halo) quanh mọi ranh giới dải (edge = k * band)
+static void snapshotBandEdges(const uint8_t *base, size_t stride, int32_t W, int32_t H,
+                              int32_t band, int32_t halo, BandEdgeSnapshot &snap) {
+    snap.width = W;
+    snap.slots = scratchArena().borrow(static_cast<size_t>(H) * sizeof(int32_t));
+    auto *slot = snap.slots.as<int32_t>();
+    std::fill(slot, slot + H, -1);
+    int32_t count = 0;
+    for (int32_t edge = band; edge < H; edge += band) {
+        for (int32_t y = std::max(0, edge - halo); y < std::min(H, edge + halo); ++y) {
+            if (slot[y] < 0) slot[y] = count++;
+        }
+    }
+    const size_t rowBytes = static_cast<size_t>(W) * 4u;
+    snap.pixels = scratchArena().borrow(static_cast<size_t>(count) * rowBytes);
+    for (int32_t y = 0; y < H; ++y) {
+        if (slot[y] >= 0) {
+            std::memcpy(snap.pixels.as<uint32_t>() + static_cast<size_t>(slot[y]) * static_cast<size_t>(W),
+                        base + static_cast<size_t>(y) * stride, rowBytes);
+        }
+    }
+}
+
+// Nhóm point-wise đứng trước denoise (ctx.preOps): áp lên các hàng [top, top + count), cột [xa, xb)
+// mà denoise sắp đọc, ghi vào buf (stride = width pixel) rồi trỏ rows[] sang đó. Hàng halo bị tính lại
+// ở tile kề bên, đổi lại không cần pass ghi ảnh trung gian. coords: hàng/cột buffer -> toạ độ ảnh gốc.
+static void preSpatialRows(const uint32_t **rows, int32_t top, int32_t count, int32_t xa, int32_t xb,
+                           int32_t width, const RegionMapping &coords, const RenderCtx &ctx, uint32_t *buf) {
+    for (int32_t i = 0; i < count; ++i) {
+        const float fy = std::floor(coords.top + (static_cast<float>(top + i) + 0.5f) * coords.scaleY);
+        const uint32_t *in = rows[i];
+        uint32_t *out = buf + static_cast<size_t>(i) * static_cast<size_t>(width);
+        for (int32_t x = xa; x < xb; ++x) {
+            const float fx = std::floor(coords.left + (static_cast<float>(x) + 0.5f) * coords.scaleX);
+            out[x] = orderedPixel(in[x], fx, fy, ctx, ctx.preOps, ctx.preCount, nullptr);
+        }
+        rows[i] = out;
+    }
+}
+
+// Denoise in-place dải [y0, y1), mỗi strip xong thì gọi pointRows(a, b) cho các hàng [a, b) đã lọc
+template <typename PointRowsFn>
+static void denoiseBandInPlace(uint8_t *base, size_t stride, int32_t W, int32_t H, int32_t y0, int32_t y1,
+                               const BandEdgeSnapshot &snap, const DenoiseSettings &ds,
+                               const RenderCtx &ctx, const RegionMapping &coords,
+                               PointRowsFn &&pointRows) {
+    const int32_t halo = ds.halo();
+    const int32_t stripRows = std::max(kDenoiseTileH, halo); // >= halo: ring luôn nằm trong strip vừa xong
+    const size_t width = static_cast<size_t>(W);
+    const size_t rowBytes = width * 4u;
+    const ScratchArena::Lease stripLease = scratchArena().borrow(static_cast<size_t>(stripRows) * rowBytes);
+    const ScratchArena::Lease ringLease = scratchArena().borrow(static_cast<size_t>(halo) * rowBytes);
+    const ScratchArena::Lease rowsLease = scratchArena().borrow(static_cast<size_t>(stripRows + 2 * halo) * sizeof(const uint32_t *));
+    const ScratchArena::Lease preLease = scratchArena().borrow(ctx.preCount > 0 ? static_cast<size_t>(stripRows + 2 * halo) * rowBytes : 0u);
+    auto *strip = stripLease.as<uint32_t>();
+    auto *ring = ringLease.as<uint32_t>(); // hàng gốc [a - halo, a)
+    auto **rows = rowsLease.as<const uint32_t *>();
+    auto bitmapRow = [&](int32_t y) { return reinterpret_cast<uint32_t *>(base + static_cast<size_t>(y) * stride); };
+
+    for (int32_t a = y0; a < y1; a += stripRows) {
+        const int32_t b = std::min(y1, a + stripRows);
+        const int32_t top = std::max(0, a - halo);
+        const int32_t bottom = std::min(H, b + halo);
+        for (int32_t y = top; y < bottom; ++y) {
+            const uint32_t *r;
+            if (y < y0 || y >= y1) r = snap.row(y);
+            else if (y < a) r = ring + static_cast<size_t>(y - (a - halo)) * width;
+            else r = bitmapRow(y);
+            rows[y - top] = r;
+        }
+        if (ctx.preCount > 0) preSpatialRows(rows, top, bottom - top, 0, W, W, coords, ctx, preLease.as<uint32_t>());
+        denoiseRect(rows, top, W, H, 0, a, W, b, ds, ctx.premultiplied, reinterpret_cast<uint8_t *>(strip), rowBytes);
+
+        // Giữ bản gốc `halo` hàng cuối trước khi ghi đè: strip sau còn đọc làm halo
+        if (b < y1) {
+            for (int32_t y = b - halo; y < b; ++y) {
+                std::memcpy(ring + static_cast<size_t>(y - (b - halo)) * width, bitmapRow(y), rowBytes);
+            }
+        }
+        for (int32_t y = a; y < b; ++y) {
+            std::memcpy(bitmapRow(y), strip + static_cast<size_t>(y - a) * width, rowBytes);
+        }
+        pointRows(a, b);
+    }
+}
+
+// Lấy mẫu vùng nguồn sang không gian output, chưa qua stage nào (đầu vào của denoise khi render vùng)
+static void sampleRegionRows(const uint8_t *src, size_t srcStride, uint8_t *dst, size_t dstStride,
+                             int32_t dstW, int32_t y0, int32_t y1, const RegionMapping &m) {
+    for (int32_t dy = y0; dy < y1; ++dy) {
+        auto *out = reinterpret_cast<uint32_t *>(dst + static_cast<size_t>(dy) * dstStride);
+        const float sy = m.top + (static_cast<float>(dy) + 0.5f) * m.scaleY - 0.5f;
+        if (m.identity) {
+            const auto *srcRow = reinterpret_cast<const uint32_t *>(src + static_cast<size_t>(static_cast<int32_t>(sy)) * srcStride);
+            std::memcpy(out, srcRow + static_cast<int32_t>(m.left), static_cast<size_t>(dstW) * 4u);
+        } else {
+            sampleRegionRow(src, srcStride, m, dy, out, dstW);
+        }
+    }
+}
+
+// =============================================================
+// 🔗 JNI: applyAdjustNative
 // =============================================================
 extern "C"
 JNIEXPORT jboolean JNICALL
 Java_com_core_adjust_AdjustProcessor_applyAdjustNative(JNIEnv *env, jobject /*thiz*/,
                                                        jobject context,
                                                        jobject bitmap,
-                                                       jobject paramsObj, jobject progressCb) {
+                                                       jobject paramsObj, jobject progressCb,
+                                                       jobject statsObj, jlong sourceId) {
     if (!bitmap || !paramsObj) return JNI_FALSE;
 
     // Initialize thread pool on demand
-    if (!gPool) {
-        const unsigned int hw = std::thread::hardware_concurrency();
-        const unsigned int n  = std::max(2u, (hw > 0 ? hw / 2 : 2u));
-        gPool = new ThreadPool(static_cast<size_t>(n));
-    }
+    const std::shared_ptr<ThreadPool> pool = ensurePool();
+    const MemoryCheckpoint memoryCheckpoint; // hết lời gọi (lease đã trả) -> giữ tổng trong budget
 
     // 1) Load params
     AdjustParams p{};
+    const ThreadLutPath lutPathBuf(p.lutPath);
     loadParamsFromJava(env, paramsObj, p);
+    if (p.geometry.active()) {
+        // Render tại chỗ giữ nguyên kích thước bitmap -> không có chỗ cho khung crop (applyAdjustRegionNative)
+        LOGE("applyAdjustNative: geometry (crop / rotate / flip / straighten) not supported in place");
+        return JNI_FALSE;
+    }
+    const uint64_t costMask = p.activeMask & kCostBits; // khoá cost model = mask phía Kotlin gửi xuống
 
     // 2) Read LUT path from paramsObj.lutPath and store into p.lutPath
-    std::string lutPath;
-    {
-        jclass cls = env->GetObjectClass(paramsObj);
-        jfieldID lutField = cls ? env->GetFieldID(cls, "lutPath", "Ljava/lang/String;") : nullptr;
-        if (lutField) {
-            jstring jstr = static_cast<jstring>(env->GetObjectField(paramsObj, lutField));
-            if (jstr) {
-                const char *cstr = env->GetStringUTFChars(jstr, nullptr);
-                if (cstr) { lutPath.assign(cstr); env->ReleaseStringUTFChars(jstr, cstr); }
-                DeleteLocalRefSafely(env, jstr);
-            }
-        }
-        DeleteLocalRefSafely(env, cls);
-    }
-    p.lutPath = lutPath; // must set before hashing
+    readLutPath(env, paramsObj, p.lutPath); // must set before hashing
+    const std::string &lutPath = p.lutPath;
+
+    // 3) Hash after we have lutPath; đường render (fixed / float) cũng đổi pixel output
+    const auto fixedMode = static_cast<uint32_t>(s_fixedMode.load(std::memory_order_relaxed));
+    const uint64_t hash = computeAdjustHash(p) ^ (uint64_t{fixedMode} * uint64_t{0x9E3779B97F4A7C15u});
 
-    // 3) Hash after we have lutPath
-    const uint64_t hash = computeAdjustHash(p);
-    const uint64_t last = s_lastHash.load(std::memory_order_relaxed);
-    if (hash == last) {
-        LOGI("🔁 Same hash detected — skip all processing");
-        return JNI_FALSE; // do not call progress on skip
+    // 4) Bitmap info (trước khi so hash: cùng params nhưng khác ảnh / kích thước thì không được skip)
+    AndroidBitmapInfo info{};
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) return JNI_FALSE;
+
+    // sourceId = 0 (thumbnail...): bitmap luôn là bản copy mới -> luôn render, không đụng hash của preview
+    if (sourceId != 0) {
+        uint64_t skipKey = hash;
+        for (const uint64_t v : {static_cast<uint64_t>(sourceId), static_cast<uint64_t>(info.width),
+                                 static_cast<uint64_t>(info.height)}) {
+            skipKey = (skipKey ^ v) * 1099511628211ull;
+        }
+        const uint64_t last = s_lastHash.load(std::memory_order_relaxed);
+        if (skipKey == last) {
+            LOGI("🔁 Same hash detected — skip all processing");
+            return JNI_FALSE; // do not call progress on skip
+        }
+        s_lastHash.store(skipKey, std::memory_order_relaxed);
     }
-    s_lastHash.store(hash, std::memory_order_relaxed);
 
-    // 4) No-op guard (reset = 0 or LUT amount == 0)
+    // 5) No-op guard (reset = 0 or LUT amount == 0)
     const bool hasLut = ((p.activeMask & MASK_LUT) && !lutPath.empty());
     if (isNoOp(p, hasLut)) {
         LOGI("No-op: all params 0 or LUT amount==0 -> skip");
         return JNI_FALSE;
     }
 
-    // 5) Prepare progress callback
+    // 6) Prepare progress callback
     jmethodID onProgress = nullptr;
     if (progressCb) {
         jclass cbCls = env->GetObjectClass(progressCb);
@@ -637,93 +1884,114 @@ Java_com_core_adjust_AdjustProcessor_applyAdjustNative(JNIEnv *env, jobject /*th
         DeleteLocalRefSafely(env, cbCls);
     }
 
-    // 6) Bitmap info
-    AndroidBitmapInfo info{};
-    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
-    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) return JNI_FALSE;
-
     void *pixels = nullptr;
     if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
     const bool premultiplied = (info.flags & ANDROID_BITMAP_FLAGS_ALPHA_PREMUL) != 0;
 
+    const int32_t W = static_cast<int32_t>(info.width);
+    const int32_t H = static_cast<int32_t>(info.height);
+    const int64_t total = static_cast<int64_t>(W) * static_cast<int64_t>(H);
+    const size_t stride = static_cast<size_t>(info.stride);
+
     // ---------------------------------------------------------
-    // 🎨 LUT Stage (apply BEFORE other adjusts) + lutAmount blend
+    // 🗃️ Render cache: state đã render gần đây -> copy thẳng, không render lại
+    // (sourceId = 0: caller không dùng cache, vd. thumbnail)
     // ---------------------------------------------------------
-    if ((p.activeMask & MASK_LUT) && !lutPath.empty() && p.lutAmount > 0.0f) {
-        LOGI("🎨 Applying LUT from path: %s with lutAmount=%.3f", lutPath.c_str(), p.lutAmount);
-        Lut3D lut;
-        if (loadTableFile(env, context, lutPath, lut)) {
-            s_lastLutPath = lutPath; // remember last LUT path
-
-            const int32_t W = static_cast<int32_t>(info.width);
-            const int32_t H = static_cast<int32_t>(info.height);
-            const int64_t total = static_cast<int64_t>(W) * static_cast<int64_t>(H);
-            const size_t stride = static_cast<size_t>(info.stride);
-
-            const unsigned int nThreads = std::max(1u, std::thread::hardware_concurrency());
-            const int64_t chunk = (total + static_cast<int64_t>(nThreads) - 1) / static_cast<int64_t>(nThreads);
-
-            for (unsigned int tIdx = 0; tIdx < nThreads; ++tIdx) {
-                const int64_t start = static_cast<int64_t>(tIdx) * chunk;
-                const int64_t end   = std::min<int64_t>(total, start + chunk);
-                if (start >= end) break;
-
-                gPool->enqueue([pixels, premultiplied, start, end, W, stride, &p, &lut]() {
-                    processLutRange(pixels, start, end, W, stride, p, lut, premultiplied);
-                });
+    RenderCacheKey cacheKey;
+    cacheKey.hash = hash;
+    cacheKey.sourceId = static_cast<int64_t>(sourceId);
+    cacheKey.width = W;
+    cacheKey.height = H;
+    if (sourceId != 0) {
+        RenderStats cachedStats;
+        if (renderCache().get(cacheKey, static_cast<uint8_t *>(pixels), stride,
+                              statsObj != nullptr, statsObj ? &cachedStats : nullptr)) {
+            LOGI("🗃️ Render cache hit");
+            if (onProgress) {
+                env->CallVoidMethod(progressCb, onProgress, static_cast<jint>(100));
+                if (env->ExceptionCheck()) env->ExceptionClear();
             }
+            AndroidBitmap_unlockPixels(env, bitmap);
+            if (statsObj) publishStats(env, statsObj, cachedStats);
+            return JNI_TRUE;
+        }
+    }
 
-            gPool->waitAll();
-            LOGI("✅ LUT applied successfully (multi-thread)");
+    // ---------------------------------------------------------
+    // 🎨 LUT: nạp 1 lần, áp trong cùng 1 pass với các adjust (mặc định đứng trước, xem plan)
+    // ---------------------------------------------------------
+    std::shared_ptr<const Lut3D> lut;
+    bool lutFailed = false; // kết quả thiếu LUT không được lưu dưới hash có LUT
+    if ((p.activeMask & MASK_LUT) && !lutPath.empty() && p.lutAmount > 0.0f) {
+        LOGI("🎨 Applying LUT from path: %s with lutAmount=%.3f", lutPath.c_str(), static_cast<double>(p.lutAmount));
+        if ((lut = acquireLut(env, context, lutPath))) {
+            s_lastLutPath = lutPath; // remember last LUT path
         } else {
             LOGE("❌ Failed to load LUT file: %s", lutPath.c_str());
+            p.activeMask &= ~MASK_LUT;
+            lutFailed = true;
         }
     } else {
         LOGI("⚠️ No LUT stage (mask off, empty path, or lutAmount==0)");
+        p.activeMask &= ~MASK_LUT;
     }
 
-    // Sau khi đã áp LUT (nếu có), vẫn có thể còn mask khác
-    uint64_t effectiveMask = p.activeMask;
+    // 🔇 Denoise: stage không gian, kernel point-wise không thấy bit này (vị trí của nó theo plan)
+    const DenoiseSettings denoise = denoiseSettings(p, 1.0f);
+    const PipelinePlan plan = compilePipeline(p.order, p.activeMask, denoise.halo());
+    p.activeMask &= ~MASK_DENOISE;
 
-    // Bỏ LUT ra để xem còn mask nào khác không
-    const uint64_t nonLutMask = effectiveMask & ~MASK_LUT;
-
-    // Nếu chỉ có LUT, không còn LIGHT/COLOR/DETAIL... thì không cần pass thứ 2
-    if (nonLutMask == 0) {
+    if ((p.activeMask & kStageBits) == 0 && !denoise.active()) {
         AndroidBitmap_unlockPixels(env, bitmap);
-        LOGI("Only LUT active -> skip adjust stage");
-        return JNI_TRUE; // ảnh đã thay đổi thật sự
+        LOGI("Nothing left to apply after LUT load -> skip render");
+        return JNI_TRUE;
     }
 
     // ---------------------------------------------------------
-    // APPLY ADJUSTS (multi-threaded) cho các mask còn lại (không gồm LUT)
+    // APPLY (multi-threaded): 1 pass đọc/ghi cho LUT + mọi adjust
     // ---------------------------------------------------------
-    const int32_t W = static_cast<int32_t>(info.width);
-    const int32_t H = static_cast<int32_t>(info.height);
-    const int64_t total = static_cast<int64_t>(W) * static_cast<int64_t>(H);
-    const size_t stride = static_cast<size_t>(info.stride);
+    RenderCtx ctx;
+    ctx.p = &p;
+    ctx.lut = lut.get();
+    ctx.lutT = clampf(p.lutAmount, 0.f, 1.f);
+    ctx.fullW = static_cast<float>(W);
+    ctx.fullH = static_cast<float>(H);
+    ctx.premultiplied = premultiplied;
+    bindPipeline(ctx, plan);
+    FixedPipeline fixed;
+    if (useFixedPath(ctx, fixed)) ctx.fixed = &fixed;
+    const FusedRowsFn kernel = ctx.fixed ? &fixedFusedRows : selectFusedRows(ctx);
 
     std::atomic<int64_t> doneCounter{0};
-    const unsigned int nThreads = std::max(1u, std::thread::hardware_concurrency());
-    const int64_t chunk = (total + static_cast<int64_t>(nThreads) - 1) / static_cast<int64_t>(nThreads);
-
-    // tạo bản sao params chỉ chứa nonLutMask
-    AdjustParams p2 = p;
-    p2.activeMask = nonLutMask;
-
-    for (unsigned int t = 0; t < nThreads; ++t) {
-        const int64_t start = static_cast<int64_t>(t) * chunk;
-        const int64_t end   = std::min<int64_t>(total, start + chunk);
-        if (start >= end) break;
-        gPool->enqueue([p2, pixels, premultiplied, start, end, W, H, stride, &doneCounter]() {
-            processRange(pixels, start, end, W, H, stride, p2, doneCounter, premultiplied);
-        });
+    const TaskPriority prio = t_priority;
+    const int32_t band = taskBandRows(H, W, prio);
+
+    // Per-task stats (chỉ mượn buffer khi caller yêu cầu)
+    TaskStats threadStats;
+    if (statsObj) threadStats.init(taskCount(H, band));
+
+    const auto renderStart = std::chrono::steady_clock::now();
+    TaskGroup group;
+    auto *base = static_cast<uint8_t *>(pixels);
+    BandEdgeSnapshot edges;
+    if (denoise.active()) snapshotBandEdges(base, stride, W, H, band, denoise.halo(), edges);
+    const RegionMapping imageCoords; // buffer = ảnh gốc
+    for (int32_t y0 = 0, t = 0; y0 < H; y0 += band, ++t) {
+        const int32_t y1 = std::min(H, y0 + band);
+        RenderStats *slot = threadStats.slot(t);
+        pool->enqueue([kernel, base, stride, W, H, y0, y1, &ctx, &doneCounter, slot, &denoise, &edges, &imageCoords]() {
+            if (!denoise.active()) {
+                kernel(base, stride, W, y0, y1, ctx, doneCounter, slot);
+                return;
+            }
+            denoiseBandInPlace(base, stride, W, H, y0, y1, edges, denoise, ctx, imageCoords,
+                               [&](int32_t a, int32_t b) { kernel(base, stride, W, a, b, ctx, doneCounter, slot); });
+        }, prio, &group);
     }
 
     // Progress polling (giảm spam: sleep lâu hơn, chỉ update khi nhảy >= 3%)
     int32_t lastPct = 0;
-    while (doneCounter.load(std::memory_order_relaxed) < total) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(12));
+    while (!group.waitFor(std::chrono::milliseconds(12))) {
         const int64_t done = doneCounter.load(std::memory_order_relaxed);
         const int32_t pct = static_cast<int32_t>((done * 100) / std::max<int64_t>(total, 1));
         if (onProgress && pct - lastPct >= 3) {
@@ -733,28 +2001,1395 @@ Java_com_core_adjust_AdjustProcessor_applyAdjustNative(JNIEnv *env, jobject /*th
         }
     }
 
-    gPool->waitAll();
+    group.wait();
+    renderCostModel().record(costMask, total, std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - renderStart).count());
 
     if (onProgress) {
         env->CallVoidMethod(progressCb, onProgress, static_cast<jint>(100));
         if (env->ExceptionCheck()) env->ExceptionClear();
     }
 
+    const RenderStats *merged = threadStats.empty() ? nullptr : &threadStats.merge();
+    if (sourceId != 0 && !lutFailed) renderCache().put(cacheKey, base, stride, merged);
+
     AndroidBitmap_unlockPixels(env, bitmap);
+    if (statsObj && merged) publishStats(env, statsObj, *merged);
     return JNI_TRUE; // ✅ Thông báo có thay đổi thật sự
 }
 
 // =============================================================
-// 🧹 JNI helpers
+// 🔍 JNI: applyAdjustRegionNative
+// Render riêng vùng [left, top, right, bottom) của ảnh gốc vào bitmap output
+// (kích thước output tuỳ ý). Chi phí tỉ lệ với số pixel output, không phải ảnh gốc.
+// Params có geometry -> khung crop của geometry thay cho vùng trên (adjust_geometry.h).
 // =============================================================
-extern "C" JNIEXPORT void JNICALL
-Java_com_core_adjust_AdjustProcessor_clearCache(JNIEnv *, jclass) {
-    s_lastHash.store(0ull, std::memory_order_relaxed);
-    s_lastLutPath.clear();
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_core_adjust_AdjustProcessor_applyAdjustRegionNative(JNIEnv *env, jobject /*thiz*/,
+                                                             jobject context,
+                                                             jobject srcBitmap,
+                                                             jobject dstBitmap,
+                                                             jobject paramsObj,
+                                                             jint left, jint top, jint right, jint bottom,
+                                                             jfloat sourceScale,
+                                                             jobject progressCb,
+                                                             jobject statsObj) {
+    if (!srcBitmap || !dstBitmap || !paramsObj) return JNI_FALSE;
+    const std::shared_ptr<ThreadPool> pool = ensurePool();
+    const MemoryCheckpoint memoryCheckpoint;
+
+    AdjustParams p{};
+    const ThreadLutPath lutPathBuf(p.lutPath);
+    loadParamsFromJava(env, paramsObj, p);
+    const uint64_t costMask = p.activeMask & kCostBits;
+    readLutPath(env, paramsObj, p.lutPath);
+
+    AndroidBitmapInfo srcInfo{}, dstInfo{};
+    if (AndroidBitmap_getInfo(env, srcBitmap, &srcInfo) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    if (AndroidBitmap_getInfo(env, dstBitmap, &dstInfo) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    if (srcInfo.format != ANDROID_BITMAP_FORMAT_RGBA_8888 || dstInfo.format != ANDROID_BITMAP_FORMAT_RGBA_8888) return JNI_FALSE;
+    if (dstInfo.width == 0 || dstInfo.height == 0) return JNI_FALSE;
+
+    const int32_t srcW = static_cast<int32_t>(srcInfo.width);
+    const int32_t srcH = static_cast<int32_t>(srcInfo.height);
+    const int32_t l = std::clamp<int32_t>(left, 0, srcW);
+    const int32_t tp = std::clamp<int32_t>(top, 0, srcH);
+    const int32_t r = std::clamp<int32_t>(right, l, srcW);
+    const int32_t b = std::clamp<int32_t>(bottom, tp, srcH);
+    if (r - l <= 0 || b - tp <= 0) return JNI_FALSE;
+
+    const int32_t dstW = static_cast<int32_t>(dstInfo.width);
+    const int32_t dstH = static_cast<int32_t>(dstInfo.height);
+
+    RegionMapping m;
+    m.left = static_cast<float>(l);
+    m.top = static_cast<float>(tp);
+    m.scaleX = static_cast<float>(r - l) / static_cast<float>(dstW);
+    m.scaleY = static_cast<float>(b - tp) / static_cast<float>(dstH);
+    m.srcW = srcW;
+    m.srcH = srcH;
+    m.identity = (r - l == dstW) && (b - tp == dstH);
+
+    // 📏 Geometry đứng đầu pipeline: khung crop (sau xoay 90° / lật / straighten) thay cho vùng
+    // [left, right) × [top, bottom); toạ độ stage tính theo khung crop, đơn vị pixel nguồn.
+    GeometryTransform geo;
+    if (p.geometry.active()) {
+        geo = buildGeometryTransform(p.geometry, srcW, srcH, dstW, dstH,
+                                     (srcInfo.flags & ANDROID_BITMAP_FLAGS_ALPHA_PREMUL) != 0);
+        m.geo = &geo;
+        m.identity = false;
+        m.left = m.top = 0.0f;
+        m.scaleX = geo.scaleX;
+        m.scaleY = geo.scaleY;
+    }
+
+    // LUT (nếu có) được áp ngay trong cùng pass với adjust
+    std::shared_ptr<const Lut3D> lut;
+    bool hasLut = false;
+    if ((p.activeMask & MASK_LUT) && !p.lutPath.empty() && p.lutAmount > 0.0f) {
+        hasLut = (lut = acquireLut(env, context, p.lutPath)) != nullptr;
+        if (!hasLut) LOGE("❌ Failed to load LUT file: %s", p.lutPath.c_str());
+    }
+    if (!hasLut) p.activeMask &= ~MASK_LUT;
+
+    // 🔇 Denoise theo độ phân giải output: preview proxy chỉ tốn chi phí của proxy, bán kính co theo tỉ lệ.
+    // sourceScale < 1: src đã là proxy thu nhỏ từ ảnh gốc (resampleNative) -> tính cả tỉ lệ đó.
+    const float srcScale = sourceScale > 0.0f ? std::min(static_cast<float>(sourceScale), 1.0f) : 1.0f;
+    const DenoiseSettings denoise = denoiseSettings(p, srcScale * std::min(1.0f / m.scaleX, 1.0f / m.scaleY));
+    const PipelinePlan plan = compilePipeline(p.order, p.activeMask, denoise.halo());
+    p.activeMask &= ~MASK_DENOISE;
+
+    jmethodID onProgress = nullptr;
+    if (progressCb) {
+        jclass cbCls = env->GetObjectClass(progressCb);
+        if (cbCls) onProgress = env->GetMethodID(cbCls, "onProgress", "(I)V");
+        DeleteLocalRefSafely(env, cbCls);
+    }
+
+    void *srcPixels = nullptr;
+    void *dstPixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, srcBitmap, &srcPixels) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    if (AndroidBitmap_lockPixels(env, dstBitmap, &dstPixels) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        AndroidBitmap_unlockPixels(env, srcBitmap);
+        return JNI_FALSE;
+    }
+    const bool premultiplied = (srcInfo.flags & ANDROID_BITMAP_FLAGS_ALPHA_PREMUL) != 0;
+    const size_t srcStride = static_cast<size_t>(srcInfo.stride);
+    const size_t dstStride = static_cast<size_t>(dstInfo.stride);
+    const int64_t total = static_cast<int64_t>(dstW) * static_cast<int64_t>(dstH);
+
+    const TaskPriority prio = t_priority;
+    const int32_t band = taskBandRows(dstH, dstW, prio);
+    TaskStats threadStats;
+    if (statsObj) threadStats.init(taskCount(dstH, band));
+    std::atomic<int64_t> doneCounter{0};
+
+    RenderCtx ctx;
+    ctx.p = &p;
+    ctx.lut = lut.get();
+    ctx.lutT = clampf(p.lutAmount, 0.f, 1.f);
+    ctx.fullW = m.geo ? geo.frameW : static_cast<float>(srcW);
+    ctx.fullH = m.geo ? geo.frameH : static_cast<float>(srcH);
+    ctx.premultiplied = premultiplied;
+    bindPipeline(ctx, plan);
+    FixedPipeline fixed;
+    if (useFixedPath(ctx, fixed)) ctx.fixed = &fixed;
+    const RegionRowsFn kernel = ctx.fixed ? &fixedRegionRows : selectRegionRows(ctx);
+
+    const auto renderStart = std::chrono::steady_clock::now();
+    const auto *src = static_cast<const uint8_t *>(srcPixels);
+    auto *dst = static_cast<uint8_t *>(dstPixels);
+
+    // Denoise: lấy mẫu vùng vào dst trước, rồi denoise + point-wise in-place trên dst.
+    // Kernel đọc lại dst: 1:1 qua gốc toạ độ (left, top), khác tỉ lệ qua presampled.
+    RegionMapping km = m;
+    const uint8_t *kernelSrc = src;
+    size_t kernelStride = srcStride;
+    BandEdgeSnapshot edges;
+    if (denoise.active()) {
+        TaskGroup sampleGroup;
+        for (int32_t y0 = 0; y0 < dstH; y0 += band) {
+            const int32_t y1 = std::min(dstH, y0 + band);
+            pool->enqueue([src, srcStride, dst, dstStride, dstW, y0, y1, &m]() {
+                sampleRegionRows(src, srcStride, dst, dstStride, dstW, y0, y1, m);
+            }, prio, &sampleGroup);
+        }
+        sampleGroup.wait();
+        snapshotBandEdges(dst, dstStride, dstW, dstH, band, denoise.halo(), edges);
+        if (m.identity) {
+            km.srcOriginX = l;
+            km.srcOriginY = tp;
+        } else {
+            km.presampled = true;
+        }
+        kernelSrc = dst;
+        kernelStride = dstStride;
+    }
+
+    TaskGroup group;
+    for (int32_t y0 = 0, t = 0; y0 < dstH; y0 += band, ++t) {
+        const int32_t y1 = std::min(dstH, y0 + band);
+        RenderStats *slot = threadStats.slot(t);
+        pool->enqueue([kernel, kernelSrc, kernelStride, dst, dstStride, dstW, dstH, y0, y1, &m, &km, &ctx,
+                        &doneCounter, slot, &denoise, &edges]() {
+            auto pointRows = [&](int32_t rowA, int32_t rowB) {
+                kernel(kernelSrc, kernelStride, dst, dstStride, dstW, rowA, rowB, km, ctx, doneCounter, slot);
+            };
+            if (!denoise.active()) {
+                pointRows(y0, y1);
+                return;
+            }
+            denoiseBandInPlace(dst, dstStride, dstW, dstH, y0, y1, edges, denoise, ctx, m, pointRows);
+        }, prio, &group);
+    }
+
+    int32_t lastPct = 0;
+    while (!group.waitFor(std::chrono::milliseconds(12))) {
+        const int64_t done = doneCounter.load(std::memory_order_relaxed);
+        const int32_t pct = static_cast<int32_t>((done * 100) / std::max<int64_t>(total, 1));
+        if (onProgress && pct - lastPct >= 3) {
+            lastPct = pct;
+            env->CallVoidMethod(progressCb, onProgress, static_cast<jint>(pct));
+            if (env->ExceptionCheck()) env->ExceptionClear();
+        }
+    }
+    group.wait();
+    renderCostModel().record(costMask, total, std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - renderStart).count());
+
+    if (onProgress) {
+        env->CallVoidMethod(progressCb, onProgress, static_cast<jint>(100));
+        if (env->ExceptionCheck()) env->ExceptionClear();
+    }
+
+    AndroidBitmap_unlockPixels(env, dstBitmap);
+    AndroidBitmap_unlockPixels(env, srcBitmap);
+    if (statsObj && !threadStats.empty()) publishStats(env, statsObj, threadStats.merge());
+    return JNI_TRUE;
+}
+
+// =============================================================
+// 🎞️ JNI: processStreamNative (strip streaming, bộ nhớ ~ stripHeight × width)
+// Pixel đi theo dải hàng: StripSource.readStrip -> pipeline -> StripSink.writeStrip.
+// Cả 2 callback nhận DirectByteBuffer trỏ thẳng vào buffer native (RGBA_8888, không copy JNI).
+// =============================================================
+
+// Số hàng halo mà các stage không gian cần đọc thêm ở trên/dưới mỗi dải.
+// Hiện chỉ có denoise; stage không gian mới khai báo halo tại đây.
+static int32_t spatialHaloRows(const DenoiseSettings &denoise) {
+    return denoise.active() ? denoise.halo() : 0;
+}
+
+static bool callStripCallback(JNIEnv *env, jobject cb, jmethodID mid,
+                              int32_t top, int32_t rows, uint8_t *data, size_t bytes) {
+    jobject buf = env->NewDirectByteBuffer(data, static_cast<jlong>(bytes));
+    if (!buf) return false;
+    const jboolean ok = env->CallBooleanMethod(cb, mid, static_cast<jint>(top), static_cast<jint>(rows), buf);
+    DeleteLocalRefSafely(env, buf);
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        return false;
+    }
+    return ok == JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_core_adjust_AdjustProcessor_processStreamNative(JNIEnv *env, jobject /*thiz*/,
+                                                         jobject context,
+                                                         jint width, jint height,
+                                                         jobject paramsObj,
+                                                         jobject source, jobject sink,
+                                                         jint stripHeight,
+                                                         jboolean premultipliedJ,
+                                                         jobject progressCb) {
+    if (!paramsObj || !source || !sink || width <= 0 || height <= 0) return JNI_FALSE;
+    const std::shared_ptr<ThreadPool> pool = ensurePool();
+    const MemoryCheckpoint memoryCheckpoint;
+
+    AdjustParams p{};
+    const ThreadLutPath lutPathBuf(p.lutPath);
+    loadParamsFromJava(env, paramsObj, p);
+    if (p.geometry.active()) {
+        // Xoay 90° / straighten: 1 dải output cần cột / vùng nghiêng của cả ảnh nguồn -> không stream theo dải được
+        LOGE("processStreamNative: geometry (crop / rotate / flip / straighten) not supported when streaming");
+        return JNI_FALSE;
+    }
+    readLutPath(env, paramsObj, p.lutPath);
+
+    std::shared_ptr<const Lut3D> lut;
+    bool hasLut = false;
+    if ((p.activeMask & MASK_LUT) && !p.lutPath.empty() && p.lutAmount > 0.0f) {
+        hasLut = (lut = acquireLut(env, context, p.lutPath)) != nullptr;
+        if (!hasLut) LOGE("❌ Failed to load LUT file: %s", p.lutPath.c_str());
+    }
+    if (!hasLut) p.activeMask &= ~MASK_LUT;
+
+    jmethodID readStrip = nullptr, writeStrip = nullptr, onProgress = nullptr;
+    {
+        jclass srcCls = env->GetObjectClass(source);
+        if (srcCls) readStrip = env->GetMethodID(srcCls, "readStrip", "(IILjava/nio/ByteBuffer;)Z");
+        DeleteLocalRefSafely(env, srcCls);
+        jclass sinkCls = env->GetObjectClass(sink);
+        if (sinkCls) writeStrip = env->GetMethodID(sinkCls, "writeStrip", "(IILjava/nio/ByteBuffer;)Z");
+        DeleteLocalRefSafely(env, sinkCls);
+        if (progressCb) {
+            jclass cbCls = env->GetObjectClass(progressCb);
+            if (cbCls) onProgress = env->GetMethodID(cbCls, "onProgress", "(I)V");
+            DeleteLocalRefSafely(env, cbCls);
+        }
+    }
+    if (!readStrip || !writeStrip) {
+        if (env->ExceptionCheck()) env->ExceptionClear();
+        LOGE("StripSource/StripSink methods not found");
+        return JNI_FALSE;
+    }
+
+    const int32_t W = width;
+    const int32_t H = height;
+    const int32_t stripH = std::clamp<int32_t>(stripHeight, 1, H);
+    const DenoiseSettings denoise = denoiseSettings(p, 1.0f);
+    const PipelinePlan plan = compilePipeline(p.order, p.activeMask, denoise.halo());
+    p.activeMask &= ~MASK_DENOISE;
+    const int32_t halo = spatialHaloRows(denoise);
+    const size_t rowBytes = static_cast<size_t>(W) * 4u;
+    const bool premultiplied = premultipliedJ == JNI_TRUE;
+
+    // window: các hàng nguồn [winTop, winTop + winRows) gồm dải hiện tại + halo 2 phía
+    // out: dải kết quả, gửi cho sink. Mọi buffer mượn từ scratchArena() (export liên tiếp dùng lại).
+    const ScratchArena::Lease windowLease = scratchArena().borrow(static_cast<size_t>(stripH + 2 * halo) * rowBytes);
+    const ScratchArena::Lease outLease = scratchArena().borrow(static_cast<size_t>(stripH) * rowBytes);
+    const ScratchArena::Lease denoisedLease = scratchArena().borrow(denoise.active() ? static_cast<size_t>(stripH) * rowBytes : 0u);
+    const ScratchArena::Lease rowPtrsLease = scratchArena().borrow(denoise.active() ? static_cast<size_t>(stripH + 2 * halo) * sizeof(const uint32_t *) : 0u);
+    if (!windowLease || !outLease || (denoise.active() && (!denoisedLease || !rowPtrsLease))) {
+        LOGE("Out of memory for %d-row strips", stripH);
+        return JNI_FALSE;
+    }
+    uint8_t *window = windowLease.as<uint8_t>();
+    auto **winRowPtrs = rowPtrsLease.as<const uint32_t *>();
+    int32_t winTop = 0;
+    int32_t winRows = 0;
+
+    RegionMapping m;
+    m.srcW = W;
+    m.srcH = H;
+    m.identity = true;
+
+    RenderCtx ctx;
+    ctx.p = &p;
+    ctx.lut = lut.get();
+    ctx.lutT = clampf(p.lutAmount, 0.f, 1.f);
+    ctx.fullW = static_cast<float>(W);
+    ctx.fullH = static_cast<float>(H);
+    ctx.premultiplied = premultiplied;
+    bindPipeline(ctx, plan);
+    FixedPipeline fixed;
+    if (useFixedPath(ctx, fixed)) ctx.fixed = &fixed;
+    const RegionRowsFn kernel = ctx.fixed ? &fixedRegionRows : selectRegionRows(ctx);
+
+    const TaskPriority prio = t_priority;
+    std::atomic<int64_t> doneCounter{0};
+    int32_t lastPct = 0;
+
+    for (int32_t y0 = 0; y0 < H; y0 += stripH) {
+        const int32_t y1 = std::min(H, y0 + stripH);
+        const int32_t needTop = std::max(0, y0 - halo);
+        const int32_t needBottom = std::min(H, y1 + halo);
+
+        // Giữ lại phần halo đã đọc (trượt cửa sổ), chỉ kéo thêm các hàng mới
+        const int32_t keepFrom = std::max(needTop, winTop);
+        const int32_t keepTo = std::min(needBottom, winTop + winRows);
+        if (keepTo > keepFrom && keepFrom > winTop) {
+            std::memmove(window,
+                         window + static_cast<size_t>(keepFrom - winTop) * rowBytes,
+                         static_cast<size_t>(keepTo - keepFrom) * rowBytes);
+        }
+        const int32_t have = keepTo > keepFrom ? keepTo - keepFrom : 0;
+        winTop = needTop;
+        winRows = have;
+        const int32_t fetchTop = needTop + have;
+        const int32_t fetchRows = needBottom - fetchTop;
+        if (fetchRows > 0) {
+            uint8_t *dst = window + static_cast<size_t>(have) * rowBytes;
+            if (!callStripCallback(env, source, readStrip, fetchTop, fetchRows, dst,
+                                   static_cast<size_t>(fetchRows) * rowBytes)) {
+                LOGE("StripSource.readStrip failed at row %d", fetchTop);
+                return JNI_FALSE;
+            }
+            winRows += fetchRows;
+        }
+
+        // Pipeline cho các hàng [y0, y1) -> out (toạ độ vignette/grain theo ảnh đầy đủ)
+        // top = y0: hàng dy của out ứng với hàng ảnh gốc y0 + dy
+        // Denoise (nếu bật): cửa sổ chỉ đọc -> mỗi task lọc hàng của mình vào `denoised`,
+        // kernel point-wise đọc từ đó (hàng 0 của denoised = hàng y0)
+        m.top = static_cast<float>(y0);
+        m.srcOriginY = denoise.active() ? y0 : winTop;
+        const int32_t rows = y1 - y0;
+        const int32_t band = taskBandRows(rows, W, prio);
+        const uint8_t *winData = window;
+        uint8_t *outData = outLease.as<uint8_t>();
+        uint8_t *denoisedData = denoisedLease.as<uint8_t>();
+        if (denoise.active()) {
+            for (int32_t i = 0; i < winRows; ++i) {
+                winRowPtrs[i] = reinterpret_cast<const uint32_t *>(winData + static_cast<size_t>(i) * rowBytes);
+            }
+        }
+        const uint32_t *const *rowPtrs = winRowPtrs;
+        TaskGroup group;
+        for (int32_t r0 = 0; r0 < rows; r0 += band) {
+            const int32_t r1 = std::min(rows, r0 + band);
+            pool->enqueue([kernel, winData, outData, denoisedData, rowPtrs, winTop, rowBytes, W, H, y0, r0, r1,
+                            premultiplied, &m, &ctx, &doneCounter, &denoise]() {
+                if (!denoise.active()) {
+                    kernel(winData, rowBytes, outData, rowBytes, W, r0, r1, m, ctx, doneCounter, nullptr);
+                    return;
+                }
+                if (ctx.preCount == 0) {
+                    denoiseRect(rowPtrs, winTop, W, H, 0, y0 + r0, W, y0 + r1, denoise, premultiplied,
+                                denoisedData + static_cast<size_t>(r0) * rowBytes, rowBytes);
+                } else {
+                    // Cửa sổ dùng chung giữa các task -> mỗi task áp nhóm pre lên bản riêng của hàng nó đọc
+                    const int32_t top = std::max(0, y0 + r0 - denoise.halo());
+                    const int32_t count = std::min(H, y0 + r1 + denoise.halo()) - top;
+                    const ScratchArena::Lease ptrsLease = scratchArena().borrow(static_cast<size_t>(count) * sizeof(const uint32_t *));
+                    const ScratchArena::Lease preLease = scratchArena().borrow(static_cast<size_t>(count) * rowBytes);
+                    auto **pre = ptrsLease.as<const uint32_t *>();
+                    std::copy(rowPtrs + (top - winTop), rowPtrs + (top - winTop) + count, pre);
+                    preSpatialRows(pre, top, count, 0, W, W, RegionMapping(), ctx, preLease.as<uint32_t>());
+                    denoiseRect(pre, top, W, H, 0, y0 + r0, W, y0 + r1, denoise, premultiplied,
+                                denoisedData + static_cast<size_t>(r0) * rowBytes, rowBytes);
+                }
+                kernel(denoisedData, rowBytes, outData, rowBytes, W, r0, r1, m, ctx, doneCounter, nullptr);
+            }, prio, &group);
+        }
+        group.wait();
+
+        if (!callStripCallback(env, sink, writeStrip, y0, rows, outData,
+                               static_cast<size_t>(rows) * rowBytes)) {
+            LOGE("StripSink.writeStrip failed at row %d", y0);
+            return JNI_FALSE;
+        }
+
+        if (onProgress) {
+            const int32_t pct = static_cast<int32_t>((static_cast<int64_t>(y1) * 100) / H);
+            if (pct - lastPct >= 3 || y1 == H) {
+                lastPct = pct;
+                env->CallVoidMethod(progressCb, onProgress, static_cast<jint>(pct));
+                if (env->ExceptionCheck()) env->ExceptionClear();
+            }
+        }
+    }
+    return JNI_TRUE;
+}
+
+// =============================================================
+// 📹 JNI: applyAdjustYuvNative (frame camera / video, xem adjust_yuv.h)
+// 1 pass cho mỗi khối kYuvChunkRows hàng: YUV -> RGBA -> LUT + adjust -> bitmap RGBA hoặc YUV.
+// Ra bitmap: đổi màu thẳng vào hàng của bitmap rồi chạy kernel in-place (không buffer trung gian).
+// Ra YUV: mỗi task mượn 1 khối RGBA từ scratchArena() -> frame liên tiếp không cấp phát.
+// dst có thể trùng src (lọc in-place): khối hàng chẵn -> hàng chroma của mỗi khối không giao nhau.
+// Denoise (stage không gian) không chạy trên frame: giữ latency ổn định cho preview 30 fps.
+// =============================================================
+static constexpr int32_t kYuvChunkRows = 16; // chẵn; 1080p: 16 × 1920 × 4 = 120 KB, nằm gọn trong L2
+
+static bool readYuvFrame(JNIEnv *env, jobject frameObj, YuvPlanes &f, YuvColorSpace &cs) {
+    f.width = getIntField(env, frameObj, "width");
+    f.height = getIntField(env, frameObj, "height");
+    int64_t yCap = 0, uCap = 0, vCap = 0;
+    f.y = getDirectBufferField(env, frameObj, "y", yCap);
+    f.u = getDirectBufferField(env, frameObj, "u", uCap);
+    f.v = getDirectBufferField(env, frameObj, "v", vCap);
+    f.yStride = getIntField(env, frameObj, "yStride");
+    f.uvStride = getIntField(env, frameObj, "uvStride");
+    f.uvPixelStride = getIntField(env, frameObj, "uvPixelStride");
+    cs = static_cast<YuvColorSpace>(std::clamp(getIntField(env, frameObj, "colorSpace"),
+                                               static_cast<int32_t>(YUV_BT601_FULL),
+                                               static_cast<int32_t>(YUV_BT709_LIMITED)));
+    if (env->ExceptionCheck()) env->ExceptionClear();
+    if (!yuvPlanesValid(f)) return false;
+
+    // Hàng cuối không cần đủ stride (Image của camera thường cắt padding ở hàng cuối)
+    const int64_t chromaW = (f.width + 1) / 2;
+    const int64_t chromaH = (f.height + 1) / 2;
+    const int64_t yNeed = static_cast<int64_t>(f.height - 1) * f.yStride + f.width;
+    const int64_t uvNeed = (chromaH - 1) * f.uvStride + (chromaW - 1) * f.uvPixelStride + 1;
+    return yCap >= yNeed && uCap >= uvNeed && vCap >= uvNeed;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_core_adjust_AdjustProcessor_applyAdjustYuvNative(JNIEnv *env, jobject /*thiz*/,
+                                                          jobject context,
+                                                          jobject srcFrame,
+                                                          jobject dstFrame,
+                                                          jobject dstBitmap,
+                                                          jobject paramsObj) {
+    if (!srcFrame || !paramsObj || (!dstFrame == !dstBitmap)) return JNI_FALSE;
+    const std::shared_ptr<ThreadPool> pool = ensurePool();
+    const MemoryCheckpoint memoryCheckpoint;
+
+    YuvPlanes src{}, dstYuv{};
+    YuvColorSpace srcCs = YUV_BT601_FULL, dstCs = YUV_BT601_FULL;
+    if (!readYuvFrame(env, srcFrame, src, srcCs)) {
+        LOGE("YuvFrame nguồn không hợp lệ (cần direct ByteBuffer)");
+        return JNI_FALSE;
+    }
+    const int32_t W = src.width;
+    const int32_t H = src.height;
+    if (dstFrame && (!readYuvFrame(env, dstFrame, dstYuv, dstCs) || dstYuv.width != W || dstYuv.height != H)) {
+        LOGE("YuvFrame đích không hợp lệ hoặc khác kích thước %dx%d", W, H);
+        return JNI_FALSE;
+    }
+
+    AdjustParams p{};
+    const ThreadLutPath lutPathBuf(p.lutPath);
+    loadParamsFromJava(env, paramsObj, p);
+    readLutPath(env, paramsObj, p.lutPath);
+
+    std::shared_ptr<const Lut3D> lut;
+    bool hasLut = false;
+    if ((p.activeMask & MASK_LUT) && !p.lutPath.empty() && p.lutAmount > 0.0f) {
+        hasLut = (lut = acquireLut(env, context, p.lutPath)) != nullptr;
+        if (!hasLut) LOGE("❌ Failed to load LUT file: %s", p.lutPath.c_str());
+    }
+    if (!hasLut) p.activeMask &= ~MASK_LUT;
+    p.activeMask &= ~MASK_DENOISE;
+
+    uint8_t *bitmapPixels = nullptr;
+    size_t bitmapStride = 0;
+    if (dstBitmap) {
+        AndroidBitmapInfo info{};
+        if (AndroidBitmap_getInfo(env, dstBitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+        if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) return JNI_FALSE;
+        if (static_cast<int32_t>(info.width) != W || static_cast<int32_t>(info.height) != H) {
+            LOGE("Bitmap %ux%u khác kích thước frame %dx%d", info.width, info.height, W, H);
+            return JNI_FALSE;
+        }
+        void *pixels = nullptr;
+        if (AndroidBitmap_lockPixels(env, dstBitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+        bitmapPixels = static_cast<uint8_t *>(pixels);
+        bitmapStride = static_cast<size_t>(info.stride);
+    }
+
+    // Alpha luôn 255 -> premultiplied hay không đều như nhau
+    RenderCtx ctx;
+    ctx.p = &p;
+    ctx.lut = lut.get();
+    ctx.lutT = clampf(p.lutAmount, 0.f, 1.f);
+    ctx.fullW = static_cast<float>(W);
+    ctx.fullH = static_cast<float>(H);
+    ctx.premultiplied = false;
+    const PipelinePlan plan = compilePipeline(p.order, p.activeMask, 0);
+    bindPipeline(ctx, plan);
+    FixedPipeline fixed;
+    if (useFixedPath(ctx, fixed)) ctx.fixed = &fixed;
+    const RegionRowsFn kernel = ctx.fixed ? &fixedRegionRows : selectRegionRows(ctx);
+
+    const YuvMatrix toRgb = yuvMatrix(srcCs);
+    const YuvMatrix toYuv = yuvMatrix(dstCs);
+    const size_t rowBytes = static_cast<size_t>(W) * 4u;
+
+    const TaskPriority prio = t_priority;
+    const int32_t band = (taskBandRows(H, W, prio) + 1) & ~1;
+    std::atomic<int64_t> doneCounter{0};
+    std::atomic<bool> failed{false};
+
+    TaskGroup group;
+    for (int32_t y0 = 0; y0 < H; y0 += band) {
+        const int32_t y1 = std::min(H, y0 + band);
+        pool->enqueue([kernel, bitmapPixels, bitmapStride, rowBytes, W, H, y0, y1, &src, &dstYuv,
+                        &toRgb, &toYuv, &ctx, &doneCounter, &failed]() {
+            ScratchArena::Lease chunkLease;
+            if (!bitmapPixels) {
+                chunkLease = scratchArena().borrow(static_cast<size_t>(std::min(kYuvChunkRows, y1 - y0)) * rowBytes);
+                if (!chunkLease) {
+                    failed.store(true, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            RegionMapping m;
+            m.srcW = W;
+            m.srcH = H;
+            m.identity = true;
+            for (int32_t a = y0; a < y1; a += kYuvChunkRows) {
+                const int32_t b = std::min(y1, a + kYuvChunkRows);
+                uint8_t *rgba = bitmapPixels ? bitmapPixels + static_cast<size_t>(a) * bitmapStride
+                                             : chunkLease.as<uint8_t>();
+                const size_t stride = bitmapPixels ? bitmapStride : rowBytes;
+                yuvToRgbaRows(src, toRgb, a, b, rgba, stride);
+                // hàng dy của khối = hàng ảnh a + dy (vignette/grain theo toạ độ frame)
+                m.top = static_cast<float>(a);
+                m.srcOriginY = a;
+                kernel(rgba, stride, rgba, stride, W, 0, b - a, m, ctx, doneCounter, nullptr);
+                if (!bitmapPixels) rgbaToYuvRows(rgba, stride, toYuv, a, b, dstYuv);
+            }
+        }, prio, &group);
+    }
+    group.wait();
+
+    if (dstBitmap) AndroidBitmap_unlockPixels(env, dstBitmap);
+    if (failed.load(std::memory_order_relaxed)) {
+        LOGE("Out of memory for %d-row YUV chunks", kYuvChunkRows);
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+// =============================================================
+// 🖌️ Local adjustments
+// Session giữ danh sách layer (AdjustParams riêng + mask dạng tile); handle jlong = con trỏ LocalSession.
+// Các lời gọi trên cùng 1 session phải tuần tự (LocalAdjustSession phía Kotlin đảm bảo).
+// Render theo tile 64×64: pipeline global chạy trên mọi tile cần vẽ, layer chỉ chạy trên tile
+// mà mask chạm tới (EMPTY -> bỏ qua, FULL -> không cần đọc trọng số).
+// =============================================================
+using LocalPixelFn = uint32_t (*)(uint32_t, float, float, const RenderCtx &, RenderStats *);
+
+// Mỗi layer có thứ tự stage riêng (params.order) -> plan + kernel riêng, ctx.ops trỏ vào plan của chính nó
+struct LocalRenderLayer {
+    const TiledMask *mask = nullptr;
+    PipelinePlan plan;
+    RenderCtx ctx;
+    LocalPixelFn pixel = nullptr;
+};
+
+static inline LocalSession *sessionFromHandle(jlong handle) {
+    return reinterpret_cast<LocalSession *>(static_cast<intptr_t>(handle));
+}
+
+static jintArray toRectArray(JNIEnv *env, const TileRect &r) {
+    if (r.empty()) return nullptr;
+    const jint v[4] = {r.left, r.top, r.right, r.bottom};
+    jintArray arr = env->NewIntArray(4);
+    if (arr) env->SetIntArrayRegion(arr, 0, 4, v);
+    return arr;
+}
+
+// lerp theo trọng số mask (0..255) trên 3 kênh màu; alpha giữ nguyên
+static inline uint32_t blendByWeight(uint32_t base, uint32_t local, uint32_t w) {
+    uint32_t out = base & 0xFF000000u;
+    for (uint32_t shift = 0; shift < 24; shift += 8) {
+        const uint32_t a = (base >> shift) & 0xFFu;
+        const uint32_t b = (local >> shift) & 0xFFu;
+        out |= ((a * (255u - w) + b * w + 127u) / 255u) << shift;
+    }
+    return out;
+}
+
+static void renderLocalTile(const uint8_t *src, size_t srcStride, uint8_t *dst, size_t dstStride,
+                            int32_t tx, int32_t ty, int32_t width, int32_t height,
+                            RegionRowsFn globalKernel, const RenderCtx &globalCtx,
+                            const DenoiseSettings &denoise,
+                            const ScratchArray<LocalRenderLayer> &layers,
+                            std::atomic<int64_t> &doneCounter) {
+    const int32_t x0 = tx * kMaskTileSize;
+    const int32_t y0 = ty * kMaskTileSize;
+    const int32_t x1 = std::min(width, x0 + kMaskTileSize);
+    const int32_t y1 = std::min(height, y0 + kMaskTileSize);
+
+    // 1) Pipeline global: src -> dst, 1:1 theo toạ độ ảnh gốc (khớp full render)
+    RegionMapping m;
+    m.left = static_cast<float>(x0);
+    m.srcW = width;
+    m.srcH = height;
+    m.identity = true;
+    if (denoise.active()) {
+        // src chỉ đọc -> lọc tile (kèm halo đọc thẳng từ src) vào buffer riêng rồi chạy point-wise
+        const size_t tileStride = static_cast<size_t>(kMaskTileSize) * 4u;
+        const int32_t top = std::max(0, y0 - denoise.halo());
+        const int32_t bottom = std::min(height, y1 + denoise.halo());
+        const ScratchArena::Lease tileBuf = scratchArena().borrow(static_cast<size_t>(kMaskTileSize) * tileStride);
+        const ScratchArena::Lease rowPtrsBuf = scratchArena().borrow(static_cast<size_t>(bottom - top) * sizeof(const uint32_t *));
+        auto **rowPtrs = rowPtrsBuf.as<const uint32_t *>();
+        for (int32_t y = top; y < bottom; ++y) {
+            rowPtrs[y - top] = reinterpret_cast<const uint32_t *>(src + static_cast<size_t>(y) * srcStride);
+        }
+        ScratchArena::Lease preBuf;
+        if (globalCtx.preCount > 0) {
+            preBuf = scratchArena().borrow(static_cast<size_t>(bottom - top) * static_cast<size_t>(width) * 4u);
+            preSpatialRows(rowPtrs, top, bottom - top, std::max(0, x0 - denoise.halo()),
+                           std::min(width, x1 + denoise.halo()), width, RegionMapping(), globalCtx, preBuf.as<uint32_t>());
+        }
+        denoiseRect(rowPtrs, top, width, height, x0, y0, x1, y1, denoise, globalCtx.premultiplied,
+                    tileBuf.as<uint8_t>(), tileStride);
+        m.srcOriginX = x0;
+        m.srcOriginY = y0;
+        globalKernel(tileBuf.as<const uint8_t>(), tileStride,
+                     dst + static_cast<size_t>(x0) * 4u, dstStride, x1 - x0, y0, y1,
+                     m, globalCtx, doneCounter, nullptr);
+    } else {
+        globalKernel(src, srcStride, dst + static_cast<size_t>(x0) * 4u, dstStride, x1 - x0, y0, y1,
+                     m, globalCtx, doneCounter, nullptr);
+    }
+
+    // 2) Các layer local, áp chồng lên kết quả global trong bbox của mask
+    for (const LocalRenderLayer &layer : layers) {
+        const MaskTile &t = layer.mask->tile(tx, ty);
+        if (t.state == TILE_EMPTY) continue;
+        for (int32_t y = y0 + t.y0; y < y0 + t.y1; ++y) {
+            auto *row = reinterpret_cast<uint32_t *>(dst + static_cast<size_t>(y) * dstStride);
+            const uint8_t *wRow = t.weights ? t.weights.get() + (y - y0) * kMaskTileSize : nullptr;
+            const float fy = static_cast<float>(y);
+            for (int32_t x = x0 + t.x0; x < x0 + t.x1; ++x) {
+                const uint32_t w = wRow ? wRow[x - x0] : 255u;
+                if (w == 0u) continue;
+                const uint32_t c = row[x];
+                const uint32_t adj = layer.pixel(c, static_cast<float>(x), fy, layer.ctx, nullptr);
+                row[x] = (w == 255u) ? adj : blendByWeight(c, adj, w);
+            }
+        }
+    }
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_core_adjust_AdjustProcessor_createLocalSessionNative(JNIEnv *, jobject /*thiz*/,
+                                                              jint width, jint height) {
+    if (width <= 0 || height <= 0) return 0;
+    auto *session = new LocalSession();
+    session->width = width;
+    session->height = height;
+    registerMemoryConsumers();
+    noteSessionBytes(session);
+    return static_cast<jlong>(reinterpret_cast<intptr_t>(session));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_core_adjust_AdjustProcessor_releaseLocalSessionNative(JNIEnv *, jobject /*thiz*/, jlong handle) {
+    LocalSession *session = sessionFromHandle(handle);
+    if (!session) return;
+    noteSessionBytes(session, true);
+    delete session;
+}
+
+// Tạo/cập nhật layer. geometry: RADIAL = [cx, cy, rx, ry, angleDeg, feather], LINEAR = [x0, y0, x1, y1],
+// BRUSH = null (giữ nét đã vẽ nếu layer vốn là brush). Trả về vùng cần render lại (mask cũ ∪ mask mới).
+extern "C"
+JNIEXPORT jintArray JNICALL
+Java_com_core_adjust_AdjustProcessor_setLocalLayerNative(JNIEnv *env, jobject /*thiz*/,
+                                                         jlong handle, jint index, jint type,
+                                                         jfloatArray geometry, jboolean invert,
+                                                         jobject paramsObj) {
+    LocalSession *session = sessionFromHandle(handle);
+    if (!session || !paramsObj) return nullptr;
+    if (index < 0 || index >= kMaxLocalLayers) return nullptr;
+    if (type < LOCAL_MASK_RADIAL || type > LOCAL_MASK_BRUSH) return nullptr;
+    LocalLayer *layer = session->layer(index, true);
+    if (!layer) return nullptr;
+
+    const TileRect before = layer->mask.coverage();
+
+    AdjustParams p{};
+    loadParamsFromJava(env, paramsObj, p);
+    p.activeMask &= ~MASK_LUT; // layer local không áp LUT
+    layer->params = p;
+
+    float g[6] = {0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+    if (geometry) {
+        const jsize n = std::min<jsize>(env->GetArrayLength(geometry), 6);
+        env->GetFloatArrayRegion(geometry, 0, n, g);
+    }
+
+    const auto maskType = static_cast<LocalMaskType>(type);
+    switch (maskType) {
+        case LOCAL_MASK_RADIAL:
+            layer->mask.buildRadial(g[0], g[1], g[2], g[3], g[4], g[5], invert == JNI_TRUE);
+            break;
+        case LOCAL_MASK_LINEAR:
+            layer->mask.buildLinear(g[0], g[1], g[2], g[3], invert == JNI_TRUE);
+            break;
+        case LOCAL_MASK_BRUSH:
+            if (layer->type != LOCAL_MASK_BRUSH) layer->mask.reset(session->width, session->height);
+            break;
+    }
+    layer->type = maskType;
+    noteSessionBytes(session);
+
+    return toRectArray(env, unionRect(before, layer->mask.coverage()));
+}
+
+// 1 dab của nét brush; trả về vùng tile bị đổi (null nếu không đổi gì)
+extern "C"
+JNIEXPORT jintArray JNICALL
+Java_com_core_adjust_AdjustProcessor_paintLocalBrushNative(JNIEnv *env, jobject /*thiz*/,
+                                                           jlong handle, jint index,
+                                                           jfloat x, jfloat y, jfloat radius,
+                                                           jfloat hardness, jfloat flow, jboolean erase) {
+    LocalSession *session = sessionFromHandle(handle);
+    if (!session) return nullptr;
+    LocalLayer *layer = session->layer(index, false);
+    if (!layer || layer->type != LOCAL_MASK_BRUSH) return nullptr;
+    const TileRect dirty = layer->mask.paintDab(x, y, radius, hardness, flow, erase == JNI_TRUE);
+    if (!dirty.empty()) noteSessionBytes(session);
+    return toRectArray(env, dirty);
+}
+
+extern "C"
+JNIEXPORT jintArray JNICALL
+Java_com_core_adjust_AdjustProcessor_removeLocalLayerNative(JNIEnv *env, jobject /*thiz*/,
+                                                            jlong handle, jint index) {
+    LocalSession *session = sessionFromHandle(handle);
+    if (!session) return nullptr;
+    LocalLayer *layer = session->layer(index, false);
+    if (!layer) return nullptr;
+    const TileRect dirty = layer->mask.coverage();
+    session->layers[static_cast<size_t>(index)].reset();
+    noteSessionBytes(session);
+    return toRectArray(env, dirty);
+}
+
+// Render global + mọi layer local từ src vào dst (cùng kích thước session).
+// [left, top, right, bottom) rỗng = toàn ảnh; ngược lại chỉ vẽ lại các tile giao với vùng đó,
+// phần còn lại của dst giữ nguyên kết quả lần render trước.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_core_adjust_AdjustProcessor_renderLocalNative(JNIEnv *env, jobject /*thiz*/,
+                                                       jlong handle, jobject context,
+                                                       jobject srcBitmap, jobject dstBitmap,
+                                                       jobject paramsObj,
+                                                       jint left, jint top, jint right, jint bottom,
+                                                       jobject progressCb) {
+    LocalSession *session = sessionFromHandle(handle);
+    if (!session || !srcBitmap || !dstBitmap || !paramsObj) return JNI_FALSE;
+    const std::shared_ptr<ThreadPool> pool = ensurePool();
+    const MemoryCheckpoint memoryCheckpoint;
+
+    AndroidBitmapInfo srcInfo{}, dstInfo{};
+    if (AndroidBitmap_getInfo(env, srcBitmap, &srcInfo) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    if (AndroidBitmap_getInfo(env, dstBitmap, &dstInfo) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    if (srcInfo.format != ANDROID_BITMAP_FORMAT_RGBA_8888 || dstInfo.format != ANDROID_BITMAP_FORMAT_RGBA_8888) return JNI_FALSE;
+
+    const int32_t W = session->width;
+    const int32_t H = session->height;
+    if (static_cast<int32_t>(srcInfo.width) != W || static_cast<int32_t>(srcInfo.height) != H) return JNI_FALSE;
+    if (dstInfo.width != srcInfo.width || dstInfo.height != srcInfo.height) return JNI_FALSE;
+
+    // Vùng cần vẽ -> khoảng tile
+    int32_t l = 0, tp = 0, r = W, b = H;
+    if (right > left && bottom > top) {
+        l = std::clamp<int32_t>(left, 0, W);
+        tp = std::clamp<int32_t>(top, 0, H);
+        r = std::clamp<int32_t>(right, l, W);
+        b = std::clamp<int32_t>(bottom, tp, H);
+        if (r - l <= 0 || b - tp <= 0) return JNI_TRUE;
+    }
+    const int32_t tx0 = l / kMaskTileSize, tx1 = (r + kMaskTileSize - 1) / kMaskTileSize;
+    const int32_t ty0 = tp / kMaskTileSize, ty1 = (b + kMaskTileSize - 1) / kMaskTileSize;
+
+    AdjustParams p{};
+    const ThreadLutPath lutPathBuf(p.lutPath);
+    loadParamsFromJava(env, paramsObj, p);
+    readLutPath(env, paramsObj, p.lutPath);
+
+    std::shared_ptr<const Lut3D> lut;
+    bool hasLut = false;
+    if ((p.activeMask & MASK_LUT) && !p.lutPath.empty() && p.lutAmount > 0.0f) {
+        hasLut = (lut = acquireLut(env, context, p.lutPath)) != nullptr;
+        if (!hasLut) LOGE("❌ Failed to load LUT file: %s", p.lutPath.c_str());
+    }
+    if (!hasLut) p.activeMask &= ~MASK_LUT;
+
+    const DenoiseSettings denoise = denoiseSettings(p, 1.0f);
+    const PipelinePlan plan = compilePipeline(p.order, p.activeMask, denoise.halo());
+    p.activeMask &= ~MASK_DENOISE;
+
+    jmethodID onProgress = nullptr;
+    if (progressCb) {
+        jclass cbCls = env->GetObjectClass(progressCb);
+        if (cbCls) onProgress = env->GetMethodID(cbCls, "onProgress", "(I)V");
+        DeleteLocalRefSafely(env, cbCls);
+    }
+
+    void *srcPixels = nullptr;
+    void *dstPixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, srcBitmap, &srcPixels) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    if (AndroidBitmap_lockPixels(env, dstBitmap, &dstPixels) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        AndroidBitmap_unlockPixels(env, srcBitmap);
+        return JNI_FALSE;
+    }
+    const bool premultiplied = (srcInfo.flags & ANDROID_BITMAP_FLAGS_ALPHA_PREMUL) != 0;
+    const size_t srcStride = static_cast<size_t>(srcInfo.stride);
+    const size_t dstStride = static_cast<size_t>(dstInfo.stride);
+
+    RenderCtx ctx;
+    ctx.p = &p;
+    ctx.lut = lut.get();
+    ctx.lutT = clampf(p.lutAmount, 0.f, 1.f);
+    ctx.fullW = static_cast<float>(W);
+    ctx.fullH = static_cast<float>(H);
+    ctx.premultiplied = premultiplied;
+    bindPipeline(ctx, plan);
+    const RegionRowsFn kernel = selectRegionRows(ctx);
+
+    // Chỉ giữ layer có stage thật sự bật. Bind pipeline sau khi đã nằm trong mảng (ctx.ops trỏ vào plan).
+    ScratchArray<LocalRenderLayer> layers(session->layers.size());
+    for (const auto &layer : session->layers) {
+        if (!layer || (layer->params.activeMask & kStageBits) == 0) continue;
+        LocalRenderLayer lr;
+        lr.mask = &layer->mask;
+        lr.plan = compilePipeline(layer->params.order, layer->params.activeMask, 0);
+        lr.ctx = ctx;
+        lr.ctx.p = &layer->params;
+        lr.ctx.lut = nullptr;
+        if (!layers.push_back(lr)) break;
+        LocalRenderLayer &bound = layers[layers.size() - 1];
+        bindPipeline(bound.ctx, bound.plan);
+        bound.pixel = bound.ctx.ordered ? &renderPixel<kOrderedMask> : &renderPixel<kDynamicMask>;
+    }
+
+    const int32_t tilesX = (W + kMaskTileSize - 1) / kMaskTileSize;
+    ScratchArray<int32_t> tiles(static_cast<size_t>(ty1 - ty0) * static_cast<size_t>(tx1 - tx0));
+    int64_t total = 0;
+    for (int32_t ty = ty0; ty < ty1; ++ty) {
+        for (int32_t tx = tx0; tx < tx1; ++tx) {
+            tiles.push_back(ty * tilesX + tx);
+            total += static_cast<int64_t>(std::min(W, (tx + 1) * kMaskTileSize) - tx * kMaskTileSize)
+                     * static_cast<int64_t>(std::min(H, (ty + 1) * kMaskTileSize) - ty * kMaskTileSize);
+        }
+    }
+
+    // Interactive: mỗi worker tự lấy tile kế tiếp -> cân tải khi chỉ vài tile có layer.
+    // Lớp thấp hơn: 1 task / tile để nhường worker cho preview giữa các tile.
+    std::atomic<int64_t> doneCounter{0};
+    std::atomic<size_t> nextTile{0};
+    const TaskPriority prio = t_priority;
+    const unsigned int nThreads = std::max(1u, std::thread::hardware_concurrency());
+    const auto *src = static_cast<const uint8_t *>(srcPixels);
+    auto *dst = static_cast<uint8_t *>(dstPixels);
+    TaskGroup group;
+    if (prio == PRIORITY_INTERACTIVE) {
+        for (unsigned int t = 0; t < std::min<size_t>(nThreads, tiles.size()); ++t) {
+            pool->enqueue([&, src, dst]() {
+                for (size_t i = nextTile.fetch_add(1); i < tiles.size(); i = nextTile.fetch_add(1)) {
+                    renderLocalTile(src, srcStride, dst, dstStride, tiles[i] % tilesX, tiles[i] / tilesX, W, H,
+                                    kernel, ctx, denoise, layers, doneCounter);
+                }
+            }, prio, &group);
+        }
+    } else {
+        for (const int32_t tile : tiles) {
+            pool->enqueue([&, src, dst, tile]() {
+                renderLocalTile(src, srcStride, dst, dstStride, tile % tilesX, tile / tilesX, W, H,
+                                kernel, ctx, denoise, layers, doneCounter);
+            }, prio, &group);
+        }
+    }
+
+    int32_t lastPct = 0;
+    while (!group.waitFor(std::chrono::milliseconds(12))) {
+        const int64_t done = doneCounter.load(std::memory_order_relaxed);
+        const int32_t pct = static_cast<int32_t>((done * 100) / std::max<int64_t>(total, 1));
+        if (onProgress && pct - lastPct >= 3) {
+            lastPct = pct;
+            env->CallVoidMethod(progressCb, onProgress, static_cast<jint>(pct));
+            if (env->ExceptionCheck()) env->ExceptionClear();
+        }
+    }
+    group.wait();
+
+    if (onProgress) {
+        env->CallVoidMethod(progressCb, onProgress, static_cast<jint>(100));
+        if (env->ExceptionCheck()) env->ExceptionClear();
+    }
+
+    AndroidBitmap_unlockPixels(env, dstBitmap);
+    AndroidBitmap_unlockPixels(env, srcBitmap);
+    return JNI_TRUE;
+}
+
+// =============================================================
+// 🔍 JNI: analyzeImageNative (1 pass, song song theo dải hàng)
+// =============================================================
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_core_adjust_AdjustProcessor_analyzeImageNative(JNIEnv *env, jobject /*thiz*/,
+                                                        jobject bitmap, jobject outObj) {
+    if (!bitmap || !outObj) return JNI_FALSE;
+    const std::shared_ptr<ThreadPool> pool = ensurePool();
+
+    AndroidBitmapInfo info{};
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) return JNI_FALSE;
+    if (info.width == 0 || info.height == 0) return JNI_FALSE;
+
+    void *pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    const bool premultiplied = (info.flags & ANDROID_BITMAP_FLAGS_ALPHA_PREMUL) != 0;
+
+    const int32_t W = static_cast<int32_t>(info.width);
+    const int32_t H = static_cast<int32_t>(info.height);
+    const size_t stride = static_cast<size_t>(info.stride);
+    // ~256K mẫu là đủ ổn định cho các tín hiệu thống kê, bất kể kích thước ảnh
+    const int32_t step = analysisStep(W, H, 256 * 1024);
+
+    const unsigned int nThreads = std::max(1u, std::thread::hardware_concurrency());
+    const int32_t band = (H + static_cast<int32_t>(nThreads) - 1) / static_cast<int32_t>(nThreads);
+    std::vector<ImageAnalysisAccum> partial(nThreads);
+
+    TaskGroup group;
+    for (unsigned int t = 0; t < nThreads; ++t) {
+        const int32_t y0 = static_cast<int32_t>(t) * band;
+        const int32_t y1 = std::min(H, y0 + band);
+        if (y0 >= y1) break;
+        ImageAnalysisAccum *acc = &partial[t];
+        pool->enqueue([pixels, W, H, stride, y0, y1, step, premultiplied, acc]() {
+            analyzeRows(static_cast<const uint8_t *>(pixels), W, H, stride, y0, y1, step, premultiplied, *acc);
+        }, t_priority, &group);
+    }
+    group.wait();
+    AndroidBitmap_unlockPixels(env, bitmap);
+
+    for (size_t i = 1; i < partial.size(); ++i) partial[0].merge(partial[i]);
+    ImageAnalysis a;
+    finalizeAnalysis(partial[0], a);
+
+    setFloatField(env, outObj, "meanR", a.meanR);
+    setFloatField(env, outObj, "meanG", a.meanG);
+    setFloatField(env, outObj, "meanB", a.meanB);
+    setFloatField(env, outObj, "meanLuma", a.meanLuma);
+    setFloatField(env, outObj, "contrast", a.contrast);
+    setFloatField(env, outObj, "temperatureBias", a.temperatureBias);
+    setFloatField(env, outObj, "skyRatio", a.skyRatio);
+    setFloatField(env, outObj, "foliageRatio", a.foliageRatio);
+    setFloatField(env, outObj, "meanSaturation", a.meanSaturation);
+    setFloatArrayField(env, outObj, "saturationBins", a.saturationBins, 4);
+    setLongField(env, outObj, "sampleCount", a.sampleCount);
+    return a.sampleCount > 0 ? JNI_TRUE : JNI_FALSE;
+}
+
+// =============================================================
+// 📐 JNI: resampleNative (scale + crop vào bitmap caller cấp, xem adjust_resample.h)
+// Vùng nguồn [left, right) × [top, bottom) lấp đầy toàn bộ dst; crop giữa / giữ tỉ lệ tính phía Kotlin.
+// =============================================================
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_core_adjust_AdjustProcessor_resampleNative(JNIEnv *env, jobject /*thiz*/,
+                                                    jobject srcBitmap, jobject dstBitmap,
+                                                    jfloat left, jfloat top, jfloat right, jfloat bottom,
+                                                    jint filter, jboolean linearLight) {
+    if (!srcBitmap || !dstBitmap) return JNI_FALSE;
+    const std::shared_ptr<ThreadPool> pool = ensurePool();
+    const MemoryCheckpoint memoryCheckpoint;
+
+    AndroidBitmapInfo srcInfo{}, dstInfo{};
+    if (AndroidBitmap_getInfo(env, srcBitmap, &srcInfo) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    if (AndroidBitmap_getInfo(env, dstBitmap, &dstInfo) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    if (srcInfo.format != ANDROID_BITMAP_FORMAT_RGBA_8888 || dstInfo.format != ANDROID_BITMAP_FORMAT_RGBA_8888) return JNI_FALSE;
+
+    const int32_t srcW = static_cast<int32_t>(srcInfo.width);
+    const int32_t srcH = static_cast<int32_t>(srcInfo.height);
+    const int32_t dstW = static_cast<int32_t>(dstInfo.width);
+    const int32_t dstH = static_cast<int32_t>(dstInfo.height);
+    const float l = std::clamp(static_cast<float>(left), 0.0f, static_cast<float>(srcW));
+    const float tp = std::clamp(static_cast<float>(top), 0.0f, static_cast<float>(srcH));
+    const float r = std::clamp(static_cast<float>(right), l, static_cast<float>(srcW));
+    const float b = std::clamp(static_cast<float>(bottom), tp, static_cast<float>(srcH));
+
+    const bool premultiplied = (srcInfo.flags & ANDROID_BITMAP_FLAGS_ALPHA_PREMUL) != 0;
+    ResamplePlan plan;
+    if (!plan.init(srcW, srcH, l, tp, r, b, dstW, dstH, static_cast<ResampleFilter>(filter),
+                   linearLight == JNI_TRUE, premultiplied)) {
+        return JNI_FALSE;
+    }
+
+    void *srcPixels = nullptr;
+    void *dstPixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, srcBitmap, &srcPixels) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    if (AndroidBitmap_lockPixels(env, dstBitmap, &dstPixels) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        AndroidBitmap_unlockPixels(env, srcBitmap);
+        return JNI_FALSE;
+    }
+    const auto *src = static_cast<const uint8_t *>(srcPixels);
+    auto *dst = static_cast<uint8_t *>(dstPixels);
+    const size_t srcStride = static_cast<size_t>(srcInfo.stride);
+    const size_t dstStride = static_cast<size_t>(dstInfo.stride);
+
+    // Chi phí theo số pixel nguồn phải đọc, không phải số pixel output
+    const int32_t costWidth = static_cast<int32_t>(std::min<int64_t>(
+            plan.sourcePixels() / std::max(dstH, 1), INT32_MAX));
+    const int32_t band = taskBandRows(dstH, costWidth, t_priority);
+    TaskGroup group;
+    for (int32_t y0 = 0; y0 < dstH; y0 += band) {
+        const int32_t y1 = std::min(dstH, y0 + band);
+        pool->enqueue([&plan, src, srcStride, dst, dstStride, y0, y1]() {
+            plan.run(src, srcStride, dst, dstStride, y0, y1);
+        }, t_priority, &group);
+    }
+    group.wait();
+
+    AndroidBitmap_unlockPixels(env, dstBitmap);
+    AndroidBitmap_unlockPixels(env, srcBitmap);
+    return JNI_TRUE;
+}
+
+// =============================================================
+// 🧹 JNI helpers
+// =============================================================
+extern "C" JNIEXPORT void JNICALL
+Java_com_core_adjust_AdjustProcessor_clearCache(JNIEnv *, jclass) {
+    s_lastHash.store(0ull, std::memory_order_relaxed);
+    s_lastLutPath.clear();
+}
+
+// =============================================================
+// 📥 Import LUT: .cube / HaldCLUT -> .table (convert 1 lần, Kotlin cache file theo nguồn)
+// =============================================================
+static constexpr uint64_t kMaxCubeFileBytes = 64ull * 1024ull * 1024ull;
+
+static std::string jstringToStd(JNIEnv *env, jstring s) {
+    if (!s) return {};
+    const char *chars = env->GetStringUTFChars(s, nullptr);
+    std::string out = chars ? chars : "";
+    if (chars) env->ReleaseStringUTFChars(s, chars);
+    return out;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_core_adjust_AdjustProcessor_convertCubeNative(JNIEnv *env, jclass, jstring srcPath, jstring dstPath) {
+    const std::string src = jstringToStd(env, srcPath);
+    const std::string dst = jstringToStd(env, dstPath);
+    if (src.empty() || dst.empty()) return JNI_FALSE;
+
+    std::ifstream f(src, std::ios::binary | std::ios::ate);
+    if (!f.is_open()) {
+        LOGE("Cannot open .cube: %s", src.c_str());
+        return JNI_FALSE;
+    }
+    const auto bytes = static_cast<uint64_t>(f.tellg());
+    if (bytes == 0 || bytes > kMaxCubeFileBytes) {
+        LOGE("Unexpected .cube size %llu: %s", static_cast<unsigned long long>(bytes), src.c_str());
+        return JNI_FALSE;
+    }
+    std::vector<char> text(static_cast<size_t>(bytes));
+    f.seekg(0);
+    f.read(text.data(), static_cast<std::streamsize>(bytes));
+    if (!f) return JNI_FALSE;
+
+    Lut3D lut;
+    std::string err;
+    if (!parseCube(text.data(), text.size(), lut, &err) || !writeTableFile(dst, lut, &err)) {
+        LOGE("❌ .cube import failed (%s): %s", err.c_str(), src.c_str());
+        return JNI_FALSE;
+    }
+    dropCachedLuts(); // dst có thể trùng path một LUT đang cache
+    LOGI("✅ .cube imported: %s -> %s (size=%d)", src.c_str(), dst.c_str(), lut.size);
+    return JNI_TRUE;
+}
+
+// bitmap: HaldCLUT đã decode ARGB_8888, KHÔNG premultiply (inPremultiplied = false)
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_core_adjust_AdjustProcessor_convertHaldClutNative(JNIEnv *env, jclass, jobject bitmap, jstring dstPath) {
+    const std::string dst = jstringToStd(env, dstPath);
+    if (!bitmap || dst.empty()) return JNI_FALSE;
+
+    AndroidBitmapInfo info{};
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) return JNI_FALSE;
+
+    void *pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    Lut3D lut;
+    std::string err;
+    const bool parsed = parseHaldClut(static_cast<const uint8_t *>(pixels),
+                                      static_cast<int32_t>(info.width), static_cast<int32_t>(info.height),
+                                      static_cast<size_t>(info.stride), lut, &err);
+    AndroidBitmap_unlockPixels(env, bitmap);
+
+    if (!parsed || !writeTableFile(dst, lut, &err)) {
+        LOGE("❌ HaldCLUT import failed (%s)", err.c_str());
+        return JNI_FALSE;
+    }
+    dropCachedLuts();
+    LOGI("✅ HaldCLUT imported -> %s (size=%d)", dst.c_str(), lut.size);
+    return JNI_TRUE;
+}
+
+// Render cache: giữ qua clearCache() để undo / quay lại filter cũ vẫn hit
+extern "C" JNIEXPORT void JNICALL
+Java_com_core_adjust_AdjustProcessor_configureRenderCache(JNIEnv *, jclass, jlong budgetBytes, jboolean compressCold) {
+    renderCache().configure(static_cast<size_t>(std::max<jlong>(budgetBytes, 0)), compressCold == JNI_TRUE);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_core_adjust_AdjustProcessor_clearRenderCache(JNIEnv *, jclass) {
+    renderCache().clear();
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_core_adjust_AdjustProcessor_renderCacheBytes(JNIEnv *, jclass) {
+    return static_cast<jlong>(renderCache().bytesUsed());
+}
+
+// =============================================================
+// 💾 JNI: thumbnail disk cache (adjust_thumbcache.h)
+// Key ghép từ hash nội dung ảnh nguồn (contentHashNative, tính 1 lần / ảnh) + lutKey + kích thước bitmap.
+// =============================================================
+static constexpr int32_t kContentHashBandRows = 64; // cố định -> hash không phụ thuộc số worker
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_core_adjust_AdjustProcessor_openThumbnailCacheNative(JNIEnv *env, jobject /*thiz*/, jstring dir,
+                                                              jlong capBytes) {
+    const std::string path = jstringToStd(env, dir);
+    if (path.empty()) return JNI_FALSE;
+    std::string err;
+    const uint64_t cap = capBytes > 0 ? static_cast<uint64_t>(capBytes) : ThumbDiskCache::kDefaultCapBytes;
+    if (!thumbDiskCache().open(path, cap, &err)) {
+        LOGE("❌ Thumbnail cache unavailable (%s): %s", err.c_str(), path.c_str());
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_core_adjust_AdjustProcessor_closeThumbnailCache(JNIEnv *, jobject /*thiz*/) {
+    thumbDiskCache().close();
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_core_adjust_AdjustProcessor_clearThumbnailCache(JNIEnv *, jobject /*thiz*/) {
+    thumbDiskCache().clear();
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_core_adjust_AdjustProcessor_thumbnailCacheBytes(JNIEnv *, jobject /*thiz*/) {
+    return static_cast<jlong>(thumbDiskCache().diskBytes());
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_core_adjust_AdjustProcessor_contentHashNative(JNIEnv *env, jobject /*thiz*/, jobject bitmap) {
+    if (!bitmap) return 0;
+    const std::shared_ptr<ThreadPool> pool = ensurePool();
+    const MemoryCheckpoint memoryCheckpoint;
+    AndroidBitmapInfo info{};
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) return 0;
+    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) return 0;
+    void *pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS) return 0;
+
+    const auto *src = static_cast<const uint8_t *>(pixels);
+    const size_t stride = static_cast<size_t>(info.stride);
+    const int32_t W = static_cast<int32_t>(info.width);
+    const int32_t H = static_cast<int32_t>(info.height);
+    const int32_t bands = (H + kContentHashBandRows - 1) / kContentHashBandRows;
+    ScratchArray<uint64_t> bandHash(static_cast<size_t>(bands));
+    for (int32_t i = 0; i < bands; ++i) bandHash.push_back(0);
+    if (bandHash.size() != static_cast<size_t>(bands)) {
+        AndroidBitmap_unlockPixels(env, bitmap);
+        return 0;
+    }
+    // Mỗi task hash vài dải liền nhau; kết quả ghép theo thứ tự dải
+    const int32_t perTask = std::max(1, taskBandRows(H, W, t_priority) / kContentHashBandRows);
+    TaskGroup group;
+    for (int32_t b0 = 0; b0 < bands; b0 += perTask) {
+        const int32_t b1 = std::min(bands, b0 + perTask);
+        pool->enqueue([src, stride, W, H, b0, b1, &bandHash]() {
+            for (int32_t b = b0; b < b1; ++b) {
+                const int32_t y0 = b * kContentHashBandRows;
+                bandHash[static_cast<size_t>(b)] = hashPixels(src, stride, W, y0, std::min(H, y0 + kContentHashBandRows));
+            }
+        }, t_priority, &group);
+    }
+    group.wait();
+    AndroidBitmap_unlockPixels(env, bitmap);
+
+    uint64_t h = combineHash(static_cast<uint64_t>(static_cast<uint32_t>(W)) << 32 | static_cast<uint32_t>(H),
+                             info.flags);
+    for (const uint64_t v : bandHash) h = combineHash(h, v);
+    return static_cast<jlong>(h == 0 ? 1 : h); // 0 = "chưa tính" phía Kotlin
+}
+
+static bool thumbKeyFor(JNIEnv *env, jlong sourceHash, jstring lutKey, const AndroidBitmapInfo &info, ThumbKey &key) {
+    const std::string id = jstringToStd(env, lutKey);
+    if (id.empty() || info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) return false;
+    key.source = static_cast<uint64_t>(sourceHash);
+    key.lut = hashString(id.data(), id.size());
+    key.width = static_cast<int32_t>(info.width);
+    key.height = static_cast<int32_t>(info.height);
+    key.engine = ThumbDiskCache::kEngineVersion;
+    return true;
+}
+
+// Hit: giải nén thẳng vào bitmap caller cấp (kích thước bitmap là 1 phần của key)
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_core_adjust_AdjustProcessor_loadThumbnailNative(JNIEnv *env, jobject /*thiz*/, jlong sourceHash,
+                                                         jstring lutKey, jobject bitmap) {
+    if (!bitmap) return JNI_FALSE;
+    const MemoryCheckpoint memoryCheckpoint;
+    AndroidBitmapInfo info{};
+    ThumbKey key;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS ||
+        !thumbKeyFor(env, sourceHash, lutKey, info, key)) {
+        return JNI_FALSE;
+    }
+    void *pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    const bool hit = thumbDiskCache().get(key, static_cast<uint8_t *>(pixels), static_cast<size_t>(info.stride));
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return hit ? JNI_TRUE : JNI_FALSE;
+}
+
+// Chỉ copy vào hàng đợi; nén + ghi đĩa trên luồng writer của cache
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_core_adjust_AdjustProcessor_storeThumbnailNative(JNIEnv *env, jobject /*thiz*/, jlong sourceHash,
+                                                          jstring lutKey, jobject bitmap) {
+    if (!bitmap) return JNI_FALSE;
+    AndroidBitmapInfo info{};
+    ThumbKey key;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS ||
+        !thumbKeyFor(env, sourceHash, lutKey, info, key)) {
+        return JNI_FALSE;
+    }
+    void *pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS) return JNI_FALSE;
+    const bool queued = thumbDiskCache().put(key, static_cast<const uint8_t *>(pixels), static_cast<size_t>(info.stride));
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return queued ? JNI_TRUE : JNI_FALSE;
+}
+
+// Scratch arena: giữ qua clearCache(); trim khi app thiếu bộ nhớ
+extern "C" JNIEXPORT void JNICALL
+Java_com_core_adjust_AdjustProcessor_configureScratchArena(JNIEnv *, jclass, jlong capBytes) {
+    scratchArena().setCapBytes(static_cast<size_t>(std::max<jlong>(capBytes, 0)));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_core_adjust_AdjustProcessor_trimScratchArena(JNIEnv *, jclass, jlong keepBytes) {
+    scratchArena().trim(static_cast<size_t>(std::max<jlong>(keepBytes, 0)));
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_core_adjust_AdjustProcessor_scratchArenaBytes(JNIEnv *, jclass) {
+    return static_cast<jlong>(scratchArena().retainedBytes() + scratchArena().leasedBytes());
+}
+
+// Budget chung cho mọi cache native (scratch rảnh, render cache, LUT); session local chỉ được đếm
+extern "C" JNIEXPORT void JNICALL
+Java_com_core_adjust_AdjustProcessor_setMemoryBudget(JNIEnv *, jclass, jlong budgetBytes) {
+    registerMemoryConsumers();
+    memoryGovernor().setBudget(static_cast<size_t>(std::max<jlong>(budgetBytes, 0)));
+}
+
+// level = ComponentCallbacks2.TRIM_MEMORY_*
+extern "C" JNIEXPORT void JNICALL
+Java_com_core_adjust_AdjustProcessor_trimMemory(JNIEnv *, jclass, jint level) {
+    registerMemoryConsumers();
+    memoryGovernor().trimMemory(level);
+    LOGI("🧹 trimMemory(%d): %zu / %zu bytes", level, memoryGovernor().totalBytes(), memoryGovernor().budget());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_core_adjust_AdjustProcessor_memoryUsageNative(JNIEnv *env, jclass, jobject out) {
+    if (!out) return;
+    registerMemoryConsumers();
+    const MemoryGovernor &g = memoryGovernor();
+    const size_t cache = g.bytes(MEM_RENDER_CACHE);
+    // Dữ liệu render cache cũng là lease của arena -> phần render đang mượn = leased - cache
+    const size_t leased = scratchArena().leasedBytes();
+    const size_t inUse = leased > cache ? leased - cache : 0u;
+    const size_t total = g.totalBytes();
+
+    setLongField(env, out, "scratchIdleBytes", static_cast<jlong>(g.bytes(MEM_SCRATCH_IDLE)));
+    setLongField(env, out, "scratchInUseBytes", static_cast<jlong>(inUse));
+    setLongField(env, out, "renderCacheBytes", static_cast<jlong>(cache));
+    setLongField(env, out, "lutCacheBytes", static_cast<jlong>(g.bytes(MEM_LUT_CACHE)));
+    setLongField(env, out, "localSessionBytes", static_cast<jlong>(g.bytes(MEM_LOCAL_SESSIONS)));
+    setLongField(env, out, "totalBytes", static_cast<jlong>(total + inUse));
+    setLongField(env, out, "budgetBytes", static_cast<jlong>(g.budget()));
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_core_adjust_AdjustProcessor_allocationCount(JNIEnv *, jclass) {
+    return static_cast<jlong>(engineAllocationCount());
+}
+
+// Lớp ưu tiên cho các lời gọi render tiếp theo trên luồng hiện tại; trả về lớp cũ để khôi phục
+extern "C" JNIEXPORT jint JNICALL
+Java_com_core_adjust_AdjustProcessor_setRenderPriorityNative(JNIEnv *, jclass, jint priority) {
+    const TaskPriority old = t_priority;
+    t_priority = static_cast<TaskPriority>(std::clamp<jint>(priority, PRIORITY_INTERACTIVE, PRIORITY_EXPORT));
+    return old;
+}
+
+// Số worker tối đa cho thumbnail / export (<= 0: mặc định n - 1 và n / 2). Interactive luôn dùng được mọi worker.
+extern "C" JNIEXPORT void JNICALL
+Java_com_core_adjust_AdjustProcessor_configureScheduler(JNIEnv *, jclass, jint thumbnailWorkers, jint exportWorkers) {
+    std::lock_guard<std::mutex> lock(s_poolMutex);
+    s_thumbnailShare = thumbnailWorkers > 0 ? static_cast<size_t>(thumbnailWorkers) : 0u;
+    s_exportShare = exportWorkers > 0 ? static_cast<size_t>(exportWorkers) : 0u;
+    if (gPool) applySharesLocked();
+}
+
+extern "C" JNIEXPORT jdouble JNICALL
+Java_com_core_adjust_AdjustProcessor_estimateRenderNsPerPixel(JNIEnv *, jclass, jlong mask) {
+    return static_cast<jdouble>(renderCostModel().estimateNsPerPixel(static_cast<uint64_t>(mask) & kCostBits));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_core_adjust_AdjustProcessor_resetRenderCostModel(JNIEnv *, jclass) {
+    renderCostModel().reset();
+}
+
+// Pass plan mà render full-res của params sẽ chạy (profiling); LUT tính theo bit mask, không nạp file
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_core_adjust_AdjustProcessor_describePipelineNative(JNIEnv *env, jclass, jobject paramsObj) {
+    if (!paramsObj) return nullptr;
+    AdjustParams p{};
+    loadParamsFromJava(env, paramsObj, p);
+    const PipelinePlan plan = compilePipeline(p.order, p.activeMask, denoiseSettings(p, 1.0f).halo());
+    return env->NewStringUTF(describePipeline(plan).c_str());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_core_adjust_AdjustProcessor_setFixedPointMode(JNIEnv *, jclass, jint mode) {
+    const int32_t m = (mode >= FIXED_AUTO && mode <= FIXED_OFF) ? static_cast<int32_t>(mode) : FIXED_AUTO;
+    s_fixedMode.store(m, std::memory_order_relaxed);
+    s_lastHash.store(0, std::memory_order_relaxed); // đổi đường render -> không skip theo hash cũ
 }
 
 extern "C" JNIEXPORT void JNICALL
 Java_com_core_adjust_AdjustProcessor_releasePool(JNIEnv *, jclass) {
-    delete gPool;
-    gPool = nullptr;
+    std::lock_guard<std::mutex> lock(s_poolMutex);
+    gPool.reset();
 }
@@ -0,0 +1,115 @@
+#include "adjust_analysis.h"
+#include <algorithm>
+#include <cmath>
+
+void ImageAnalysisAccum::merge(const ImageAnalysisAccum &o) {
+    sumR += o.sumR;
+    sumG += o.sumG;
+    sumB += o.sumB;
+    sumL += o.sumL;
+    sumL2 += o.sumL2;
+    sumSat += o.sumSat;
+    for (int i = 0; i < 4; ++i) satBins[i] += o.satBins[i];
+    skyCount += o.skyCount;
+    upperCount += o.upperCount;
+    foliageCount += o.foliageCount;
+    count += o.count;
+}
+
+int32_t analysisStep(int32_t width, int32_t height, int64_t targetSamples) {
+    const int64_t total = static_cast<int64_t>(width) * static_cast<int64_t>(height);
+    if (total <= targetSamples || targetSamples <= 0) return 1;
+    const double ratio = static_cast<double>(total) / static_cast<double>(targetSamples);
+    return std::max(1, static_cast<int32_t>(std::lround(std::sqrt(ratio))));
+}
+
+// Hue (độ) + saturation/value kiểu HSV, tất cả trên thang 0..255 để tránh chia nhiều
+static inline void hueSatVal(int32_t r, int32_t g, int32_t b, float &hue, float &sat, float &val) {
+    const int32_t mx = std::max(r, std::max(g, b));
+    const int32_t mn = std::min(r, std::min(g, b));
+    const int32_t d = mx - mn;
+    val = static_cast<float>(mx) / 255.0f;
+    sat = (mx > 0) ? static_cast<float>(d) / static_cast<float>(mx) : 0.0f;
+    if (d == 0) { hue = 0.0f; return; }
+    const float fd = static_cast<float>(d);
+    if (mx == r)      hue = 60.0f * (static_cast<float>(g - b) / fd);
+    else if (mx == g) hue = 60.0f * (static_cast<float>(b - r) / fd + 2.0f);
+    else              hue = 60.0f * (static_cast<float>(r - g) / fd + 4.0f);
+    if (hue < 0.0f) hue += 360.0f;
+}
+
+void analyzeRows(const uint8_t *pixels, int32_t width, int32_t height, size_t strideBytes,
+                 int32_t y0, int32_t y1, int32_t step, bool premultiplied,
+                 ImageAnalysisAccum &acc) {
+    const int32_t upperLimit = height / 2;
+    // Bắt đầu tại hàng là bội số của step để các worker không lấy trùng/lệch lưới
+    const int32_t yStart = ((y0 + step - 1) / step) * step;
+
+    for (int32_t y = yStart; y < y1; y += step) {
+        const auto *row = reinterpret_cast<const uint32_t *>(pixels + static_cast<size_t>(y) * strideBytes);
+        const bool upper = y < upperLimit;
+        for (int32_t x = 0; x < width; x += step) {
+            // RGBA_8888: bộ nhớ là R, G, B, A -> trên little-endian R nằm ở byte thấp nhất
+            const uint32_t c = row[x];
+            const int32_t a = static_cast<int32_t>((c >> 24) & 0xFFu);
+            int32_t b = static_cast<int32_t>((c >> 16) & 0xFFu);
+            int32_t g = static_cast<int32_t>((c >>  8) & 0xFFu);
+            int32_t r = static_cast<int32_t>( c        & 0xFFu);
+            if (a == 0) continue;
+            if (premultiplied && a < 255) {
+                r = std::min(255, r * 255 / a);
+                g = std::min(255, g * 255 / a);
+                b = std::min(255, b * 255 / a);
+            }
+
+            const double l = 0.299 * r + 0.587 * g + 0.114 * b;
+            acc.sumR += r;
+            acc.sumG += g;
+            acc.sumB += b;
+            acc.sumL += l;
+            acc.sumL2 += l * l;
+
+            float hue, sat, val;
+            hueSatVal(r, g, b, hue, sat, val);
+            acc.sumSat += static_cast<double>(sat);
+            const int bin = sat < 0.15f ? 0 : (sat < 0.35f ? 1 : (sat < 0.6f ? 2 : 3));
+            ++acc.satBins[bin];
+
+            // Trời xanh: hue 185..250, đủ sáng, bão hòa vừa phải (trời nhạt vẫn tính)
+            if (upper) {
+                ++acc.upperCount;
+                if (hue >= 185.0f && hue <= 250.0f && sat >= 0.15f && val >= 0.35f) ++acc.skyCount;
+            }
+            // Lá cây: hue 65..160, bão hòa & độ sáng tối thiểu
+            if (hue >= 65.0f && hue <= 160.0f && sat >= 0.2f && val >= 0.15f) ++acc.foliageCount;
+
+            ++acc.count;
+        }
+    }
+}
+
+void finalizeAnalysis(const ImageAnalysisAccum &acc, ImageAnalysis &out) {
+    out = ImageAnalysis{};
+    out.sampleCount = static_cast<int64_t>(acc.count);
+    if (acc.count == 0) return;
+
+    const double n = static_cast<double>(acc.count);
+    out.meanR = static_cast<float>(acc.sumR / n);
+    out.meanG = static_cast<float>(acc.sumG / n);
+    out.meanB = static_cast<float>(acc.sumB / n);
+
+    const double meanL = acc.sumL / n;
+    const double varL = std::max(0.0, acc.sumL2 / n - meanL * meanL);
+    out.meanLuma = static_cast<float>(meanL);
+    out.contrast = static_cast<float>(std::sqrt(varL));
+    out.temperatureBias = (out.meanR - out.meanB) / 255.0f;
+
+    out.skyRatio = acc.upperCount > 0
+                   ? static_cast<float>(static_cast<double>(acc.skyCount) / static_cast<double>(acc.upperCount))
+                   : 0.0f;
+    out.foliageRatio = static_cast<float>(static_cast<double>(acc.foliageCount) / n);
+    out.meanSaturation = static_cast<float>(acc.sumSat / n);
+    for (int i = 0; i < 4; ++i) {
+        out.saturationBins[i] = static_cast<float>(static_cast<double>(acc.satBins[i]) / n);
+    }
+}
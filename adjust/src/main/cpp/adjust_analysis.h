@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// =============================================================
+// 🔍 Image analysis (1 pass, downsample theo bước lấy mẫu)
+// Dùng cho FilterSuggestionUtils: thay cho nhiều lần bitmap[x, y] bên Kotlin.
+// =============================================================
+struct ImageAnalysisAccum {
+    double sumR = 0.0, sumG = 0.0, sumB = 0.0;
+    double sumL = 0.0, sumL2 = 0.0;
+    double sumSat = 0.0;
+    uint64_t satBins[4] = {0, 0, 0, 0}; // [0,.15) [.15,.35) [.35,.6) [.6,1]
+    uint64_t skyCount = 0;              // chỉ tính ở nửa trên ảnh
+    uint64_t upperCount = 0;
+    uint64_t foliageCount = 0;
+    uint64_t count = 0;
+
+    void merge(const ImageAnalysisAccum &o);
+};
+
+struct ImageAnalysis {
+    float meanR = 0.f, meanG = 0.f, meanB = 0.f; // 0..255
+    float meanLuma = 0.f;                        // 0..255
+    float contrast = 0.f;                        // độ lệch chuẩn luma, 0..~128
+    float temperatureBias = 0.f;                 // (R - B) / 255, > 0 = ấm
+    float skyRatio = 0.f;                        // tỉ lệ pixel "trời xanh" ở nửa trên
+    float foliageRatio = 0.f;                    // tỉ lệ pixel "lá cây"
+    float meanSaturation = 0.f;                  // 0..1
+    float saturationBins[4] = {0.f, 0.f, 0.f, 0.f};
+    int64_t sampleCount = 0;
+};
+
+// Bước lấy mẫu để số mẫu ~ targetSamples (>= 1)
+int32_t analysisStep(int32_t width, int32_t height, int64_t targetSamples);
+
+// Quét các hàng [y0, y1) (theo lưới step) của ảnh RGBA_8888
+void analyzeRows(const uint8_t *pixels, int32_t width, int32_t height, size_t strideBytes,
+                 int32_t y0, int32_t y1, int32_t step, bool premultiplied,
+                 ImageAnalysisAccum &acc);
+
+void finalizeAnalysis(const ImageAnalysisAccum &acc, ImageAnalysis &out);
@@ -0,0 +1,228 @@
+#include "adjust_arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static constexpr size_t kFreeListReserve = 8; // đủ cho mọi render đồng thời -> push_back không cấp phát
+
+// Class nhỏ nhất có dung lượng >= bytes; -1 nếu vượt class lớn nhất
+static int32_t sizeClass(size_t bytes) {
+    constexpr int32_t steps = ScratchArena::kStepsPerOctave;
+    int32_t k = ScratchArena::kMinClassShift;
+    if (bytes <= (size_t{1} << k)) return 0;
+    while ((size_t{2} << k) <= bytes - 1u) ++k; // 2^k < bytes <= 2^(k+1)
+    const size_t base = size_t{1} << k;
+    const size_t step = base / steps;
+    auto q = static_cast<int32_t>((bytes - base + step - 1u) / step);
+    if (q == steps) {
+        ++k;
+        q = 0;
+    }
+    const int32_t cls = (k - ScratchArena::kMinClassShift) * steps + q;
+    return cls < ScratchArena::kClassCount ? cls : -1;
+}
+
+static size_t classBytes(int32_t cls) {
+    constexpr int32_t steps = ScratchArena::kStepsPerOctave;
+    const size_t base = size_t{1} << (ScratchArena::kMinClassShift + cls / steps);
+    return base + static_cast<size_t>(cls % steps) * (base / steps);
+}
+
+static void *allocAligned(size_t bytes) {
+    return ::operator new(bytes, std::align_val_t(ScratchArena::kAlignment), std::nothrow);
+}
+
+static void freeAligned(void *ptr) {
+    ::operator delete(ptr, std::align_val_t(ScratchArena::kAlignment));
+}
+
+// =============================================================
+// Lease
+// =============================================================
+ScratchArena::Lease &ScratchArena::Lease::operator=(Lease &&o) noexcept {
+    if (this != &o) {
+        release();
+        arena_ = o.arena_;
+        ptr_ = o.ptr_;
+        bytes_ = o.bytes_;
+        cls_ = o.cls_;
+        o.arena_ = nullptr;
+        o.ptr_ = nullptr;
+        o.bytes_ = 0;
+        o.cls_ = -1;
+    }
+    return *this;
+}
+
+void ScratchArena::Lease::release() {
+    if (ptr_ && arena_) arena_->giveBack(ptr_, cls_);
+    arena_ = nullptr;
+    ptr_ = nullptr;
+    bytes_ = 0;
+    cls_ = -1;
+}
+
+// =============================================================
+// ScratchArena
+// =============================================================
+ScratchArena::ScratchArena() {
+    for (auto &list : free_) list.reserve(kFreeListReserve);
+}
+
+ScratchArena::~ScratchArena() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    trimLocked(0);
+}
+
+ScratchArena::Lease ScratchArena::borrow(size_t bytes) {
+    Lease lease;
+    if (bytes == 0) return lease;
+    const int32_t cls = sizeClass(bytes);
+    if (cls < 0) return lease;
+    const size_t size = classBytes(cls);
+
+    void *ptr = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &list = free_[cls];
+        if (!list.empty()) {
+            ptr = list.back();
+            list.pop_back();
+            retained_ -= size;
+        }
+        leased_ += size;
+        highWater_ = std::max(highWater_, leased_ + retained_);
+    }
+    if (!ptr) {
+        // Cấp phát ngoài lock: buffer lớn có thể mất vài ms (page fault)
+        ptr = allocAligned(size);
+        if (!ptr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            leased_ -= size;
+            return lease;
+        }
+    }
+    lease.arena_ = this;
+    lease.ptr_ = ptr;
+    lease.bytes_ = size;
+    lease.cls_ = cls;
+    return lease;
+}
+
+void ScratchArena::giveBack(void *ptr, int32_t cls) {
+    const size_t size = classBytes(cls);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        leased_ -= size;
+        if (retained_ + size <= cap_) {
+            free_[cls].push_back(ptr);
+            retained_ += size;
+            return;
+        }
+    }
+    freeAligned(ptr);
+}
+
+void ScratchArena::setCapBytes(size_t capBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cap_ = capBytes;
+    trimLocked(cap_);
+}
+
+void ScratchArena::trim(size_t keepBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    trimLocked(keepBytes);
+    if (keepBytes == 0) highWater_ = leased_;
+}
+
+void ScratchArena::trimLocked(size_t keepBytes) {
+    for (int32_t cls = kClassCount - 1; cls >= 0 && retained_ > keepBytes; --cls) {
+        auto &list = free_[cls];
+        while (!list.empty() && retained_ > keepBytes) {
+            freeAligned(list.back());
+            list.pop_back();
+            retained_ -= classBytes(cls);
+        }
+    }
+}
+
+size_t ScratchArena::retainedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return retained_;
+}
+
+size_t ScratchArena::leasedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return leased_;
+}
+
+size_t ScratchArena::highWaterBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return highWater_;
+}
+
+ScratchArena &scratchArena() {
+    static ScratchArena arena;
+    return arena;
+}
+
+// =============================================================
+// 🔢 Bộ đếm cấp phát (Debug): thay operator new / delete của libadjust.
+// Symbol ẩn (CXX_VISIBILITY_PRESET hidden) -> chỉ đếm cấp phát phát sinh trong engine
+// (gồm cả libc++ static), không đếm phía ART / thư viện khác.
+// =============================================================
+#if defined(ADJUST_ALLOC_COUNTER)
+static std::atomic<int64_t> s_allocCount{0};
+
+static void *countedAlloc(size_t bytes, size_t align) {
+    s_allocCount.fetch_add(1, std::memory_order_relaxed);
+    if (bytes == 0) bytes = 1;
+    if (align <= alignof(std::max_align_t)) return std::malloc(bytes);
+    void *p = nullptr;
+    return posix_memalign(&p, align, bytes) == 0 ? p : nullptr;
+}
+
+void *operator new(size_t n) {
+    void *p = countedAlloc(n, 0);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void *operator new[](size_t n) { return operator new(n); }
+void *operator new(size_t n, const std::nothrow_t &) noexcept { return countedAlloc(n, 0); }
+void *operator new[](size_t n, const std::nothrow_t &) noexcept { return countedAlloc(n, 0); }
+void *operator new(size_t n, std::align_val_t a) {
+    void *p = countedAlloc(n, static_cast<size_t>(a));
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void *operator new[](size_t n, std::align_val_t a) { return operator new(n, a); }
+void *operator new(size_t n, std::align_val_t a, const std::nothrow_t &) noexcept {
+    return countedAlloc(n, static_cast<size_t>(a));
+}
+void *operator new[](size_t n, std::align_val_t a, const std::nothrow_t &) noexcept {
+    return countedAlloc(n, static_cast<size_t>(a));
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+
+int64_t engineAllocationCount() {
+    return s_allocCount.load(std::memory_order_relaxed);
+}
+#else
+int64_t engineAllocationCount() {
+    return -1;
+}
+#endif
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// =============================================================
+// 🧺 ScratchArena — buffer tạm (plane trung gian) dùng lại giữa các lần render
+// Size class: 4 bậc trong mỗi khoảng lũy thừa 2 (2^k × 1, 1.25, 1.5, 1.75; >= 4 KB) -> phí làm tròn <= 25%,
+// căn 64 byte. Render "mượn" (Lease, RAII) rồi trả về free list của class đó -> sau vài frame đầu,
+// kéo slider không còn cấp phát heap.
+// Tổng byte đang rảnh bị chặn bởi cap (high-water mark): trả về vượt cap thì free luôn.
+// trim() giải phóng buffer rảnh khi app bị nhắc thiếu bộ nhớ (onTrimMemory).
+// =============================================================
+class ScratchArena {
+public:
+    static constexpr size_t kAlignment = 64;
+    static constexpr int32_t kMinClassShift = 12; // 4 KB
+    static constexpr int32_t kStepsPerOctave = 4;
+    static constexpr int32_t kClassCount = 20 * kStepsPerOctave; // 4 KB .. ~3.5 GB
+    static constexpr size_t kDefaultCapBytes = 32u * 1024u * 1024u;
+
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        Lease(Lease &&o) noexcept { *this = static_cast<Lease &&>(o); }
+        Lease &operator=(Lease &&o) noexcept;
+        ~Lease() { release(); }
+
+        void *data() const { return ptr_; }
+        template <typename T>
+        T *as() const { return static_cast<T *>(ptr_); }
+        size_t bytes() const { return bytes_; } // dung lượng thật của class (>= số byte xin)
+        explicit operator bool() const { return ptr_ != nullptr; }
+
+        void release();
+
+    private:
+        friend class ScratchArena;
+        ScratchArena *arena_ = nullptr;
+        void *ptr_ = nullptr;
+        size_t bytes_ = 0;
+        int32_t cls_ = -1;
+    };
+
+    ScratchArena();
+    ~ScratchArena();
+
+    // Buffer >= bytes (nội dung không xác định). bytes = 0 -> lease rỗng.
+    Lease borrow(size_t bytes);
+
+    // Giới hạn tổng byte rảnh được giữ lại; giảm cap sẽ trim ngay
+    void setCapBytes(size_t capBytes);
+    // Free buffer rảnh (class lớn trước) tới khi còn <= keepBytes. Buffer đang mượn không bị ảnh hưởng.
+    void trim(size_t keepBytes = 0);
+
+    size_t retainedBytes() const;  // đang rảnh trong free list
+    size_t leasedBytes() const;    // đang được render mượn
+    size_t highWaterBytes() const; // đỉnh (rảnh + mượn) kể từ lần trim(0) gần nhất
+
+private:
+    void giveBack(void *ptr, int32_t cls);
+    void trimLocked(size_t keepBytes);
+
+    mutable std::mutex mutex_;
+    std::vector<void *> free_[kClassCount];
+    size_t retained_ = 0;
+    size_t leased_ = 0;
+    size_t highWater_ = 0;
+    size_t cap_ = kDefaultCapBytes;
+};
+
+ScratchArena &scratchArena();
+
+// Mảng tạm kích thước tối đa biết trước trên buffer mượn (thay std::vector trong 1 render)
+template <typename T>
+class ScratchArray {
+    static_assert(std::is_trivially_destructible<T>::value, "ScratchArray không gọi destructor");
+    static_assert(alignof(T) <= ScratchArena::kAlignment, "căn lề vượt quá arena");
+
+public:
+    explicit ScratchArray(size_t capacity)
+        : lease_(scratchArena().borrow(capacity * sizeof(T))), data_(lease_.as<T>()),
+          capacity_(data_ ? capacity : 0) {}
+
+    bool push_back(const T &v) {
+        if (size_ == capacity_) return false;
+        new (data_ + size_) T(v);
+        ++size_;
+        return true;
+    }
+
+    T &operator[](size_t i) { return data_[i]; }
+    const T &operator[](size_t i) const { return data_[i]; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const T *begin() const { return data_; }
+    const T *end() const { return data_ + size_; }
+
+private:
+    ScratchArena::Lease lease_;
+    T *data_ = nullptr;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+};
+
+// Bộ đếm cấp phát heap của engine (operator new trong libadjust), chỉ có khi build với
+// ADJUST_ALLOC_COUNTER (mặc định ở Debug). Trả về -1 nếu không bật.
+int64_t engineAllocationCount();
@@ -0,0 +1,252 @@
+#include "adjust_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+// =============================================================
+// 🗜️ Codec: delta + block 16 byte
+// delta[i] = src[i] - src[i - 4] (cùng kênh của pixel bên trái). Ảnh preview mịn cho delta rất nhỏ:
+//   ZERO   : 16 delta = 0                 -> 1 byte header
+//   NIBBLE : 16 delta trong [-8, 7]       -> 1 + 8 byte
+//   RAW    : còn lại                       -> 1 + 16 byte
+// =============================================================
+namespace {
+
+constexpr size_t kBlock = 16;
+constexpr uint8_t kBlockZero = 0;
+constexpr uint8_t kBlockNibble = 1;
+constexpr uint8_t kBlockRaw = 2;
+
+inline uint8_t deltaAt(const uint8_t *src, size_t i) {
+    return static_cast<uint8_t>(i >= 4 ? src[i] - src[i - 4] : src[i]);
+}
+
+inline bool fitsNibble(uint8_t d) {
+    const auto s = static_cast<int8_t>(d);
+    return s >= -8 && s <= 7;
+}
+
+// Cộng 4 byte song song (mod 256 từng byte, không tràn sang byte bên cạnh)
+inline uint32_t addBytes(uint32_t a, uint32_t b) {
+    return ((a & 0x7F7F7F7Fu) + (b & 0x7F7F7F7Fu)) ^ ((a ^ b) & 0x80808080u);
+}
+
+} // namespace
+
+bool compressPixels(const uint8_t *src, size_t size, uint8_t *out, size_t &outSize) {
+    size_t o = 0;
+    uint8_t d[kBlock];
+    for (size_t pos = 0; pos < size; pos += kBlock) {
+        const size_t n = std::min(kBlock, size - pos);
+        bool zero = true, nibble = (n == kBlock);
+        for (size_t i = 0; i < n; ++i) {
+            d[i] = deltaAt(src, pos + i);
+            zero = zero && d[i] == 0u;
+            nibble = nibble && fitsNibble(d[i]);
+        }
+        if (zero && n == kBlock) {
+            out[o++] = kBlockZero;
+        } else if (nibble) {
+            out[o++] = kBlockNibble;
+            for (size_t i = 0; i < kBlock; i += 2) {
+                out[o++] = static_cast<uint8_t>((d[i] & 0x0Fu) | ((d[i + 1] & 0x0Fu) << 4));
+            }
+        } else {
+            out[o++] = kBlockRaw;
+            std::memcpy(out + o, d, n);
+            o += n;
+        }
+        // Không lợi -> bỏ, giữ bản raw (cũng đảm bảo không ghi quá `size` byte)
+        if (o >= size - size / 8) return false;
+    }
+    outSize = o;
+    return true;
+}
+
+bool decompressPixels(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize) {
+    size_t in = 0;
+    for (size_t pos = 0; pos < dstSize; pos += kBlock) {
+        if (in >= srcSize) return false;
+        const size_t n = std::min(kBlock, dstSize - pos);
+        const uint8_t tag = src[in++];
+        uint8_t d[kBlock] = {0};
+        if (tag == kBlockNibble) {
+            if (in + kBlock / 2 > srcSize) return false;
+            for (size_t i = 0; i < kBlock; i += 2) {
+                const uint8_t b = src[in++];
+                // sign-extend 4 bit
+                d[i]     = static_cast<uint8_t>(static_cast<int8_t>(static_cast<uint8_t>(b << 4)) >> 4);
+                d[i + 1] = static_cast<uint8_t>(static_cast<int8_t>(b & 0xF0u) >> 4);
+            }
+        } else if (tag == kBlockRaw) {
+            if (in + n > srcSize) return false;
+            std::memcpy(d, src + in, n);
+            in += n;
+        } else if (tag != kBlockZero) {
+            return false;
+        }
+        if (n == kBlock) {
+            // Block trọn = 4 pixel: cộng dồn cả pixel 1 lần thay vì từng byte
+            uint32_t px = 0;
+            if (pos >= 4) std::memcpy(&px, dst + pos - 4, 4);
+            for (size_t i = 0; i < kBlock; i += 4) {
+                uint32_t dp;
+                std::memcpy(&dp, d + i, 4);
+                px = addBytes(px, dp);
+                std::memcpy(dst + pos + i, &px, 4);
+            }
+            continue;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            const size_t k = pos + i;
+            dst[k] = static_cast<uint8_t>(k >= 4 ? dst[k - 4] + d[i] : d[i]);
+        }
+    }
+    return true;
+}
+
+// =============================================================
+// 🗃️ RenderCache
+// =============================================================
+void RenderCache::configure(size_t budgetBytes, bool compressCold) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_ = budgetBytes;
+    compressCold_ = compressCold;
+    evictToBudget();
+}
+
+void RenderCache::compressEntry(Entry &e) {
+    if (e.compressed || e.packTried) return;
+    e.packTried = true;
+    // Nén vào buffer tạm cỡ raw rồi chép sang buffer vừa khít (theo size class)
+    const ScratchArena::Lease tmp = scratchArena().borrow(e.size + kBlock + 1u);
+    size_t packedSize = 0;
+    if (!tmp || !compressPixels(e.data.as<uint8_t>(), e.size, tmp.as<uint8_t>(), packedSize)) return;
+    ScratchArena::Lease packed = scratchArena().borrow(packedSize);
+    if (!packed || packed.bytes() >= e.data.bytes()) return;
+    std::memcpy(packed.data(), tmp.data(), packedSize);
+    bytes_ -= e.data.bytes();
+    bytes_ += packed.bytes();
+    e.data = std::move(packed); // bản raw về arena -> buffer cho put kế tiếp
+    e.size = packedSize;
+    e.compressed = true;
+}
+
+void RenderCache::recycle(std::list<Entry>::iterator it) {
+    bytes_ -= it->data.bytes();
+    it->data.release();
+    if (spare_.size() < kSpareNodes) spare_.splice(spare_.begin(), lru_, it);
+    else lru_.erase(it);
+}
+
+void RenderCache::evictToBudget() {
+    while (!lru_.empty() && bytes_ > budget_) recycle(std::prev(lru_.end()));
+}
+
+void RenderCache::put(const RenderCacheKey &key, const uint8_t *pixels, size_t stride, const RenderStats *stats) {
+    const size_t rowBytes = static_cast<size_t>(key.width) * 4u;
+    const size_t size = rowBytes * static_cast<size_t>(key.height);
+    if (size == 0 || !pixels) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (size > budget_) return;
+
+    // Đã có -> bỏ bản cũ, bản mới lên đầu
+    for (auto it = lru_.begin(); it != lru_.end(); ++it) {
+        if (it->key == key) {
+            recycle(it);
+            break;
+        }
+    }
+
+    ScratchArena::Lease data = scratchArena().borrow(size);
+    if (!data) return;
+    if (spare_.empty()) lru_.emplace_front();
+    else lru_.splice(lru_.begin(), spare_, spare_.begin());
+    Entry &e = lru_.front();
+    e.key = key;
+    e.data = std::move(data);
+    e.size = size;
+    e.compressed = false;
+    e.packTried = false;
+    for (int32_t y = 0; y < key.height; ++y) {
+        std::memcpy(e.data.as<uint8_t>() + static_cast<size_t>(y) * rowBytes,
+                    pixels + static_cast<size_t>(y) * stride, rowBytes);
+    }
+    if (!stats) e.stats.reset();
+    else if (e.stats) *e.stats = *stats;
+    else e.stats.reset(new RenderStats(*stats));
+    bytes_ += e.data.bytes();
+
+    // Entry ra khỏi nhóm "nóng" -> nén (thường chỉ 1 entry mới, entry đã thử thì bỏ qua ngay)
+    if (compressCold_) {
+        size_t i = 0;
+        for (Entry &cold : lru_) {
+            if (i++ >= kHotEntries) compressEntry(cold);
+        }
+    }
+    evictToBudget();
+}
+
+bool RenderCache::get(const RenderCacheKey &key, uint8_t *pixels, size_t stride, bool needStats, RenderStats *outStats) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(lru_.begin(), lru_.end(), [&](const Entry &e) { return e.key == key; });
+    if (it == lru_.end()) return false;
+    if (needStats && !it->stats) return false;
+
+    const size_t rowBytes = static_cast<size_t>(key.width) * 4u;
+    const size_t size = rowBytes * static_cast<size_t>(key.height);
+    if (!it->compressed) {
+        if (stride == rowBytes) {
+            std::memcpy(pixels, it->data.data(), size);
+        } else {
+            for (int32_t y = 0; y < key.height; ++y) {
+                std::memcpy(pixels + static_cast<size_t>(y) * stride,
+                            it->data.as<uint8_t>() + static_cast<size_t>(y) * rowBytes, rowBytes);
+            }
+        }
+    } else if (stride == rowBytes) {
+        // Giải nén thẳng vào bitmap
+        if (!decompressPixels(it->data.as<uint8_t>(), it->size, pixels, size)) return false;
+    } else {
+        const ScratchArena::Lease tmp = scratchArena().borrow(size);
+        if (!tmp || !decompressPixels(it->data.as<uint8_t>(), it->size, tmp.as<uint8_t>(), size)) return false;
+        for (int32_t y = 0; y < key.height; ++y) {
+            std::memcpy(pixels + static_cast<size_t>(y) * stride,
+                        tmp.as<uint8_t>() + static_cast<size_t>(y) * rowBytes, rowBytes);
+        }
+    }
+    if (outStats && it->stats) *outStats = *it->stats;
+
+    lru_.splice(lru_.begin(), lru_, it);
+    return true;
+}
+
+void RenderCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    spare_.clear();
+    bytes_ = 0;
+}
+
+void RenderCache::trim(size_t keepBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!lru_.empty() && bytes_ > keepBytes) recycle(std::prev(lru_.end()));
+    if (lru_.empty()) spare_.clear();
+}
+
+size_t RenderCache::bytesUsed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+size_t RenderCache::entryCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lru_.size();
+}
+
+RenderCache &renderCache() {
+    static RenderCache cache;
+    return cache;
+}
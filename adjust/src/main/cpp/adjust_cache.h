@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+
+#include "adjust_arena.h"
+#include "adjust_stats.h"
+
+// =============================================================
+// 🗃️ RenderCache — LRU các ảnh preview đã render
+// Key = hash params (computeAdjustHash) + sourceId + kích thước. Hit = memcpy thẳng vào bitmap
+// thay vì render lại (undo/redo, bật/tắt before-after, quay lại filter vừa dùng).
+// Entry "nguội" (ngoài kHotEntries entry mới nhất) có thể được nén nhẹ để chứa được nhiều state hơn.
+// Dữ liệu entry mượn từ scratchArena(): buffer của state bị evict / bản raw vừa nén trở thành buffer
+// của state kế tiếp, node list + RenderStats của entry bị evict cũng được dùng lại.
+// =============================================================
+struct RenderCacheKey {
+    uint64_t hash = 0;
+    int64_t sourceId = 0;
+    int32_t width = 0, height = 0;
+
+    bool operator==(const RenderCacheKey &o) const {
+        return hash == o.hash && sourceId == o.sourceId && width == o.width && height == o.height;
+    }
+};
+
+class RenderCache {
+public:
+    static constexpr size_t kDefaultBudgetBytes = 64u * 1024u * 1024u;
+    static constexpr size_t kHotEntries = 2;
+
+    void configure(size_t budgetBytes, bool compressCold);
+
+    // Copy ảnh (width*4 byte mỗi hàng, stride tuỳ ý) vào cache; stats có thể null
+    void put(const RenderCacheKey &key, const uint8_t *pixels, size_t stride, const RenderStats *stats);
+
+    // Hit: ghi ảnh vào `pixels` (+ stats nếu entry có và outStats != null) rồi đưa entry lên đầu LRU.
+    // needStats = true mà entry không lưu stats -> coi như miss.
+    bool get(const RenderCacheKey &key, uint8_t *pixels, size_t stride, bool needStats, RenderStats *outStats);
+
+    void clear();
+    // Evict entry cũ nhất tới khi còn <= keepBytes (budget giữ nguyên); buffer trả về scratchArena()
+    void trim(size_t keepBytes);
+
+    size_t bytesUsed() const;
+    size_t entryCount() const;
+
+private:
+    static constexpr size_t kSpareNodes = 4;
+
+    struct Entry {
+        RenderCacheKey key;
+        ScratchArena::Lease data;       // raw (width*height*4) hoặc đã nén; budget tính theo data.bytes()
+        size_t size = 0;                // số byte dùng trong data
+        bool compressed = false;
+        bool packTried = false;         // đã thử nén (nén không lợi thì giữ raw, không thử lại)
+        std::unique_ptr<RenderStats> stats;
+    };
+
+    void evictToBudget();
+    void compressEntry(Entry &e);
+    void recycle(std::list<Entry>::iterator it);
+
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;               // đầu = mới dùng nhất
+    std::list<Entry> spare_;             // node đã bỏ (không còn data), put sau splice lại thay vì cấp phát
+    size_t bytes_ = 0;
+    size_t budget_ = kDefaultBudgetBytes;
+    bool compressCold_ = true;
+};
+
+// Codec nén nhẹ (lossless): delta theo pixel bên trái + block 16 byte mã hoá ZERO / NIBBLE / RAW.
+// Trả về false nếu không nén được nhỏ hơn đầu vào. out: >= size + 17 byte; outSize = số byte đã ghi.
+bool compressPixels(const uint8_t *src, size_t size, uint8_t *out, size_t &outSize);
+bool decompressPixels(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize);
+
+RenderCache &renderCache();
@@ -2,6 +2,8 @@
 
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
+#include <memory>
 #include <string>
 
 enum AdjustMask : uint64_t {
@@ -12,8 +14,69 @@ enum AdjustMask : uint64_t {
     MASK_GRAIN = 1ull << 4,
     MASK_HSL = 1ull << 5,
     MASK_LUT = 1ull << 6,
+    MASK_CURVES = 1ull << 7,
+    MASK_DENOISE = 1ull << 8,
 };
 
+// Tone curve: điểm điều khiển (x, y) trong [0, 1], x tăng dần (normalizeCurve); count < 2 = identity
+static constexpr int32_t kCurveMaxPoints = 16;
+
+struct ToneCurve {
+    int32_t count = 0;
+    float x[kCurveMaxPoints] = {0.f};
+    float y[kCurveMaxPoints] = {0.f};
+};
+
+// RED/GREEN/BLUE là kênh màu thật của RGBA_8888 (xem prepareToneTables: ánh xạ sang kênh engine)
+enum CurveChannel : int32_t {
+    CURVE_MASTER = 0,
+    CURVE_RED    = 1,
+    CURVE_GREEN  = 2,
+    CURVE_BLUE   = 3,
+    CURVE_COUNT  = 4,
+};
+
+// Node của pipeline graph (xem adjust_pipeline.h). Giá trị enum = thứ tự mặc định;
+// TONE = LIGHT + CURVES (curves đã gộp vào bảng của LIGHT nên luôn đi cùng nhau).
+enum PipelineStage : uint8_t {
+    STAGE_DENOISE  = 0,
+    STAGE_LUT      = 1,
+    STAGE_TONE     = 2,
+    STAGE_HSL      = 3,
+    STAGE_COLOR    = 4,
+    STAGE_DETAIL   = 5,
+    STAGE_VIGNETTE = 6,
+    STAGE_GRAIN    = 7,
+    STAGE_COUNT    = 8,
+};
+
+// Thứ tự áp stage phía Kotlin gửi xuống; count = 0 -> thứ tự mặc định
+struct PipelineOrder {
+    int32_t count = 0;
+    uint8_t stages[STAGE_COUNT] = {0};
+};
+
+// Geometry (xem adjust_geometry.h): xoay 90° / lật -> straighten quanh tâm -> crop
+enum GeometryInterp : int32_t {
+    GEOMETRY_BILINEAR = 0,
+    GEOMETRY_BICUBIC  = 1, // Catmull-Rom
+};
+
+struct GeometryParams {
+    float straighten = 0.f;            // độ, dương = theo chiều kim đồng hồ, quay quanh tâm khung đã xoay 90°
+    int32_t quarterTurns = 0;          // xoay 90° × n theo chiều kim đồng hồ
+    bool flipH = false, flipV = false; // lật sau khi xoay 90°
+    float crop[4] = {0.f, 0.f, 1.f, 1.f}; // [l, t, r, b] chuẩn hoá theo khung đã xoay 90° / lật
+    int32_t interp = GEOMETRY_BICUBIC;
+
+    bool active() const {
+        return straighten != 0.f || (quarterTurns & 3) != 0 || flipH || flipV
+               || crop[0] != 0.f || crop[1] != 0.f || crop[2] != 1.f || crop[3] != 1.f;
+    }
+};
+
+struct ToneTables; // adjust_curves.h
+
 struct AdjustParams {
     float exposure     = 0.f;
     float brightness   = 0.f;
@@ -35,6 +98,9 @@ struct AdjustParams {
     float vignette     = 0.f;
     float grain        = 0.f;
 
+    float denoiseLuma   = 0.f; // 0..1
+    float denoiseChroma = 0.f; // 0..1
+
     uint64_t activeMask = 0ull;
 
     // --- HSL ---
@@ -45,6 +111,19 @@ struct AdjustParams {
     // --- LUT ---
     std::string lutPath;
     float lutAmount = 1.0f;
+
+    // --- Tone curves ---
+    ToneCurve curves[CURVE_COUNT];
+
+    // --- Pipeline graph ---
+    PipelineOrder order;
+
+    // --- Geometry: chỉ render vùng (applyAdjustRegionNative) áp dụng, luôn đứng đầu pipeline ---
+    GeometryParams geometry;
+
+    // LIGHT + curves đã compile thành bảng 1D (prepareToneTables, 1 lần / lượt đổi params);
+    // null -> LIGHT tính trực tiếp như cũ
+    std::shared_ptr<const ToneTables> tone;
 };
 
 static inline float clampf(float v, float lo = 0.f, float hi = 1.f) {
@@ -0,0 +1,54 @@
+#include "adjust_cost.h"
+
+#include <algorithm>
+
+#include "adjust_common.h"
+
+// Chi phí tương đối (ns/px, 1 luồng, máy tầm trung) — chỉ dùng khi mask chưa có số đo.
+// Con số tuyệt đối không quan trọng: deviceFactor_ kéo về đúng máy sau vài render.
+double RenderCostModel::priorNsPerPixel(uint64_t mask) {
+    double ns = 2.0; // đọc/ghi pixel
+    if (mask & MASK_LIGHT)    ns += 20.0;
+    if (mask & MASK_COLOR)    ns += 6.0;
+    if (mask & MASK_HSL)      ns += 45.0;
+    if (mask & MASK_DETAIL)   ns += 25.0;
+    if (mask & MASK_VIGNETTE) ns += 8.0;
+    if (mask & MASK_GRAIN)    ns += 12.0;
+    if (mask & MASK_LUT)      ns += 25.0;
+    if ((mask & MASK_CURVES) && !(mask & MASK_LIGHT)) ns += 4.0; // có LIGHT thì curves nằm sẵn trong bảng của LIGHT
+    if (mask & MASK_DENOISE)  ns += 70.0;
+    return ns;
+}
+
+void RenderCostModel::record(uint64_t mask, int64_t pixels, int64_t nanos) {
+    if (pixels <= 0 || nanos <= 0) return;
+    const double measured = static_cast<double>(nanos) / static_cast<double>(pixels);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry &e = entries_[mask];
+    e.nsPerPixel = (e.samples == 0) ? measured : e.nsPerPixel + kEwmaAlpha * (measured - e.nsPerPixel);
+    ++e.samples;
+
+    const double ratio = measured / priorNsPerPixel(mask);
+    deviceFactor_ = (deviceSamples_ == 0) ? ratio : deviceFactor_ + kEwmaAlpha * (ratio - deviceFactor_);
+    ++deviceSamples_;
+}
+
+double RenderCostModel::estimateNsPerPixel(uint64_t mask) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(mask);
+    if (it != entries_.end() && it->second.samples > 0) return std::max(it->second.nsPerPixel, 1e-3);
+    return std::max(priorNsPerPixel(mask) * deviceFactor_, 1e-3);
+}
+
+void RenderCostModel::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    deviceFactor_ = 1.0;
+    deviceSamples_ = 0;
+}
+
+RenderCostModel &renderCostModel() {
+    static RenderCostModel model;
+    return model;
+}
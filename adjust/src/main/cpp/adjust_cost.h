@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+// =============================================================
+// ⏱️ RenderCostModel — thời gian render đo được theo tổ hợp stage
+// Mỗi render (full / region) ghi lại wall-time / số pixel output vào EWMA theo activeMask.
+// Mask chưa từng render -> ước lượng từ chi phí tương đối của từng stage × hệ số thiết bị
+// (hệ số này học từ mọi render, nên máy yếu/mạnh đều hiệu chỉnh sau 1-2 frame).
+// Phía Kotlin (PreviewQualityController) dùng ước lượng để chọn độ phân giải preview.
+// =============================================================
+class RenderCostModel {
+public:
+    static constexpr double kEwmaAlpha = 0.3;
+
+    // wall-time của 1 render `pixels` pixel output với tổ hợp stage `mask`
+    void record(uint64_t mask, int64_t pixels, int64_t nanos);
+
+    // ns / pixel output dự kiến (luôn > 0)
+    double estimateNsPerPixel(uint64_t mask) const;
+
+    void reset();
+
+private:
+    struct Entry {
+        double nsPerPixel = 0.0;
+        uint32_t samples = 0;
+    };
+
+    static double priorNsPerPixel(uint64_t mask);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, Entry> entries_;
+    double deviceFactor_ = 1.0; // đo được / prior, EWMA trên mọi mask
+    uint32_t deviceSamples_ = 0;
+};
+
+RenderCostModel &renderCostModel();
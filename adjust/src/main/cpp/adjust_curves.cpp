@@ -0,0 +1,86 @@
+#include "adjust_curves.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+void normalizeCurve(ToneCurve &c) {
+    c.count = std::clamp(c.count, 0, kCurveMaxPoints);
+    std::pair<float, float> pts[kCurveMaxPoints];
+    for (int32_t i = 0; i < c.count; ++i) pts[i] = {clampf(c.x[i]), clampf(c.y[i])};
+    std::stable_sort(pts, pts + c.count, [](const auto &a, const auto &b) { return a.first < b.first; });
+
+    int32_t n = 0;
+    for (int32_t i = 0; i < c.count; ++i) {
+        if (n > 0 && pts[i].first - c.x[n - 1] < 1e-4f) --n; // trùng x -> điểm sau thắng
+        c.x[n] = pts[i].first;
+        c.y[n] = pts[i].second;
+        ++n;
+    }
+    c.count = n;
+}
+
+bool curveIsIdentity(const ToneCurve &c) {
+    if (c.count < 2) return true;
+    for (int32_t i = 0; i < c.count; ++i) {
+        if (std::fabs(c.x[i] - c.y[i]) > 1e-4f) return false;
+    }
+    return true;
+}
+
+void sampleMonotoneCurve(const ToneCurve &c, float *out, int32_t n) {
+    const float step = 1.0f / static_cast<float>(n - 1);
+    if (c.count < 2) {
+        for (int32_t i = 0; i < n; ++i) out[i] = static_cast<float>(i) * step;
+        return;
+    }
+
+    // Fritsch–Carlson: tiếp tuyến ban đầu = trung bình secant, rồi co lại để giữ đơn điệu
+    const int32_t k = c.count;
+    float d[kCurveMaxPoints];  // secant
+    float m[kCurveMaxPoints];  // tiếp tuyến tại điểm
+    for (int32_t i = 0; i + 1 < k; ++i) d[i] = (c.y[i + 1] - c.y[i]) / (c.x[i + 1] - c.x[i]);
+    m[0] = d[0];
+    m[k - 1] = d[k - 2];
+    for (int32_t i = 1; i + 1 < k; ++i) m[i] = (d[i - 1] * d[i] <= 0.0f) ? 0.0f : 0.5f * (d[i - 1] + d[i]);
+    for (int32_t i = 0; i + 1 < k; ++i) {
+        if (d[i] == 0.0f) {
+            m[i] = m[i + 1] = 0.0f;
+            continue;
+        }
+        const float a = m[i] / d[i];
+        const float b = m[i + 1] / d[i];
+        const float s = a * a + b * b;
+        if (s > 9.0f) {
+            const float t = 3.0f / std::sqrt(s);
+            m[i] = t * a * d[i];
+            m[i + 1] = t * b * d[i];
+        }
+    }
+
+    int32_t seg = 0;
+    for (int32_t i = 0; i < n; ++i) {
+        const float x = static_cast<float>(i) * step;
+        if (x <= c.x[0]) { out[i] = c.y[0]; continue; }
+        if (x >= c.x[k - 1]) { out[i] = c.y[k - 1]; continue; }
+        while (seg + 2 < k && x > c.x[seg + 1]) ++seg;
+
+        // Hermite cubic trên đoạn [x_seg, x_seg+1]
+        const float h = c.x[seg + 1] - c.x[seg];
+        const float t = (x - c.x[seg]) / h;
+        const float t2 = t * t, t3 = t2 * t;
+        const float h00 = 2.0f * t3 - 3.0f * t2 + 1.0f;
+        const float h10 = t3 - 2.0f * t2 + t;
+        const float h01 = -2.0f * t3 + 3.0f * t2;
+        const float h11 = t3 - t2;
+        out[i] = clampf(h00 * c.y[seg] + h10 * h * m[seg] + h01 * c.y[seg + 1] + h11 * h * m[seg + 1]);
+    }
+}
+
+void applyCurveAdjust(float &r, float &g, float &b, const AdjustParams &p) {
+    const ToneTables *t = p.tone.get();
+    if (!t || t->lightOn) return;
+    r = t->post[0][toneTableIndex(r / 255.0f)];
+    g = t->post[1][toneTableIndex(g / 255.0f)];
+    b = t->post[2][toneTableIndex(b / 255.0f)];
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+#include "adjust_common.h"
+
+// =============================================================
+// 📈 Tone curves (master + R/G/B) + bảng 1D của LIGHT
+// Curve: spline cubic đơn điệu (Fritsch–Carlson) qua các điểm điều khiển -> không overshoot,
+// điểm tăng dần thì curve tăng dần.
+// Mỗi lần đổi params, phần 1D của LIGHT (sRGB -> linear -> exposure/contrast/brightness, rồi
+// tone map -> sRGB) cùng curves được compile thành bảng; per-pixel chỉ còn vài lần tra bảng.
+// Shadows/highlights/whites/blacks phụ thuộc luminance của cả 3 kênh nên vẫn tính giữa 2 bảng.
+// =============================================================
+static constexpr int32_t kToneTableSize = 4096;
+
+struct ToneTables {
+    bool lightOn = false;                 // LIGHT bật: post nhận giá trị linear; tắt: post nhận sRGB
+    float pre[256];                       // sRGB 8-bit -> linear sau exposure/contrast/brightness (đã clamp)
+    float post[3][kToneTableSize];        // [0, 1] -> 0..255, theo kênh engine (0 = bit 16..23, ..., 2 = bit 0..7)
+};
+
+// clamp [0, 1], sắp theo x, bỏ điểm trùng x (giữ điểm sau)
+void normalizeCurve(ToneCurve &c);
+
+bool curveIsIdentity(const ToneCurve &c);
+
+// Lấy mẫu curve tại n điểm đều trên [0, 1] (n >= 2); ngoài [x đầu, x cuối] giữ nguyên y biên
+void sampleMonotoneCurve(const ToneCurve &c, float *out, int32_t n);
+
+// Compile p.tone khi LIGHT hoặc CURVES bật (gọi sau khi nạp xong params)
+void prepareToneTables(AdjustParams &p);
+
+// CURVES khi LIGHT tắt (r/g/b 0..255). Khi LIGHT bật, curves đã gộp vào applyLightAdjust.
+void applyCurveAdjust(float &r, float &g, float &b, const AdjustParams &p);
+
+static inline int32_t toneTableIndex(float v01) {
+    return static_cast<int32_t>(std::clamp(v01, 0.0f, 1.0f) * static_cast<float>(kToneTableSize - 1) + 0.5f);
+}
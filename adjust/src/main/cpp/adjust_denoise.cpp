@@ -0,0 +1,304 @@
+#include "adjust_denoise.h"
+#include "adjust_arena.h"
+
+#include <cmath>
+#include <initializer_list>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ADJUST_DENOISE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define ADJUST_DENOISE_SSE2 1
+#endif
+
+DenoiseSettings denoiseSettings(const AdjustParams &p, float pxScale) {
+    DenoiseSettings s;
+    if (!(p.activeMask & MASK_DENOISE)) return s;
+
+    const float scale = std::clamp(pxScale, 0.05f, 1.0f);
+    auto radius = [scale](float full) {
+        return std::max(1, static_cast<int32_t>(std::lround(full * scale)));
+    };
+
+    // eps ~ (độ lệch chuẩn nhiễu cần xoá)^2; slider 0..1
+    const float luma = clampf(p.denoiseLuma);
+    if (luma > 0.0f) {
+        const float sigma = 0.01f + 0.07f * luma;
+        s.lumaRadius = radius(kDenoiseLumaRadius);
+        s.lumaEps = sigma * sigma;
+    }
+    const float chroma = clampf(p.denoiseChroma);
+    if (chroma > 0.0f) {
+        const float sigma = 0.02f + 0.10f * chroma;
+        s.chromaRadius = radius(kDenoiseChromaRadius);
+        s.chromaEps = sigma * sigma;
+    }
+    return s;
+}
+
+// =============================================================
+// Vòng lặp theo hàng (SIMD)
+// =============================================================
+
+// acc += add (nếu có); acc -= sub (nếu có)
+static void rowAddSub(float *acc, const float *add, const float *sub, int32_t n) {
+    int32_t i = 0;
+#if defined(ADJUST_DENOISE_NEON)
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t v = vld1q_f32(acc + i);
+        if (add) v = vaddq_f32(v, vld1q_f32(add + i));
+        if (sub) v = vsubq_f32(v, vld1q_f32(sub + i));
+        vst1q_f32(acc + i, v);
+    }
+#elif defined(ADJUST_DENOISE_SSE2)
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(acc + i);
+        if (add) v = _mm_add_ps(v, _mm_loadu_ps(add + i));
+        if (sub) v = _mm_sub_ps(v, _mm_loadu_ps(sub + i));
+        _mm_storeu_ps(acc + i, v);
+    }
+#endif
+    for (; i < n; ++i) {
+        if (add) acc[i] += add[i];
+        if (sub) acc[i] -= sub[i];
+    }
+}
+
+// dst = (hi - lo) * invX * s
+static void rowDiffScale(float *dst, const float *hi, const float *lo, const float *invX, float s, int32_t n) {
+    int32_t i = 0;
+#if defined(ADJUST_DENOISE_NEON)
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t d = vsubq_f32(vld1q_f32(hi + i), vld1q_f32(lo + i));
+        vst1q_f32(dst + i, vmulq_n_f32(vmulq_f32(d, vld1q_f32(invX + i)), s));
+    }
+#elif defined(ADJUST_DENOISE_SSE2)
+    const __m128 vs = _mm_set1_ps(s);
+    for (; i + 4 <= n; i += 4) {
+        const __m128 d = _mm_sub_ps(_mm_loadu_ps(hi + i), _mm_loadu_ps(lo + i));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_mul_ps(d, _mm_loadu_ps(invX + i)), vs));
+    }
+#endif
+    for (; i < n; ++i) dst[i] = (hi[i] - lo[i]) * invX[i] * s;
+}
+
+// Hệ số guided filter: a = var / (var + eps), b = mean - a * mean (ghi đè meanII -> a, meanI -> b)
+static void rowGuidedCoeffs(float *meanI, float *meanII, float eps, int32_t n) {
+    int32_t i = 0;
+#if defined(ADJUST_DENOISE_NEON)
+    const float32x4_t vEps = vdupq_n_f32(eps);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t m = vld1q_f32(meanI + i);
+        const float32x4_t var = vmaxq_f32(vsubq_f32(vld1q_f32(meanII + i), vmulq_f32(m, m)), zero);
+        const float32x4_t den = vaddq_f32(var, vEps);
+#if defined(__aarch64__)
+        const float32x4_t a = vdivq_f32(var, den);
+#else
+        // ARMv7 không có phép chia vector: ước lượng 1/x + 2 bước Newton
+        float32x4_t inv = vrecpeq_f32(den);
+        inv = vmulq_f32(vrecpsq_f32(den, inv), inv);
+        inv = vmulq_f32(vrecpsq_f32(den, inv), inv);
+        const float32x4_t a = vmulq_f32(var, inv);
+#endif
+        vst1q_f32(meanII + i, a);
+        vst1q_f32(meanI + i, vsubq_f32(m, vmulq_f32(a, m)));
+    }
+#elif defined(ADJUST_DENOISE_SSE2)
+    const __m128 vEps = _mm_set1_ps(eps);
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        const __m128 m = _mm_loadu_ps(meanI + i);
+        const __m128 var = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(meanII + i), _mm_mul_ps(m, m)), zero);
+        const __m128 a = _mm_div_ps(var, _mm_add_ps(var, vEps));
+        _mm_storeu_ps(meanII + i, a);
+        _mm_storeu_ps(meanI + i, _mm_sub_ps(m, _mm_mul_ps(a, m)));
+    }
+#endif
+    for (; i < n; ++i) {
+        const float m = meanI[i];
+        const float var = std::max(meanII[i] - m * m, 0.0f);
+        const float a = var / (var + eps);
+        meanII[i] = a;
+        meanI[i] = m - a * m;
+    }
+}
+
+// io = meanA * io + meanB
+static void rowGuidedApply(float *io, const float *meanA, const float *meanB, int32_t n) {
+    int32_t i = 0;
+#if defined(ADJUST_DENOISE_NEON)
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(io + i, vaddq_f32(vmulq_f32(vld1q_f32(meanA + i), vld1q_f32(io + i)), vld1q_f32(meanB + i)));
+    }
+#elif defined(ADJUST_DENOISE_SSE2)
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(io + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(meanA + i), _mm_loadu_ps(io + i)),
+                                         _mm_loadu_ps(meanB + i)));
+    }
+#endif
+    for (; i < n; ++i) io[i] = meanA[i] * io[i] + meanB[i];
+}
+
+// =============================================================
+// Box filter (trung bình cửa sổ (2r+1)^2, cắt theo biên plane)
+// Dọc: tổng trượt theo cột (SIMD trên cả hàng). Ngang: prefix sum rồi hiệu 2 đầu cửa sổ.
+// =============================================================
+// Con trỏ vào 1 buffer mượn từ scratchArena() cho cả denoiseRect (tile lớn nhất + halo)
+struct DenoiseScratch {
+    float *planes[3]; // Y, Cb, Cr
+    float *sq, *meanI, *meanII, *tmp;
+    float *acc, *prefix, *hi, *lo, *invX;
+};
+
+static void boxFilter(const float *src, float *dst, int32_t w, int32_t h, int32_t r, DenoiseScratch &s) {
+    const size_t sw = static_cast<size_t>(w);
+    std::fill(s.acc, s.acc + sw, 0.0f);
+    for (int32_t x = 0; x < w; ++x) {
+        const int32_t cnt = std::min(w - 1, x + r) - std::max(0, x - r) + 1;
+        s.invX[static_cast<size_t>(x)] = 1.0f / static_cast<float>(cnt);
+    }
+
+    for (int32_t y = 0; y <= std::min(r, h - 1); ++y) rowAddSub(s.acc, src + static_cast<size_t>(y) * sw, nullptr, w);
+
+    for (int32_t y = 0; y < h; ++y) {
+        // acc = tổng các hàng [y - r, y + r] ∩ [0, h)
+        s.prefix[0] = 0.0f;
+        for (size_t x = 0; x < sw; ++x) s.prefix[x + 1u] = s.prefix[x] + s.acc[x];
+        for (int32_t x = 0; x < w; ++x) {
+            s.hi[static_cast<size_t>(x)] = s.prefix[static_cast<size_t>(std::min(w, x + r + 1))];
+            s.lo[static_cast<size_t>(x)] = s.prefix[static_cast<size_t>(std::max(0, x - r))];
+        }
+        const int32_t cntY = std::min(h - 1, y + r) - std::max(0, y - r) + 1;
+        rowDiffScale(dst + static_cast<size_t>(y) * sw, s.hi, s.lo, s.invX,
+                     1.0f / static_cast<float>(cntY), w);
+
+        const int32_t addY = y + r + 1;
+        const int32_t subY = y - r;
+        rowAddSub(s.acc,
+                  addY < h ? src + static_cast<size_t>(addY) * sw : nullptr,
+                  subY >= 0 ? src + static_cast<size_t>(subY) * sw : nullptr, w);
+    }
+}
+
+// q = guided(P, P): ghi đè plane
+static void guidedFilterPlane(float *plane, int32_t w, int32_t h, int32_t r, float eps, DenoiseScratch &s) {
+    const size_t n = static_cast<size_t>(w) * static_cast<size_t>(h);
+    for (size_t i = 0; i < n; ++i) s.sq[i] = plane[i] * plane[i];
+
+    boxFilter(plane, s.meanI, w, h, r, s);
+    boxFilter(s.sq, s.meanII, w, h, r, s);
+    for (int32_t y = 0; y < h; ++y) {
+        const size_t o = static_cast<size_t>(y) * static_cast<size_t>(w);
+        rowGuidedCoeffs(s.meanI + o, s.meanII + o, eps, w);
+    }
+    // meanII = a, meanI = b -> trung bình a (tmp), b (sq)
+    boxFilter(s.meanII, s.tmp, w, h, r, s);
+    boxFilter(s.meanI, s.sq, w, h, r, s);
+    for (int32_t y = 0; y < h; ++y) {
+        const size_t o = static_cast<size_t>(y) * static_cast<size_t>(w);
+        rowGuidedApply(plane + o, s.tmp + o, s.sq + o, w);
+    }
+}
+
+// =============================================================
+// Tile: RGBA -> Y/Cb/Cr (kênh thật: R = bit 0..7, B = bit 16..23) -> lọc -> RGBA
+// =============================================================
+static constexpr float kInv255 = 1.0f / 255.0f;
+
+static void denoiseTile(const uint32_t *const *rows, int32_t rowsTop, int32_t width, int32_t height,
+                        int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                        const DenoiseSettings &ds, bool premultiplied,
+                        uint8_t *out, size_t outStride, DenoiseScratch &s) {
+    const int32_t halo = ds.halo();
+    const int32_t ex0 = std::max(0, x0 - halo), ex1 = std::min(width, x1 + halo);
+    const int32_t ey0 = std::max(0, y0 - halo), ey1 = std::min(height, y1 + halo);
+    const int32_t w = ex1 - ex0, h = ey1 - ey0;
+    float *pY = s.planes[0];
+    float *pCb = s.planes[1];
+    float *pCr = s.planes[2];
+
+    for (int32_t y = ey0; y < ey1; ++y) {
+        const uint32_t *row = rows[y - rowsTop];
+        const size_t o = static_cast<size_t>(y - ey0) * static_cast<size_t>(w);
+        for (int32_t x = ex0; x < ex1; ++x) {
+            const uint32_t c = row[x];
+            float rr = static_cast<float>(c & 0xFFu);
+            float gg = static_cast<float>((c >> 8) & 0xFFu);
+            float bb = static_cast<float>((c >> 16) & 0xFFu);
+            const uint32_t a = c >> 24;
+            if (premultiplied && a > 0u && a < 255u) {
+                const float inv = 255.0f / static_cast<float>(a);
+                rr = std::min(255.0f, rr * inv);
+                gg = std::min(255.0f, gg * inv);
+                bb = std::min(255.0f, bb * inv);
+            }
+            rr *= kInv255;
+            gg *= kInv255;
+            bb *= kInv255;
+            const float yy = 0.299f * rr + 0.587f * gg + 0.114f * bb;
+            const size_t i = o + static_cast<size_t>(x - ex0);
+            pY[i] = yy;
+            pCb[i] = bb - yy;
+            pCr[i] = rr - yy;
+        }
+    }
+
+    if (ds.lumaRadius > 0) guidedFilterPlane(pY, w, h, ds.lumaRadius, ds.lumaEps, s);
+    if (ds.chromaRadius > 0) {
+        guidedFilterPlane(pCb, w, h, ds.chromaRadius, ds.chromaEps, s);
+        guidedFilterPlane(pCr, w, h, ds.chromaRadius, ds.chromaEps, s);
+    }
+
+    for (int32_t y = y0; y < y1; ++y) {
+        const uint32_t *row = rows[y - rowsTop];
+        auto *dst = reinterpret_cast<uint32_t *>(out + static_cast<size_t>(y - y0) * outStride);
+        const size_t o = static_cast<size_t>(y - ey0) * static_cast<size_t>(w);
+        for (int32_t x = x0; x < x1; ++x) {
+            const uint32_t c = row[x];
+            const uint32_t a = c >> 24;
+            if (premultiplied && a == 0u) {
+                dst[x - x0] = c;
+                continue;
+            }
+            const size_t i = o + static_cast<size_t>(x - ex0);
+            const float yy = pY[i];
+            const float rr = clampf(pCr[i] + yy);
+            const float bb = clampf(pCb[i] + yy);
+            const float gg = clampf((yy - 0.299f * rr - 0.114f * bb) * (1.0f / 0.587f));
+            const float scale = (premultiplied ? static_cast<float>(a) : 255.0f);
+            const auto q = [scale](float v) { return static_cast<uint32_t>(v * scale + 0.5f); };
+            dst[x - x0] = (c & 0xFF000000u) | (q(bb) << 16) | (q(gg) << 8) | q(rr);
+        }
+    }
+}
+
+void denoiseRect(const uint32_t *const *rows, int32_t rowsTop, int32_t width, int32_t height,
+                 int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                 const DenoiseSettings &s, bool premultiplied,
+                 uint8_t *out, size_t outStride) {
+    // Tile lớn nhất kèm halo: 7 plane + 5 hàng (prefix dài hơn 1)
+    const int32_t halo = s.halo();
+    const size_t maxW = static_cast<size_t>(std::min(width, kDenoiseTileW + 2 * halo));
+    const size_t maxH = static_cast<size_t>(std::min(height, kDenoiseTileH + 2 * halo));
+    const size_t n = maxW * maxH;
+    const ScratchArena::Lease lease = scratchArena().borrow((7u * n + 5u * maxW + 1u) * sizeof(float));
+    if (!lease) return;
+    DenoiseScratch scratch{};
+    float *cursor = lease.as<float>();
+    for (float *&pl : scratch.planes) { pl = cursor; cursor += n; }
+    for (float **pl : {&scratch.sq, &scratch.meanI, &scratch.meanII, &scratch.tmp}) { *pl = cursor; cursor += n; }
+    for (float **row : {&scratch.acc, &scratch.hi, &scratch.lo, &scratch.invX}) { *row = cursor; cursor += maxW; }
+    scratch.prefix = cursor;
+
+    for (int32_t ty = y0; ty < y1; ty += kDenoiseTileH) {
+        const int32_t ty1 = std::min(y1, ty + kDenoiseTileH);
+        for (int32_t tx = x0; tx < x1; tx += kDenoiseTileW) {
+            const int32_t tx1 = std::min(x1, tx + kDenoiseTileW);
+            denoiseTile(rows, rowsTop, width, height, tx, ty, tx1, ty1, s, premultiplied,
+                        out + static_cast<size_t>(ty - y0) * outStride + static_cast<size_t>(tx - x0) * 4u,
+                        outStride, scratch);
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "adjust_common.h"
+
+// =============================================================
+// 🔇 Noise reduction (luminance + chroma) — guided filter tự dẫn (He et al.)
+// Ảnh được tách Y / Cb / Cr; mỗi plane lọc với bán kính + eps riêng:
+//   vùng phẳng (variance << eps) -> làm mượt, cạnh (variance >> eps) -> giữ nguyên.
+// Mọi box filter là O(1) / pixel theo bán kính (tổng trượt), vòng lặp theo hàng dùng SIMD.
+// Stage KHÔNG point-wise: chạy trên tile có halo = 2 × bán kính lớn nhất; mặc định đứng trước mọi stage
+// khác, vị trí thật theo pipeline graph (adjust_pipeline.h).
+// =============================================================
+static constexpr int32_t kDenoiseTileW = 128;
+static constexpr int32_t kDenoiseTileH = 64;
+
+// Bán kính đo ở độ phân giải đầy đủ của ảnh; proxy (preview thu nhỏ) co lại theo tỉ lệ
+static constexpr float kDenoiseLumaRadius = 2.0f;
+static constexpr float kDenoiseChromaRadius = 5.0f;
+
+struct DenoiseSettings {
+    int32_t lumaRadius = 0;   // 0 = tắt
+    int32_t chromaRadius = 0; // 0 = tắt
+    float lumaEps = 0.f;      // ngưỡng variance, thang [0, 1]^2
+    float chromaEps = 0.f;
+
+    bool active() const { return lumaRadius > 0 || chromaRadius > 0; }
+    // guided filter = 2 lớp box lồng nhau -> cần 2r hàng/cột ngoài vùng output
+    int32_t halo() const { return 2 * std::max(lumaRadius, chromaRadius); }
+};
+
+// pxScale: số pixel đang render / 1 pixel ảnh gốc (1 = full, 0.25 = proxy 1/4)
+DenoiseSettings denoiseSettings(const AdjustParams &p, float pxScale);
+
+// Lọc vùng [x0, x1) × [y0, y1) của ảnh width × height (RGBA_8888, kênh theo vị trí bit như pipeline).
+// rows[y - rowsTop] = hàng y của ảnh nguồn, phải có đủ [y0 - halo, y1 + halo) ∩ [0, height).
+// out: pixel (x0, y0) của kết quả; alpha giữ nguyên. Ngoài biên ảnh box filter chuẩn hoá theo số pixel thật.
+void denoiseRect(const uint32_t *const *rows, int32_t rowsTop, int32_t width, int32_t height,
+                 int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                 const DenoiseSettings &s, bool premultiplied,
+                 uint8_t *out, size_t outStride);
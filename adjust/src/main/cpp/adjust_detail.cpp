@@ -68,10 +68,25 @@ extern "C" void applyVignetteAt(float &rf, float &gf, float &bf,
     bf *= f;
 }
 
+// Hash toạ độ -> noise xác định theo vị trí (thay cho std::rand):
+// cùng 1 pixel của ảnh gốc luôn nhận cùng 1 hạt grain, dù render full hay chỉ 1 vùng.
+static inline uint32_t grainHash(uint32_t x, uint32_t y) {
+    uint32_t h = x * 0x8da6b343u ^ y * 0xd8163841u;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
 extern "C" void applyGrainAt(float &rf, float &gf, float &bf,
+                             float x, float y,
                              const AdjustParams &p) {
     if (p.grain <= 0.f) return;
-    const float noise = ((std::rand() % 200 - 100) / 100.f) * (p.grain * 0.20f);
+    const uint32_t h = grainHash(static_cast<uint32_t>(static_cast<int32_t>(x)),
+                                 static_cast<uint32_t>(static_cast<int32_t>(y)));
+    const float noise = (static_cast<float>(static_cast<int32_t>(h % 200u) - 100) / 100.f) * (p.grain * 0.20f);
     rf = clampf(rf + noise);
     gf = clampf(gf + noise);
     bf = clampf(bf + noise);
@@ -0,0 +1,267 @@
+#include "adjust_fixed.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ADJUST_FIXED_NEON 1
+#endif
+
+extern void applyLightAdjust(float &r, float &g, float &b, const AdjustParams &p);
+extern void applyCurveAdjust(float &r, float &g, float &b, const AdjustParams &p);
+
+bool fixedPathEligible(const AdjustParams &p) {
+    static constexpr uint64_t kFixedStages = MASK_LIGHT | MASK_COLOR | MASK_LUT | MASK_CURVES;
+    const uint64_t mask = p.activeMask;
+    if (mask & ~kFixedStages) return false;
+    // Các tone adjust phụ thuộc luminance của cả 3 kênh -> không còn là đường cong 1D
+    if ((mask & MASK_LIGHT) && (p.shadows != 0.f || p.highlights != 0.f || p.whites != 0.f || p.blacks != 0.f)) return false;
+    if ((mask & MASK_COLOR) && p.vibrance != 0.f) return false;
+    return true;
+}
+
+static inline int32_t toQ(float v, int32_t one) {
+    return static_cast<int32_t>(std::lround(v * static_cast<float>(one)));
+}
+
+bool buildFixedPipeline(const AdjustParams &p, const Lut3D *lut, float lutT, bool premultiplied, FixedPipeline &out) {
+    out.premultiplied = premultiplied;
+    const uint64_t mask = p.activeMask;
+
+    out.lutOn = (mask & MASK_LUT) && lut && lut->packedValid();
+    if (out.lutOn) {
+        out.lutSize = lut->size;
+        out.lut = lut->packed.data();
+        out.lutT = toQ(clampf(lutT), 256);
+    }
+
+    out.adjustOn = (mask & (MASK_LIGHT | MASK_COLOR | MASK_CURVES)) != 0;
+    out.colorOn = (mask & MASK_COLOR) != 0;
+
+    // LIGHT/CURVES: đường cong 1D mỗi kênh, đánh giá đúng hàm float tại 256 mức
+    for (int32_t v = 0; v < 256; ++v) {
+        float c[3] = {static_cast<float>(v), static_cast<float>(v), static_cast<float>(v)};
+        if (mask & MASK_LIGHT) applyLightAdjust(c[0], c[1], c[2], p);
+        else if (mask & MASK_CURVES) applyCurveAdjust(c[0], c[1], c[2], p);
+        for (int32_t ch = 0; ch < 3; ++ch) {
+            out.tone[ch][v] = static_cast<int16_t>(toQ(std::clamp(c[ch], 0.f, 255.f) / 255.f, kFixedOne));
+        }
+    }
+
+    // COLOR: out = M (c + t), M = (1 + s) I - s * 1 * w^T
+    float m[9] = {1.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f};
+    float t[3] = {0.f, 0.f, 0.f};
+    if (out.colorOn) {
+        const float s = p.saturation;
+        const float w[3] = {0.299f, 0.587f, 0.114f};
+        for (int32_t r = 0; r < 3; ++r) {
+            for (int32_t c = 0; c < 3; ++c) m[r * 3 + c] = (r == c ? 1.f + s : 0.f) - s * w[c];
+        }
+        t[0] = p.temperature * 0.25f + p.tint * 0.125f;
+        t[1] = -p.tint * 0.25f;
+        t[2] = -p.temperature * 0.25f + p.tint * 0.125f;
+    }
+    for (int32_t r = 0; r < 3; ++r) {
+        float b = 0.f;
+        for (int32_t c = 0; c < 3; ++c) {
+            const int32_t q = toQ(m[r * 3 + c], kFixedOne);
+            if (q < INT16_MIN || q > INT16_MAX) return false; // saturation quá lớn cho Q12 16-bit
+            out.matrix[r * 3 + c] = static_cast<int16_t>(q);
+            b += m[r * 3 + c] * t[c];
+        }
+        // bias ở Q24 để cộng thẳng vào tích Q12 x Q12
+        out.bias[r] = toQ(b, kFixedOne * kFixedOne);
+    }
+    return true;
+}
+
+// 8-bit -> unorm16 cho giá trị gốc khi blend LUT (x * 65535 / 255 = x * 257, chính xác)
+static inline int32_t unorm16Of8(int32_t v) { return v * 257; }
+
+// Tetrahedral: 4 đỉnh thay vì 8 (trilinear), trọng số /255 theo phần lẻ của vị trí 8-bit
+static inline void tetraSample(const FixedPipeline &fp, int32_t u0, int32_t u1, int32_t u2, int32_t out[3]) {
+    const int32_t S = fp.lutSize;
+    const int32_t p0 = u0 * (S - 1), p1 = u1 * (S - 1), p2 = u2 * (S - 1);
+    const int32_t i0 = p0 / 255, i1 = p1 / 255, i2 = p2 / 255;
+    const int32_t f0 = p0 - i0 * 255, f1 = p1 - i1 * 255, f2 = p2 - i2 * 255;
+    const int32_t d0 = (i0 < S - 1) ? S * S * 4 : 0;
+    const int32_t d1 = (i1 < S - 1) ? S * 4 : 0;
+    const int32_t d2 = (i2 < S - 1) ? 4 : 0;
+    const uint16_t *c000 = fp.lut + ((i0 * S + i1) * S + i2) * 4;
+
+    // Chọn tứ diện theo thứ tự f0/f1/f2: đi từ c000 lần lượt qua trục có phần lẻ lớn nhất
+    int32_t fa, fb, fc, da, db;
+    if (f0 >= f1) {
+        if (f1 >= f2)      { fa = f0; fb = f1; fc = f2; da = d0; db = d0 + d1; }
+        else if (f0 >= f2) { fa = f0; fb = f2; fc = f1; da = d0; db = d0 + d2; }
+        else               { fa = f2; fb = f0; fc = f1; da = d2; db = d2 + d0; }
+    } else {
+        if (f0 >= f2)      { fa = f1; fb = f0; fc = f2; da = d1; db = d1 + d0; }
+        else if (f1 >= f2) { fa = f1; fb = f2; fc = f0; da = d1; db = d1 + d2; }
+        else               { fa = f2; fb = f1; fc = f0; da = d2; db = d2 + d1; }
+    }
+    const uint16_t *ca = c000 + da;
+    const uint16_t *cb = c000 + db;
+    const uint16_t *c111 = c000 + d0 + d1 + d2;
+    for (int32_t c = 0; c < 3; ++c) {
+        const int32_t sum = (255 - fa) * c000[c] + (fa - fb) * ca[c] + (fb - fc) * cb[c] + fc * c111[c];
+        out[c] = (sum + 127) / 255;
+    }
+}
+
+static inline uint32_t lutPixelFixed(const FixedPipeline &fp, uint32_t c, RenderStats *stats) {
+    const int32_t a = static_cast<int32_t>(c >> 24);
+    int32_t u[3] = {static_cast<int32_t>((c >> 16) & 0xFFu), static_cast<int32_t>((c >> 8) & 0xFFu),
+                    static_cast<int32_t>(c & 0xFFu)};
+    const bool unpremul = fp.premultiplied && a > 0;
+    if (unpremul) {
+        for (int32_t &v : u) v = std::min(255, (v * 255) / a);
+    }
+    int32_t l[3];
+    tetraSample(fp, u[0], u[1], u[2], l);
+
+    const int32_t scale = unpremul ? a : 255;
+    uint32_t outc = static_cast<uint32_t>(a) << 24;
+    for (int32_t ch = 0; ch < 3; ++ch) {
+        const int32_t v = (unorm16Of8(u[ch]) * (256 - fp.lutT) + l[ch] * fp.lutT + 128) >> 8;
+        u[ch] = (v * 255 + 2048) >> kLutFixedShift; // straight (cho stats)
+        const int32_t o = (v * scale + 2048) >> kLutFixedShift;
+        outc |= static_cast<uint32_t>(o) << (16 - 8 * ch);
+    }
+    if (stats) stats->accumulateLanes(static_cast<uint8_t>(u[0]), static_cast<uint8_t>(u[1]), static_cast<uint8_t>(u[2]));
+    return outc;
+}
+
+// Matrix + scale output cho 1 pixel (bản tham chiếu của nhánh NEON, cho kết quả giống hệt)
+static inline int32_t matrixRow(const FixedPipeline &fp, int32_t row, int32_t t0, int32_t t1, int32_t t2) {
+    int32_t acc = fp.matrix[row * 3] * t0 + fp.matrix[row * 3 + 1] * t1 + fp.matrix[row * 3 + 2] * t2;
+    acc = (acc + fp.bias[row] + (kFixedOne >> 1)) >> kFixedShift;
+    return std::clamp(acc, 0, kFixedOne);
+}
+
+static inline void gatherTone(const FixedPipeline &fp, uint32_t c, int32_t &t0, int32_t &t1, int32_t &t2, int32_t &scale) {
+    const int32_t a = static_cast<int32_t>(c >> 24);
+    int32_t u0 = static_cast<int32_t>((c >> 16) & 0xFFu);
+    int32_t u1 = static_cast<int32_t>((c >> 8) & 0xFFu);
+    int32_t u2 = static_cast<int32_t>(c & 0xFFu);
+    const bool unpremul = fp.premultiplied && a > 0;
+    if (unpremul) {
+        u0 = std::min(255, (u0 * 255) / a);
+        u1 = std::min(255, (u1 * 255) / a);
+        u2 = std::min(255, (u2 * 255) / a);
+    }
+    t0 = fp.tone[0][u0];
+    t1 = fp.tone[1][u1];
+    t2 = fp.tone[2][u2];
+    scale = unpremul ? a : 255;
+}
+
+static inline uint32_t adjustPixelFixed(const FixedPipeline &fp, uint32_t c, RenderStats *stats) {
+    int32_t t0, t1, t2, scale;
+    gatherTone(fp, c, t0, t1, t2, scale);
+    uint32_t outc = c & 0xFF000000u;
+    int32_t straight[3];
+    for (int32_t ch = 0; ch < 3; ++ch) {
+        const int32_t o = matrixRow(fp, ch, t0, t1, t2);
+        straight[ch] = (o * 255 + 128) >> kFixedShift;
+        outc |= static_cast<uint32_t>((o * scale + 128) >> kFixedShift) << (16 - 8 * ch);
+    }
+    if (stats) {
+        stats->accumulateLanes(static_cast<uint8_t>(straight[0]), static_cast<uint8_t>(straight[1]),
+                                static_cast<uint8_t>(straight[2]));
+    }
+    return outc;
+}
+
+#ifdef ADJUST_FIXED_NEON
+// 8 pixel / lần: tra bảng tone (vô hướng) rồi ma trận + scale output bằng NEON integer
+static void adjustBlock8Neon(const FixedPipeline &fp, const uint32_t *src, uint32_t *dst, RenderStats *stats) {
+    int16_t t[3][8];
+    uint16_t sc[8];
+    uint8_t alpha[8];
+    for (int32_t i = 0; i < 8; ++i) {
+        int32_t t0, t1, t2, scale;
+        gatherTone(fp, src[i], t0, t1, t2, scale);
+        t[0][i] = static_cast<int16_t>(t0);
+        t[1][i] = static_cast<int16_t>(t1);
+        t[2][i] = static_cast<int16_t>(t2);
+        sc[i] = static_cast<uint16_t>(scale);
+        alpha[i] = static_cast<uint8_t>(src[i] >> 24);
+    }
+    const int16x8_t v0 = vld1q_s16(t[0]);
+    const int16x8_t v1 = vld1q_s16(t[1]);
+    const int16x8_t v2 = vld1q_s16(t[2]);
+    const uint16x8_t vs = vld1q_u16(sc);
+    const int16x8_t zero = vdupq_n_s16(0);
+    const int16x8_t one = vdupq_n_s16(static_cast<int16_t>(kFixedOne));
+
+    uint8x8_t outCh[3];
+    uint8_t straight[3][8];
+    for (int32_t ch = 0; ch < 3; ++ch) {
+        const int16_t m0 = fp.matrix[ch * 3], m1 = fp.matrix[ch * 3 + 1], m2 = fp.matrix[ch * 3 + 2];
+        const int32x4_t bias = vdupq_n_s32(fp.bias[ch] + (kFixedOne >> 1));
+        int32x4_t lo = vmull_n_s16(vget_low_s16(v0), m0);
+        lo = vmlal_n_s16(lo, vget_low_s16(v1), m1);
+        lo = vmlal_n_s16(lo, vget_low_s16(v2), m2);
+        int32x4_t hi = vmull_n_s16(vget_high_s16(v0), m0);
+        hi = vmlal_n_s16(hi, vget_high_s16(v1), m1);
+        hi = vmlal_n_s16(hi, vget_high_s16(v2), m2);
+        lo = vshrq_n_s32(vaddq_s32(lo, bias), kFixedShift);
+        hi = vshrq_n_s32(vaddq_s32(hi, bias), kFixedShift);
+        int16x8_t o = vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi));
+        o = vminq_s16(vmaxq_s16(o, zero), one);
+        const uint16x8_t ou = vreinterpretq_u16_s16(o);
+
+        const uint32x4_t rnd = vdupq_n_u32(128);
+        const uint32x4_t plo = vaddq_u32(vmull_u16(vget_low_u16(ou), vget_low_u16(vs)), rnd);
+        const uint32x4_t phi = vaddq_u32(vmull_u16(vget_high_u16(ou), vget_high_u16(vs)), rnd);
+        outCh[ch] = vmovn_u16(vcombine_u16(vshrn_n_u32(plo, kFixedShift), vshrn_n_u32(phi, kFixedShift)));
+
+        if (stats) {
+            const uint16x8_t k255 = vdupq_n_u16(255);
+            const uint32x4_t slo = vaddq_u32(vmull_u16(vget_low_u16(ou), vget_low_u16(k255)), rnd);
+            const uint32x4_t shi = vaddq_u32(vmull_u16(vget_high_u16(ou), vget_high_u16(k255)), rnd);
+            vst1_u8(straight[ch], vmovn_u16(vcombine_u16(vshrn_n_u32(slo, kFixedShift), vshrn_n_u32(shi, kFixedShift))));
+        }
+    }
+    // Bộ nhớ little-endian: byte 0 = kênh 2, byte 1 = kênh 1, byte 2 = kênh 0, byte 3 = alpha
+    uint8x8x4_t px;
+    px.val[0] = outCh[2];
+    px.val[1] = outCh[1];
+    px.val[2] = outCh[0];
+    px.val[3] = vld1_u8(alpha);
+    vst4_u8(reinterpret_cast<uint8_t *>(dst), px);
+
+    if (stats) {
+        for (int32_t i = 0; i < 8; ++i) stats->accumulateLanes(straight[0][i], straight[1][i], straight[2][i]);
+    }
+}
+#endif
+
+void fixedLutRow(const FixedPipeline &fp, const uint32_t *src, uint32_t *dst, int32_t count, RenderStats *stats) {
+    for (int32_t x = 0; x < count; ++x) dst[x] = lutPixelFixed(fp, src[x], stats);
+}
+
+void fixedAdjustRow(const FixedPipeline &fp, const uint32_t *src, uint32_t *dst, int32_t count, RenderStats *stats) {
+    int32_t x = 0;
+#ifdef ADJUST_FIXED_NEON
+    for (; x + 8 <= count; x += 8) adjustBlock8Neon(fp, src + x, dst + x, stats);
+#endif
+    for (; x < count; ++x) dst[x] = adjustPixelFixed(fp, src[x], stats);
+}
+
+void fixedProcessRow(const FixedPipeline &fp, const uint32_t *src, uint32_t *dst, int32_t count, RenderStats *stats) {
+    if (fp.lutOn) {
+        fixedLutRow(fp, src, dst, count, fp.adjustOn ? nullptr : stats);
+        if (fp.adjustOn) fixedAdjustRow(fp, dst, dst, count, stats);
+    } else if (fp.adjustOn) {
+        fixedAdjustRow(fp, src, dst, count, stats);
+    } else {
+        for (int32_t x = 0; x < count; ++x) {
+            dst[x] = src[x];
+            if (stats) stats->accumulateLanes(static_cast<uint8_t>(src[x] >> 16), static_cast<uint8_t>(src[x] >> 8),
+                                              static_cast<uint8_t>(src[x]));
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+#include "adjust_common.h"
+#include "adjust_lut.h"
+#include "adjust_stats.h"
+
+// =============================================================
+// 🔢 Fixed-point pipeline (8-bit in/out, số nguyên 16-bit)
+// Dành cho máy yếu (armeabi-v7a): thay float bằng
+//   LIGHT -> bảng 1D 256 mục (Q12), chỉ khi shadows/highlights/whites/blacks = 0,
+//   COLOR -> ma trận affine Q12 (temperature/tint/saturation; vibrance phi tuyến -> không hỗ trợ),
+//   LUT   -> nội suy tetrahedral số nguyên thẳng trên Lut3D::packed (uint16 unorm).
+// Các stage khác (HSL, DETAIL, VIGNETTE, GRAIN) -> không đủ điều kiện, dùng đường float.
+// Thứ tự kênh giữ nguyên như đường float: kênh 0 = bit 16..23, kênh 1 = bit 8..15, kênh 2 = bit 0..7.
+// =============================================================
+static constexpr int32_t kFixedShift = 12;
+static constexpr int32_t kFixedOne = 1 << kFixedShift;
+static constexpr int32_t kLutFixedShift = 16;
+
+struct FixedPipeline {
+    bool premultiplied = false;
+
+    // LUT (áp trước, bàn giao 8-bit như đường float)
+    bool lutOn = false;
+    int32_t lutSize = 0;
+    const uint16_t *lut = nullptr; // = Lut3D::packed (size^3 * 4, unorm16), Lut3D phải sống hết lượt render
+    int32_t lutT = 256;          // lutAmount Q8
+
+    // Adjust
+    bool adjustOn = false;
+    bool colorOn = false;
+    int16_t tone[3][256];        // 8-bit -> Q12 sau LIGHT/CURVES, theo kênh engine (hoặc identity)
+    int16_t matrix[9];           // Q12, hàng = kênh output
+    int32_t bias[3];             // Q24 (cộng thẳng vào tích Q12 x Q12)
+};
+
+enum FixedPointMode : int32_t {
+    FIXED_AUTO = 0, // bật trên armeabi-v7a
+    FIXED_ON   = 1,
+    FIXED_OFF  = 2,
+};
+
+bool fixedPathEligible(const AdjustParams &p);
+
+// lut: chỉ dùng khi activeMask có MASK_LUT
+// false nếu tham số vượt phạm vi Q12 (ví dụ saturation quá lớn) -> dùng đường float
+bool buildFixedPipeline(const AdjustParams &p, const Lut3D *lut, float lutT, bool premultiplied, FixedPipeline &out);
+
+// Xử lý `count` pixel (src == dst được phép). stats (nếu có) đo trên giá trị output straight-alpha.
+void fixedProcessRow(const FixedPipeline &fp, const uint32_t *src, uint32_t *dst, int32_t count, RenderStats *stats);
+
+// Từng stage riêng lẻ (LUT / adjust), dùng khi đo sai số so với đường float
+void fixedLutRow(const FixedPipeline &fp, const uint32_t *src, uint32_t *dst, int32_t count, RenderStats *stats);
+void fixedAdjustRow(const FixedPipeline &fp, const uint32_t *src, uint32_t *dst, int32_t count, RenderStats *stats);
@@ -0,0 +1,269 @@
+#include "adjust_geometry.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ADJUST_GEOMETRY_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define ADJUST_GEOMETRY_SSE2 1
+#endif
+
+// =============================================================
+// Ma trận affine (double khi dựng, float khi lấy mẫu)
+// =============================================================
+namespace {
+
+struct Affine {
+    double a = 1.0, b = 0.0, c = 0.0;
+    double d = 0.0, e = 1.0, f = 0.0;
+};
+
+// Áp `inner` trước rồi `outer`
+Affine compose(const Affine &outer, const Affine &inner) {
+    Affine r;
+    r.a = outer.a * inner.a + outer.b * inner.d;
+    r.b = outer.a * inner.b + outer.b * inner.e;
+    r.c = outer.a * inner.c + outer.b * inner.f + outer.c;
+    r.d = outer.d * inner.a + outer.e * inner.d;
+    r.e = outer.d * inner.b + outer.e * inner.e;
+    r.f = outer.d * inner.c + outer.e * inner.f + outer.f;
+    return r;
+}
+
+Affine translate(double tx, double ty) {
+    Affine r;
+    r.c = tx;
+    r.f = ty;
+    return r;
+}
+
+void cropRect(const GeometryParams &g, double &l, double &t, double &r, double &b) {
+    l = std::clamp<double>(g.crop[0], 0.0, 1.0);
+    t = std::clamp<double>(g.crop[1], 0.0, 1.0);
+    r = std::clamp<double>(g.crop[2], 0.0, 1.0);
+    b = std::clamp<double>(g.crop[3], 0.0, 1.0);
+    if (r <= l || b <= t) {
+        l = t = 0.0;
+        r = b = 1.0;
+    }
+}
+
+} // namespace
+
+void geometryOutputSize(const GeometryParams &g, int32_t srcW, int32_t srcH, int32_t &outW, int32_t &outH) {
+    const bool swap = (g.quarterTurns & 1) != 0;
+    const double fw = swap ? srcH : srcW;
+    const double fh = swap ? srcW : srcH;
+    double l, t, r, b;
+    cropRect(g, l, t, r, b);
+    outW = std::max<int32_t>(1, static_cast<int32_t>(std::lround((r - l) * fw)));
+    outH = std::max<int32_t>(1, static_cast<int32_t>(std::lround((b - t) * fh)));
+}
+
+GeometryTransform buildGeometryTransform(const GeometryParams &g, int32_t srcW, int32_t srcH,
+                                         int32_t dstW, int32_t dstH, bool premultiplied) {
+    const int32_t turns = g.quarterTurns & 3;
+    const double W = srcW, H = srcH;
+    const double fw = (turns & 1) ? H : W; // khung đã xoay 90°
+    const double fh = (turns & 1) ? W : H;
+    double l, t, r, b;
+    cropRect(g, l, t, r, b);
+
+    // Toạ độ liên tục (mép pixel) qua từng bước, từ output ngược về nguồn:
+    // tâm pixel output -> khung crop -> bỏ straighten -> bỏ lật -> bỏ xoay 90° -> tâm pixel nguồn
+    Affine m = translate(0.5, 0.5);
+
+    Affine toFrame;
+    toFrame.a = (r - l) * fw / dstW;
+    toFrame.c = l * fw;
+    toFrame.e = (b - t) * fh / dstH;
+    toFrame.f = t * fh;
+    m = compose(toFrame, m);
+
+    if (g.straighten != 0.0f) {
+        // Ảnh hiển thị = ảnh quay θ theo chiều kim đồng hồ (trục y hướng xuống) -> quay ngược -θ
+        const double th = static_cast<double>(g.straighten) * 3.14159265358979323846 / 180.0;
+        const double cs = std::cos(th), sn = std::sin(th);
+        Affine rot;
+        rot.a = cs;  rot.b = sn;
+        rot.d = -sn; rot.e = cs;
+        m = compose(translate(-0.5 * fw, -0.5 * fh), m);
+        m = compose(rot, m);
+        m = compose(translate(0.5 * fw, 0.5 * fh), m);
+    }
+
+    Affine unflip;
+    if (g.flipH) { unflip.a = -1.0; unflip.c = fw; }
+    if (g.flipV) { unflip.e = -1.0; unflip.f = fh; }
+    m = compose(unflip, m);
+
+    // Khung xoay k × 90° (CW) -> ảnh nguồn: (u, v) -> (x, y)
+    Affine unturn;
+    switch (turns) {
+        case 1: unturn = {0.0, 1.0, 0.0, -1.0, 0.0, H}; break;  // x = v,     y = H - u
+        case 2: unturn = {-1.0, 0.0, W, 0.0, -1.0, H}; break;   // x = W - u, y = H - v
+        case 3: unturn = {0.0, -1.0, W, 1.0, 0.0, 0.0}; break;  // x = W - v, y = u
+        default: break;
+    }
+    m = compose(unturn, m);
+    m = compose(translate(-0.5, -0.5), m);
+
+    GeometryTransform out;
+    out.a = static_cast<float>(m.a); out.b = static_cast<float>(m.b); out.c = static_cast<float>(m.c);
+    out.d = static_cast<float>(m.d); out.e = static_cast<float>(m.e); out.f = static_cast<float>(m.f);
+    out.scaleX = static_cast<float>(std::hypot(m.a, m.d));
+    out.scaleY = static_cast<float>(std::hypot(m.b, m.e));
+    out.frameW = static_cast<float>((r - l) * fw);
+    out.frameH = static_cast<float>((b - t) * fh);
+    out.interp = g.interp == GEOMETRY_BILINEAR ? GEOMETRY_BILINEAR : GEOMETRY_BICUBIC;
+    out.premultiplied = premultiplied;
+    return out;
+}
+
+// =============================================================
+// Lấy mẫu: 1 pixel = vector 4 float (SIMD), cùng thứ tự byte với RGBA_8888
+// =============================================================
+namespace {
+
+#if defined(ADJUST_GEOMETRY_NEON)
+using V4 = float32x4_t;
+inline V4 vzero() { return vdupq_n_f32(0.0f); }
+inline V4 vload(uint32_t px) {
+    const uint8x8_t b = vcreate_u8(static_cast<uint64_t>(px));
+    return vcvtq_f32_u32(vmovl_u16(vget_low_u16(vmovl_u8(b))));
+}
+inline V4 vmadd(V4 acc, V4 v, float w) { return vmlaq_n_f32(acc, v, w); }
+inline uint32_t vstore(V4 v) {
+    v = vminq_f32(vmaxq_f32(v, vdupq_n_f32(0.0f)), vdupq_n_f32(255.0f));
+    const uint16x4_t h = vmovn_u32(vcvtq_u32_f32(vaddq_f32(v, vdupq_n_f32(0.5f))));
+    return vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(h, h))), 0);
+}
+#elif defined(ADJUST_GEOMETRY_SSE2)
+using V4 = __m128;
+inline V4 vzero() { return _mm_setzero_ps(); }
+inline V4 vload(uint32_t px) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i b = _mm_cvtsi32_si128(static_cast<int>(px));
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(b, zero), zero));
+}
+inline V4 vmadd(V4 acc, V4 v, float w) { return _mm_add_ps(acc, _mm_mul_ps(v, _mm_set1_ps(w))); }
+inline uint32_t vstore(V4 v) {
+    v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+    const __m128i i = _mm_cvttps_epi32(_mm_add_ps(v, _mm_set1_ps(0.5f)));
+    const __m128i p = _mm_packs_epi32(i, i);
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(p, p)));
+}
+#else
+struct V4 { float v[4]; };
+inline V4 vzero() { return {{0.0f, 0.0f, 0.0f, 0.0f}}; }
+inline V4 vload(uint32_t px) {
+    return {{static_cast<float>(px & 0xFFu), static_cast<float>((px >> 8) & 0xFFu),
+             static_cast<float>((px >> 16) & 0xFFu), static_cast<float>(px >> 24)}};
+}
+inline V4 vmadd(V4 acc, V4 v, float w) {
+    for (int32_t k = 0; k < 4; ++k) acc.v[k] += v.v[k] * w;
+    return acc;
+}
+inline uint32_t vstore(V4 v) {
+    uint32_t out = 0;
+    for (uint32_t k = 0; k < 4; ++k) {
+        out |= static_cast<uint32_t>(std::clamp(v.v[k], 0.0f, 255.0f) + 0.5f) << (8u * k);
+    }
+    return out;
+}
+#endif
+
+// Pixel ngoài ảnh = trong suốt (0) -> mép ảnh sau straighten được khử răng cưa
+inline uint32_t fetch(const uint8_t *src, size_t stride, int32_t w, int32_t h, int32_t x, int32_t y) {
+    if (x < 0 || y < 0 || x >= w || y >= h) return 0u;
+    return reinterpret_cast<const uint32_t *>(src + static_cast<size_t>(y) * stride)[x];
+}
+
+inline uint32_t bilinearAt(const uint8_t *src, size_t stride, int32_t w, int32_t h, float sx, float sy) {
+    if (!(sx > -1.0f && sy > -1.0f && sx < static_cast<float>(w) && sy < static_cast<float>(h))) return 0u;
+    const float fx0 = std::floor(sx), fy0 = std::floor(sy);
+    const int32_t x0 = static_cast<int32_t>(fx0), y0 = static_cast<int32_t>(fy0);
+    const float fx = sx - fx0, fy = sy - fy0;
+
+    uint32_t c00, c01, c10, c11;
+    if (x0 >= 0 && y0 >= 0 && x0 + 1 < w && y0 + 1 < h) {
+        const auto *r0 = reinterpret_cast<const uint32_t *>(src + static_cast<size_t>(y0) * stride) + x0;
+        const auto *r1 = reinterpret_cast<const uint32_t *>(reinterpret_cast<const uint8_t *>(r0) + stride);
+        c00 = r0[0]; c01 = r0[1]; c10 = r1[0]; c11 = r1[1];
+    } else {
+        c00 = fetch(src, stride, w, h, x0, y0);
+        c01 = fetch(src, stride, w, h, x0 + 1, y0);
+        c10 = fetch(src, stride, w, h, x0, y0 + 1);
+        c11 = fetch(src, stride, w, h, x0 + 1, y0 + 1);
+    }
+    V4 acc = vzero();
+    acc = vmadd(acc, vload(c00), (1.0f - fx) * (1.0f - fy));
+    acc = vmadd(acc, vload(c01), fx * (1.0f - fy));
+    acc = vmadd(acc, vload(c10), (1.0f - fx) * fy);
+    acc = vmadd(acc, vload(c11), fx * fy);
+    return vstore(acc);
+}
+
+// Catmull-Rom (a = -0.5): tại toạ độ nguyên = đúng pixel nguồn
+inline void cubicWeights(float t, float w[4]) {
+    const float t2 = t * t, t3 = t2 * t;
+    w[0] = 0.5f * (-t3 + 2.0f * t2 - t);
+    w[1] = 0.5f * (3.0f * t3 - 5.0f * t2 + 2.0f);
+    w[2] = 0.5f * (-3.0f * t3 + 4.0f * t2 + t);
+    w[3] = 0.5f * (t3 - t2);
+}
+
+inline uint32_t bicubicAt(const uint8_t *src, size_t stride, int32_t w, int32_t h, float sx, float sy,
+                          bool premultiplied) {
+    if (!(sx > -2.0f && sy > -2.0f && sx < static_cast<float>(w + 1) && sy < static_cast<float>(h + 1))) return 0u;
+    const float fx0 = std::floor(sx), fy0 = std::floor(sy);
+    const int32_t x0 = static_cast<int32_t>(fx0) - 1, y0 = static_cast<int32_t>(fy0) - 1;
+    float wx[4], wy[4];
+    cubicWeights(sx - fx0, wx);
+    cubicWeights(sy - fy0, wy);
+
+    const bool inside = x0 >= 0 && y0 >= 0 && x0 + 4 <= w && y0 + 4 <= h;
+    V4 acc = vzero();
+    for (int32_t j = 0; j < 4; ++j) {
+        V4 row = vzero();
+        if (inside) {
+            const auto *r = reinterpret_cast<const uint32_t *>(src + static_cast<size_t>(y0 + j) * stride) + x0;
+            for (int32_t i = 0; i < 4; ++i) row = vmadd(row, vload(r[i]), wx[i]);
+        } else {
+            for (int32_t i = 0; i < 4; ++i) row = vmadd(row, vload(fetch(src, stride, w, h, x0 + i, y0 + j)), wx[i]);
+        }
+        acc = vmadd(acc, row, wy[j]);
+    }
+    uint32_t c = vstore(acc);
+    if (premultiplied) {
+        // Vượt biên của Catmull-Rom có thể cho màu > alpha -> kẹp để giữ premultiplied hợp lệ
+        const uint32_t a = c >> 24;
+        uint32_t out = a << 24;
+        for (uint32_t s = 0; s < 24; s += 8) out |= std::min((c >> s) & 0xFFu, a) << s;
+        c = out;
+    }
+    return c;
+}
+
+} // namespace
+
+void sampleGeometryRow(const uint8_t *src, size_t srcStride, int32_t srcW, int32_t srcH,
+                       const GeometryTransform &t, int32_t dy, uint32_t *out, int32_t n) {
+    const float y = static_cast<float>(dy);
+    const float bx = t.b * y + t.c;
+    const float by = t.e * y + t.f;
+    if (t.interp == GEOMETRY_BILINEAR) {
+        for (int32_t dx = 0; dx < n; ++dx) {
+            const float x = static_cast<float>(dx);
+            out[dx] = bilinearAt(src, srcStride, srcW, srcH, t.a * x + bx, t.d * x + by);
+        }
+    } else {
+        for (int32_t dx = 0; dx < n; ++dx) {
+            const float x = static_cast<float>(dx);
+            out[dx] = bicubicAt(src, srcStride, srcW, srcH, t.a * x + bx, t.d * x + by, t.premultiplied);
+        }
+    }
+}
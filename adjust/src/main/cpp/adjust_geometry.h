@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "adjust_common.h"
+
+// =============================================================
+// 📏 Geometry stage — xoay 90° / lật, straighten, crop (affine) đứng đầu pipeline render vùng
+// Không tạo bitmap trung gian: mỗi pixel output ánh xạ ngược về toạ độ ảnh nguồn rồi lấy mẫu
+// bilinear / bicubic ngay trong task của dải hàng đó -> mỗi tile chỉ đọc đúng pixel nguồn nó cần,
+// kết quả đi thẳng vào denoise / kernel point-wise như pixel nguồn bình thường.
+// Kích thước output theo khung crop (geometryOutputSize); render vào bitmap nhỏ hơn = proxy,
+// đủ nhanh để kéo straighten tương tác. Điểm rơi ngoài ảnh nguồn -> pixel trong suốt (mép có khử răng cưa).
+// =============================================================
+
+struct GeometryTransform {
+    // Pixel output (x, y) -> toạ độ lấy mẫu trong ảnh nguồn (đơn vị pixel, tâm pixel = số nguyên):
+    // sx = a·x + b·y + c, sy = d·x + e·y + f
+    float a = 1.f, b = 0.f, c = 0.f;
+    float d = 0.f, e = 1.f, f = 0.f;
+    float scaleX = 1.f, scaleY = 1.f; // pixel nguồn / pixel output theo từng trục output
+    float frameW = 0.f, frameH = 0.f; // khung crop, đơn vị pixel nguồn (toạ độ cho vignette / grain)
+    int32_t interp = GEOMETRY_BICUBIC;
+    bool premultiplied = false;
+};
+
+// Kích thước đầy đủ (pixel nguồn) của khung crop sau xoay 90°
+void geometryOutputSize(const GeometryParams &g, int32_t srcW, int32_t srcH, int32_t &outW, int32_t &outH);
+
+// Khung crop của `g` -> toàn bộ dstW × dstH
+GeometryTransform buildGeometryTransform(const GeometryParams &g, int32_t srcW, int32_t srcH,
+                                         int32_t dstW, int32_t dstH, bool premultiplied);
+
+// Lấy mẫu hàng output `dy`, cột [0, n) (chưa qua stage nào)
+void sampleGeometryRow(const uint8_t *src, size_t srcStride, int32_t srcW, int32_t srcH,
+                       const GeometryTransform &t, int32_t dy, uint32_t *out, int32_t n);
@@ -1,6 +1,9 @@
 #include "adjust_common.h"
+#include "adjust_curves.h"
+#include "adjust_arena.h"
 #include <algorithm>
 #include <cmath>
+#include <memory>
 
 // ======================= LUT Gamma Table =======================
 static bool s_gammaInit = false;
@@ -24,10 +27,6 @@ static void initGammaLUT() {
     s_gammaInit = true;
 }
 
-static inline float srgbToLinear(float c) {
-    return (c <= 0.0f) ? 0.0f : (c >= 1.0f ? 1.0f : s_srgbToLinearLUT[int(c * 255.0f)]);
-}
-
 static inline float linearToSrgb(float c) {
     return (c <= 0.0f) ? 0.0f : (c >= 1.0f ? 1.0f : s_linearToSrgbLUT[int(c * 255.0f)]);
 }
@@ -38,84 +37,146 @@ static inline float toneMapCurve(float x) {
     return std::clamp(x + 0.15f * sinf((x - 0.5f) * 3.1415926f), 0.0f, 1.0f);
 }
 
-// ======================= Main Adjust ===========================
-void applyLightAdjust(float &r, float &g, float &b, const AdjustParams &p) {
-    initGammaLUT();
-
-    // ---- Normalize về [0,1] ----
-    r /= 255.0f;
-    g /= 255.0f;
-    b /= 255.0f;
-
-    // ---- sRGB -> Linear ----
-    r = srgbToLinear(r);
-    g = srgbToLinear(g);
-    b = srgbToLinear(b);
-
+// ======================= Các bước 1D ===========================
+// Exposure -> contrast -> brightness -> clamp, trên giá trị linear
+static inline float lightLinearStage(float c, const AdjustParams &p) {
     // ---- Exposure ----
-    float exposureFactor = powf(2.0f, p.exposure * 0.5f);
-    r *= exposureFactor;
-    g *= exposureFactor;
-    b *= exposureFactor;
+    c *= powf(2.0f, p.exposure * 0.5f);
 
     // ---- Contrast ---- (xử lý trước brightness)
     float contrastFactor = (p.contrast >= 0.0f)
                            ? 1.0f + (p.contrast * 0.8f)
                            : 1.0f / (1.0f - (p.contrast * 0.5f));
-
-    r = ((r - 0.5f) * contrastFactor) + 0.5f;
-    g = ((g - 0.5f) * contrastFactor) + 0.5f;
-    b = ((b - 0.5f) * contrastFactor) + 0.5f;
+    c = ((c - 0.5f) * contrastFactor) + 0.5f;
 
     // ---- Brightness ---- (midtone lift)
     if (p.brightness != 0.0f) {
         float factor = 1.0f + (p.brightness * 0.2f);
-        r = (r - 0.5f) * factor + 0.5f;
-        g = (g - 0.5f) * factor + 0.5f;
-        b = (b - 0.5f) * factor + 0.5f;
+        c = (c - 0.5f) * factor + 0.5f;
     }
 
-    // ---- Clamp ----
-    r = std::clamp(r, 0.0f, 1.0f);
-    g = std::clamp(g, 0.0f, 1.0f);
-    b = std::clamp(b, 0.0f, 1.0f);
-
-    // ---- Tone Adjust (cập nhật luminance mỗi lần) ----
-    auto toneAdjust = [&](float factor, float low, float high) {
-        if (factor != 0.0f) {
-            float lum = 0.299f * r + 0.587f * g + 0.114f * b;
-            if (lum < low) {
-                float boost = (low - lum) * factor;
-                r += boost;
-                g += boost;
-                b += boost;
-            }
-            if (lum > high) {
-                float reduce = (lum - high) * factor;
-                r -= reduce;
-                g -= reduce;
-                b -= reduce;
-            }
-        }
+    return std::clamp(c, 0.0f, 1.0f);
+}
+
+// Tone mapping midtone + clamp + về sRGB [0, 1]
+static inline float lightOutputStage(float c) {
+    return linearToSrgb(std::clamp(toneMapCurve(c), 0.0f, 1.0f));
+}
+
+// sRGB [0, 255] -> index bảng gamma (cách làm tròn cũ: int(c * 255))
+static inline int32_t srgbIndex(float v) {
+    const float c = v / 255.0f;
+    return (c <= 0.0f) ? 0 : (c >= 1.0f ? 255 : int(c * 255.0f));
+}
+
+// ---- Tone Adjust ----
+// Shadows/highlights/whites/blacks đẩy cả 3 kênh cùng 1 lượng; trọng số luminance cộng lại = 1
+// nên luminance cập nhật cộng dồn thay vì tính lại sau mỗi bước.
+static inline void toneAdjust(float &r, float &g, float &b, const AdjustParams &p) {
+    if (p.shadows == 0.0f && p.highlights == 0.0f && p.whites == 0.0f && p.blacks == 0.0f) return;
+
+    float lum = 0.299f * r + 0.587f * g + 0.114f * b;
+    auto step = [&](float factor, float low, float high) {
+        if (factor == 0.0f) return;
+        float d = 0.0f;
+        if (lum < low) d += (low - lum) * factor;
+        if (lum > high) d -= (lum - high) * factor;
+        r += d;
+        g += d;
+        b += d;
+        lum += d;
     };
 
-    toneAdjust(p.shadows * 0.5f, 0.5f, 1.0f);
-    toneAdjust(p.highlights * 0.5f, 0.0f, 0.5f);
-    toneAdjust(p.whites * 0.7f, 0.0f, 0.65f);
-    toneAdjust(p.blacks * 0.7f, 0.35f, 1.0f);
-
-    // ---- Tone mapping midtone ----
-    r = toneMapCurve(r);
-    g = toneMapCurve(g);
-    b = toneMapCurve(b);
-
-    // ---- Clamp và chuyển ngược về sRGB ----
-    r = linearToSrgb(std::clamp(r, 0.0f, 1.0f));
-    g = linearToSrgb(std::clamp(g, 0.0f, 1.0f));
-    b = linearToSrgb(std::clamp(b, 0.0f, 1.0f));
-
-    // ---- Scale về [0,255] ----
-    r *= 255.0f;
-    g *= 255.0f;
-    b *= 255.0f;
+    step(p.shadows * 0.5f, 0.5f, 1.0f);
+    step(p.highlights * 0.5f, 0.0f, 0.5f);
+    step(p.whites * 0.7f, 0.0f, 0.65f);
+    step(p.blacks * 0.7f, 0.35f, 1.0f);
+}
+
+// ======================= Tone tables ===========================
+// Bảng (~50 KB) tái dùng theo luồng: chỉ lấy lại bảng không còn ai giữ ngoài pool
+// (render trước đã xong; layer local đang giữ bảng cũ thì dùng bảng khác).
+static constexpr size_t kToneTablePool = 4;
+
+static std::shared_ptr<ToneTables> recycledToneTables() {
+    static thread_local std::shared_ptr<ToneTables> pool[kToneTablePool];
+    for (auto &t : pool) {
+        if (!t) t = std::make_shared<ToneTables>();
+        if (t.use_count() == 1) return t;
+    }
+    return std::make_shared<ToneTables>();
+}
+
+void prepareToneTables(AdjustParams &p) {
+    const bool lightOn = (p.activeMask & MASK_LIGHT) != 0;
+    bool curvesOn = false;
+    if (p.activeMask & MASK_CURVES) {
+        for (const ToneCurve &c : p.curves) curvesOn |= !curveIsIdentity(c);
+    }
+    if (!lightOn && !curvesOn) {
+        p.tone.reset();
+        return;
+    }
+    initGammaLUT();
+
+    std::shared_ptr<ToneTables> t = recycledToneTables();
+    t->lightOn = lightOn;
+    for (int32_t i = 0; i < 256; ++i) {
+        t->pre[i] = lightOn ? lightLinearStage(s_srgbToLinearLUT[i], p) : static_cast<float>(i) / 255.0f;
+    }
+
+    // Curves lấy mẫu 1 lần cùng độ phân giải với bảng, tra tuyến tính khi ghép
+    const ScratchArena::Lease samples = scratchArena().borrow(2u * kToneTableSize * sizeof(float));
+    float *master = samples.as<float>();
+    float *channel = master + kToneTableSize;
+    sampleMonotoneCurve(p.curves[CURVE_MASTER], master, kToneTableSize);
+    auto lookup = [](const float *table, float v) {
+        const float f = clampf(v) * static_cast<float>(kToneTableSize - 1);
+        const int32_t i = std::min(static_cast<int32_t>(f), kToneTableSize - 2);
+        return table[i] + (table[i + 1] - table[i]) * (f - static_cast<float>(i));
+    };
+
+    // Kênh engine 0/1/2 = bit 16/8/0 của pixel = B/G/R thật của RGBA_8888
+    static constexpr CurveChannel kEngineToCurve[3] = {CURVE_BLUE, CURVE_GREEN, CURVE_RED};
+    for (int32_t ch = 0; ch < 3; ++ch) {
+        sampleMonotoneCurve(p.curves[kEngineToCurve[ch]], channel, kToneTableSize);
+        for (int32_t i = 0; i < kToneTableSize; ++i) {
+            const float x = static_cast<float>(i) / static_cast<float>(kToneTableSize - 1);
+            float v = lightOn ? lightOutputStage(x) : x;
+            if (curvesOn) v = lookup(channel, lookup(master, v));
+            t->post[ch][i] = v * 255.0f;
+        }
+    }
+    p.tone = std::move(t);
+}
+
+// ======================= Main Adjust ===========================
+void applyLightAdjust(float &r, float &g, float &b, const AdjustParams &p) {
+    const ToneTables *t = p.tone.get();
+    if (t && t->lightOn) {
+        // Bảng: sRGB -> linear -> exposure/contrast/brightness
+        r = t->pre[srgbIndex(r)];
+        g = t->pre[srgbIndex(g)];
+        b = t->pre[srgbIndex(b)];
+
+        toneAdjust(r, g, b, p);
+
+        // Bảng: tone map -> sRGB -> curves -> [0, 255]
+        r = t->post[0][toneTableIndex(r)];
+        g = t->post[1][toneTableIndex(g)];
+        b = t->post[2][toneTableIndex(b)];
+        return;
+    }
+
+    // Chưa compile bảng (params không qua prepareToneTables): tính trực tiếp, không có curves
+    initGammaLUT();
+    r = lightLinearStage(s_srgbToLinearLUT[srgbIndex(r)], p);
+    g = lightLinearStage(s_srgbToLinearLUT[srgbIndex(g)], p);
+    b = lightLinearStage(s_srgbToLinearLUT[srgbIndex(b)], p);
+
+    toneAdjust(r, g, b, p);
+
+    r = lightOutputStage(r) * 255.0f;
+    g = lightOutputStage(g) * 255.0f;
+    b = lightOutputStage(b) * 255.0f;
 }
@@ -0,0 +1,323 @@
+#include "adjust_local.h"
+
+#include <cmath>
+#include <cstring>
+
+// =============================================================
+// 🖌️ TiledMask
+// Toạ độ pixel lấy theo tâm pixel (x + 0.5, y + 0.5) để khớp giữa rasterize và phân loại tile.
+// =============================================================
+
+// Viền mờ: 1 bên trong `inner`, 0 từ 1 trở ra, smoothstep ở giữa
+static inline float featherWeight(float d, float inner) {
+    if (d <= inner) return 1.f;
+    if (d >= 1.f) return 0.f;
+    const float s = (1.f - d) / std::max(1.f - inner, 1e-6f);
+    return s * s * (3.f - 2.f * s);
+}
+
+static inline uint8_t toWeight8(float w) {
+    return static_cast<uint8_t>(clampf(w) * 255.f + 0.5f);
+}
+
+void TiledMask::reset(int32_t width, int32_t height) {
+    width_ = std::max(0, width);
+    height_ = std::max(0, height);
+    tilesX_ = (width_ + kMaskTileSize - 1) / kMaskTileSize;
+    tilesY_ = (height_ + kMaskTileSize - 1) / kMaskTileSize;
+    tiles_.clear();
+    tiles_.resize(static_cast<size_t>(tilesX_) * static_cast<size_t>(tilesY_));
+}
+
+TileRect TiledMask::tileRect(int32_t tx, int32_t ty) const {
+    TileRect r;
+    r.left = tx * kMaskTileSize;
+    r.top = ty * kMaskTileSize;
+    r.right = std::min(width_, r.left + kMaskTileSize);
+    r.bottom = std::min(height_, r.top + kMaskTileSize);
+    return r;
+}
+
+void TiledMask::setUniform(MaskTile &t, MaskTileState state, const TileRect &r) {
+    t.state = state;
+    t.weights.reset();
+    t.x0 = t.y0 = 0;
+    if (state == TILE_FULL) {
+        t.x1 = static_cast<uint16_t>(r.right - r.left);
+        t.y1 = static_cast<uint16_t>(r.bottom - r.top);
+    } else {
+        t.x1 = t.y1 = 0;
+    }
+}
+
+void TiledMask::compactTile(int32_t tx, int32_t ty) {
+    MaskTile &t = tileAt(tx, ty);
+    if (!t.weights) return;
+    const TileRect r = tileRect(tx, ty);
+    const int32_t w = r.right - r.left;
+    const int32_t h = r.bottom - r.top;
+
+    int32_t bx0 = w, by0 = h, bx1 = 0, by1 = 0;
+    bool allFull = true;
+    for (int32_t y = 0; y < h; ++y) {
+        const uint8_t *row = t.weights.get() + y * kMaskTileSize;
+        for (int32_t x = 0; x < w; ++x) {
+            const uint8_t v = row[x];
+            if (v != 255u) allFull = false;
+            if (v == 0u) continue;
+            bx0 = std::min(bx0, x);
+            by0 = std::min(by0, y);
+            bx1 = std::max(bx1, x + 1);
+            by1 = std::max(by1, y + 1);
+        }
+    }
+
+    if (bx1 <= bx0) { setUniform(t, TILE_EMPTY, r); return; }
+    if (allFull)    { setUniform(t, TILE_FULL, r); return; }
+    t.state = TILE_PARTIAL;
+    t.x0 = static_cast<uint16_t>(bx0);
+    t.y0 = static_cast<uint16_t>(by0);
+    t.x1 = static_cast<uint16_t>(bx1);
+    t.y1 = static_cast<uint16_t>(by1);
+}
+
+// Khoảng cách nhỏ nhất từ gốc toạ độ tới đoạn thẳng (ax, ay)-(bx, by)
+static float originSegmentDistance(float ax, float ay, float bx, float by) {
+    const float dx = bx - ax, dy = by - ay;
+    const float len2 = dx * dx + dy * dy;
+    float t = len2 > 0.f ? -(ax * dx + ay * dy) / len2 : 0.f;
+    t = clampf(t);
+    const float px = ax + dx * t, py = ay + dy * t;
+    return std::sqrt(px * px + py * py);
+}
+
+void TiledMask::buildRadial(float cx, float cy, float rx, float ry, float angleDeg, float feather, bool invert) {
+    rx = std::max(rx, 1e-3f);
+    ry = std::max(ry, 1e-3f);
+    const float inner = 1.f - clampf(feather);
+    const float rad = angleDeg * 3.14159265f / 180.f;
+    const float cs = std::cos(rad), sn = std::sin(rad);
+
+    // Không gian chuẩn hoá: ellipse -> đường tròn đơn vị (phép biến đổi tuyến tính)
+    auto toUnit = [&](float x, float y, float &u, float &v) {
+        const float dx = x - cx, dy = y - cy;
+        u = ( dx * cs + dy * sn) / rx;
+        v = (-dx * sn + dy * cs) / ry;
+    };
+
+    for (int32_t ty = 0; ty < tilesY_; ++ty) {
+        for (int32_t tx = 0; tx < tilesX_; ++tx) {
+            const TileRect r = tileRect(tx, ty);
+            MaskTile &t = tileAt(tx, ty);
+
+            // Tile -> hình bình hành trong không gian chuẩn hoá (theo tâm pixel ở 2 mép).
+            // max khoảng cách đạt tại đỉnh; min = 0 nếu gốc nằm trong, ngược lại là min tới 4 cạnh.
+            float u[4], v[4];
+            const float xl = static_cast<float>(r.left) + 0.5f, xr = static_cast<float>(r.right) - 0.5f;
+            const float yt = static_cast<float>(r.top) + 0.5f, yb = static_cast<float>(r.bottom) - 0.5f;
+            toUnit(xl, yt, u[0], v[0]);
+            toUnit(xr, yt, u[1], v[1]);
+            toUnit(xr, yb, u[2], v[2]);
+            toUnit(xl, yb, u[3], v[3]);
+
+            float maxD = 0.f, minD = 1e30f;
+            bool pos = false, neg = false;
+            for (int32_t i = 0; i < 4; ++i) {
+                const int32_t j = (i + 1) & 3;
+                maxD = std::max(maxD, std::sqrt(u[i] * u[i] + v[i] * v[i]));
+                minD = std::min(minD, originSegmentDistance(u[i], v[i], u[j], v[j]));
+                const float cross = u[i] * v[j] - v[i] * u[j];
+                if (cross > 0.f) pos = true;
+                if (cross < 0.f) neg = true;
+            }
+            if (!(pos && neg)) minD = 0.f;
+
+            if (minD >= 1.f) { setUniform(t, invert ? TILE_FULL : TILE_EMPTY, r); continue; }
+            if (maxD <= inner) { setUniform(t, invert ? TILE_EMPTY : TILE_FULL, r); continue; }
+
+            if (!t.weights) t.weights.reset(new uint8_t[kMaskTileSize * kMaskTileSize]);
+            for (int32_t y = r.top; y < r.bottom; ++y) {
+                uint8_t *row = t.weights.get() + (y - r.top) * kMaskTileSize;
+                const float fy = static_cast<float>(y) + 0.5f;
+                for (int32_t x = r.left; x < r.right; ++x) {
+                    float uu, vv;
+                    toUnit(static_cast<float>(x) + 0.5f, fy, uu, vv);
+                    float w = featherWeight(std::sqrt(uu * uu + vv * vv), inner);
+                    if (invert) w = 1.f - w;
+                    row[x - r.left] = toWeight8(w);
+                }
+            }
+            compactTile(tx, ty);
+        }
+    }
+}
+
+void TiledMask::buildLinear(float x0, float y0, float x1, float y1, bool invert) {
+    float dx = x1 - x0, dy = y1 - y0;
+    const float len2 = dx * dx + dy * dy;
+    if (len2 < 1e-6f) { dx = 0.f; dy = 1e-3f; }
+    const float inv = 1.f / std::max(len2, 1e-6f);
+
+    // t = 0 tại điểm đầu (trọng số 1), t = 1 tại điểm cuối (trọng số 0)
+    auto paramAt = [&](float x, float y) { return ((x - x0) * dx + (y - y0) * dy) * inv; };
+
+    for (int32_t ty = 0; ty < tilesY_; ++ty) {
+        for (int32_t tx = 0; tx < tilesX_; ++tx) {
+            const TileRect r = tileRect(tx, ty);
+            MaskTile &t = tileAt(tx, ty);
+
+            // t tuyến tính theo (x, y) -> cực trị trên tile nằm ở 4 góc
+            const float xl = static_cast<float>(r.left) + 0.5f, xr = static_cast<float>(r.right) - 0.5f;
+            const float yt = static_cast<float>(r.top) + 0.5f, yb = static_cast<float>(r.bottom) - 0.5f;
+            const float c0 = paramAt(xl, yt), c1 = paramAt(xr, yt), c2 = paramAt(xl, yb), c3 = paramAt(xr, yb);
+            const float tMin = std::min(std::min(c0, c1), std::min(c2, c3));
+            const float tMax = std::max(std::max(c0, c1), std::max(c2, c3));
+
+            if (tMin >= 1.f) { setUniform(t, invert ? TILE_FULL : TILE_EMPTY, r); continue; }
+            if (tMax <= 0.f) { setUniform(t, invert ? TILE_EMPTY : TILE_FULL, r); continue; }
+
+            if (!t.weights) t.weights.reset(new uint8_t[kMaskTileSize * kMaskTileSize]);
+            for (int32_t y = r.top; y < r.bottom; ++y) {
+                uint8_t *row = t.weights.get() + (y - r.top) * kMaskTileSize;
+                const float fy = static_cast<float>(y) + 0.5f;
+                for (int32_t x = r.left; x < r.right; ++x) {
+                    // featherWeight(d, 0) = 1 - smoothstep(d)
+                    float w = featherWeight(paramAt(static_cast<float>(x) + 0.5f, fy), 0.f);
+                    if (invert) w = 1.f - w;
+                    row[x - r.left] = toWeight8(w);
+                }
+            }
+            compactTile(tx, ty);
+        }
+    }
+}
+
+TileRect TiledMask::paintDab(float cx, float cy, float radius, float hardness, float flow, bool erase) {
+    TileRect dirty;
+    dirty.left = width_;
+    dirty.top = height_;
+    if (radius <= 0.f || flow <= 0.f || tiles_.empty()) return TileRect{};
+
+    const float inner = clampf(hardness);
+    const float amount = clampf(flow);
+    const int32_t px0 = std::max(0, static_cast<int32_t>(std::floor(cx - radius)));
+    const int32_t py0 = std::max(0, static_cast<int32_t>(std::floor(cy - radius)));
+    const int32_t px1 = std::min(width_, static_cast<int32_t>(std::ceil(cx + radius)) + 1);
+    const int32_t py1 = std::min(height_, static_cast<int32_t>(std::ceil(cy + radius)) + 1);
+    if (px1 <= px0 || py1 <= py0) return TileRect{};
+
+    const float invR = 1.f / radius;
+    for (int32_t ty = py0 / kMaskTileSize; ty <= (py1 - 1) / kMaskTileSize; ++ty) {
+        for (int32_t tx = px0 / kMaskTileSize; tx <= (px1 - 1) / kMaskTileSize; ++tx) {
+            MaskTile &t = tileAt(tx, ty);
+            // Tô lên tile đã đầy / xoá trên tile trống: không đổi gì
+            if (!erase && t.state == TILE_FULL) continue;
+            if (erase && t.state == TILE_EMPTY) continue;
+
+            const TileRect r = tileRect(tx, ty);
+            if (!t.weights) {
+                t.weights.reset(new uint8_t[kMaskTileSize * kMaskTileSize]);
+                std::memset(t.weights.get(), t.state == TILE_FULL ? 0xFF : 0x00, kMaskTileSize * kMaskTileSize);
+            }
+
+            bool changed = false;
+            const int32_t y0 = std::max(py0, r.top), y1 = std::min(py1, r.bottom);
+            const int32_t x0 = std::max(px0, r.left), x1 = std::min(px1, r.right);
+            for (int32_t y = y0; y < y1; ++y) {
+                uint8_t *row = t.weights.get() + (y - r.top) * kMaskTileSize;
+                const float dy = (static_cast<float>(y) + 0.5f - cy) * invR;
+                for (int32_t x = x0; x < x1; ++x) {
+                    const float dx = (static_cast<float>(x) + 0.5f - cx) * invR;
+                    const float a = featherWeight(std::sqrt(dx * dx + dy * dy), inner) * amount;
+                    if (a <= 0.f) continue;
+                    const float cur = static_cast<float>(row[x - r.left]);
+                    const float next = erase ? cur * (1.f - a) : cur + (255.f - cur) * a;
+                    const uint8_t v = static_cast<uint8_t>(std::clamp(next + 0.5f, 0.f, 255.f));
+                    if (v != row[x - r.left]) { row[x - r.left] = v; changed = true; }
+                }
+            }
+
+            const MaskTileState before = t.state;
+            compactTile(tx, ty);
+            if (!changed && before == t.state) continue;
+            dirty.left = std::min(dirty.left, r.left);
+            dirty.top = std::min(dirty.top, r.top);
+            dirty.right = std::max(dirty.right, r.right);
+            dirty.bottom = std::max(dirty.bottom, r.bottom);
+        }
+    }
+    return dirty.empty() ? TileRect{} : dirty;
+}
+
+uint8_t TiledMask::weightAt(int32_t x, int32_t y) const {
+    if (x < 0 || y < 0 || x >= width_ || y >= height_) return 0u;
+    const int32_t tx = x / kMaskTileSize, ty = y / kMaskTileSize;
+    const MaskTile &t = tile(tx, ty);
+    if (t.state == TILE_EMPTY) return 0u;
+    if (t.state == TILE_FULL) return 255u;
+    return t.weights[static_cast<size_t>((y - ty * kMaskTileSize) * kMaskTileSize + (x - tx * kMaskTileSize))];
+}
+
+TileRect TiledMask::coverage() const {
+    TileRect c;
+    c.left = width_;
+    c.top = height_;
+    for (int32_t ty = 0; ty < tilesY_; ++ty) {
+        for (int32_t tx = 0; tx < tilesX_; ++tx) {
+            if (tile(tx, ty).state == TILE_EMPTY) continue;
+            const TileRect r = tileRect(tx, ty);
+            c.left = std::min(c.left, r.left);
+            c.top = std::min(c.top, r.top);
+            c.right = std::max(c.right, r.right);
+            c.bottom = std::max(c.bottom, r.bottom);
+        }
+    }
+    return c.empty() ? TileRect{} : c;
+}
+
+size_t TiledMask::partialTileCount() const {
+    size_t n = 0;
+    for (const MaskTile &t : tiles_) n += (t.state == TILE_PARTIAL) ? 1u : 0u;
+    return n;
+}
+
+size_t TiledMask::bytes() const {
+    return tiles_.capacity() * sizeof(MaskTile) +
+           partialTileCount() * static_cast<size_t>(kMaskTileSize * kMaskTileSize);
+}
+
+TileRect unionRect(const TileRect &a, const TileRect &b) {
+    if (a.empty()) return b;
+    if (b.empty()) return a;
+    TileRect r;
+    r.left = std::min(a.left, b.left);
+    r.top = std::min(a.top, b.top);
+    r.right = std::max(a.right, b.right);
+    r.bottom = std::max(a.bottom, b.bottom);
+    return r;
+}
+
+// =============================================================
+// 🗂️ LocalSession
+// =============================================================
+LocalLayer *LocalSession::layer(int32_t index, bool create) {
+    if (index < 0 || index >= kMaxLocalLayers) return nullptr;
+    const auto idx = static_cast<size_t>(index);
+    if (idx >= layers.size()) {
+        if (!create) return nullptr;
+        layers.resize(idx + 1);
+    }
+    if (!layers[idx] && create) {
+        layers[idx].reset(new LocalLayer());
+        layers[idx]->mask.reset(width, height);
+    }
+    return layers[idx].get();
+}
+
+size_t LocalSession::bytes() const {
+    size_t n = layers.capacity() * sizeof(layers[0]);
+    for (const auto &l : layers) {
+        if (l) n += sizeof(LocalLayer) + l->mask.bytes();
+    }
+    return n;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "adjust_common.h"
+
+// =============================================================
+// 🖌️ Local adjustments: mask dạng tile (radial / linear gradient / brush)
+// Mỗi tile lưu trạng thái EMPTY / FULL / PARTIAL + bounding box vùng có trọng số > 0.
+// Chỉ tile PARTIAL mới cấp phát buffer trọng số (uint8, 0..255).
+// =============================================================
+static constexpr int32_t kMaskTileSize = 64;
+// Số layer tối đa mỗi session; index ngoài [0, kMaxLocalLayers) bị từ chối (index lấy thẳng từ Java)
+static constexpr int32_t kMaxLocalLayers = 32;
+
+enum LocalMaskType : int32_t {
+    LOCAL_MASK_RADIAL = 0,
+    LOCAL_MASK_LINEAR = 1,
+    LOCAL_MASK_BRUSH  = 2,
+};
+
+enum MaskTileState : uint8_t {
+    TILE_EMPTY   = 0,
+    TILE_FULL    = 1,
+    TILE_PARTIAL = 2,
+};
+
+struct MaskTile {
+    MaskTileState state = TILE_EMPTY;
+    // bbox (toạ độ trong tile, nửa mở) của các pixel có trọng số > 0
+    uint16_t x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    std::unique_ptr<uint8_t[]> weights; // kMaskTileSize^2, chỉ khi PARTIAL
+};
+
+struct TileRect {
+    int32_t left = 0, top = 0, right = 0, bottom = 0; // pixel, nửa mở
+    bool empty() const { return right <= left || bottom <= top; }
+};
+
+TileRect unionRect(const TileRect &a, const TileRect &b);
+
+class TiledMask {
+public:
+    void reset(int32_t width, int32_t height);
+
+    int32_t width() const { return width_; }
+    int32_t height() const { return height_; }
+    int32_t tilesX() const { return tilesX_; }
+    int32_t tilesY() const { return tilesY_; }
+    const MaskTile &tile(int32_t tx, int32_t ty) const { return tiles_[static_cast<size_t>(ty * tilesX_ + tx)]; }
+
+    // Radial: ellipse tâm (cx, cy), bán kính (rx, ry), xoay angleDeg; feather 0..1 = phần viền mờ
+    void buildRadial(float cx, float cy, float rx, float ry, float angleDeg, float feather, bool invert);
+
+    // Linear gradient: trọng số 1 ở phía (x0, y0), giảm mượt về 0 tại (x1, y1)
+    void buildLinear(float x0, float y0, float x1, float y1, bool invert);
+
+    // Brush: 1 "dab" tròn; hardness 0..1, flow 0..1. Trả về vùng pixel bị thay đổi (theo tile).
+    TileRect paintDab(float cx, float cy, float radius, float hardness, float flow, bool erase);
+
+    // Trọng số tại pixel (x, y) của ảnh gốc (0..255)
+    uint8_t weightAt(int32_t x, int32_t y) const;
+
+    // Hình chữ nhật (căn theo tile) bao mọi tile không EMPTY
+    TileRect coverage() const;
+
+    size_t partialTileCount() const;
+    // Bộ nhớ heap đang giữ: mảng tile + buffer trọng số của tile PARTIAL
+    size_t bytes() const;
+
+private:
+    int32_t width_ = 0, height_ = 0;
+    int32_t tilesX_ = 0, tilesY_ = 0;
+    std::vector<MaskTile> tiles_;
+
+    TileRect tileRect(int32_t tx, int32_t ty) const;
+    MaskTile &tileAt(int32_t tx, int32_t ty) { return tiles_[static_cast<size_t>(ty * tilesX_ + tx)]; }
+    // Sau khi ghi weights: tính lại state/bbox, giải phóng buffer nếu EMPTY/FULL
+    void compactTile(int32_t tx, int32_t ty);
+    void setUniform(MaskTile &t, MaskTileState state, const TileRect &r);
+};
+
+struct LocalLayer {
+    LocalMaskType type = LOCAL_MASK_BRUSH;
+    AdjustParams params;  // activeMask không gồm MASK_LUT
+    TiledMask mask;
+};
+
+struct LocalSession {
+    int32_t width = 0, height = 0;
+    std::vector<std::unique_ptr<LocalLayer>> layers;
+
+    LocalLayer *layer(int32_t index, bool create);
+    size_t bytes() const;
+};
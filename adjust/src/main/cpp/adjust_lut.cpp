@@ -0,0 +1,568 @@
+#include "adjust_lut.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#include <zlib.h>
+
+static inline void setErr(std::string *err, const char *msg) {
+    if (err) *err = msg;
+}
+
+void packLut(Lut3D &lut, bool dropFloat) {
+    if (!lut.valid()) return;
+    const size_t points = lut.data.size() / 3u;
+    lut.packed.assign(points * 4u, 0);
+    for (size_t i = 0; i < points; ++i) {
+        for (size_t c = 0; c < 3; ++c) {
+            const float v = std::clamp(lut.data[i * 3u + c], 0.0f, 1.0f);
+            lut.packed[i * 4u + c] = static_cast<uint16_t>(std::lround(v * 65535.0f));
+        }
+    }
+    if (dropFloat) {
+        lut.data.clear();
+        lut.data.shrink_to_fit();
+    }
+}
+
+int32_t validateTableHeader(const uint32_t header[2], uint64_t fileBytes, std::string *err) {
+    const uint32_t size = header[0];
+    if (size < static_cast<uint32_t>(kLutMinSize) || size > static_cast<uint32_t>(kLutMaxSize)) {
+        setErr(err, "LUT size out of range");
+        return 0;
+    }
+    if (header[1] != kTableVersion) {
+        setErr(err, "Unknown .table version");
+        return 0;
+    }
+    const uint64_t expect = kTableHeaderBytes + static_cast<uint64_t>(size) * size * size * 3u * sizeof(float);
+    if (fileBytes != expect) {
+        setErr(err, "LUT size does not match file length");
+        return 0;
+    }
+    return static_cast<int32_t>(size);
+}
+
+// =============================================================
+// 🔁 Resample: lưới nguồn N^3 (fetch theo chỉ số r, g, b) -> Lut3D size S (R chậm nhất)
+// =============================================================
+template <class Fetch>
+static void resampleLattice(Lut3D &out, int32_t S, int32_t N, Fetch fetch) {
+    out.size = S;
+    out.data.assign(static_cast<size_t>(S) * static_cast<size_t>(S) * static_cast<size_t>(S) * 3u, 0.f);
+    const float scale = static_cast<float>(N - 1) / static_cast<float>(S - 1);
+
+    auto axis = [&](int32_t i, int32_t &i0, int32_t &i1, float &w) {
+        const float f = static_cast<float>(i) * scale;
+        i0 = std::min(static_cast<int32_t>(f), N - 1);
+        i1 = std::min(i0 + 1, N - 1);
+        w = f - static_cast<float>(i0);
+    };
+
+    size_t o = 0;
+    for (int32_t r = 0; r < S; ++r) {
+        int32_t r0, r1; float wr;
+        axis(r, r0, r1, wr);
+        for (int32_t g = 0; g < S; ++g) {
+            int32_t g0, g1; float wg;
+            axis(g, g0, g1, wg);
+            for (int32_t b = 0; b < S; ++b, o += 3) {
+                int32_t b0, b1; float wb;
+                axis(b, b0, b1, wb);
+                float c[8][3];
+                fetch(r0, g0, b0, c[0]); fetch(r0, g0, b1, c[1]);
+                fetch(r0, g1, b0, c[2]); fetch(r0, g1, b1, c[3]);
+                fetch(r1, g0, b0, c[4]); fetch(r1, g0, b1, c[5]);
+                fetch(r1, g1, b0, c[6]); fetch(r1, g1, b1, c[7]);
+                for (int32_t ch = 0; ch < 3; ++ch) {
+                    const float c00 = c[0][ch] + (c[1][ch] - c[0][ch]) * wb;
+                    const float c01 = c[2][ch] + (c[3][ch] - c[2][ch]) * wb;
+                    const float c10 = c[4][ch] + (c[5][ch] - c[4][ch]) * wb;
+                    const float c11 = c[6][ch] + (c[7][ch] - c[6][ch]) * wb;
+                    const float c0 = c00 + (c01 - c00) * wg;
+                    const float c1 = c10 + (c11 - c10) * wg;
+                    out.data[o + static_cast<size_t>(ch)] = c0 + (c1 - c0) * wr;
+                }
+            }
+        }
+    }
+}
+
+// =============================================================
+// 📄 .cube
+// =============================================================
+namespace {
+
+struct CubeFile {
+    int32_t size1D = 0, size3D = 0;
+    float min1D[3] = {0.f, 0.f, 0.f}, max1D[3] = {1.f, 1.f, 1.f};
+    float min3D[3] = {0.f, 0.f, 0.f}, max3D[3] = {1.f, 1.f, 1.f};
+    std::vector<float> rows; // mọi dòng dữ liệu theo thứ tự file (1D trước, rồi 3D)
+};
+
+// Đọc tối đa n số thực từ p; trả về số lượng đọc được
+int32_t readFloats(const char *p, const char *end, float *out, int32_t n) {
+    int32_t k = 0;
+    std::string tmp(p, end);
+    const char *s = tmp.c_str();
+    while (k < n) {
+        char *next = nullptr;
+        const float v = std::strtof(s, &next);
+        if (next == s) break;
+        out[k++] = v;
+        s = next;
+    }
+    return k;
+}
+
+bool startsWith(const char *p, const char *end, const char *kw) {
+    const size_t n = std::strlen(kw);
+    return static_cast<size_t>(end - p) >= n && std::memcmp(p, kw, n) == 0
+           && (static_cast<size_t>(end - p) == n || p[n] == ' ' || p[n] == '\t');
+}
+
+// Nội suy tuyến tính bảng 1D (domain [mn, mx]) cho kênh ch
+float eval1D(const CubeFile &c, const float *table, int32_t ch, float v) {
+    const float span = c.max1D[ch] - c.min1D[ch];
+    float t = span != 0.f ? (v - c.min1D[ch]) / span : 0.f;
+    t = std::clamp(t, 0.f, 1.f) * static_cast<float>(c.size1D - 1);
+    const int32_t i0 = std::min(static_cast<int32_t>(t), c.size1D - 1);
+    const int32_t i1 = std::min(i0 + 1, c.size1D - 1);
+    const float w = t - static_cast<float>(i0);
+    const float a = table[static_cast<size_t>(i0) * 3u + static_cast<size_t>(ch)];
+    const float b = table[static_cast<size_t>(i1) * 3u + static_cast<size_t>(ch)];
+    return a + (b - a) * w;
+}
+
+// Trilinear trên lưới .cube (R đổi nhanh nhất), domain [min3D, max3D]
+void eval3D(const CubeFile &c, const float *table, const float in[3], float out[3]) {
+    const int32_t N = c.size3D;
+    int32_t i0[3], i1[3];
+    float w[3];
+    for (int32_t ch = 0; ch < 3; ++ch) {
+        const float span = c.max3D[ch] - c.min3D[ch];
+        float t = span != 0.f ? (in[ch] - c.min3D[ch]) / span : 0.f;
+        t = std::clamp(t, 0.f, 1.f) * static_cast<float>(N - 1);
+        i0[ch] = std::min(static_cast<int32_t>(t), N - 1);
+        i1[ch] = std::min(i0[ch] + 1, N - 1);
+        w[ch] = t - static_cast<float>(i0[ch]);
+    }
+    auto at = [&](int32_t r, int32_t g, int32_t b, int32_t ch) {
+        const size_t idx = (static_cast<size_t>(b) * static_cast<size_t>(N) + static_cast<size_t>(g)) * static_cast<size_t>(N)
+                           + static_cast<size_t>(r);
+        return table[idx * 3u + static_cast<size_t>(ch)];
+    };
+    for (int32_t ch = 0; ch < 3; ++ch) {
+        const float c00 = at(i0[0], i0[1], i0[2], ch) + (at(i0[0], i0[1], i1[2], ch) - at(i0[0], i0[1], i0[2], ch)) * w[2];
+        const float c01 = at(i0[0], i1[1], i0[2], ch) + (at(i0[0], i1[1], i1[2], ch) - at(i0[0], i1[1], i0[2], ch)) * w[2];
+        const float c10 = at(i1[0], i0[1], i0[2], ch) + (at(i1[0], i0[1], i1[2], ch) - at(i1[0], i0[1], i0[2], ch)) * w[2];
+        const float c11 = at(i1[0], i1[1], i0[2], ch) + (at(i1[0], i1[1], i1[2], ch) - at(i1[0], i1[1], i0[2], ch)) * w[2];
+        const float c0 = c00 + (c01 - c00) * w[1];
+        const float c1 = c10 + (c11 - c10) * w[1];
+        out[ch] = c0 + (c1 - c0) * w[0];
+    }
+}
+
+bool isUnitDomain(const float mn[3], const float mx[3]) {
+    for (int32_t i = 0; i < 3; ++i) {
+        if (mn[i] != 0.f || mx[i] != 1.f) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseCube(const char *text, size_t length, Lut3D &out, std::string *err) {
+    CubeFile c;
+    const char *p = text;
+    const char *end = text + length;
+    bool dataStarted = false;
+
+    while (p < end) {
+        const char *eol = static_cast<const char *>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!eol) eol = end;
+        const char *s = p;
+        const char *e = eol;
+        p = eol + (eol < end ? 1 : 0);
+        while (s < e && (*s == ' ' || *s == '\t' || *s == '\r')) ++s;
+        while (e > s && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r')) --e;
+        if (s == e || *s == '#') continue;
+
+        float v[3];
+        if ((*s >= '0' && *s <= '9') || *s == '-' || *s == '+' || *s == '.') {
+            if (readFloats(s, e, v, 3) != 3) { setErr(err, "Malformed .cube data line"); return false; }
+            c.rows.insert(c.rows.end(), v, v + 3);
+            dataStarted = true;
+            continue;
+        }
+        if (dataStarted) { setErr(err, "Keyword after .cube data"); return false; }
+
+        if (startsWith(s, e, "TITLE")) continue;
+        if (startsWith(s, e, "LUT_3D_SIZE") || startsWith(s, e, "LUT_1D_SIZE")) {
+            const bool is3D = s[4] == '3';
+            const char *num = s + std::strlen("LUT_3D_SIZE");
+            if (readFloats(num, e, v, 1) != 1) { setErr(err, "Malformed LUT size"); return false; }
+            const auto n = static_cast<int32_t>(v[0]);
+            const int32_t maxN = is3D ? kLutMaxSize : 65536;
+            if (n < kLutMinSize || n > maxN) { setErr(err, "LUT size out of range"); return false; }
+            (is3D ? c.size3D : c.size1D) = n;
+            continue;
+        }
+        if (startsWith(s, e, "DOMAIN_MIN") || startsWith(s, e, "DOMAIN_MAX")) {
+            const bool isMin = s[9] == 'N';
+            if (readFloats(s + std::strlen("DOMAIN_MIN"), e, v, 3) != 3) { setErr(err, "Malformed DOMAIN line"); return false; }
+            // Adobe: 1 domain dùng chung cho cả 1D và 3D
+            std::memcpy(isMin ? c.min1D : c.max1D, v, sizeof(v));
+            std::memcpy(isMin ? c.min3D : c.max3D, v, sizeof(v));
+            continue;
+        }
+        if (startsWith(s, e, "LUT_1D_INPUT_RANGE") || startsWith(s, e, "LUT_3D_INPUT_RANGE")) {
+            // Biến thể của Resolve: min max dùng chung cho 3 kênh
+            const bool is3D = s[4] == '3';
+            if (readFloats(s + std::strlen("LUT_1D_INPUT_RANGE"), e, v, 2) != 2) { setErr(err, "Malformed INPUT_RANGE"); return false; }
+            float *mn = is3D ? c.min3D : c.min1D;
+            float *mx = is3D ? c.max3D : c.max1D;
+            for (int32_t i = 0; i < 3; ++i) { mn[i] = v[0]; mx[i] = v[1]; }
+            continue;
+        }
+        // Keyword lạ: bỏ qua (theo spec, các reader phải bỏ qua keyword không biết)
+    }
+
+    if (c.size1D == 0 && c.size3D == 0) { setErr(err, "Missing LUT_3D_SIZE / LUT_1D_SIZE"); return false; }
+    const size_t rows1D = static_cast<size_t>(c.size1D);
+    const size_t rows3D = static_cast<size_t>(c.size3D) * static_cast<size_t>(c.size3D) * static_cast<size_t>(c.size3D);
+    if (c.rows.size() != (rows1D + rows3D) * 3u) { setErr(err, "Entry count does not match LUT size"); return false; }
+
+    const float *table1D = c.size1D ? c.rows.data() : nullptr;
+    const float *table3D = c.size3D ? c.rows.data() + rows1D * 3u : nullptr;
+
+    // Nhanh: chỉ 3D, domain [0, 1], size vừa phải -> chỉ đổi thứ tự trục (R nhanh -> R chậm)
+    if (!table1D && c.size3D <= kLutConvertMaxSize && isUnitDomain(c.min3D, c.max3D)) {
+        const int32_t N = c.size3D;
+        out.size = N;
+        out.data.resize(rows3D * 3u);
+        for (int32_t r = 0; r < N; ++r)
+            for (int32_t g = 0; g < N; ++g)
+                for (int32_t b = 0; b < N; ++b) {
+                    const size_t src = ((static_cast<size_t>(b) * static_cast<size_t>(N) + static_cast<size_t>(g)) * static_cast<size_t>(N)
+                                        + static_cast<size_t>(r)) * 3u;
+                    const size_t dst = ((static_cast<size_t>(r) * static_cast<size_t>(N) + static_cast<size_t>(g)) * static_cast<size_t>(N)
+                                        + static_cast<size_t>(b)) * 3u;
+                    std::memcpy(&out.data[dst], &table3D[src], 3u * sizeof(float));
+                }
+        return true;
+    }
+
+    // Tổng quát: đánh giá (1D rồi 3D) tại từng điểm lưới đầu ra trên domain [0, 1]
+    const int32_t S = std::min(c.size3D ? c.size3D : 33, kLutConvertMaxSize);
+    out.size = S;
+    out.data.resize(static_cast<size_t>(S) * static_cast<size_t>(S) * static_cast<size_t>(S) * 3u);
+    const float inv = 1.f / static_cast<float>(S - 1);
+    size_t o = 0;
+    for (int32_t r = 0; r < S; ++r)
+        for (int32_t g = 0; g < S; ++g)
+            for (int32_t b = 0; b < S; ++b, o += 3) {
+                float v[3] = {static_cast<float>(r) * inv, static_cast<float>(g) * inv, static_cast<float>(b) * inv};
+                if (table1D) {
+                    for (int32_t ch = 0; ch < 3; ++ch) v[ch] = eval1D(c, table1D, ch, v[ch]);
+                }
+                if (table3D) {
+                    float t[3];
+                    eval3D(c, table3D, v, t);
+                    std::memcpy(v, t, sizeof(v));
+                }
+                std::memcpy(&out.data[o], v, sizeof(v));
+            }
+    return true;
+}
+
+// =============================================================
+// 🖼️ HaldCLUT
+// =============================================================
+bool parseHaldClut(const uint8_t *rgba, int32_t width, int32_t height, size_t stride, Lut3D &out, std::string *err) {
+    if (!rgba || width != height) { setErr(err, "HaldCLUT must be square"); return false; }
+    int32_t level = 0;
+    for (int32_t l = 2; l * l * l <= width; ++l) {
+        if (l * l * l == width) level = l;
+    }
+    if (level == 0) { setErr(err, "HaldCLUT width must be level^3"); return false; }
+    const int32_t N = level * level;
+
+    auto fetch = [&](int32_t r, int32_t g, int32_t b, float c[3]) {
+        const size_t i = (static_cast<size_t>(b) * static_cast<size_t>(N) + static_cast<size_t>(g)) * static_cast<size_t>(N)
+                         + static_cast<size_t>(r);
+        const uint8_t *px = rgba + (i / static_cast<size_t>(width)) * stride + (i % static_cast<size_t>(width)) * 4u;
+        c[0] = static_cast<float>(px[0]) / 255.f;
+        c[1] = static_cast<float>(px[1]) / 255.f;
+        c[2] = static_cast<float>(px[2]) / 255.f;
+    };
+
+    if (N <= kLutConvertMaxSize) {
+        out.size = N;
+        out.data.resize(static_cast<size_t>(N) * static_cast<size_t>(N) * static_cast<size_t>(N) * 3u);
+        size_t o = 0;
+        for (int32_t r = 0; r < N; ++r)
+            for (int32_t g = 0; g < N; ++g)
+                for (int32_t b = 0; b < N; ++b, o += 3) fetch(r, g, b, &out.data[o]);
+        return true;
+    }
+    // Level cao (vd. 12 -> lưới 144): resample xuống kLutConvertMaxSize
+    resampleLattice(out, kLutConvertMaxSize, N, fetch);
+    return true;
+}
+
+// File tạm + rename để không bao giờ để lại file hỏng
+static bool writeFileAtomic(const std::string &path, const void *head, size_t headBytes,
+                            const void *body, size_t bodyBytes, std::string *err) {
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f.is_open()) { setErr(err, "Cannot open output file"); return false; }
+        f.write(static_cast<const char *>(head), static_cast<std::streamsize>(headBytes));
+        f.write(static_cast<const char *>(body), static_cast<std::streamsize>(bodyBytes));
+        if (!f) {
+            f.close();
+            std::remove(tmp.c_str());
+            setErr(err, "Write failed");
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        setErr(err, "Rename failed");
+        return false;
+    }
+    return true;
+}
+
+bool writeTableFile(const std::string &path, const Lut3D &lut, std::string *err) {
+    if (!lut.valid()) { setErr(err, "Invalid LUT"); return false; }
+    const uint32_t header[2] = {static_cast<uint32_t>(lut.size), kTableVersion};
+    return writeFileAtomic(path, header, sizeof(header), lut.data.data(), lut.data.size() * sizeof(float), err);
+}
+
+// =============================================================
+// 🗜️ .lutz
+// =============================================================
+namespace {
+
+// Residual Lorenzo 3D = sai phân hỗn hợp theo cả 3 trục -> đảo lại bằng 3 lượt cộng dồn độc lập:
+// theo b (quét từng hàng), theo g (cộng cả hàng trước), theo r (cộng cả mặt trước) — 2 lượt sau là
+// phép cộng vector dài, không có chuỗi phụ thuộc từng phần tử như dự đoán 7 điểm.
+void lorenzoForward(int32_t *q, int32_t S) {
+    const auto n = static_cast<size_t>(S);
+    const size_t plane = n * n;
+    for (size_t i = plane * n; i-- > plane;) q[i] -= q[i - plane];
+    for (size_t r = 0; r < n; ++r) {
+        int32_t *p = q + r * plane;
+        for (size_t i = plane; i-- > n;) p[i] -= p[i - n];
+    }
+    for (size_t row = 0; row < plane; ++row) {
+        int32_t *p = q + row * n;
+        for (size_t b = n; b-- > 1;) p[b] -= p[b - 1];
+    }
+}
+
+inline int32_t identityUnorm(int32_t i, int32_t S) {
+    return static_cast<int32_t>((static_cast<int64_t>(i) * 65535 * 2 + (S - 1)) / (2 * (S - 1)));
+}
+
+inline void putU16(uint8_t *p, uint32_t v) { p[0] = static_cast<uint8_t>(v); p[1] = static_cast<uint8_t>(v >> 8); }
+inline void putU32(uint8_t *p, uint32_t v) { putU16(p, v & 0xFFFFu); putU16(p + 2, v >> 16); }
+inline uint32_t getU16(const uint8_t *p) { return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8); }
+inline uint32_t getU32(const uint8_t *p) { return getU16(p) | (getU16(p + 2) << 16); }
+
+// |residual| <= 8 * 65535 -> zigzag < 2^21 -> tối đa 3 byte varint
+constexpr size_t kLutzMaxVarintBytes = 3;
+
+} // namespace
+
+bool isLutzHeader(const uint8_t *bytes, size_t n) {
+    return n >= 4 && getU32(bytes) == kLutzMagic;
+}
+
+bool encodeLutz(const Lut3D &lut, int32_t step, std::vector<uint8_t> &out, std::string *err) {
+    if (!lut.valid()) { setErr(err, "Invalid LUT"); return false; }
+    if (step < 1 || step > kLutzMaxStep) { setErr(err, "Invalid .lutz step"); return false; }
+    const int32_t S = lut.size;
+    const size_t points = static_cast<size_t>(S) * static_cast<size_t>(S) * static_cast<size_t>(S);
+
+    std::vector<uint8_t> stream;
+    stream.reserve(points * 3u);
+    std::vector<int32_t> q(points);
+    for (int32_t c = 0; c < 3; ++c) {
+        size_t i = 0;
+        for (int32_t r = 0; r < S; ++r) {
+            for (int32_t g = 0; g < S; ++g) {
+                for (int32_t b = 0; b < S; ++b, ++i) {
+                    const int32_t axis = (c == 0) ? r : (c == 1) ? g : b;
+                    const float v = std::clamp(lut.data[i * 3u + static_cast<size_t>(c)], 0.0f, 1.0f);
+                    const auto u = static_cast<int32_t>(std::lround(v * 65535.0f));
+                    const int32_t d = u - identityUnorm(axis, S);
+                    // Làm tròn đối xứng quanh 0 để step > 1 không lệch về 1 phía
+                    q[i] = (d >= 0) ? (d + step / 2) / step : -((-d + step / 2) / step);
+                    // step > 1: decoder đọc q dạng int16; chỉ step = 2, d = 65535 chạm 32768 (lệch 1 <= step / 2)
+                    if (step > 1) q[i] = std::min(q[i], 32767);
+                }
+            }
+        }
+        lorenzoForward(q.data(), S);
+        for (const int32_t res : q) {
+            auto z = (static_cast<uint32_t>(res) << 1) ^ static_cast<uint32_t>(res >> 31);
+            while (z >= 0x80u) {
+                stream.push_back(static_cast<uint8_t>(z | 0x80u));
+                z >>= 7;
+            }
+            stream.push_back(static_cast<uint8_t>(z));
+        }
+    }
+
+    uLongf zBytes = compressBound(static_cast<uLong>(stream.size()));
+    out.assign(kLutzHeaderBytes + zBytes, 0);
+    if (compress2(out.data() + kLutzHeaderBytes, &zBytes, stream.data(), static_cast<uLong>(stream.size()),
+                  Z_BEST_COMPRESSION) != Z_OK) {
+        setErr(err, "deflate failed");
+        return false;
+    }
+    out.resize(kLutzHeaderBytes + zBytes);
+    putU32(out.data(), kLutzMagic);
+    putU16(out.data() + 4, kLutzVersion);
+    putU16(out.data() + 6, static_cast<uint32_t>(step));
+    putU32(out.data() + 8, static_cast<uint32_t>(S));
+    putU32(out.data() + 12, static_cast<uint32_t>(stream.size()));
+    putU32(out.data() + 16, static_cast<uint32_t>(zBytes));
+    return true;
+}
+
+bool decodeLutz(const uint8_t *file, size_t fileBytes, Lut3D &out, std::string *err) {
+    if (!file || fileBytes < kLutzHeaderBytes || !isLutzHeader(file, fileBytes)) {
+        setErr(err, "Not a .lutz file");
+        return false;
+    }
+    if (getU16(file + 4) != kLutzVersion) { setErr(err, "Unknown .lutz version"); return false; }
+    const auto step = static_cast<int32_t>(getU16(file + 6));
+    const uint32_t size = getU32(file + 8);
+    const uint32_t streamBytes = getU32(file + 12);
+    const uint32_t payloadBytes = getU32(file + 16);
+    if (step < 1 || step > kLutzMaxStep) { setErr(err, "Invalid .lutz step"); return false; }
+    if (size < static_cast<uint32_t>(kLutMinSize) || size > static_cast<uint32_t>(kLutMaxSize)) {
+        setErr(err, "LUT size out of range");
+        return false;
+    }
+    const int32_t S = static_cast<int32_t>(size);
+    const size_t points = static_cast<size_t>(S) * static_cast<size_t>(S) * static_cast<size_t>(S);
+    if (kLutzHeaderBytes + static_cast<uint64_t>(payloadBytes) != fileBytes) {
+        setErr(err, "LUT size does not match file length");
+        return false;
+    }
+    if (streamBytes < points * 3u || streamBytes > points * 3u * kLutzMaxVarintBytes) {
+        setErr(err, "Invalid .lutz stream length");
+        return false;
+    }
+
+    // Không zero-init: inflate ghi đè toàn bộ (got == streamBytes được kiểm tra ngay sau)
+    std::unique_ptr<uint8_t[]> stream(new uint8_t[streamBytes]);
+    uLongf got = streamBytes;
+    if (uncompress(stream.get(), &got, file + kLutzHeaderBytes, payloadBytes) != Z_OK || got != streamBytes) {
+        setErr(err, "Corrupt .lutz payload");
+        return false;
+    }
+
+    int32_t ident[kLutMaxSize];
+    for (int32_t i = 0; i < S; ++i) ident[i] = identityUnorm(i, S);
+
+    // Đảo Lorenzo = cộng dồn theo b, g, r. Lượt b gộp vào lúc đọc varint, ghi xen kẽ 3 kênh (i * 3 + c);
+    // lượt g và r gộp vào lượt interleave bên dưới. Số học uint16 quay vòng: mọi phép cộng là mod 2^16,
+    // nên giá trị cuối đúng bất kể tổng trung gian (stream hỏng chỉ cho ra giá trị rác, không tràn số có dấu).
+    const auto n = static_cast<size_t>(S);
+    const size_t plane = n * n;
+    const size_t rowLen = n * 3u;
+    std::unique_ptr<uint16_t[]> q(new uint16_t[points * 3u]);
+    const uint8_t *p = stream.get();
+    const uint8_t *const end = p + streamBytes;
+    for (size_t c = 0; c < 3; ++c) {
+        uint16_t *row = q.get() + c;
+        for (size_t rowIndex = 0; rowIndex < plane; ++rowIndex, row += rowLen) {
+            uint32_t acc = 0;
+            size_t b = 0;
+            while (b < n) {
+                // Gần như mọi residual = 0 hoặc rất nhỏ: 8 byte liền không có bit tiếp nối -> 8 giá trị 1 byte
+                uint64_t word;
+                if (n - b >= 8 && end - p >= 8 && (std::memcpy(&word, p, 8), (word & 0x8080808080808080ull) == 0)) {
+                    for (size_t k = 0; k < 8; ++k, ++b) {
+                        const auto z = static_cast<uint32_t>((word >> (8u * k)) & 0xFFu);
+                        acc += (z >> 1) ^ (0u - (z & 1u));
+                        row[b * 3u] = static_cast<uint16_t>(acc);
+                    }
+                    p += 8;
+                    continue;
+                }
+                uint32_t z = 0;
+                for (uint32_t shift = 0;; shift += 7) {
+                    if (p == end || shift > 14) { setErr(err, "Corrupt .lutz stream"); return false; }
+                    const uint8_t byte = *p++;
+                    z |= static_cast<uint32_t>(byte & 0x7Fu) << shift;
+                    if (!(byte & 0x80u)) break;
+                }
+                acc += (z >> 1) ^ (0u - (z & 1u));
+                row[b++ * 3u] = static_cast<uint16_t>(acc);
+            }
+        }
+    }
+    if (p != end) { setErr(err, "Corrupt .lutz stream"); return false; }
+
+    out.size = S;
+    out.data.clear();
+    if (out.packed.size() != points * 4u) out.packed.assign(points * 4u, 0);
+
+    // gRow: tổng theo g trong mặt r hiện tại; rPlane: tổng theo r của gRow (= q cuối) cho cả mặt.
+    // Cả 2 nằm gọn trong cache (65^3: 25 KB), mỗi hàng là 3n uint16 liền nhau -> vector hoá được.
+    std::unique_ptr<uint16_t[]> accBuf(new uint16_t[rowLen * (n + 1u)]());
+    uint16_t *const gRow = accBuf.get();
+    uint16_t *const rPlane = gRow + rowLen;
+    const uint16_t *src = q.get();
+    uint16_t *dst = out.packed.data();
+    for (size_t r = 0; r < n; ++r) {
+        std::fill(gRow, gRow + rowLen, uint16_t{0});
+        for (size_t g = 0; g < n; ++g, src += rowLen) {
+            uint16_t *const qRow = rPlane + g * rowLen;
+            for (size_t k = 0; k < rowLen; ++k) {
+                gRow[k] = static_cast<uint16_t>(gRow[k] + src[k]);
+                qRow[k] = static_cast<uint16_t>(qRow[k] + gRow[k]);
+            }
+            const int32_t ir = ident[r], ig = ident[g];
+            if (step == 1) {
+                // u16 = identity + q, luôn trong [0, 65535] với stream hợp lệ -> mod 2^16 là chính xác
+                for (size_t b = 0; b < n; ++b, dst += 4) {
+                    dst[0] = static_cast<uint16_t>(ir + qRow[b * 3u]);
+                    dst[1] = static_cast<uint16_t>(ig + qRow[b * 3u + 1u]);
+                    dst[2] = static_cast<uint16_t>(ident[b] + qRow[b * 3u + 2u]);
+                    dst[3] = 0;
+                }
+            } else {
+                // step > 1: |q| <= 32768 -> encoder kẹp vào int16; làm tròn q có thể vượt [0, 65535] -> kẹp
+                const auto unorm = [step](int32_t base, uint16_t v) {
+                    return static_cast<uint16_t>(std::clamp(base + static_cast<int16_t>(v) * step, 0, 65535));
+                };
+                for (size_t b = 0; b < n; ++b, dst += 4) {
+                    dst[0] = unorm(ir, qRow[b * 3u]);
+                    dst[1] = unorm(ig, qRow[b * 3u + 1u]);
+                    dst[2] = unorm(ident[b], qRow[b * 3u + 2u]);
+                    dst[3] = 0;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool writeLutzFile(const std::string &path, const Lut3D &lut, int32_t step, std::string *err) {
+    std::vector<uint8_t> bytes;
+    if (!encodeLutz(lut, step, bytes, err)) return false;
+    return writeFileAtomic(path, bytes.data(), bytes.size(), nullptr, 0, err);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// =============================================================
+// 🎨 LUT 3D + định dạng .table (định dạng nhị phân "nhanh" của engine)
+// .table: uint32 size, uint32 version (= 0), rồi size^3 * 3 float (little-endian),
+// thứ tự R chậm nhất: index = (r * size + g) * size + b, domain đầu vào [0, 1].
+// =============================================================
+struct Lut3D {
+    int32_t size = 0;
+    std::vector<float> data;      // size^3 * 3 (định dạng .table; dùng khi parse / convert)
+    // Layout runtime: size^3 * 4 uint16 unorm (RGB + pad) -> mỗi đỉnh lưới = 1 lần load 8 byte thẳng hàng.
+    // 33^3: 287 KB thay vì 431 KB float, và không đỉnh nào vắt qua 2 cache line.
+    std::vector<uint16_t> packed;
+
+    bool valid() const {
+        const size_t need = static_cast<size_t>(size) * static_cast<size_t>(size) * static_cast<size_t>(size) * 3u;
+        return size > 0 && data.size() == need;
+    }
+    bool packedValid() const {
+        const size_t need = static_cast<size_t>(size) * static_cast<size_t>(size) * static_cast<size_t>(size) * 4u;
+        return size > 0 && packed.size() == need;
+    }
+};
+
+static constexpr float kLutUnormScale = 1.0f / 65535.0f;
+
+// data -> packed (clamp [0, 1], làm tròn). dropFloat: giải phóng `data` khi chỉ còn dùng để render.
+void packLut(Lut3D &lut, bool dropFloat);
+
+static constexpr int32_t kLutMinSize = 2;
+static constexpr int32_t kLutMaxSize = 256;
+// Hald / .cube lớn hơn mức này được resample xuống khi convert (bộ nhớ + cache)
+static constexpr int32_t kLutConvertMaxSize = 65;
+static constexpr uint32_t kTableVersion = 0;
+static constexpr size_t kTableHeaderBytes = 8;
+
+// Kiểm tra header .table so với tổng kích thước file TRƯỚC khi cấp phát; trả về size hợp lệ hoặc 0.
+int32_t validateTableHeader(const uint32_t header[2], uint64_t fileBytes, std::string *err);
+
+// Adobe .cube (LUT_3D_SIZE / LUT_1D_SIZE, DOMAIN_MIN / DOMAIN_MAX, TITLE, comment '#').
+// 1D được chuyển thành 3D; domain khác [0, 1] được resample về [0, 1].
+bool parseCube(const char *text, size_t length, Lut3D &out, std::string *err);
+
+// HaldCLUT: ảnh vuông level L (cạnh L^3, lưới L^2), pixel RGBA 8-bit KHÔNG premultiply, R đổi nhanh nhất.
+bool parseHaldClut(const uint8_t *rgba, int32_t width, int32_t height, size_t stride, Lut3D &out, std::string *err);
+
+// Ghi .table (file tạm + rename để không bao giờ để lại file hỏng)
+bool writeTableFile(const std::string &path, const Lut3D &lut, std::string *err);
+
+// =============================================================
+// 🗜️ .lutz: LUT nén cho assets (converter host: adjust/tools/lut_compress.cpp)
+// Header 20 byte (little-endian): char[4] "LUTZ", uint16 version (= 1), uint16 step, uint32 size,
+// uint32 streamBytes (sau inflate), uint32 payloadBytes (zlib), rồi payload.
+// Mỗi kênh lưu q = round((u16 - identity) / step), u16 = giá trị unorm giống packLut;
+// theo từng kênh (R chậm nhất) residual = q - dự đoán Lorenzo 3D (lưới nội suy tuyến tính -> 0),
+// zigzag + varint, cả stream deflate. step = 1: giải nén ra đúng bảng packed của .table gốc.
+// step > 1: q được kẹp vào int16 (decoder cộng dồn mod 2^16 rồi đọc q có dấu).
+// =============================================================
+static constexpr uint32_t kLutzMagic = 0x5A54554Cu; // "LUTZ"
+static constexpr uint16_t kLutzVersion = 1;
+static constexpr size_t kLutzHeaderBytes = 20;
+static constexpr int32_t kLutzMaxStep = 256;
+// Trần cho file đọc vào bộ nhớ trước khi giải nén (65^3 thực tế < 100 KB)
+static constexpr uint64_t kLutzMaxFileBytes = 16ull * 1024ull * 1024ull;
+
+// 4 byte đầu của file là "LUTZ" (.table bắt đầu bằng size <= kLutMaxSize nên không nhầm được)
+bool isLutzHeader(const uint8_t *bytes, size_t n);
+
+// Giải nén thẳng vào out.packed (out.data để trống). Mọi kích thước được kiểm tra trước khi cấp phát.
+bool decodeLutz(const uint8_t *file, size_t fileBytes, Lut3D &out, std::string *err);
+
+// lut.data (float) -> file .lutz trong bộ nhớ; step 1..kLutzMaxStep (> 1: mất tối đa step / 2 / 65535 mỗi kênh)
+bool encodeLutz(const Lut3D &lut, int32_t step, std::vector<uint8_t> &out, std::string *err);
+
+bool writeLutzFile(const std::string &path, const Lut3D &lut, int32_t step, std::string *err);
+
@@ -0,0 +1,78 @@
+#include "adjust_memory.h"
+
+#include <algorithm>
+
+void MemoryGovernor::attach(MemoryPool pool, MemoryConsumer *consumer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    consumers_[pool] = consumer;
+}
+
+void MemoryGovernor::setBudget(size_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_ = budgetBytes;
+    if (totalLocked() > budget_) shrinkLocked(budget_, MEM_LUT_CACHE);
+}
+
+size_t MemoryGovernor::budget() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return budget_;
+}
+
+void MemoryGovernor::enforce() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (totalLocked() > budget_) shrinkLocked(budget_, MEM_LUT_CACHE);
+}
+
+void MemoryGovernor::trimMemory(int32_t level) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (level >= TRIM_BACKGROUND) {
+        // Có thể bị kill bất cứ lúc nào: trả mọi thứ dựng lại được
+        shrinkLocked(0, MEM_LUT_CACHE);
+    } else if (level >= TRIM_RUNNING_CRITICAL) {
+        // Critical hoặc UI vừa ẩn: giữ LUT đang dùng, bỏ preview đã cache
+        shrinkLocked(0, MEM_RENDER_CACHE);
+    } else if (level >= TRIM_RUNNING_LOW) {
+        shrinkLocked(0, MEM_SCRATCH_IDLE);
+        shrinkLocked(std::min(budget_, totalLocked()) / 2, MEM_RENDER_CACHE);
+    } else if (level >= TRIM_RUNNING_MODERATE) {
+        shrinkLocked(0, MEM_SCRATCH_IDLE);
+    }
+}
+
+size_t MemoryGovernor::bytes(MemoryPool pool) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return consumers_[pool] ? consumers_[pool]->bytes() : 0u;
+}
+
+size_t MemoryGovernor::totalBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return totalLocked();
+}
+
+size_t MemoryGovernor::totalLocked() const {
+    size_t total = 0;
+    for (const MemoryConsumer *c : consumers_) {
+        if (c) total += c->bytes();
+    }
+    return total;
+}
+
+void MemoryGovernor::shrinkLocked(size_t target, MemoryPool lastPool) {
+    // 2 lượt: buffer mà render cache trả ra quay về arena (pool rẻ hơn) -> lượt 2 dọn nốt
+    for (int32_t pass = 0; pass < 2; ++pass) {
+        for (int32_t i = 0; i <= lastPool; ++i) {
+            MemoryConsumer *c = consumers_[i];
+            if (!c || !c->evictable()) continue;
+            const size_t total = totalLocked();
+            if (total <= target) return;
+            const size_t own = c->bytes();
+            const size_t excess = total - target;
+            c->trim(own > excess ? own - excess : 0u);
+        }
+    }
+}
+
+MemoryGovernor &memoryGovernor() {
+    static MemoryGovernor governor;
+    return governor;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// =============================================================
+// 📊 MemoryGovernor — budget chung cho bộ nhớ native của engine
+// Mỗi cache đăng ký 1 MemoryConsumer vào 1 pool; thứ tự enum = thứ tự evict (rẻ nhất để dựng lại trước).
+// Tổng vượt budget (enforce() sau mỗi lần 1 cache lớn lên) -> trim lần lượt từ pool đầu tiên.
+// trimMemory(level) nhận level của ComponentCallbacks2.onTrimMemory, level càng cao càng đi sâu xuống danh sách.
+// Session local (dữ liệu người dùng) chỉ được báo cáo, không bao giờ bị evict.
+// =============================================================
+enum MemoryPool : int32_t {
+    MEM_SCRATCH_IDLE = 0,   // buffer rảnh của scratchArena()
+    MEM_RENDER_CACHE = 1,   // ảnh preview đã render (RenderCache)
+    MEM_LUT_CACHE = 2,      // LUT đã parse theo path
+    MEM_LOCAL_SESSIONS = 3, // mask của LocalSession
+    MEM_POOL_COUNT
+};
+
+class MemoryConsumer {
+public:
+    virtual ~MemoryConsumer() = default;
+    virtual size_t bytes() const = 0;
+    // Giải phóng tới khi còn <= keepBytes (best effort). Không được gọi lại MemoryGovernor.
+    virtual void trim(size_t keepBytes) = 0;
+    virtual bool evictable() const { return true; }
+};
+
+// Level của android.content.ComponentCallbacks2
+enum TrimLevel : int32_t {
+    TRIM_RUNNING_MODERATE = 5,
+    TRIM_RUNNING_LOW = 10,
+    TRIM_RUNNING_CRITICAL = 15,
+    TRIM_UI_HIDDEN = 20,
+    TRIM_BACKGROUND = 40,
+    TRIM_MODERATE = 60,
+    TRIM_COMPLETE = 80,
+};
+
+class MemoryGovernor {
+public:
+    static constexpr size_t kDefaultBudgetBytes = 128u * 1024u * 1024u;
+
+    // Consumer phải sống tới hết process (static); gọi lại với cùng pool thì thay consumer cũ
+    void attach(MemoryPool pool, MemoryConsumer *consumer);
+
+    void setBudget(size_t budgetBytes);
+    size_t budget() const;
+
+    // Gọi sau khi 1 cache có thể đã lớn lên, KHÔNG giữ lock của cache đó
+    void enforce();
+    void trimMemory(int32_t level);
+
+    size_t bytes(MemoryPool pool) const;
+    size_t totalBytes() const;
+
+private:
+    size_t totalLocked() const;
+    // Evict pool [0, lastPool] theo thứ tự tới khi tổng <= target
+    void shrinkLocked(size_t target, MemoryPool lastPool);
+
+    mutable std::mutex mutex_;
+    MemoryConsumer *consumers_[MEM_POOL_COUNT] = {};
+    size_t budget_ = kDefaultBudgetBytes;
+};
+
+MemoryGovernor &memoryGovernor();
+
+// Đặt ở đầu 1 lời gọi render: khi ra khỏi scope (sau khi mọi lease đã trả về arena) thì enforce budget
+class MemoryCheckpoint {
+public:
+    MemoryCheckpoint() = default;
+    MemoryCheckpoint(const MemoryCheckpoint &) = delete;
+    MemoryCheckpoint &operator=(const MemoryCheckpoint &) = delete;
+    ~MemoryCheckpoint() { memoryGovernor().enforce(); }
+};
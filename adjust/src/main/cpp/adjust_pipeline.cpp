@@ -0,0 +1,111 @@
+#include "adjust_pipeline.h"
+
+#include <cstdio>
+
+static const StageInfo kStageInfo[STAGE_COUNT] = {
+    {"denoise",  MASK_DENOISE,               true},
+    {"lut",      MASK_LUT,                   false},
+    {"tone",     MASK_LIGHT | MASK_CURVES,   false},
+    {"hsl",      MASK_HSL,                   false},
+    {"color",    MASK_COLOR,                 false},
+    {"detail",   MASK_DETAIL,                false},
+    {"vignette", MASK_VIGNETTE,              false},
+    {"grain",    MASK_GRAIN,                 false},
+};
+
+const StageInfo &stageInfo(PipelineStage stage) {
+    return kStageInfo[stage < STAGE_COUNT ? stage : 0];
+}
+
+const PipelineGroup *PipelinePlan::pre() const {
+    return spatialGroup > 0 ? &groups[spatialGroup - 1] : nullptr;
+}
+
+const PipelineGroup *PipelinePlan::post() const {
+    const int32_t i = spatialGroup + 1; // không có stage không gian -> nhóm 0
+    return i < groupCount ? &groups[i] : nullptr;
+}
+
+PipelineOrder normalizeOrder(const PipelineOrder &order) {
+    PipelineOrder out;
+    bool seen[STAGE_COUNT] = {false};
+    const int32_t n = order.count < STAGE_COUNT ? order.count : STAGE_COUNT;
+    for (int32_t i = 0; i < n; ++i) {
+        const uint8_t s = order.stages[i];
+        if (s >= STAGE_COUNT || seen[s]) continue;
+        seen[s] = true;
+        out.stages[out.count++] = s;
+    }
+    for (uint8_t s = 0; s < STAGE_COUNT; ++s) {
+        if (!seen[s]) out.stages[out.count++] = s;
+    }
+    return out;
+}
+
+PipelinePlan compilePipeline(const PipelineOrder &order, uint64_t activeMask, int32_t denoiseHalo) {
+    const PipelineOrder o = normalizeOrder(order);
+    PipelinePlan plan;
+    int32_t spatialCount = 0;
+    uint8_t lastPoint = 0; // stage point-wise trước đó trong nhóm hiện tại (kiểm tra thứ tự mặc định)
+
+    for (int32_t i = 0; i < o.count; ++i) {
+        const auto stage = static_cast<PipelineStage>(o.stages[i]);
+        const StageInfo &info = kStageInfo[stage];
+        if ((activeMask & info.maskBits) == 0) continue;
+        if (stage == STAGE_DENOISE && denoiseHalo <= 0) continue;
+
+        if (info.spatial) {
+            PipelineGroup &g = plan.groups[plan.groupCount++];
+            g.spatial = true;
+            g.halo = denoiseHalo;
+            g.stages[g.count++] = stage;
+            if (plan.spatialGroup < 0) plan.spatialGroup = plan.groupCount - 1;
+            ++spatialCount;
+            continue;
+        }
+
+        // Point-wise: nối vào nhóm point-wise đang mở, không có thì mở nhóm mới
+        if (plan.groupCount == 0 || plan.groups[plan.groupCount - 1].spatial) {
+            plan.groupCount++;
+            lastPoint = 0;
+        }
+        PipelineGroup &g = plan.groups[plan.groupCount - 1];
+        if (stage < lastPoint) plan.specialized = false;
+        lastPoint = stage;
+        g.stages[g.count++] = stage;
+    }
+
+    // Mỗi stage không gian sau stage đầu cần ảnh trung gian đầy đủ -> thêm 1 pass
+    plan.passCount = spatialCount > 1 ? spatialCount : 1;
+    if (plan.pre()) plan.specialized = false;
+    return plan;
+}
+
+std::string describePipeline(const PipelinePlan &plan) {
+    std::string out = std::to_string(plan.passCount) + (plan.passCount == 1 ? " pass: " : " passes: ");
+    if (plan.groupCount == 0) return out + "copy";
+
+    char buf[48];
+    for (int32_t i = 0; i < plan.groupCount; ++i) {
+        const PipelineGroup &g = plan.groups[i];
+        if (i > 0) out += " -> ";
+        if (g.spatial) {
+            std::snprintf(buf, sizeof(buf), "(halo %d)", g.halo);
+            out += kStageInfo[g.stages[0]].name;
+            out += buf;
+            continue;
+        }
+        out += '[';
+        for (int32_t k = 0; k < g.count; ++k) {
+            if (k > 0) out += " > ";
+            out += kStageInfo[g.stages[k]].name;
+        }
+        out += ']';
+    }
+    if (plan.pre()) {
+        std::snprintf(buf, sizeof(buf), "; pre recomputed on halo %d", plan.groups[plan.spatialGroup].halo);
+        out += buf;
+    }
+    out += plan.specialized ? "; specialized kernel" : "; ordered kernel";
+    return out;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "adjust_common.h"
+
+// =============================================================
+// 🧩 Pipeline graph — thứ tự stage cấu hình được
+// AdjustParams.order liệt kê stage theo thứ tự áp; compilePipeline bỏ stage không bật rồi gộp
+// các stage point-wise liền nhau thành 1 nhóm (1 lần đọc/ghi pixel). Stage không gian (denoise)
+// tách nhóm: nhóm point-wise đứng TRƯỚC nó được tính lại trên halo của từng tile thay vì
+// thêm 1 pass ghi cả ảnh, nên mọi thứ tự hiện có đều chạy trong 1 pass.
+//
+// Thêm stage mới: 1 giá trị PipelineStage + 1 dòng trong kStageInfo (adjust_pipeline.cpp)
+// + 1 case trong orderedPixel (AdjustProcessor.cpp).
+// =============================================================
+
+struct StageInfo {
+    const char *name;
+    uint64_t maskBits; // bật khi activeMask có bất kỳ bit nào
+    bool spatial;      // cần đọc pixel lân cận -> tách nhóm, cần halo
+};
+
+const StageInfo &stageInfo(PipelineStage stage);
+
+// Nhóm stage chạy liền nhau trên cùng 1 pixel (point-wise) hoặc 1 stage không gian
+struct PipelineGroup {
+    bool spatial = false;
+    int32_t halo = 0;  // spatial: số hàng/cột cần đọc thêm ngoài vùng output
+    int32_t count = 0;
+    uint8_t stages[STAGE_COUNT] = {0};
+};
+
+struct PipelinePlan {
+    PipelineGroup groups[STAGE_COUNT];
+    int32_t groupCount = 0;
+    int32_t passCount = 0;     // số lần đọc/ghi ảnh đầy đủ
+    int32_t spatialGroup = -1; // chỉ số nhóm không gian, -1 = không có
+    // 1 nhóm point-wise theo thứ tự mặc định -> dùng được kernel specialize / fixed-point như trước
+    bool specialized = true;
+
+    // Nhóm point-wise trước / sau stage không gian (nullptr = không có)
+    const PipelineGroup *pre() const;
+    const PipelineGroup *post() const;
+};
+
+// Thứ tự hợp lệ: stage lạ / lặp lại bị bỏ, stage không liệt kê nối vào cuối theo thứ tự mặc định
+PipelineOrder normalizeOrder(const PipelineOrder &order);
+
+// activeMask: stage đang bật (sau khi đã nạp LUT); denoiseHalo: halo của denoise ở độ phân giải đang render
+PipelinePlan compilePipeline(const PipelineOrder &order, uint64_t activeMask, int32_t denoiseHalo);
+
+// Vd. "1 pass: [tone > hsl] -> denoise(halo 10) -> [color > lut]" (profiling / log)
+std::string describePipeline(const PipelinePlan &plan);
@@ -0,0 +1,384 @@
+#include "adjust_resample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ADJUST_RESAMPLE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define ADJUST_RESAMPLE_SSE2 1
+#endif
+
+// =============================================================
+// Kernel & trọng số
+// =============================================================
+
+static constexpr double kPi = 3.14159265358979323846;
+static constexpr int32_t kLanczosLobes = 3;
+
+static double sinc(double x) {
+    if (x == 0.0) return 1.0;
+    const double px = kPi * x;
+    return std::sin(px) / px;
+}
+
+// Bán kính (đơn vị pixel nguồn) mà pixel output phủ tới; ss = max(tỉ lệ thu nhỏ, 1)
+static double filterSupport(ResampleFilter filter, double ss) {
+    switch (filter) {
+        case RESAMPLE_BILINEAR: return ss;
+        case RESAMPLE_LANCZOS3: return kLanczosLobes * ss;
+        default: return 0.5 * ss;
+    }
+}
+
+// Trọng số thô của pixel nguồn j (tâm j + 0.5) cho pixel output có tâm `center`
+static double filterWeight(ResampleFilter filter, double j, double center, double ss) {
+    switch (filter) {
+        case RESAMPLE_BILINEAR: {
+            const double t = std::fabs((j + 0.5 - center) / ss);
+            return t < 1.0 ? 1.0 - t : 0.0;
+        }
+        case RESAMPLE_LANCZOS3: {
+            const double t = (j + 0.5 - center) / ss;
+            return std::fabs(t) < kLanczosLobes ? sinc(t) * sinc(t / kLanczosLobes) : 0.0;
+        }
+        default: {
+            // Box: phần diện tích của [j, j + 1) nằm trong footprint [center - ss/2, center + ss/2)
+            const double half = 0.5 * ss;
+            return std::max(0.0, std::min(j + 1.0, center + half) - std::max(j, center - half));
+        }
+    }
+}
+
+// Số pixel nguồn tối đa 1 pixel output đọc tới
+static int32_t tapsBound(ResampleFilter filter, double ss, int32_t srcN) {
+    return std::min(static_cast<int32_t>(std::ceil(2.0 * filterSupport(filter, ss))) + 2, srcN + 1);
+}
+
+// Hệ số của pixel i ở weights[i × stride]; taps = số tap dài nhất (<= stride), pixel ít tap hơn đệm 0
+static void buildAxis(ResampleAxis &ax, int32_t srcN, int32_t dstN, double origin, double scale,
+                      ResampleFilter filter) {
+    const double ss = std::max(scale, 1.0);
+    const double support = filterSupport(filter, ss);
+    const int32_t stride = ax.stride;
+
+    int32_t taps = 1;
+    for (int32_t i = 0; i < dstN; ++i) {
+        const double center = origin + (i + 0.5) * scale;
+        const int32_t j0 = std::max(0, static_cast<int32_t>(std::floor(center - support)));
+        const int32_t j1 = std::min(srcN, static_cast<int32_t>(std::ceil(center + support)));
+        float *w = ax.weights + static_cast<size_t>(i) * static_cast<size_t>(stride);
+
+        double sum = 0.0;
+        int32_t n = 0;
+        for (int32_t j = j0; j < j1 && n < stride; ++j, ++n) {
+            const double v = filterWeight(filter, j, center, ss);
+            w[n] = static_cast<float>(v);
+            sum += v;
+        }
+        // Bỏ hệ số ~0 ở 2 đầu (vd. Lanczos tại toạ độ nguyên) -> 1:1 thành copy, ít tap hơn
+        int32_t lead = 0;
+        while (lead < n && std::fabs(w[lead]) <= 1e-6f) ++lead;
+        while (n > lead && std::fabs(w[n - 1]) <= 1e-6f) --n;
+
+        if (n <= lead || std::fabs(sum) < 1e-9) {
+            // Không phủ pixel nào: lấy pixel gần nhất
+            ax.start[i] = std::clamp(static_cast<int32_t>(std::floor(center)), 0, srcN - 1);
+            w[0] = 1.0f;
+            std::fill(w + 1, w + stride, 0.0f);
+            continue;
+        }
+        const float inv = static_cast<float>(1.0 / sum);
+        for (int32_t k = lead; k < n; ++k) w[k - lead] = w[k] * inv;
+        std::fill(w + (n - lead), w + stride, 0.0f);
+        ax.start[i] = j0 + lead;
+        taps = std::max(taps, n - lead);
+    }
+    ax.taps = std::min(taps, srcN);
+
+    // Pixel sát biên phải ít tap hơn: lùi start (đẩy hệ số sang phải) để [start, start + taps) vẫn trong ảnh
+    for (int32_t i = 0; i < dstN; ++i) {
+        const int32_t shift = std::max(0, ax.start[i] + ax.taps - srcN);
+        if (shift == 0) continue;
+        float *w = ax.weights + static_cast<size_t>(i) * static_cast<size_t>(stride);
+        for (int32_t k = ax.taps - 1; k >= 0; --k) w[k] = k >= shift ? w[k - shift] : 0.0f;
+        ax.start[i] -= shift;
+    }
+}
+
+// =============================================================
+// Bảng sRGB <-> linear (linearLight)
+// =============================================================
+static constexpr int32_t kLinearSteps = 16384; // bậc của bảng linear -> sRGB (lỗi < 0.5 mức 8-bit cả vùng tối)
+
+static double srgbToLinear(double v) {
+    return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+}
+
+static double linearToSrgb(double v) {
+    return v <= 0.0031308 ? v * 12.92 : 1.055 * std::pow(v, 1.0 / 2.4) - 0.055;
+}
+
+// 8-bit sRGB -> linear, thang 0..255
+static const float *srgbToLinearTable() {
+    static const auto *table = [] {
+        static float t[256];
+        for (int32_t i = 0; i < 256; ++i) t[i] = static_cast<float>(srgbToLinear(i / 255.0) * 255.0);
+        return t;
+    }();
+    return table;
+}
+
+// linear [0, 1] (kLinearSteps bậc) -> 8-bit sRGB
+static const uint8_t *linearToSrgbTable() {
+    static const auto *table = [] {
+        static uint8_t t[kLinearSteps];
+        for (int32_t i = 0; i < kLinearSteps; ++i) {
+            const double s = linearToSrgb(i / static_cast<double>(kLinearSteps - 1)) * 255.0;
+            t[i] = static_cast<uint8_t>(std::clamp(std::lround(s), 0l, 255l));
+        }
+        return t;
+    }();
+    return table;
+}
+
+static inline uint8_t encodeLinear(float v01, const uint8_t *table) {
+    const float idx = std::clamp(v01, 0.0f, 1.0f) * static_cast<float>(kLinearSteps - 1) + 0.5f;
+    return table[static_cast<int32_t>(idx)];
+}
+
+// =============================================================
+// Vòng lặp theo hàng (SIMD). Pixel = 4 float liền nhau, cùng thứ tự byte với RGBA_8888.
+// =============================================================
+
+// n pixel 8-bit -> float 0..255
+static void decodeRow(const uint8_t *src, float *out, int32_t n) {
+    int32_t i = 0;
+#if defined(ADJUST_RESAMPLE_NEON)
+    for (; i + 4 <= n; i += 4) {
+        const uint8x16_t b = vld1q_u8(src + 4 * i);
+        const uint16x8_t lo = vmovl_u8(vget_low_u8(b));
+        const uint16x8_t hi = vmovl_u8(vget_high_u8(b));
+        float *o = out + 4 * i;
+        vst1q_f32(o,      vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))));
+        vst1q_f32(o + 4,  vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))));
+        vst1q_f32(o + 8,  vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))));
+        vst1q_f32(o + 12, vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))));
+    }
+#elif defined(ADJUST_RESAMPLE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4) {
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 4 * i));
+        const __m128i lo = _mm_unpacklo_epi8(b, zero);
+        const __m128i hi = _mm_unpackhi_epi8(b, zero);
+        float *o = out + 4 * i;
+        _mm_storeu_ps(o,      _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_ps(o + 4,  _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_ps(o + 8,  _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_ps(o + 12, _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)));
+    }
+#endif
+    for (int32_t k = 4 * i; k < 4 * n; ++k) out[k] = static_cast<float>(src[k]);
+}
+
+// n pixel 8-bit sRGB -> linear thang 0..255 (alpha giữ nguyên); premultiplied: bỏ nhân alpha trước khi tra bảng
+static void decodeRowLinear(const uint8_t *src, float *out, int32_t n, bool premultiplied) {
+    const float *lin = srgbToLinearTable();
+    for (int32_t i = 0; i < n; ++i) {
+        const uint8_t *p = src + 4 * i;
+        float *o = out + 4 * i;
+        const uint32_t a = p[3];
+        o[3] = static_cast<float>(a);
+        if (!premultiplied || a == 255u) {
+            o[0] = lin[p[0]];
+            o[1] = lin[p[1]];
+            o[2] = lin[p[2]];
+        } else if (a == 0u) {
+            o[0] = o[1] = o[2] = 0.0f;
+        } else {
+            const float af = static_cast<float>(a) * (1.0f / 255.0f);
+            for (int32_t c = 0; c < 3; ++c) {
+                const uint32_t u = std::min(255u, (p[c] * 255u + a / 2u) / a);
+                o[c] = lin[u] * af;
+            }
+        }
+    }
+}
+
+// out[x] = Σ_k w[x][k] · line[start[x] - colBegin + k]
+static void horizontalRow(const float *line, float *out, const ResampleAxis &ax, int32_t colBegin, int32_t n) {
+    const int32_t taps = ax.taps;
+    for (int32_t x = 0; x < n; ++x) {
+        const float *p = line + 4 * (ax.start[x] - colBegin);
+        const float *w = ax.weights + static_cast<size_t>(x) * static_cast<size_t>(ax.stride);
+#if defined(ADJUST_RESAMPLE_NEON)
+        float32x4_t acc = vmulq_n_f32(vld1q_f32(p), w[0]);
+        for (int32_t k = 1; k < taps; ++k) acc = vmlaq_n_f32(acc, vld1q_f32(p + 4 * k), w[k]);
+        vst1q_f32(out + 4 * x, acc);
+#elif defined(ADJUST_RESAMPLE_SSE2)
+        __m128 acc = _mm_mul_ps(_mm_loadu_ps(p), _mm_set1_ps(w[0]));
+        for (int32_t k = 1; k < taps; ++k) {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(p + 4 * k), _mm_set1_ps(w[k])));
+        }
+        _mm_storeu_ps(out + 4 * x, acc);
+#else
+        float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        for (int32_t k = 0; k < taps; ++k) {
+            for (int32_t c = 0; c < 4; ++c) acc[c] += w[k] * p[4 * k + c];
+        }
+        std::memcpy(out + 4 * x, acc, sizeof(acc));
+#endif
+    }
+}
+
+// acc = w · row (first) hoặc acc += w · row
+static void rowMulAdd(float *acc, const float *row, float w, int32_t n, bool first) {
+    int32_t i = 0;
+#if defined(ADJUST_RESAMPLE_NEON)
+    if (first) {
+        for (; i + 4 <= n; i += 4) vst1q_f32(acc + i, vmulq_n_f32(vld1q_f32(row + i), w));
+    } else {
+        for (; i + 4 <= n; i += 4) vst1q_f32(acc + i, vmlaq_n_f32(vld1q_f32(acc + i), vld1q_f32(row + i), w));
+    }
+#elif defined(ADJUST_RESAMPLE_SSE2)
+    const __m128 vw = _mm_set1_ps(w);
+    if (first) {
+        for (; i + 4 <= n; i += 4) _mm_storeu_ps(acc + i, _mm_mul_ps(_mm_loadu_ps(row + i), vw));
+    } else {
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(_mm_loadu_ps(row + i), vw)));
+        }
+    }
+#endif
+    if (first) {
+        for (; i < n; ++i) acc[i] = w * row[i];
+    } else {
+        for (; i < n; ++i) acc[i] += w * row[i];
+    }
+}
+
+static inline uint8_t toByte(float v) {
+    return static_cast<uint8_t>(std::clamp(v + 0.5f, 0.0f, 255.0f));
+}
+
+// Hàng float -> 8-bit. Lanczos có thể vượt [0, 255] (ringing) -> kẹp; premultiplied: màu <= alpha.
+static void encodeRow(const float *acc, uint8_t *out, int32_t n, bool linear, bool premultiplied) {
+    const uint8_t *srgb = linear ? linearToSrgbTable() : nullptr;
+    for (int32_t i = 0; i < n; ++i) {
+        const float *p = acc + 4 * i;
+        uint8_t *o = out + 4 * i;
+        const uint8_t a = toByte(p[3]);
+        o[3] = a;
+        if (!linear) {
+            for (int32_t c = 0; c < 3; ++c) {
+                const uint8_t v = toByte(p[c]);
+                o[c] = premultiplied ? std::min(v, a) : v;
+            }
+        } else if (!premultiplied) {
+            for (int32_t c = 0; c < 3; ++c) o[c] = encodeLinear(p[c] * (1.0f / 255.0f), srgb);
+        } else if (a == 0) {
+            o[0] = o[1] = o[2] = 0;
+        } else {
+            const float af = std::max(p[3], 0.5f);
+            for (int32_t c = 0; c < 3; ++c) {
+                const float s = static_cast<float>(encodeLinear(p[c] / af, srgb));
+                o[c] = std::min(toByte(s * static_cast<float>(a) * (1.0f / 255.0f)), a);
+            }
+        }
+    }
+}
+
+// =============================================================
+// ResamplePlan
+// =============================================================
+
+bool ResamplePlan::init(int32_t srcW, int32_t srcH, float left, float top, float right, float bottom,
+                        int32_t dstW, int32_t dstH, ResampleFilter filter, bool linearLight, bool premultiplied) {
+    if (srcW <= 0 || srcH <= 0 || dstW <= 0 || dstH <= 0) return false;
+    if (!(right > left) || !(bottom > top)) return false;
+    if (filter < 0 || filter >= RESAMPLE_FILTER_COUNT) filter = RESAMPLE_BOX;
+
+    const double scaleX = (static_cast<double>(right) - static_cast<double>(left)) / dstW;
+    const double scaleY = (static_cast<double>(bottom) - static_cast<double>(top)) / dstH;
+    x_.stride = tapsBound(filter, std::max(scaleX, 1.0), srcW);
+    y_.stride = tapsBound(filter, std::max(scaleY, 1.0), srcH);
+
+    const size_t ints = static_cast<size_t>(dstW) + static_cast<size_t>(dstH);
+    const size_t floats = static_cast<size_t>(dstW) * static_cast<size_t>(x_.stride)
+                          + static_cast<size_t>(dstH) * static_cast<size_t>(y_.stride);
+    storage_ = scratchArena().borrow(ints * sizeof(int32_t) + floats * sizeof(float));
+    if (!storage_) return false;
+
+    auto *intBase = storage_.as<int32_t>();
+    auto *floatBase = reinterpret_cast<float *>(intBase + ints);
+    x_.start = intBase;
+    y_.start = intBase + dstW;
+    x_.weights = floatBase;
+    y_.weights = floatBase + static_cast<size_t>(dstW) * static_cast<size_t>(x_.stride);
+    buildAxis(x_, srcW, dstW, left, scaleX, filter);
+    buildAxis(y_, srcH, dstH, top, scaleY, filter);
+
+    colBegin_ = x_.start[0];
+    colEnd_ = colBegin_;
+    for (int32_t i = 0; i < dstW; ++i) {
+        colBegin_ = std::min(colBegin_, x_.start[i]);
+        colEnd_ = std::max(colEnd_, x_.start[i] + x_.taps);
+    }
+    dstW_ = dstW;
+    dstH_ = dstH;
+    linear_ = linearLight;
+    premultiplied_ = premultiplied;
+    return true;
+}
+
+int64_t ResamplePlan::sourcePixels() const {
+    if (dstH_ <= 0) return 0;
+    const int64_t rows = y_.start[dstH_ - 1] + y_.taps - y_.start[0];
+    return rows * (colEnd_ - colBegin_);
+}
+
+void ResamplePlan::run(const uint8_t *src, size_t srcStride, uint8_t *dst, size_t dstStride,
+                       int32_t y0, int32_t y1) const {
+    y0 = std::max(y0, 0);
+    y1 = std::min(y1, dstH_);
+    if (y0 >= y1) return;
+
+    // line: 1 hàng nguồn đã decode; ring: tapsY hàng đã lọc ngang (theo hàng nguồn % tapsY); acc: 1 hàng output
+    const int32_t span = colEnd_ - colBegin_;
+    const int32_t rowFloats = 4 * dstW_;
+    const int32_t tapsY = y_.taps;
+    const size_t floats = static_cast<size_t>(4 * span) + static_cast<size_t>(tapsY + 1) * static_cast<size_t>(rowFloats);
+    ScratchArena::Lease lease = scratchArena().borrow(floats * sizeof(float) + static_cast<size_t>(tapsY) * sizeof(int32_t));
+    if (!lease) return;
+    float *line = lease.as<float>();
+    float *ring = line + 4 * span;
+    float *acc = ring + static_cast<size_t>(tapsY) * static_cast<size_t>(rowFloats);
+    auto *tags = reinterpret_cast<int32_t *>(acc + rowFloats);
+    std::fill(tags, tags + tapsY, -1);
+
+    for (int32_t dy = y0; dy < y1; ++dy) {
+        const int32_t sy0 = y_.start[dy];
+        const float *w = y_.weights + static_cast<size_t>(dy) * static_cast<size_t>(y_.stride);
+        bool first = true;
+        for (int32_t k = 0; k < tapsY; ++k) {
+            if (w[k] == 0.0f) continue; // tap đệm
+            const int32_t sy = sy0 + k;
+            const int32_t slot = sy % tapsY;
+            float *filtered = ring + static_cast<size_t>(slot) * static_cast<size_t>(rowFloats);
+            if (tags[slot] != sy) {
+                const uint8_t *srcRow = src + static_cast<size_t>(sy) * srcStride + static_cast<size_t>(colBegin_) * 4u;
+                if (linear_) decodeRowLinear(srcRow, line, span, premultiplied_);
+                else decodeRow(srcRow, line, span);
+                horizontalRow(line, filtered, x_, colBegin_, dstW_);
+                tags[slot] = sy;
+            }
+            rowMulAdd(acc, filtered, w[k], rowFloats, first);
+            first = false;
+        }
+        if (first) std::fill(acc, acc + rowFloats, 0.0f);
+        encodeRow(acc, dst + static_cast<size_t>(dy) * dstStride, dstW_, linear_, premultiplied_);
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+// =============================================================
+// 📊 RenderStats — histogram + min/max + clipping của ảnh output
+// Mỗi worker giữ 1 bản riêng (không lock), gộp lại sau waitAll().
+// =============================================================
+enum StatsChannel : int32_t {
+    STATS_R = 0,
+    STATS_G = 1,
+    STATS_B = 2,
+    STATS_L = 3,
+    STATS_CHANNELS = 4,
+};
+
+// alignas(64): tránh false-sharing giữa các slot của từng thread
+struct alignas(64) RenderStats {
+    uint32_t hist[STATS_CHANNELS][256];
+    uint8_t minV[STATS_CHANNELS];
+    uint8_t maxV[STATS_CHANNELS];
+    uint64_t clippedLow  = 0; // có ít nhất 1 kênh == 0
+    uint64_t clippedHigh = 0; // có ít nhất 1 kênh == 255
+    uint64_t pixelCount  = 0;
+
+    RenderStats() { reset(); }
+
+    void reset() {
+        std::memset(hist, 0, sizeof(hist));
+        std::memset(minV, 0xFF, sizeof(minV));
+        std::memset(maxV, 0x00, sizeof(maxV));
+        clippedLow = clippedHigh = pixelCount = 0;
+    }
+
+    // Luma Rec.601 dạng số nguyên (77 + 150 + 29 = 256), khớp hệ số 0.299/0.587/0.114 của các module
+    static inline uint8_t luma(uint8_t r, uint8_t g, uint8_t b) {
+        return static_cast<uint8_t>((77u * r + 150u * g + 29u * b) >> 8);
+    }
+
+    inline void accumulate(uint8_t r, uint8_t g, uint8_t b) {
+        const uint8_t l = luma(r, g, b);
+        ++hist[STATS_R][r];
+        ++hist[STATS_G][g];
+        ++hist[STATS_B][b];
+        ++hist[STATS_L][l];
+
+        const uint8_t lo = std::min(r, std::min(g, b));
+        const uint8_t hi = std::max(r, std::max(g, b));
+        clippedLow  += (lo == 0u)   ? 1u : 0u;
+        clippedHigh += (hi == 255u) ? 1u : 0u;
+        ++pixelCount;
+    }
+
+    // Pipeline đọc kênh theo vị trí bit của uint32 (>> 16, >> 8, >> 0). Với RGBA_8888 trên
+    // little-endian, byte thấp nhất (>> 0) mới là R thật -> đảo lại để histogram đúng kênh.
+    inline void accumulateLanes(uint8_t lane16, uint8_t lane8, uint8_t lane0) {
+        accumulate(lane0, lane8, lane16);
+    }
+
+    // min/max suy ra từ histogram khi merge -> inner loop không phải so sánh thêm
+    void finalizeRange() {
+        for (int32_t c = 0; c < STATS_CHANNELS; ++c) {
+            minV[c] = 0xFF;
+            maxV[c] = 0x00;
+            for (int32_t i = 0; i < 256; ++i) {
+                if (hist[c][i]) { minV[c] = static_cast<uint8_t>(i); break; }
+            }
+            for (int32_t i = 255; i >= 0; --i) {
+                if (hist[c][i]) { maxV[c] = static_cast<uint8_t>(i); break; }
+            }
+        }
+    }
+
+    void merge(const RenderStats &o) {
+        for (int32_t c = 0; c < STATS_CHANNELS; ++c) {
+            for (int32_t i = 0; i < 256; ++i) hist[c][i] += o.hist[c][i];
+        }
+        clippedLow  += o.clippedLow;
+        clippedHigh += o.clippedHigh;
+        pixelCount  += o.pixelCount;
+    }
+};
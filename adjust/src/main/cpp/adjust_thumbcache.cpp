@@ -0,0 +1,664 @@
+#include "adjust_thumbcache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "adjust_cache.h"
+
+// =============================================================
+// 🔑 Hash
+// =============================================================
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+
+inline uint64_t rotl(uint64_t v, int r) { return (v << r) | (v >> (64 - r)); }
+
+inline uint64_t round64(uint64_t acc, uint64_t v) { return rotl(acc + v * kPrime2, 31) * kPrime1; }
+
+inline uint64_t mix64(uint64_t v) {
+    v ^= v >> 33;
+    v *= 0xFF51AFD7ED558CCDull;
+    v ^= v >> 33;
+    v *= 0xC4CEB9FE1A85EC53ull;
+    v ^= v >> 33;
+    return v;
+}
+
+inline uint64_t load64(const uint8_t *p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+} // namespace
+
+uint64_t hashPixels(const uint8_t *pixels, size_t stride, int32_t width, int32_t y0, int32_t y1) {
+    const size_t rowBytes = static_cast<size_t>(std::max(width, 0)) * 4u;
+    // 4 lane độc lập -> không bị chặn bởi độ trễ phép nhân
+    uint64_t a = kPrime1 + kPrime2, b = kPrime2, c = 0, d = 0 - kPrime1;
+    for (int32_t y = y0; y < y1; ++y) {
+        const uint8_t *row = pixels + static_cast<size_t>(y) * stride;
+        size_t i = 0;
+        for (; i + 32 <= rowBytes; i += 32) {
+            a = round64(a, load64(row + i));
+            b = round64(b, load64(row + i + 8));
+            c = round64(c, load64(row + i + 16));
+            d = round64(d, load64(row + i + 24));
+        }
+        for (; i + 8 <= rowBytes; i += 8) a = round64(a, load64(row + i));
+        for (; i < rowBytes; ++i) b = round64(b, row[i]);
+    }
+    uint64_t h = rotl(a, 1) + rotl(b, 7) + rotl(c, 12) + rotl(d, 18);
+    h = combineHash(h, static_cast<uint64_t>(rowBytes) << 32 | static_cast<uint32_t>(y1 - y0));
+    return h;
+}
+
+uint64_t combineHash(uint64_t seed, uint64_t value) {
+    return mix64(seed * kPrime1 + value);
+}
+
+uint64_t hashString(const char *s, size_t n) {
+    uint64_t h = 0xCBF29CE484222325ull; // FNV-1a
+    for (size_t i = 0; i < n; ++i) {
+        h ^= static_cast<uint8_t>(s[i]);
+        h *= 0x100000001B3ull;
+    }
+    return mix64(h);
+}
+
+// =============================================================
+// 💾 Định dạng file (little-endian, cùng máy ghi / đọc)
+// =============================================================
+namespace {
+
+constexpr uint32_t kIndexMagic = 0x58494854u;  // "THIX"
+constexpr uint32_t kIndexVersion = 1;
+constexpr uint32_t kRecordMagic = 0x43524854u; // "THRC"
+constexpr uint32_t kCodecRaw = 0;
+constexpr uint32_t kCodecDelta = 1;            // compressPixels
+constexpr uint32_t kSlotEmpty = 0;
+constexpr uint32_t kSlotLive = 1;
+constexpr uint32_t kSlotDead = 2;              // tombstone, được dùng lại khi chèn
+constexpr uint64_t kCompactKeepPercent = 75;   // compaction giữ lại tới 75% cap (entry dùng gần nhất)
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t codec;
+    uint64_t source;
+    uint64_t lut;
+    int32_t width, height;
+    uint32_t engine;
+    uint32_t payloadBytes;
+    uint32_t crc;      // crc32 của payload
+    uint32_t reserved;
+};
+static_assert(sizeof(RecordHeader) == 48, "RecordHeader layout");
+
+std::string indexPath(const std::string &dir) { return dir + "/thumbs.idx"; }
+
+std::string packPath(const std::string &dir, uint32_t generation) {
+    return dir + "/thumbs." + std::to_string(generation) + ".pack";
+}
+
+bool setErr(std::string *err, const char *what) {
+    if (err) *err = std::string(what) + ": " + std::strerror(errno);
+    return false;
+}
+
+bool preadAll(int fd, void *buf, size_t n, uint64_t offset) {
+    auto *p = static_cast<uint8_t *>(buf);
+    while (n > 0) {
+        const ssize_t got = ::pread(fd, p, n, static_cast<off_t>(offset));
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        p += got;
+        n -= static_cast<size_t>(got);
+        offset += static_cast<uint64_t>(got);
+    }
+    return true;
+}
+
+bool pwriteAll(int fd, const void *buf, size_t n, uint64_t offset) {
+    const auto *p = static_cast<const uint8_t *>(buf);
+    while (n > 0) {
+        const ssize_t put = ::pwrite(fd, p, n, static_cast<off_t>(offset));
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return false;
+        p += put;
+        n -= static_cast<size_t>(put);
+        offset += static_cast<uint64_t>(put);
+    }
+    return true;
+}
+
+uint32_t crcOf(const uint8_t *data, size_t n) {
+    uLong crc = crc32(0L, Z_NULL, 0);
+    // crc32 nhận uInt: chia khúc cho an toàn với blob lớn
+    while (n > 0) {
+        const uInt chunk = static_cast<uInt>(std::min<size_t>(n, 1u << 30));
+        crc = crc32(crc, data, chunk);
+        data += chunk;
+        n -= chunk;
+    }
+    return static_cast<uint32_t>(crc);
+}
+
+} // namespace
+
+struct ThumbDiskCache::IndexHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t generation; // pack đang dùng: thumbs.<generation>.pack
+    uint32_t count;      // slot live
+    uint32_t dead;       // tombstone
+    uint64_t packBytes;  // cuối phần pack đã commit (record sau đó = ghi dở, bị cắt khi mở)
+    uint64_t liveBytes;
+    uint64_t clock;      // bộ đếm LRU, tăng mỗi lần get / put
+};
+static_assert(sizeof(ThumbDiskCache::IndexHeader) == 48, "IndexHeader layout");
+
+struct ThumbDiskCache::IndexSlot {
+    uint64_t source;
+    uint64_t lut;
+    int32_t width, height;
+    uint32_t engine;
+    uint32_t state;
+    uint64_t offset;     // vị trí RecordHeader trong pack
+    uint32_t bytes;      // header + payload
+    uint32_t reserved;
+    uint64_t lastUsed;
+};
+static_assert(sizeof(ThumbDiskCache::IndexSlot) == 56, "IndexSlot layout");
+
+struct ThumbDiskCache::PackFile {
+    int fd = -1;
+    explicit PackFile(int f) : fd(f) {}
+    ~PackFile() {
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+namespace {
+
+constexpr size_t kIndexBytes = sizeof(ThumbDiskCache::IndexHeader) +
+                               sizeof(ThumbDiskCache::IndexSlot) * ThumbDiskCache::kIndexSlots;
+
+inline uint32_t slotHome(const ThumbKey &k) {
+    uint64_t h = combineHash(k.source, k.lut);
+    h = combineHash(h, static_cast<uint64_t>(static_cast<uint32_t>(k.width)) << 32 | static_cast<uint32_t>(k.height));
+    h = combineHash(h, k.engine);
+    return static_cast<uint32_t>(h) & (ThumbDiskCache::kIndexSlots - 1u);
+}
+
+inline bool slotMatches(const ThumbDiskCache::IndexSlot &s, const ThumbKey &k) {
+    return s.state == kSlotLive && s.source == k.source && s.lut == k.lut && s.width == k.width &&
+           s.height == k.height && s.engine == k.engine;
+}
+
+inline ThumbKey slotKey(const ThumbDiskCache::IndexSlot &s) {
+    ThumbKey k;
+    k.source = s.source;
+    k.lut = s.lut;
+    k.width = s.width;
+    k.height = s.height;
+    k.engine = s.engine;
+    return k;
+}
+
+// Slot trống / tombstone đầu tiên trên chuỗi dò của key (bảng không bao giờ đầy: count + dead < kMaxEntries)
+ThumbDiskCache::IndexSlot *freeSlot(ThumbDiskCache::IndexSlot *slots, const ThumbKey &k) {
+    for (uint32_t i = slotHome(k), n = 0; n < ThumbDiskCache::kIndexSlots;
+         i = (i + 1u) & (ThumbDiskCache::kIndexSlots - 1u), ++n) {
+        if (slots[i].state != kSlotLive) return &slots[i];
+    }
+    return nullptr;
+}
+
+} // namespace
+
+// =============================================================
+// 💾 ThumbDiskCache
+// =============================================================
+ThumbDiskCache::~ThumbDiskCache() { close(); }
+
+bool ThumbDiskCache::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return header_ != nullptr;
+}
+
+bool ThumbDiskCache::writeIndexLocked(const std::string &path, uint32_t generation, uint64_t packBytes,
+                                      const IndexSlot *slots, std::string *err) {
+    IndexHeader h{};
+    h.magic = kIndexMagic;
+    h.version = kIndexVersion;
+    h.slots = kIndexSlots;
+    h.generation = generation;
+    h.packBytes = packBytes;
+    std::vector<IndexSlot> empty;
+    if (!slots) {
+        empty.assign(kIndexSlots, IndexSlot{});
+        slots = empty.data();
+    }
+    for (uint32_t i = 0; i < kIndexSlots; ++i) {
+        if (slots[i].state == kSlotLive) {
+            ++h.count;
+            h.liveBytes += slots[i].bytes;
+            h.clock = std::max(h.clock, slots[i].lastUsed);
+        } else if (slots[i].state == kSlotDead) {
+            ++h.dead;
+        }
+    }
+
+    // File tạm + rename: index luôn là bản cũ hoặc bản mới trọn vẹn
+    const std::string tmp = path + ".tmp";
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) return setErr(err, "create index");
+    const bool ok = pwriteAll(fd, &h, sizeof(h), 0) &&
+                    pwriteAll(fd, slots, sizeof(IndexSlot) * kIndexSlots, sizeof(h)) && ::fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(tmp.c_str(), path.c_str()) != 0) {
+        setErr(err, "write index");
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ThumbDiskCache::mapIndexLocked(std::string *err) {
+    const std::string path = indexPath(dir_);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd >= 0) {
+            struct stat st{};
+            IndexHeader h{};
+            const bool valid = ::fstat(fd, &st) == 0 && static_cast<uint64_t>(st.st_size) == kIndexBytes &&
+                               preadAll(fd, &h, sizeof(h), 0) && h.magic == kIndexMagic &&
+                               h.version == kIndexVersion && h.slots == kIndexSlots;
+            if (valid) {
+                void *map = ::mmap(nullptr, kIndexBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (map == MAP_FAILED) {
+                    ::close(fd);
+                    return setErr(err, "mmap index");
+                }
+                indexFd_ = fd;
+                header_ = static_cast<IndexHeader *>(map);
+                slots_ = reinterpret_cast<IndexSlot *>(static_cast<uint8_t *>(map) + sizeof(IndexHeader));
+                return true;
+            }
+            ::close(fd);
+        }
+        // Chưa có / sai định dạng / khác version -> index rỗng thế hệ 0 (pack cũ bị cắt về 0 khi mở)
+        if (attempt == 0 && !writeIndexLocked(path, 0, 0, nullptr, err)) return false;
+    }
+    if (err) *err = "index unusable";
+    return false;
+}
+
+void ThumbDiskCache::unmapLocked() {
+    if (header_) ::munmap(header_, kIndexBytes);
+    if (indexFd_ >= 0) ::close(indexFd_);
+    header_ = nullptr;
+    slots_ = nullptr;
+    indexFd_ = -1;
+}
+
+bool ThumbDiskCache::open(const std::string &dir, uint64_t capBytes, std::string *err) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (header_ && dir == dir_) {
+            cap_ = capBytes;
+            return true;
+        }
+    }
+    close();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (::mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) return setErr(err, "mkdir");
+    dir_ = dir;
+    cap_ = capBytes;
+    if (!mapIndexLocked(err)) return false;
+
+    const uint32_t generation = header_->generation;
+    const std::string path = packPath(dir_, generation);
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    struct stat st{};
+    if (fd < 0 || ::fstat(fd, &st) != 0) {
+        if (fd >= 0) ::close(fd);
+        unmapLocked();
+        return setErr(err, "open pack");
+    }
+    const auto fileBytes = static_cast<uint64_t>(st.st_size);
+    if (fileBytes > header_->packBytes) {
+        // Record ghi xong nhưng chưa kịp vào index (process bị kill) -> bỏ
+        if (::ftruncate(fd, static_cast<off_t>(header_->packBytes)) != 0) {
+            ::close(fd);
+            unmapLocked();
+            return setErr(err, "truncate pack");
+        }
+    } else if (fileBytes < header_->packBytes) {
+        // Index đi trước dữ liệu (mất điện trước khi pack xuống đĩa) -> entry trỏ ra ngoài file thành tombstone
+        for (uint32_t i = 0; i < kIndexSlots; ++i) {
+            IndexSlot &s = slots_[i];
+            if (s.state == kSlotLive && s.offset + s.bytes > fileBytes) {
+                s.state = kSlotDead;
+                --header_->count;
+                ++header_->dead;
+                header_->liveBytes -= s.bytes;
+            }
+        }
+        header_->packBytes = fileBytes;
+    }
+    pack_ = std::make_shared<PackFile>(fd);
+
+    // Pack thế hệ cũ còn sót (compaction bị ngắt giữa chừng)
+    if (DIR *d = ::opendir(dir_.c_str())) {
+        const std::string keep = "thumbs." + std::to_string(generation) + ".pack";
+        while (const dirent *e = ::readdir(d)) {
+            const std::string name = e->d_name;
+            if (name.size() > 12 && name.compare(0, 7, "thumbs.") == 0 &&
+                name.compare(name.size() - 5, 5, ".pack") == 0 && name != keep) {
+                ::unlink((dir_ + "/" + name).c_str());
+            }
+        }
+        ::closedir(d);
+    }
+    return true;
+}
+
+void ThumbDiskCache::close() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stop_ = true;
+    }
+    queueCv_.notify_all();
+    if (writer_.joinable()) writer_.join();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stop_ = false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    unmapLocked();
+    pack_.reset();
+}
+
+ThumbDiskCache::IndexSlot *ThumbDiskCache::findLocked(const ThumbKey &key) const {
+    for (uint32_t i = slotHome(key), n = 0; n < kIndexSlots; i = (i + 1u) & (kIndexSlots - 1u), ++n) {
+        IndexSlot &s = slots_[i];
+        if (s.state == kSlotEmpty) return nullptr;
+        if (slotMatches(s, key)) return &s;
+    }
+    return nullptr;
+}
+
+bool ThumbDiskCache::compactLocked(uint64_t keepBytes) {
+    std::vector<IndexSlot> live;
+    live.reserve(header_->count);
+    for (uint32_t i = 0; i < kIndexSlots; ++i) {
+        if (slots_[i].state == kSlotLive) live.push_back(slots_[i]);
+    }
+    std::sort(live.begin(), live.end(),
+              [](const IndexSlot &x, const IndexSlot &y) { return x.lastUsed > y.lastUsed; });
+
+    const uint32_t generation = header_->generation + 1u;
+    const std::string newPath = packPath(dir_, generation);
+    const int fd = ::open(newPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) return false;
+
+    // Chép theo LRU: dừng ở entry đầu tiên không còn vừa (giữ đúng thứ tự "mới dùng nhất")
+    std::vector<IndexSlot> table(kIndexSlots, IndexSlot{});
+    std::vector<uint8_t> buf;
+    uint64_t out = 0;
+    uint32_t kept = 0;
+    for (const IndexSlot &s : live) {
+        if (out + s.bytes > keepBytes || kept >= kMaxEntries / 4 * 3) break;
+        buf.resize(s.bytes);
+        if (!preadAll(pack_->fd, buf.data(), s.bytes, s.offset)) continue;
+        if (!pwriteAll(fd, buf.data(), s.bytes, out)) {
+            ::close(fd);
+            ::unlink(newPath.c_str());
+            return false;
+        }
+        IndexSlot *dst = freeSlot(table.data(), slotKey(s));
+        *dst = s;
+        dst->offset = out;
+        out += s.bytes;
+        ++kept;
+    }
+
+    const uint64_t clock = header_->clock;
+    const uint32_t oldGeneration = header_->generation;
+    if (::fsync(fd) != 0 || !writeIndexLocked(indexPath(dir_), generation, out, table.data(), nullptr)) {
+        ::close(fd);
+        ::unlink(newPath.c_str());
+        return false;
+    }
+    // Index mới đã thay chỗ (rename) -> map lại, pack cũ không còn ai trỏ tới
+    unmapLocked();
+    pack_ = std::make_shared<PackFile>(fd);
+    ::unlink(packPath(dir_, oldGeneration).c_str());
+    if (!mapIndexLocked(nullptr)) return false;
+    header_->clock = std::max(header_->clock, clock);
+    return true;
+}
+
+bool ThumbDiskCache::appendLocked(const ThumbKey &key, const uint8_t *payload, uint32_t payloadBytes,
+                                  uint32_t codec) {
+    const uint64_t recordBytes = sizeof(RecordHeader) + payloadBytes;
+    if (recordBytes > cap_ || recordBytes > UINT32_MAX) return false;
+    if (header_->packBytes + recordBytes > cap_ || header_->count + header_->dead + 1u >= kMaxEntries) {
+        const uint64_t keep = std::min(cap_ / 100u * kCompactKeepPercent, cap_ - recordBytes);
+        if (!compactLocked(keep)) return false;
+    }
+
+    RecordHeader rh{};
+    rh.magic = kRecordMagic;
+    rh.codec = codec;
+    rh.source = key.source;
+    rh.lut = key.lut;
+    rh.width = key.width;
+    rh.height = key.height;
+    rh.engine = key.engine;
+    rh.payloadBytes = payloadBytes;
+    rh.crc = crcOf(payload, payloadBytes);
+    const uint64_t offset = header_->packBytes;
+    if (!pwriteAll(pack_->fd, &rh, sizeof(rh), offset) ||
+        !pwriteAll(pack_->fd, payload, payloadBytes, offset + sizeof(rh))) {
+        return false;
+    }
+
+    // Ghi xong dữ liệu rồi mới publish vào index
+    if (IndexSlot *old = findLocked(key)) {
+        old->state = kSlotDead;
+        --header_->count;
+        ++header_->dead;
+        header_->liveBytes -= old->bytes;
+    }
+    IndexSlot *s = freeSlot(slots_, key);
+    if (!s) return false;
+    if (s->state == kSlotDead) --header_->dead;
+    s->source = key.source;
+    s->lut = key.lut;
+    s->width = key.width;
+    s->height = key.height;
+    s->engine = key.engine;
+    s->offset = offset;
+    s->bytes = static_cast<uint32_t>(recordBytes);
+    s->lastUsed = ++header_->clock;
+    s->state = kSlotLive;
+    ++header_->count;
+    header_->liveBytes += recordBytes;
+    header_->packBytes = offset + recordBytes;
+    return true;
+}
+
+bool ThumbDiskCache::get(const ThumbKey &key, uint8_t *pixels, size_t stride) {
+    const size_t rowBytes = static_cast<size_t>(key.width) * 4u;
+    const size_t size = rowBytes * static_cast<size_t>(key.height);
+    if (size == 0 || !pixels) return false;
+
+    // Vừa put, chưa kịp xuống đĩa
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        for (auto it = queue_.rbegin(); it != queue_.rend(); ++it) {
+            if (!(it->key == key)) continue;
+            for (int32_t y = 0; y < key.height; ++y) {
+                std::memcpy(pixels + static_cast<size_t>(y) * stride,
+                            it->pixels.as<uint8_t>() + static_cast<size_t>(y) * rowBytes, rowBytes);
+            }
+            return true;
+        }
+    }
+
+    std::shared_ptr<PackFile> pack;
+    uint64_t offset = 0;
+    uint32_t bytes = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!header_) return false;
+        IndexSlot *s = findLocked(key);
+        if (!s) return false;
+        s->lastUsed = ++header_->clock;
+        offset = s->offset;
+        bytes = s->bytes;
+        pack = pack_;
+    }
+
+    // Đọc + giải nén ngoài lock (pack cũ vẫn mở nhờ shared_ptr nếu compaction chen vào)
+    const ScratchArena::Lease buf = scratchArena().borrow(bytes);
+    bool ok = buf && bytes > sizeof(RecordHeader) && preadAll(pack->fd, buf.data(), bytes, offset);
+    RecordHeader rh{};
+    if (ok) {
+        std::memcpy(&rh, buf.data(), sizeof(rh));
+        const uint8_t *payload = buf.as<uint8_t>() + sizeof(rh);
+        ok = rh.magic == kRecordMagic && rh.source == key.source && rh.lut == key.lut && rh.width == key.width &&
+             rh.height == key.height && rh.engine == key.engine &&
+             rh.payloadBytes == bytes - sizeof(RecordHeader) && rh.crc == crcOf(payload, rh.payloadBytes);
+        if (ok && rh.codec == kCodecRaw) {
+            ok = rh.payloadBytes == size;
+            for (int32_t y = 0; ok && y < key.height; ++y) {
+                std::memcpy(pixels + static_cast<size_t>(y) * stride, payload + static_cast<size_t>(y) * rowBytes,
+                            rowBytes);
+            }
+        } else if (ok && rh.codec == kCodecDelta && stride == rowBytes) {
+            ok = decompressPixels(payload, rh.payloadBytes, pixels, size);
+        } else if (ok && rh.codec == kCodecDelta) {
+            const ScratchArena::Lease tmp = scratchArena().borrow(size);
+            ok = tmp && decompressPixels(payload, rh.payloadBytes, tmp.as<uint8_t>(), size);
+            for (int32_t y = 0; ok && y < key.height; ++y) {
+                std::memcpy(pixels + static_cast<size_t>(y) * stride,
+                            tmp.as<uint8_t>() + static_cast<size_t>(y) * rowBytes, rowBytes);
+            }
+        } else {
+            ok = false;
+        }
+    }
+    if (!ok) {
+        // Record hỏng -> tombstone để lần sau render lại và ghi đè
+        std::lock_guard<std::mutex> lock(mutex_);
+        IndexSlot *s = header_ ? findLocked(key) : nullptr;
+        if (s && s->offset == offset && pack == pack_) {
+            s->state = kSlotDead;
+            --header_->count;
+            ++header_->dead;
+            header_->liveBytes -= s->bytes;
+        }
+    }
+    return ok;
+}
+
+bool ThumbDiskCache::put(const ThumbKey &key, const uint8_t *pixels, size_t stride) {
+    const size_t rowBytes = static_cast<size_t>(key.width) * 4u;
+    const size_t size = rowBytes * static_cast<size_t>(key.height);
+    if (size == 0 || !pixels || !isOpen()) return false;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (queueBytes_ + size > kMaxPendingBytes) return false;
+    }
+
+    ScratchArena::Lease copy = scratchArena().borrow(size);
+    if (!copy) return false;
+    for (int32_t y = 0; y < key.height; ++y) {
+        std::memcpy(copy.as<uint8_t>() + static_cast<size_t>(y) * rowBytes,
+                    pixels + static_cast<size_t>(y) * stride, rowBytes);
+    }
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        queueBytes_ += copy.bytes();
+        queue_.push_back(Pending{key, std::move(copy)});
+        if (!writer_.joinable()) writer_ = std::thread(&ThumbDiskCache::writerLoop, this);
+    }
+    queueCv_.notify_one();
+    return true;
+}
+
+void ThumbDiskCache::writeOne(Pending &job) {
+    const size_t size = static_cast<size_t>(job.key.width) * 4u * static_cast<size_t>(job.key.height);
+    // Nén trước khi lấy lock index: get() song song không phải chờ
+    const ScratchArena::Lease packed = scratchArena().borrow(size + 17u);
+    size_t packedSize = 0;
+    const bool delta = packed && compressPixels(job.pixels.as<uint8_t>(), size, packed.as<uint8_t>(), packedSize);
+    const uint8_t *payload = delta ? packed.as<uint8_t>() : job.pixels.as<uint8_t>();
+    const size_t payloadBytes = delta ? packedSize : size;
+    if (payloadBytes > UINT32_MAX) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!header_ || findLocked(job.key)) return; // đã có (2 luồng cùng render 1 thumbnail)
+    appendLocked(job.key, payload, static_cast<uint32_t>(payloadBytes), delta ? kCodecDelta : kCodecRaw);
+}
+
+void ThumbDiskCache::writerLoop() {
+    for (;;) {
+        Pending *job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueCv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) return; // stop_ và đã ghi hết
+            job = &queue_.front();      // chỉ writer pop; push_back không làm mất tham chiếu phần tử deque
+        }
+        writeOne(*job);
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            queueBytes_ -= job->pixels.bytes();
+            queue_.pop_front();
+            if (queue_.empty()) idleCv_.notify_all();
+        }
+    }
+}
+
+void ThumbDiskCache::flush() {
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    idleCv_.wait(lock, [this] { return queue_.empty(); });
+}
+
+void ThumbDiskCache::clear() {
+    flush();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (header_) compactLocked(0);
+}
+
+uint64_t ThumbDiskCache::diskBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return header_ ? header_->packBytes : 0;
+}
+
+uint32_t ThumbDiskCache::entryCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return header_ ? header_->count : 0;
+}
+
+ThumbDiskCache &thumbDiskCache() {
+    static ThumbDiskCache cache;
+    return cache;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "adjust_arena.h"
+
+// =============================================================
+// 💾 ThumbDiskCache — cache thumbnail filter/LUT trên đĩa, sống qua các lần mở app
+// Key = (hash nội dung ảnh nguồn, id LUT, kích thước thumbnail, engine version).
+// Thư mục cache gồm:
+//   thumbs.idx       : bảng băm open addressing kích thước cố định, mmap MAP_SHARED -> tra cứu / cập nhật
+//                      LRU không tốn syscall, vẫn còn nguyên khi process bị kill.
+//   thumbs.<gen>.pack: blob nối đuôi (append-only): header record + pixel nén lossless (compressPixels),
+//                      checksum crc32 -> record dở dang / hỏng chỉ thành miss.
+// Pack vượt cap -> compaction: chép các entry dùng gần nhất (tới 75% cap) sang pack
+// thế hệ mới, ghi index mới rồi rename đè (atomic), xoá pack cũ.
+// put() chỉ copy pixel vào hàng đợi rồi trả về; nén + ghi đĩa chạy trên 1 luồng writer riêng
+// (không chiếm worker render). get() thấy luôn cả entry còn trong hàng đợi.
+// =============================================================
+
+struct ThumbKey {
+    uint64_t source = 0; // hashPixels của ảnh nguồn
+    uint64_t lut = 0;    // hashString của id LUT (đường dẫn + phiên bản file, do Kotlin ghép)
+    int32_t width = 0, height = 0;
+    uint32_t engine = 0; // ThumbDiskCache::kEngineVersion lúc render
+
+    bool operator==(const ThumbKey &o) const {
+        return source == o.source && lut == o.lut && width == o.width && height == o.height && engine == o.engine;
+    }
+};
+
+class ThumbDiskCache {
+public:
+    // Tăng khi output render của engine thay đổi (kernel, LUT sampling...) -> mọi thumbnail cũ thành miss
+    static constexpr uint32_t kEngineVersion = 1;
+    static constexpr uint64_t kDefaultCapBytes = 48ull * 1024ull * 1024ull;
+    static constexpr uint32_t kIndexSlots = 4096;         // lũy thừa 2
+    static constexpr uint32_t kMaxEntries = kIndexSlots / 4 * 3;
+    static constexpr size_t kMaxPendingBytes = 16u * 1024u * 1024u; // vượt -> put mới bị bỏ (cache best-effort)
+
+    ThumbDiskCache() = default;
+    ~ThumbDiskCache();
+    ThumbDiskCache(const ThumbDiskCache &) = delete;
+    ThumbDiskCache &operator=(const ThumbDiskCache &) = delete;
+
+    // Mở (hoặc tạo) cache trong `dir`; index sai định dạng / version -> làm lại từ đầu.
+    // Gọi lại với cùng dir chỉ đổi cap.
+    bool open(const std::string &dir, uint64_t capBytes, std::string *err);
+    // Chờ writer ghi hết hàng đợi rồi unmap / đóng file
+    void close();
+    bool isOpen() const;
+
+    // Hit: giải nén vào `pixels` (width*4 byte mỗi hàng, stride tuỳ ý) và đưa entry lên đầu LRU
+    bool get(const ThumbKey &key, uint8_t *pixels, size_t stride);
+    // Copy pixel vào hàng đợi ghi, không chờ I/O. false nếu cache chưa mở / hàng đợi đầy.
+    bool put(const ThumbKey &key, const uint8_t *pixels, size_t stride);
+    // Chờ tới khi hàng đợi ghi trống
+    void flush();
+    void clear();
+
+    uint64_t diskBytes() const; // kích thước pack hiện tại
+    uint32_t entryCount() const;
+
+    // Layout file (adjust_thumbcache.cpp)
+    struct IndexHeader;
+    struct IndexSlot;
+
+private:
+    struct PackFile;
+    struct Pending {
+        ThumbKey key;
+        ScratchArena::Lease pixels; // raw, width*4 byte mỗi hàng
+    };
+
+    IndexSlot *findLocked(const ThumbKey &key) const;
+    bool appendLocked(const ThumbKey &key, const uint8_t *payload, uint32_t payloadBytes, uint32_t codec);
+    bool compactLocked(uint64_t keepBytes);
+    bool writeIndexLocked(const std::string &path, uint32_t generation, uint64_t packBytes,
+                          const IndexSlot *slots, std::string *err);
+    bool mapIndexLocked(std::string *err);
+    void unmapLocked();
+    void writerLoop();
+    void writeOne(Pending &job);
+
+    mutable std::mutex mutex_;           // index + pack
+    std::string dir_;
+    uint64_t cap_ = kDefaultCapBytes;
+    int indexFd_ = -1;
+    IndexHeader *header_ = nullptr;      // mmap của thumbs.idx
+    IndexSlot *slots_ = nullptr;
+    std::shared_ptr<PackFile> pack_;     // get() giữ ref khi đọc ngoài lock, compaction thay pack khác
+
+    mutable std::mutex queueMutex_;
+    std::condition_variable queueCv_;
+    std::condition_variable idleCv_;
+    std::deque<Pending> queue_;
+    size_t queueBytes_ = 0;
+    bool stop_ = false;
+    std::thread writer_;
+};
+
+ThumbDiskCache &thumbDiskCache();
+
+// Hash 64-bit nội dung pixel (width*4 byte mỗi hàng) của hàng [y0, y1); kết hợp các dải bằng combineHash
+// theo thứ tự để kết quả không phụ thuộc cách chia task.
+uint64_t hashPixels(const uint8_t *pixels, size_t stride, int32_t width, int32_t y0, int32_t y1);
+uint64_t combineHash(uint64_t seed, uint64_t value);
+uint64_t hashString(const char *s, size_t n);
@@ -0,0 +1,285 @@
+#include "adjust_yuv.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ADJUST_YUV_NEON 1
+#endif
+
+static constexpr int32_t kHalf = 1 << (YuvMatrix::kShift - 1);
+
+static inline int32_t toQ16(double v) {
+    return static_cast<int32_t>(std::lround(v * static_cast<double>(1 << YuvMatrix::kShift)));
+}
+
+static inline uint32_t clamp8(int32_t v) {
+    return static_cast<uint32_t>(std::clamp(v, 0, 255));
+}
+
+YuvMatrix yuvMatrix(YuvColorSpace cs) {
+    const bool bt709 = (cs == YUV_BT709_LIMITED);
+    const bool full = (cs == YUV_BT601_FULL);
+    const double kr = bt709 ? 0.2126 : 0.299;
+    const double kb = bt709 ? 0.0722 : 0.114;
+    const double kg = 1.0 - kr - kb;
+    // limited: Y 16..235, U/V 16..240
+    const double yRange = full ? 1.0 : 219.0 / 255.0;
+    const double cRange = full ? 1.0 : 224.0 / 255.0;
+
+    YuvMatrix m;
+    m.yOff = full ? 0 : 16;
+    m.ys = toQ16(1.0 / yRange);
+    m.rV = toQ16(2.0 * (1.0 - kr) / cRange);
+    m.bU = toQ16(2.0 * (1.0 - kb) / cRange);
+    m.gU = toQ16(2.0 * kb * (1.0 - kb) / kg / cRange);
+    m.gV = toQ16(2.0 * kr * (1.0 - kr) / kg / cRange);
+
+    m.yR = toQ16(kr * yRange);
+    m.yG = toQ16(kg * yRange);
+    m.yB = toQ16(kb * yRange);
+    // U = (B - Y) / (2(1 - Kb)), V = (R - Y) / (2(1 - Kr))
+    const double su = cRange / (2.0 * (1.0 - kb));
+    const double sv = cRange / (2.0 * (1.0 - kr));
+    m.uR = toQ16(-kr * su);
+    m.uG = toQ16(-kg * su);
+    m.uB = toQ16((1.0 - kb) * su);
+    m.vR = toQ16((1.0 - kr) * sv);
+    m.vG = toQ16(-kg * sv);
+    m.vB = toQ16(-kb * sv);
+    return m;
+}
+
+bool yuvPlanesValid(const YuvPlanes &f) {
+    if (!f.y || !f.u || !f.v || f.width <= 0 || f.height <= 0) return false;
+    if (f.uvPixelStride != 1 && f.uvPixelStride != 2) return false;
+    const int32_t chromaW = (f.width + 1) / 2;
+    return f.yStride >= f.width && f.uvStride >= (chromaW - 1) * f.uvPixelStride + 1;
+}
+
+static inline uint32_t packRgba(int32_t luma, int32_t cr, int32_t cg, int32_t cb) {
+    const uint32_t r = clamp8((luma + cr + kHalf) >> YuvMatrix::kShift);
+    const uint32_t g = clamp8((luma - cg + kHalf) >> YuvMatrix::kShift);
+    const uint32_t b = clamp8((luma + cb + kHalf) >> YuvMatrix::kShift);
+    return 0xFF000000u | (b << 16) | (g << 8) | r;
+}
+
+#ifdef ADJUST_YUV_NEON
+static inline int32x4_t widenLo(int16x8_t v) { return vmovl_s16(vget_low_s16(v)); }
+static inline int32x4_t widenHi(int16x8_t v) { return vmovl_s16(vget_high_s16(v)); }
+
+// (a + half) >> kShift, bão hoà 0..255 cho 8 giá trị
+static inline uint8x8_t narrowQ16(int32x4_t lo, int32x4_t hi) {
+    const int32x4_t half = vdupq_n_s32(kHalf);
+    const uint16x4_t l = vqmovun_s32(vshrq_n_s32(vaddq_s32(lo, half), YuvMatrix::kShift));
+    const uint16x4_t h = vqmovun_s32(vshrq_n_s32(vaddq_s32(hi, half), YuvMatrix::kShift));
+    return vqmovn_u16(vcombine_u16(l, h));
+}
+
+// 16 pixel / lần (8 mẫu chroma, mỗi mẫu nhân đôi cho 2 pixel); trả về x đầu tiên chưa xử lý.
+// Chừa >= 2 pixel cuối hàng: vld2 với NV21 đọc tới byte ngay sau mẫu chroma cuối.
+static int32_t yuvToRgbaNeon(const uint8_t *yRow, const uint8_t *uRow, const uint8_t *vRow, int32_t ps,
+                             const YuvMatrix &m, int32_t width, uint32_t *out) {
+    const int16x8_t k128 = vdupq_n_s16(128);
+    const int16x8_t yOff = vdupq_n_s16(static_cast<int16_t>(m.yOff));
+    int32_t x = 0;
+    for (; x + 18 <= width; x += 16) {
+        const int32_t c = (x >> 1) * ps;
+        const uint8x8_t u8 = ps == 1 ? vld1_u8(uRow + c) : vld2_u8(uRow + c).val[0];
+        const uint8x8_t v8 = ps == 1 ? vld1_u8(vRow + c) : vld2_u8(vRow + c).val[0];
+        const int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u8)), k128);
+        const int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v8)), k128);
+
+        // chroma cho 8 mẫu (lo = mẫu 0..3, hi = 4..7), zip nhân đôi thành 16 pixel
+        int32x4x2_t cr[2], cg[2], cb[2];
+        const int32x4_t uw[2] = {widenLo(u), widenHi(u)};
+        const int32x4_t vw[2] = {widenLo(v), widenHi(v)};
+        for (int32_t h = 0; h < 2; ++h) {
+            const int32x4_t r = vmulq_n_s32(vw[h], m.rV);
+            const int32x4_t g = vmlaq_n_s32(vmulq_n_s32(uw[h], m.gU), vw[h], m.gV);
+            const int32x4_t b = vmulq_n_s32(uw[h], m.bU);
+            cr[h] = vzipq_s32(r, r);
+            cg[h] = vzipq_s32(g, g);
+            cb[h] = vzipq_s32(b, b);
+        }
+
+        const uint8x16_t y8 = vld1q_u8(yRow + x);
+        const int16x8_t y16[2] = {vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(y8))), yOff),
+                                  vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(y8))), yOff)};
+        uint8x8_t rr[2], gg[2], bb[2];
+        for (int32_t h = 0; h < 2; ++h) {
+            const int32x4_t l0 = vmulq_n_s32(widenLo(y16[h]), m.ys); // pixel 8h + 0..3
+            const int32x4_t l1 = vmulq_n_s32(widenHi(y16[h]), m.ys); // pixel 8h + 4..7
+            rr[h] = narrowQ16(vaddq_s32(l0, cr[h].val[0]), vaddq_s32(l1, cr[h].val[1]));
+            gg[h] = narrowQ16(vsubq_s32(l0, cg[h].val[0]), vsubq_s32(l1, cg[h].val[1]));
+            bb[h] = narrowQ16(vaddq_s32(l0, cb[h].val[0]), vaddq_s32(l1, cb[h].val[1]));
+        }
+        uint8x16x4_t px;
+        px.val[0] = vcombine_u8(rr[0], rr[1]);
+        px.val[1] = vcombine_u8(gg[0], gg[1]);
+        px.val[2] = vcombine_u8(bb[0], bb[1]);
+        px.val[3] = vdupq_n_u8(0xFF);
+        vst4q_u8(reinterpret_cast<uint8_t *>(out + x), px);
+    }
+    return x;
+}
+#endif
+
+void yuvToRgbaRows(const YuvPlanes &f, const YuvMatrix &m, int32_t y0, int32_t y1,
+                   uint8_t *dst, size_t dstStride) {
+    const int32_t W = f.width;
+    const int32_t ps = f.uvPixelStride;
+    for (int32_t y = y0; y < y1; ++y) {
+        const uint8_t *yRow = f.y + static_cast<size_t>(y) * static_cast<size_t>(f.yStride);
+        const size_t uvOff = static_cast<size_t>(y >> 1) * static_cast<size_t>(f.uvStride);
+        const uint8_t *uRow = f.u + uvOff;
+        const uint8_t *vRow = f.v + uvOff;
+        auto *out = reinterpret_cast<uint32_t *>(dst + static_cast<size_t>(y - y0) * dstStride);
+
+        int32_t x = 0;
+#ifdef ADJUST_YUV_NEON
+        x = yuvToRgbaNeon(yRow, uRow, vRow, ps, m, W, out);
+#endif
+        for (int32_t c = (x >> 1) * ps; x < W; x += 2, c += ps) {
+            const int32_t u = static_cast<int32_t>(uRow[c]) - 128;
+            const int32_t v = static_cast<int32_t>(vRow[c]) - 128;
+            const int32_t cr = m.rV * v;
+            const int32_t cg = m.gU * u + m.gV * v;
+            const int32_t cb = m.bU * u;
+            out[x] = packRgba(m.ys * (static_cast<int32_t>(yRow[x]) - m.yOff), cr, cg, cb);
+            if (x + 1 < W) out[x + 1] = packRgba(m.ys * (static_cast<int32_t>(yRow[x + 1]) - m.yOff), cr, cg, cb);
+        }
+    }
+}
+
+static inline uint8_t lumaOf(const YuvMatrix &m, uint32_t c) {
+    const auto r = static_cast<int32_t>(c & 0xFFu);
+    const auto g = static_cast<int32_t>((c >> 8) & 0xFFu);
+    const auto b = static_cast<int32_t>((c >> 16) & 0xFFu);
+    return static_cast<uint8_t>(clamp8(m.yOff + ((m.yR * r + m.yG * g + m.yB * b + kHalf) >> YuvMatrix::kShift)));
+}
+
+static constexpr int32_t kChromaShift = YuvMatrix::kShift + 2; // tổng 4 pixel -> /4
+static constexpr int32_t kChromaHalf = 1 << (kChromaShift - 1);
+
+#ifdef ADJUST_YUV_NEON
+// offset + ((a + half) >> kS), bão hoà 0..255 cho 8 giá trị
+template <int kS>
+static inline uint8x8_t narrowBiased(int32x4_t lo, int32x4_t hi, int32_t offset) {
+    const int32x4_t half = vdupq_n_s32(1 << (kS - 1));
+    const int32x4_t off = vdupq_n_s32(offset);
+    const uint16x4_t l = vqmovun_s32(vaddq_s32(vshrq_n_s32(vaddq_s32(lo, half), kS), off));
+    const uint16x4_t h = vqmovun_s32(vaddq_s32(vshrq_n_s32(vaddq_s32(hi, half), kS), off));
+    return vqmovn_u16(vcombine_u16(l, h));
+}
+
+static inline int32x4_t dot3(int32x4_t r, int32x4_t g, int32x4_t b, int32_t cr, int32_t cg, int32_t cb) {
+    return vmlaq_n_s32(vmlaq_n_s32(vmulq_n_s32(r, cr), g, cg), b, cb);
+}
+
+static inline int32x4_t widenU16Lo(uint16x8_t v) { return vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(v))); }
+static inline int32x4_t widenU16Hi(uint16x8_t v) { return vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(v))); }
+
+static inline uint8x16_t lumaNeon(const uint8x16x4_t &px, const YuvMatrix &m) {
+    uint8x8_t half[2];
+    for (int32_t h = 0; h < 2; ++h) {
+        const uint16x8_t r = vmovl_u8(h ? vget_high_u8(px.val[0]) : vget_low_u8(px.val[0]));
+        const uint16x8_t g = vmovl_u8(h ? vget_high_u8(px.val[1]) : vget_low_u8(px.val[1]));
+        const uint16x8_t b = vmovl_u8(h ? vget_high_u8(px.val[2]) : vget_low_u8(px.val[2]));
+        half[h] = narrowBiased<YuvMatrix::kShift>(
+                dot3(widenU16Lo(r), widenU16Lo(g), widenU16Lo(b), m.yR, m.yG, m.yB),
+                dot3(widenU16Hi(r), widenU16Hi(g), widenU16Hi(b), m.yR, m.yG, m.yB), m.yOff);
+    }
+    return vcombine_u8(half[0], half[1]);
+}
+
+// 16 pixel × 2 hàng / lần; trả về x đầu tiên chưa xử lý (chừa >= 2 pixel cuối hàng như chiều ngược lại)
+static int32_t rgbaToYuvNeon(const uint32_t *s0, const uint32_t *s1, bool pair, uint8_t *yRow0, uint8_t *yRow1,
+                             uint8_t *uRow, uint8_t *vRow, int32_t ps, const YuvMatrix &m, int32_t width) {
+    int32_t x = 0;
+    for (; x + 18 <= width; x += 16) {
+        const uint8x16x4_t p0 = vld4q_u8(reinterpret_cast<const uint8_t *>(s0 + x));
+        const uint8x16x4_t p1 = vld4q_u8(reinterpret_cast<const uint8_t *>(s1 + x));
+        vst1q_u8(yRow0 + x, lumaNeon(p0, m));
+        if (pair) vst1q_u8(yRow1 + x, lumaNeon(p1, m));
+
+        // tổng khối 2×2: cộng cặp pixel kề nhau trên mỗi hàng rồi cộng 2 hàng
+        const uint16x8_t r = vaddq_u16(vpaddlq_u8(p0.val[0]), vpaddlq_u8(p1.val[0]));
+        const uint16x8_t g = vaddq_u16(vpaddlq_u8(p0.val[1]), vpaddlq_u8(p1.val[1]));
+        const uint16x8_t b = vaddq_u16(vpaddlq_u8(p0.val[2]), vpaddlq_u8(p1.val[2]));
+        const int32x4_t rl = widenU16Lo(r), rh = widenU16Hi(r);
+        const int32x4_t gl = widenU16Lo(g), gh = widenU16Hi(g);
+        const int32x4_t bl = widenU16Lo(b), bh = widenU16Hi(b);
+        const uint8x8_t u = narrowBiased<kChromaShift>(dot3(rl, gl, bl, m.uR, m.uG, m.uB),
+                                                       dot3(rh, gh, bh, m.uR, m.uG, m.uB), 128);
+        const uint8x8_t v = narrowBiased<kChromaShift>(dot3(rl, gl, bl, m.vR, m.vG, m.vB),
+                                                       dot3(rh, gh, bh, m.vR, m.vG, m.vB), 128);
+
+        const int32_t c = (x >> 1) * ps;
+        if (ps == 1) {
+            vst1_u8(uRow + c, u);
+            vst1_u8(vRow + c, v);
+        } else if (vRow == uRow + 1) { // NV12
+            uint8x8x2_t uv;
+            uv.val[0] = u;
+            uv.val[1] = v;
+            vst2_u8(uRow + c, uv);
+        } else if (uRow == vRow + 1) { // NV21
+            uint8x8x2_t vu;
+            vu.val[0] = v;
+            vu.val[1] = u;
+            vst2_u8(vRow + c, vu);
+        } else {
+            uint8_t tu[8], tv[8];
+            vst1_u8(tu, u);
+            vst1_u8(tv, v);
+            for (int32_t i = 0; i < 8; ++i) {
+                uRow[c + i * ps] = tu[i];
+                vRow[c + i * ps] = tv[i];
+            }
+        }
+    }
+    return x;
+}
+#endif
+
+void rgbaToYuvRows(const uint8_t *src, size_t srcStride, const YuvMatrix &m, int32_t y0, int32_t y1,
+                   const YuvPlanes &f) {
+    const int32_t W = f.width;
+    const int32_t ps = f.uvPixelStride;
+    for (int32_t y = y0; y < y1; y += 2) {
+        const bool pair = (y + 1 < y1);
+        const auto *s0 = reinterpret_cast<const uint32_t *>(src + static_cast<size_t>(y - y0) * srcStride);
+        const auto *s1 = pair ? reinterpret_cast<const uint32_t *>(src + static_cast<size_t>(y + 1 - y0) * srcStride) : s0;
+        uint8_t *yRow0 = f.y + static_cast<size_t>(y) * static_cast<size_t>(f.yStride);
+        uint8_t *yRow1 = pair ? yRow0 + f.yStride : nullptr;
+        const size_t uvOff = static_cast<size_t>(y >> 1) * static_cast<size_t>(f.uvStride);
+        uint8_t *uRow = f.u + uvOff;
+        uint8_t *vRow = f.v + uvOff;
+
+        int32_t x = 0;
+#ifdef ADJUST_YUV_NEON
+        x = rgbaToYuvNeon(s0, s1, pair, yRow0, yRow1, uRow, vRow, ps, m, W);
+#endif
+        for (int32_t c = (x >> 1) * ps; x < W; x += 2, c += ps) {
+            const int32_t x1 = std::min(x + 1, W - 1);
+            const uint32_t p00 = s0[x], p01 = s0[x1], p10 = s1[x], p11 = s1[x1];
+            yRow0[x] = lumaOf(m, p00);
+            if (x1 != x) yRow0[x1] = lumaOf(m, p01);
+            if (pair) {
+                yRow1[x] = lumaOf(m, p10);
+                if (x1 != x) yRow1[x1] = lumaOf(m, p11);
+            }
+
+            // Cạnh lẻ: pixel lặp lại -> vẫn là trung bình đúng của phần pixel có thật
+            const auto sum = [&](uint32_t shift) {
+                return static_cast<int32_t>(((p00 >> shift) & 0xFFu) + ((p01 >> shift) & 0xFFu)
+                                            + ((p10 >> shift) & 0xFFu) + ((p11 >> shift) & 0xFFu));
+            };
+            const int32_t r = sum(0), g = sum(8), b = sum(16);
+            uRow[c] = static_cast<uint8_t>(clamp8(128 + ((m.uR * r + m.uG * g + m.uB * b + kChromaHalf) >> kChromaShift)));
+            vRow[c] = static_cast<uint8_t>(clamp8(128 + ((m.vR * r + m.vG * g + m.vB * b + kChromaHalf) >> kChromaShift)));
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================
+// 📹 YUV 4:2:0 <-> RGBA_8888 (frame camera / video decode)
+// Một bộ mô tả plane chung cho NV21 / NV12 / I420 (giống android.media.Image YUV_420_888):
+//   I420: u/v là 2 plane riêng, uvPixelStride = 1
+//   NV12: u = plane UV, v = u + 1, uvPixelStride = 2
+//   NV21: v = plane VU, u = v + 1, uvPixelStride = 2
+// Ma trận số nguyên Q16 dựng từ Kr/Kb + dải giá trị (full / limited); chroma tính 1 lần cho mỗi cặp pixel.
+// Pixel RGBA giữ đúng layout bitmap (R = bit 0..7, A = 255), kernel pipeline đọc như ảnh thường.
+// =============================================================
+enum YuvColorSpace : int32_t {
+    YUV_BT601_FULL = 0,    // JFIF: camera Android (NV21 preview, JPEG)
+    YUV_BT601_LIMITED = 1, // video SD
+    YUV_BT709_LIMITED = 2, // video HD (MediaCodec 720p+)
+};
+
+struct YuvPlanes {
+    uint8_t *y = nullptr;
+    uint8_t *u = nullptr;
+    uint8_t *v = nullptr;
+    int32_t yStride = 0;
+    int32_t uvStride = 0;
+    int32_t uvPixelStride = 1;
+    int32_t width = 0;
+    int32_t height = 0;
+};
+
+struct YuvMatrix {
+    static constexpr int32_t kShift = 16;
+
+    // YUV -> RGB: R = ys(Y - yOff) + rV·V', G = ys(Y - yOff) - gU·U' - gV·V', B = ys(Y - yOff) + bU·U' (U' = U - 128)
+    int32_t yOff = 0;
+    int32_t ys = 0;
+    int32_t rV = 0, gU = 0, gV = 0, bU = 0;
+
+    // RGB -> YUV (U/V có dấu, cộng 128 sau)
+    int32_t yR = 0, yG = 0, yB = 0;
+    int32_t uR = 0, uG = 0, uB = 0;
+    int32_t vR = 0, vG = 0, vB = 0;
+};
+
+YuvMatrix yuvMatrix(YuvColorSpace cs);
+
+// Plane hợp lệ cho kích thước width × height (con trỏ khác null, stride đủ dài)
+bool yuvPlanesValid(const YuvPlanes &f);
+
+// Hàng [y0, y1) của frame -> RGBA, hàng y0 nằm ở dst. y0 phải chẵn.
+void yuvToRgbaRows(const YuvPlanes &f, const YuvMatrix &m, int32_t y0, int32_t y1,
+                   uint8_t *dst, size_t dstStride);
+
+// RGBA (hàng y0 nằm ở src) -> hàng [y0, y1) của frame. y0 chẵn, y1 chẵn hoặc = height:
+// mỗi mẫu U/V lấy trung bình khối 2×2 (cạnh lẻ: phần pixel có thật).
+void rgbaToYuvRows(const uint8_t *src, size_t srcStride, const YuvMatrix &m, int32_t y0, int32_t y1,
+                   const YuvPlanes &f);
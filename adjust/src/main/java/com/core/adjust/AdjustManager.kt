@@ -4,7 +4,7 @@ import android.content.ContentUris
 import android.content.ContentValues
 import android.content.Context
 import android.graphics.Bitmap
-import android.graphics.Matrix
+import android.graphics.Rect
 import android.os.Build
 import android.os.Environment
 import android.provider.MediaStore
@@ -13,10 +13,11 @@ import androidx.lifecycle.LifecycleCoroutineScope
 import com.core.adjust.model.lut.LutFilter
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.Job
+import kotlinx.coroutines.delay
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
+import java.util.concurrent.atomic.AtomicLong
 import kotlin.math.max
-import kotlin.math.min
 
 /**
  * AdjustManager chịu trách nhiệm quản lý ảnh gốc, ảnh preview và thông số chỉnh ảnh.
@@ -28,19 +29,45 @@ class AdjustManager(
 ) {
 
     private var originalBitmap: Bitmap? = null
+    private var sourceId: Long = 0L
+    @Volatile
+    private var sourceHash: Long = 0L // hash nội dung ảnh gốc cho ThumbnailCache, tính khi cần
     private var previewBitmap: Bitmap? = null
+    private var proxyBitmap: Bitmap? = null
     private var applyJob: Job? = null
+    private var refineJob: Job? = null
+
+    /** Budget thời gian cho mỗi frame preview, xem [PreviewQualityController]. */
+    val previewQuality = PreviewQualityController()
 
+    // isProcessing / pendingRender chỉ đọc-ghi trên main thread (applyAdjust được gọi từ UI)
     @Volatile
     private var isProcessing = false
+    // Lần applyAdjust đến khi đang bận: chỉ giữ callback mới nhất, render bù 1 lần khi job hiện tại xong
+    private var pendingRender: PendingRender? = null
+    // Tăng mỗi lần applyAdjust: refine full-res của params cũ không được publish đè lên preview mới
+    private val generation = AtomicLong(0L)
+
+    private class PendingRender(val onStats: ((RenderStats) -> Unit)?, val onUpdated: (Bitmap) -> Unit)
 
     val params = AdjustParams()
 
+    init {
+        // Budget bộ nhớ native theo RAM máy + onTrimMemory (chỉ đăng ký 1 lần cho cả process)
+        NativeMemory.install(context)
+    }
+
     /**
      * Khởi tạo ảnh gốc và ảnh preview ban đầu.
      */
     fun setOriginalBitmap(bitmap: Bitmap) {
         originalBitmap = bitmap
+        // Ảnh mới -> các state đã cache của ảnh cũ không còn dùng được
+        sourceId = nextSourceId.incrementAndGet()
+        sourceHash = 0L
+        AdjustProcessor.clearRenderCache()
+        proxyBitmap?.recycle()
+        proxyBitmap = null
         previewBitmap = bitmap.copy(Bitmap.Config.ARGB_8888, true)
     }
 
@@ -49,81 +76,184 @@ class AdjustManager(
     /**
      * Gọi hàm apply adjust non-destructive.
      * Mỗi lần người dùng kéo slider, chỉ render lại bản mới từ ảnh gốc.
+     * Độ phân giải preview do [previewQuality] chọn theo thời gian render đo được; nếu phải render nhỏ hơn
+     * ảnh gốc thì sau [PreviewQualityController.idleRefineDelayMs] không có thay đổi mới sẽ tự render lại full-res.
+     * Gọi trên main thread. Đến khi đang render: không bị bỏ, job hiện tại xong sẽ render bù 1 lần với params mới nhất.
      */
-    fun applyAdjust(onUpdated: (Bitmap) -> Unit) {
+    fun applyAdjust(onStats: ((RenderStats) -> Unit)? = null, onUpdated: (Bitmap) -> Unit) {
         val base = originalBitmap ?: return
-        if (isProcessing) return
+        generation.incrementAndGet()
+        // Refine đang chờ / đang chạy là của params cũ: huỷ trước khi xét bận (native không dừng giữa chừng,
+        // nhưng kết quả của nó sẽ bị bỏ nhờ generation)
+        refineJob?.cancel()
+        if (isProcessing) {
+            pendingRender = PendingRender(onStats, onUpdated)
+            return
+        }
         isProcessing = true
 
         // Nếu đang chạy 1 job cũ thì hủy để không render thừa
         applyJob?.cancel()
 
-        applyJob = lifecycleScope.launch(Dispatchers.Default) {
-            val work = base.copy(Bitmap.Config.ARGB_8888, true)
+        val scale = previewQuality.chooseScale(AdjustParams.buildMask(params), base.width, base.height)
 
+        applyJob = lifecycleScope.launch(Dispatchers.Default) {
             try {
-                Log.d("TAG5", "AdjustManager_applyAdjust: ")
-                val changed = AdjustProcessor.applyAdjust(context, work, params, progress = object : AdjustProgress {
-                    override fun onProgress(percent: Int) {
-                        Log.d("TAG5", "AdjustManager_onProgress: percent = $percent")
-                    }
-                })
-
-                if (changed) {
-                    withContext(Dispatchers.Main) {
-                        previewBitmap?.recycle()
-                        previewBitmap = work
-                        //
-                        Log.d("TAG5", "AdjustManager_applyAdjust: areBitmapsDifferent = " + areBitmapsDifferent(base, work))
-                        //
-                        onUpdated(work)
-                    }
+                if (scale < 1f) {
+                    renderScaledPreview(base, scale, onStats, onUpdated)
+                    scheduleRefine(onStats, onUpdated)
                 } else {
-                    work.recycle() // bỏ nếu không thay đổi
+                    renderFullPreview(base, onStats, onUpdated)
                 }
             } catch (e: Exception) {
                 e.printStackTrace()
             } finally {
-                isProcessing = false
+                finishRender()
             }
         }
     }
 
-    fun areBitmapsDifferent(b1: Bitmap?, b2: Bitmap?): Boolean {
-        if (b1 == null || b2 == null) return true
-        if (b1.width != b2.width || b1.height != b2.height) return true
+    /** Hết bận (trên main thread); có applyAdjust đến trong lúc render -> render bù với params hiện tại. */
+    private fun finishRender() {
+        lifecycleScope.launch(Dispatchers.Main) {
+            isProcessing = false
+            pendingRender?.let {
+                pendingRender = null
+                applyAdjust(it.onStats, it.onUpdated)
+            }
+        }
+    }
 
-        val same = b1.sameAs(b2)
-        return !same
+    /**
+     * @param gen khác [ANY_GENERATION]: chỉ publish nếu chưa có applyAdjust mới kể từ lúc bắt đầu (refine).
+     */
+    private suspend fun renderFullPreview(
+        base: Bitmap, onStats: ((RenderStats) -> Unit)?, onUpdated: (Bitmap) -> Unit, gen: Long = ANY_GENERATION
+    ) {
+        val stats = if (onStats != null) RenderStats() else null
+        val progress = object : AdjustProgress {
+            override fun onProgress(percent: Int) {
+                Log.d("TAG5", "AdjustManager_onProgress: percent = $percent")
+            }
+        }
+
+        // Có crop / xoay / lật / straighten: applyAdjust (tại chỗ) bỏ qua geometry -> render vùng ra khung crop
+        if (ImageGeometry.isActive(params)) {
+            val out = AdjustProcessor.applyAdjustGeometry(context, base, params, progress = progress, stats = stats)
+            // Ảnh hiển thị không còn là kết quả applyAdjust tại chỗ -> không được skip theo hash
+            AdjustProcessor.clearCache()
+            if (out != null) publishPreview(out, stats, onStats, onUpdated, gen)
+            return
+        }
+
+        val work = base.copy(Bitmap.Config.ARGB_8888, true)
+
+        Log.d("TAG5", "AdjustManager_applyAdjust: ")
+        val changed = AdjustProcessor.applyAdjust(context, work, params, progress = progress, stats, sourceId)
+
+        if (changed) {
+            publishPreview(work, stats, onStats, onUpdated, gen)
+            //
+            Log.d("TAG5", "AdjustManager_applyAdjust: areBitmapsDifferent = " + areBitmapsDifferent(base, work))
+            //
+        } else {
+            work.recycle() // bỏ nếu không thay đổi
+        }
     }
 
-    private fun Bitmap.scaleAndCropToExactSize(targetWidth: Int = 220, targetHeight: Int = 300): Bitmap {
-        // Tính tỉ lệ scale cần thiết để phủ kín cả 2 chiều
-        val scaleRatio = max(
-            targetWidth.toFloat() / this.width,
-            targetHeight.toFloat() / this.height
-        )
+    private suspend fun renderScaledPreview(
+        base: Bitmap, scale: Float, onStats: ((RenderStats) -> Unit)?, onUpdated: (Bitmap) -> Unit
+    ) {
+        val width = max(1, (base.width * scale).toInt())
+        val height = max(1, (base.height * scale).toInt())
+        val proxy = previewProxy(base, width, height) ?: return
+        val stats = if (onStats != null) RenderStats() else null
+        val sourceScale = width.toFloat() / base.width
+
+        Log.d("TAG5", "AdjustManager_applyAdjust: scaled preview ${width}x$height (scale = $scale)")
+        val work = if (ImageGeometry.isActive(params)) {
+            // Output = khung crop của proxy (≈ ImageGeometry.outputSize của ảnh gốc × scale), giữ đúng tỉ lệ
+            AdjustProcessor.applyAdjustGeometry(context, proxy, params, stats = stats, sourceScale = sourceScale)
+        } else {
+            val out = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
+            val ok = AdjustProcessor.applyAdjustRegion(
+                context, proxy, out, params, Rect(0, 0, width, height), stats = stats,
+                sourceScale = sourceScale
+            )
+            if (ok) out else {
+                out.recycle()
+                null
+            }
+        }
+        // Ảnh đang hiển thị không còn là bản full-res của lần render trước -> không được skip theo hash
+        AdjustProcessor.clearCache()
 
-        // Tạo matrix để scale ảnh
-        val matrix = Matrix().apply {
-            postScale(scaleRatio, scaleRatio)
+        if (work != null) publishPreview(work, stats, onStats, onUpdated)
+    }
+
+    /**
+     * Ảnh gốc thu nhỏ bằng box filter (trung bình diện tích, không răng cưa) cho preview scale < 1.
+     * Chỉ resample lại khi đổi ảnh hoặc [previewQuality] đổi kích thước; mỗi lần kéo slider render từ proxy 1:1.
+     */
+    private fun previewProxy(base: Bitmap, width: Int, height: Int): Bitmap? {
+        proxyBitmap?.let { if (it.width == width && it.height == height) return it }
+        proxyBitmap?.recycle()
+        proxyBitmap = null
+        val proxy = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
+        if (!AdjustProcessor.resample(base, proxy, filter = ResampleFilter.BOX)) {
+            proxy.recycle()
+            return null
         }
+        proxyBitmap = proxy
+        return proxy
+    }
 
-        // Tạo bitmap mới đã scale
-        val scaledBitmap = Bitmap.createBitmap(this, 0, 0, this.width, this.height, matrix, true)
+    private suspend fun publishPreview(
+        work: Bitmap, stats: RenderStats?, onStats: ((RenderStats) -> Unit)?, onUpdated: (Bitmap) -> Unit,
+        gen: Long = ANY_GENERATION
+    ) {
+        withContext(Dispatchers.Main) {
+            if (gen != ANY_GENERATION && gen != generation.get()) {
+                work.recycle() // params đã đổi trong lúc render -> kết quả cũ, preview mới hơn đang/sẽ hiển thị
+                return@withContext
+            }
+            previewBitmap?.recycle()
+            previewBitmap = work
+            onUpdated(work)
+            if (stats != null) onStats?.invoke(stats)
+        }
+    }
 
-        // Tính toán vị trí cắt ở trung tâm
-        val x = (scaledBitmap.width - targetWidth) / 2
-        val y = (scaledBitmap.height - targetHeight) / 2
+    /**
+     * Input đứng yên [PreviewQualityController.idleRefineDelayMs] -> 1 lần render full-res.
+     * applyAdjust mới huỷ refine; nếu native đã chạy thì kết quả bị bỏ (generation đổi) và render bù chạy sau.
+     */
+    private fun scheduleRefine(onStats: ((RenderStats) -> Unit)?, onUpdated: (Bitmap) -> Unit) {
+        refineJob?.cancel()
+        val gen = generation.get()
+        refineJob = lifecycleScope.launch(Dispatchers.Main) {
+            delay(previewQuality.idleRefineDelayMs)
+            val base = originalBitmap ?: return@launch
+            // Đã có render mới (nó sẽ tự lên lịch refine) hoặc params đã đổi
+            if (isProcessing || gen != generation.get()) return@launch
+            isProcessing = true
+            try {
+                withContext(Dispatchers.Default) { renderFullPreview(base, onStats, onUpdated, gen) }
+                if (gen == generation.get()) previewQuality.reset()
+            } catch (e: Exception) {
+                e.printStackTrace()
+            } finally {
+                finishRender()
+            }
+        }
+    }
 
-        // Đảm bảo không cắt vượt ra ngoài kích thước ảnh
-        val cropX = max(0, x)
-        val cropY = max(0, y)
-        val cropWidth = min(targetWidth, scaledBitmap.width - cropX)
-        val cropHeight = min(targetHeight, scaledBitmap.height - cropY)
+    fun areBitmapsDifferent(b1: Bitmap?, b2: Bitmap?): Boolean {
+        if (b1 == null || b2 == null) return true
+        if (b1.width != b2.width || b1.height != b2.height) return true
 
-        // Thực hiện cắt và trả về kết quả
-        return Bitmap.createBitmap(scaledBitmap, cropX, cropY, cropWidth, cropHeight)
+        val same = b1.sameAs(b2)
+        return !same
     }
 
     /**
@@ -171,13 +301,10 @@ class AdjustManager(
                             return@forEach
                         }
 
-                        // 🔹 3️⃣ Tạo thumbnail LUT
-                        val scaled = bitmap.scaleAndCropToExactSize(300, 300)
-                        val params = AdjustParams(lutPath = lut.filePath)
-                        val result = scaled.copy(Bitmap.Config.ARGB_8888, true)
-                        val success = AdjustProcessor.applyAdjust(context, result, params, null)
+                        // 🔹 3️⃣ Tạo thumbnail LUT (cache đĩa, hoặc scale + crop giữa rồi render trên native)
+                        val result = renderLutThumb(bitmap, lut.filePath)
 
-                        if (success) {
+                        if (result != null) {
                             resolver.openOutputStream(uri)?.use { out ->
                                 result.compress(Bitmap.CompressFormat.JPEG, 90, out)
                             }
@@ -195,16 +322,54 @@ class AdjustManager(
         }
     }
 
+    /**
+     * Thumbnail [size] × [size] của ảnh gốc qua LUT [lutPath]. Ảnh đã mở gần đây -> đọc từ [ThumbnailCache];
+     * miss -> render ở lớp [RenderPriority.THUMBNAIL] rồi ghi cache nền. Gọi trên luồng background.
+     */
+    fun renderLutThumb(lutPath: String, size: Int = LUT_THUMB_SIZE): Bitmap? =
+        originalBitmap?.let { renderLutThumb(it, lutPath, size) }
+
+    private fun renderLutThumb(bitmap: Bitmap, lutPath: String, size: Int = LUT_THUMB_SIZE): Bitmap? {
+        if (!ThumbnailCache.isOpen()) ThumbnailCache.open(context)
+        val hash = sourceHash.takeIf { it != 0L }
+            ?: AdjustProcessor.contentHashNative(bitmap).also { sourceHash = it }
+        if (hash != 0L) ThumbnailCache.load(hash, lutPath, size, size)?.let { return it }
+
+        val params = AdjustParams(lutPath = lutPath)
+        val thumb = AdjustProcessor.withPriority(RenderPriority.THUMBNAIL) {
+            val scaled = AdjustProcessor.scaleAndCrop(bitmap, size, size) ?: return@withPriority null
+            if (AdjustProcessor.applyAdjust(context, scaled, params, null)) scaled else {
+                scaled.recycle()
+                null
+            }
+        } ?: return null
+        if (hash != 0L) ThumbnailCache.store(hash, lutPath, thumb)
+        return thumb
+    }
+
     /**
      * Giải phóng bộ nhớ nếu không còn dùng.
      */
     fun release() {
         originalBitmap?.recycle()
         previewBitmap?.recycle()
+        proxyBitmap?.recycle()
         originalBitmap = null
         previewBitmap = null
+        proxyBitmap = null
         applyJob?.cancel()
+        refineJob?.cancel()
+        pendingRender = null
 
+        AdjustProcessor.clearRenderCache()
+        // Buffer của render cache vừa trả về arena -> free luôn cùng scratch của phiên
+        AdjustProcessor.trimScratchArena(0L)
         AdjustProcessor.releasePool()
     }
+
+    private companion object {
+        const val LUT_THUMB_SIZE = 300
+        const val ANY_GENERATION = -1L
+        val nextSourceId = AtomicLong(0L)
+    }
 }
@@ -8,4 +8,6 @@ object AdjustMask {
     const val GRAIN = 1L shl 4
     const val MASK_HSL = 1L shl 5
     const val MASK_LUT = 1L shl 6
+    const val MASK_CURVES = 1L shl 7 // tone curves master + R/G/B
+    const val MASK_DENOISE = 1L shl 8 // noise reduction luminance + chroma
 }
\ No newline at end of file
@@ -22,6 +22,11 @@ data class AdjustParams(
     var dehaze: Float = 0f,
     var vignette: Float = 0f,
     var grain: Float = 0f,
+
+    // Noise reduction 0f..1f
+    var denoiseLuma: Float = 0f,
+    var denoiseChroma: Float = 0f,
+
     var activeMask: Long = 0L,
 
     var hslHue: FloatArray = FloatArray(8),
@@ -31,7 +36,40 @@ data class AdjustParams(
     // LUT
     var lutPath: String? = null,
     var lutAmount: Float = 1f,   // 0f..1f  (0 = tắt LUT, 1 = full LUT)
+
+    // Tone curves: điểm điều khiển phẳng [x0, y0, x1, y1, ...] trong 0f..1f, tối đa 16 điểm
+    var curveMaster: FloatArray = FloatArray(0),
+    var curveRed: FloatArray = FloatArray(0),
+    var curveGreen: FloatArray = FloatArray(0),
+    var curveBlue: FloatArray = FloatArray(0),
+
+    // Thứ tự áp stage (id [PipelineStage]); rỗng = [PipelineStage.DEFAULT], stage thiếu được nối vào cuối
+    var stageOrder: IntArray = IntArray(0),
+
+    // Geometry (chỉ áp trong render vùng, xem [AdjustProcessor.applyAdjustGeometry])
+    var straighten: Float = 0f,      // -45f..45f độ, dương = theo chiều kim đồng hồ
+    var rotate90: Int = 0,           // số lần xoay 90° theo chiều kim đồng hồ
+    var flipHorizontal: Boolean = false,
+    var flipVertical: Boolean = false,
+    var crop: FloatArray = FloatArray(0), // [l, t, r, b] chuẩn hoá theo ảnh đã xoay 90°; rỗng = cả ảnh
+    var geometryInterpolation: Int = ImageGeometry.BICUBIC,
     ) {
+    fun curve(channel: Int): FloatArray = when (channel) {
+        ToneCurveChannel.RED -> curveRed
+        ToneCurveChannel.GREEN -> curveGreen
+        ToneCurveChannel.BLUE -> curveBlue
+        else -> curveMaster
+    }
+
+    fun setCurve(channel: Int, points: FloatArray) {
+        when (channel) {
+            ToneCurveChannel.RED -> curveRed = points
+            ToneCurveChannel.GREEN -> curveGreen = points
+            ToneCurveChannel.BLUE -> curveBlue = points
+            else -> curveMaster = points
+        }
+    }
+
     companion object {
         fun buildMask(p: AdjustParams, eps: Float = 1e-6f): Long {
             fun nz(v: Float) = kotlin.math.abs(v) > eps
@@ -45,6 +83,7 @@ data class AdjustParams(
             if (nz(p.texture) || nz(p.clarity) || nz(p.dehaze)) m = m or AdjustMask.DETAIL
             if (nz(p.vignette)) m = m or AdjustMask.VIGNETTE
             if (nz(p.grain)) m = m or AdjustMask.GRAIN
+            if (nz(p.denoiseLuma) || nz(p.denoiseChroma)) m = m or AdjustMask.MASK_DENOISE
             if (p.hslHue.any { it != 0f } ||
                 p.hslSaturation.any { it != 0f } ||
                 p.hslLuminance.any { it != 0f }) {
@@ -53,7 +92,21 @@ data class AdjustParams(
             if (!p.lutPath.isNullOrBlank() && p.lutAmount > 0.001f) {
                 m = m or AdjustMask.MASK_LUT
             }
+            if (!isIdentityCurve(p.curveMaster) || !isIdentityCurve(p.curveRed) ||
+                !isIdentityCurve(p.curveGreen) || !isIdentityCurve(p.curveBlue)
+            ) {
+                m = m or AdjustMask.MASK_CURVES
+            }
             return m
         }
+
+        // < 2 điểm hoặc mọi điểm nằm trên đường chéo -> spline đơn điệu trùng y = x
+        fun isIdentityCurve(points: FloatArray, eps: Float = 1e-4f): Boolean {
+            if (points.size < 4) return true
+            for (i in 0 until points.size / 2) {
+                if (kotlin.math.abs(points[2 * i] - points[2 * i + 1]) > eps) return false
+            }
+            return true
+        }
     }
 }
@@ -2,21 +2,202 @@ package com.core.adjust
 
 import android.content.Context
 import android.graphics.Bitmap
+import android.graphics.Rect
+import android.graphics.RectF
 import android.util.Log
+import com.core.adjust.frame.YuvFrame
+import com.core.adjust.stream.StripSink
+import com.core.adjust.stream.StripSource
+import kotlin.math.roundToInt
 
 object AdjustProcessor {
     init {
         System.loadLibrary("adjust")
     }
 
-    external fun applyAdjustNative(context: Context, bitmap: Bitmap, params: AdjustParams, progress: AdjustProgress?): Boolean
+    external fun applyAdjustNative(
+        context: Context, bitmap: Bitmap, params: AdjustParams,
+        progress: AdjustProgress?, stats: RenderStats?, sourceId: Long
+    ): Boolean
+
+    external fun applyAdjustRegionNative(
+        context: Context, source: Bitmap, output: Bitmap, params: AdjustParams,
+        left: Int, top: Int, right: Int, bottom: Int, sourceScale: Float,
+        progress: AdjustProgress?, stats: RenderStats?
+    ): Boolean
+
+    /** Dùng qua [resample] / [scaleAndCrop]. */
+    external fun resampleNative(
+        source: Bitmap, output: Bitmap, left: Float, top: Float, right: Float, bottom: Float,
+        filter: Int, linearLight: Boolean
+    ): Boolean
+
+    external fun processStreamNative(
+        context: Context, width: Int, height: Int, params: AdjustParams,
+        source: StripSource, sink: StripSink,
+        stripHeight: Int, premultiplied: Boolean, progress: AdjustProgress?
+    ): Boolean
+
+    /** Đúng 1 trong [outFrame] / [outBitmap] khác null; dùng qua [applyAdjustYuv]. */
+    external fun applyAdjustYuvNative(
+        context: Context, source: YuvFrame, outFrame: YuvFrame?, outBitmap: Bitmap?, params: AdjustParams
+    ): Boolean
+
+    external fun analyzeImageNative(bitmap: Bitmap, out: ImageAnalysis): Boolean
+
+    // --- Local adjustments (dùng qua LocalAdjustSession) ---
+    external fun createLocalSessionNative(width: Int, height: Int): Long
+
+    external fun releaseLocalSessionNative(handle: Long)
+
+    external fun setLocalLayerNative(
+        handle: Long, index: Int, type: Int, geometry: FloatArray?, invert: Boolean, params: AdjustParams
+    ): IntArray?
+
+    external fun paintLocalBrushNative(
+        handle: Long, index: Int, x: Float, y: Float, radius: Float,
+        hardness: Float, flow: Float, erase: Boolean
+    ): IntArray?
+
+    external fun removeLocalLayerNative(handle: Long, index: Int): IntArray?
+
+    external fun renderLocalNative(
+        handle: Long, context: Context, source: Bitmap, output: Bitmap, params: AdjustParams,
+        left: Int, top: Int, right: Int, bottom: Int, progress: AdjustProgress?
+    ): Boolean
 
     external fun clearCache()
 
+    /** Convert Adobe .cube (1D/3D, DOMAIN_MIN/MAX) sang .table; dùng qua [com.core.adjust.utils.LutImporter]. */
+    external fun convertCubeNative(srcPath: String, dstPath: String): Boolean
+
+    /** Convert HaldCLUT (bitmap ARGB_8888 không premultiply) sang .table. */
+    external fun convertHaldClutNative(bitmap: Bitmap, dstPath: String): Boolean
+
+    /**
+     * Render cache (LRU theo byte): [budgetBytes] tổng dung lượng, [compressCold] nén nhẹ các state cũ.
+     */
+    external fun configureRenderCache(budgetBytes: Long, compressCold: Boolean)
+
+    external fun clearRenderCache()
+
+    external fun renderCacheBytes(): Long
+
+    /** Mở cache thumbnail trên đĩa trong thư mục [dir]; dùng qua [ThumbnailCache]. */
+    external fun openThumbnailCacheNative(dir: String, capBytes: Long): Boolean
+
+    /** Chờ ghi hết thumbnail đang đợi rồi đóng file. */
+    external fun closeThumbnailCache()
+
+    external fun clearThumbnailCache()
+
+    /** Dung lượng pack thumbnail trên đĩa. */
+    external fun thumbnailCacheBytes(): Long
+
+    /** Hash 64-bit nội dung pixel của [bitmap] (khác 0), đa luồng; key của [ThumbnailCache]. */
+    external fun contentHashNative(bitmap: Bitmap): Long
+
+    external fun loadThumbnailNative(sourceHash: Long, lutKey: String, output: Bitmap): Boolean
+
+    external fun storeThumbnailNative(sourceHash: Long, lutKey: String, thumb: Bitmap): Boolean
+
+    /**
+     * Scratch arena: buffer tạm của render (plane trung gian, strip, bảng tone, dữ liệu render cache)
+     * được giữ lại để dùng cho frame sau. [capBytes] = tổng byte rảnh tối đa được giữ (high-water mark).
+     */
+    external fun configureScratchArena(capBytes: Long)
+
+    /** Giải phóng buffer rảnh của arena tới khi còn <= [keepBytes] (0 = trả hết, vd. khi onTrimMemory). */
+    external fun trimScratchArena(keepBytes: Long)
+
+    /** Byte arena đang giữ (rảnh + đang được render mượn). */
+    external fun scratchArenaBytes(): Long
+
+    /**
+     * Budget tổng cho bộ nhớ native có thể dựng lại (scratch rảnh, render cache, LUT cache); vượt budget thì evict
+     * theo thứ tự đó. Mask của session local được tính vào tổng nhưng không bao giờ bị xoá. Xem [NativeMemory].
+     */
+    external fun setMemoryBudget(budgetBytes: Long)
+
+    /**
+     * Trả bộ nhớ theo level của [android.content.ComponentCallbacks2.onTrimMemory]:
+     * RUNNING_MODERATE -> scratch rảnh, RUNNING_LOW -> + nửa render cache,
+     * RUNNING_CRITICAL / UI_HIDDEN -> toàn bộ render cache, BACKGROUND trở lên -> cả LUT cache.
+     */
+    external fun trimMemory(level: Int)
+
+    external fun memoryUsageNative(out: NativeMemoryUsage)
+
+    /** Dung lượng native hiện tại theo từng cache. */
+    fun memoryUsage(): NativeMemoryUsage = NativeMemoryUsage().also { memoryUsageNative(it) }
+
+    /** Số lần cấp phát heap của engine từ lúc nạp thư viện; -1 nếu build không bật ADJUST_ALLOC_COUNTER (chỉ Debug). */
+    external fun allocationCount(): Long
+
     external fun releasePool()
 
-    fun applyAdjust(context: Context, bitmap: Bitmap?, params: AdjustParams, progress: AdjustProgress?): Boolean {
+    /** Đặt lớp ưu tiên cho các lời gọi native tiếp theo trên luồng hiện tại, trả về lớp cũ. */
+    external fun setRenderPriorityNative(priority: Int): Int
+
+    /**
+     * Số worker tối đa cho từng lớp ([RenderPriority]); <= 0 = mặc định (thumbnail: n - 1, export: n / 2).
+     * Preview luôn được dùng mọi worker.
+     */
+    external fun configureScheduler(thumbnailWorkers: Int, exportWorkers: Int)
+
+    external fun describePipelineNative(params: AdjustParams): String?
+
+    /**
+     * Pass plan mà native sẽ chạy cho [params] ở độ phân giải đầy đủ (profiling), vd.
+     * "1 pass: [tone > color] -> denoise(halo 10) -> [lut > vignette]; pre recomputed on halo 10; ordered kernel".
+     * "ordered kernel" = thứ tự khác [PipelineStage.DEFAULT], chậm hơn kernel specialize ~15-20%.
+     */
+    fun describePipeline(params: AdjustParams): String? =
+        describePipelineNative(params.copy(activeMask = AdjustParams.buildMask(params)))
+
+    /** Chọn đường render số nguyên hay float, xem [FixedPointMode]. */
+    external fun setFixedPointMode(mode: Int)
+
+    /**
+     * Thời gian render dự kiến (ns / pixel output) cho tổ hợp stage [mask], học từ các lần render trước
+     * (EWMA theo mask); dùng bởi [PreviewQualityController].
+     */
+    external fun estimateRenderNsPerPixel(mask: Long): Double
+
+    external fun resetRenderCostModel()
+
+    /**
+     * Chạy [block] với lớp ưu tiên [priority] (xem [RenderPriority]) cho mọi render native bên trong.
+     * [block] phải chạy đồng bộ trên luồng hiện tại (không suspend giữa chừng).
+     */
+    inline fun <T> withPriority(priority: Int, block: () -> T): T {
+        val old = setRenderPriorityNative(priority)
+        try {
+            return block()
+        } finally {
+            setRenderPriorityNative(old)
+        }
+    }
+
+    /**
+     * @param stats nếu khác null, native sẽ điền histogram/clipping của ảnh output trong cùng pass render.
+     * @param sourceId id của ảnh gốc mà [bitmap] được copy ra; khác 0 thì kết quả được lưu vào render cache
+     * và các state đã render gần đây (undo, before/after, filter cũ) chỉ tốn 1 lần copy.
+     * Chỉ khi khác 0 mới bỏ qua (trả về false) lần gọi trùng params + ảnh + kích thước với lần trước;
+     * bằng 0 (thumbnail, bitmap mới mỗi lần) thì luôn render.
+     * @throws IllegalArgumentException nếu [params] có geometry ([ImageGeometry.isActive]): render tại chỗ
+     * giữ nguyên kích thước [bitmap], dùng [applyAdjustGeometry].
+     */
+    fun applyAdjust(
+        context: Context,
+        bitmap: Bitmap?,
+        params: AdjustParams,
+        progress: AdjustProgress?,
+        stats: RenderStats? = null,
+        sourceId: Long = 0L
+    ): Boolean {
         if (bitmap == null) return false
+        require(!ImageGeometry.isActive(params)) { "applyAdjust không áp geometry, dùng applyAdjustGeometry" }
         val mask = AdjustParams.buildMask(params)
         if (mask == 0L) return true // cần return true để áp dụng lại ảnh gốc
 
@@ -24,6 +205,179 @@ object AdjustProcessor {
         if (mask == AdjustMask.MASK_LUT && params.lutPath.isNullOrBlank()) return false
 
         Log.d("TAG5", "AdjustProcessor_applyAdjust: params = $params")
-        return applyAdjustNative(context, bitmap, params.copy(activeMask = mask), progress)
+        return applyAdjustNative(context, bitmap, params.copy(activeMask = mask), progress, stats, sourceId)
+    }
+
+    /**
+     * Render chỉ vùng [region] (toạ độ ảnh gốc) của [source] vào [output], scale theo kích thước [output].
+     * Vignette/grain được tính theo toạ độ ảnh gốc nên vùng crop 1:1 khớp tuyệt đối với bản render toàn ảnh.
+     * Nếu [params] có geometry ([ImageGeometry.isActive]) thì [region] bị bỏ qua, xem [applyAdjustGeometry].
+     * [source] không bị thay đổi; chi phí tỉ lệ với số pixel của [output].
+     * @param sourceScale [source] là proxy đã thu nhỏ từ ảnh gốc theo tỉ lệ này (xem [scaleAndCrop]);
+     * stage không gian (denoise) co bán kính theo đó để proxy trông giống bản full-res.
+     */
+    fun applyAdjustRegion(
+        context: Context,
+        source: Bitmap,
+        output: Bitmap,
+        params: AdjustParams,
+        region: Rect,
+        progress: AdjustProgress? = null,
+        stats: RenderStats? = null,
+        sourceScale: Float = 1f
+    ): Boolean {
+        if (region.isEmpty) return false
+        val mask = AdjustParams.buildMask(params)
+        return applyAdjustRegionNative(
+            context, source, output, params.copy(activeMask = mask),
+            region.left, region.top, region.right, region.bottom, sourceScale,
+            progress, stats
+        )
+    }
+
+    /**
+     * Render [source] qua geometry của [params] (crop / xoay 90° / lật / straighten, xem [ImageGeometry])
+     * rồi mọi stage, trong 1 pass: pixel output lấy mẫu ngược về [source], không có bitmap xoay trung gian.
+     * Output = khung crop × [scale] ([scale] < 1 = proxy khi kéo straighten); góc lộ ra ngoài ảnh trong suốt.
+     * Render toàn ảnh tại chỗ ([applyAdjust]) và [processStream] từ chối params có geometry.
+     * Trả về null nếu native thất bại.
+     */
+    fun applyAdjustGeometry(
+        context: Context,
+        source: Bitmap,
+        params: AdjustParams,
+        scale: Float = 1f,
+        progress: AdjustProgress? = null,
+        stats: RenderStats? = null,
+        sourceScale: Float = 1f
+    ): Bitmap? {
+        val (w, h) = ImageGeometry.outputSize(source.width, source.height, params)
+        val output = Bitmap.createBitmap(
+            maxOf(1, (w * scale).roundToInt()), maxOf(1, (h * scale).roundToInt()), Bitmap.Config.ARGB_8888
+        )
+        val mask = AdjustParams.buildMask(params)
+        if (applyAdjustRegionNative(
+                context, source, output, params.copy(activeMask = mask),
+                0, 0, source.width, source.height, sourceScale, progress, stats
+            )
+        ) return output
+        output.recycle()
+        return null
+    }
+
+    /**
+     * Co/giãn vùng [region] (toạ độ [source], cho phép lẻ; null = cả ảnh) vào toàn bộ [output] trên native,
+     * đa luồng, không cấp phát Bitmap trung gian. Cả 2 bitmap phải là ARGB_8888.
+     * @param linearLight trung bình trong không gian tuyến tính (đúng độ sáng chi tiết nhỏ), chậm hơn ~1.2-1.5x.
+     */
+    fun resample(
+        source: Bitmap,
+        output: Bitmap,
+        region: RectF? = null,
+        filter: Int = ResampleFilter.LANCZOS3,
+        linearLight: Boolean = false
+    ): Boolean {
+        val r = region ?: RectF(0f, 0f, source.width.toFloat(), source.height.toFloat())
+        if (r.isEmpty) return false
+        return resampleNative(source, output, r.left, r.top, r.right, r.bottom, filter, linearLight)
+    }
+
+    /**
+     * Thumbnail / proxy đúng [width] × [height]: scale để phủ kín rồi cắt giữa (như centerCrop), 1 pass native.
+     * Trả về null nếu native thất bại.
+     */
+    fun scaleAndCrop(
+        source: Bitmap,
+        width: Int,
+        height: Int,
+        filter: Int = ResampleFilter.LANCZOS3,
+        linearLight: Boolean = false
+    ): Bitmap? {
+        val scale = maxOf(width.toFloat() / source.width, height.toFloat() / source.height)
+        val cropW = width / scale
+        val cropH = height / scale
+        val left = (source.width - cropW) / 2f
+        val top = (source.height - cropH) / 2f
+        val output = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
+        if (resample(source, output, RectF(left, top, left + cropW, top + cropH), filter, linearLight)) return output
+        output.recycle()
+        return null
+    }
+
+    /**
+     * Xử lý ảnh rất lớn theo từng dải [stripHeight] hàng: pixel được kéo từ [source], đi qua pipeline
+     * rồi đẩy sang [sink]. Bộ nhớ đỉnh ~ stripHeight × width × 4 byte, không phụ thuộc chiều cao ảnh.
+     * Kết quả trùng khớp với render toàn ảnh bằng [applyAdjust].
+     * Mặc định chạy ở lớp [RenderPriority.EXPORT] để không làm giật preview.
+     * @throws IllegalArgumentException nếu [params] có geometry ([ImageGeometry.isActive]): xoay 90° / straighten
+     * cần cả ảnh nguồn cho 1 dải output, không stream được -> export qua [applyAdjustGeometry].
+     */
+    fun processStream(
+        context: Context,
+        width: Int,
+        height: Int,
+        params: AdjustParams,
+        source: StripSource,
+        sink: StripSink,
+        stripHeight: Int = 256,
+        premultiplied: Boolean = true,
+        progress: AdjustProgress? = null,
+        priority: Int = RenderPriority.EXPORT
+    ): Boolean {
+        if (width <= 0 || height <= 0) return false
+        require(!ImageGeometry.isActive(params)) { "processStream không áp geometry, dùng applyAdjustGeometry" }
+        val mask = AdjustParams.buildMask(params)
+        return withPriority(priority) {
+            processStreamNative(
+                context, width, height, params.copy(activeMask = mask),
+                source, sink, stripHeight, premultiplied, progress
+            )
+        }
+    }
+
+    /**
+     * Lọc 1 frame camera / video: YUV -> RGB, LUT + adjust và ghi ra [output] (ARGB_8888, cùng kích thước frame)
+     * trong 1 pass. Không cấp phát gì mỗi frame: [output] do caller giữ và dùng lại.
+     * Denoise bị bỏ qua trên frame (stage không gian, giữ latency ổn định).
+     */
+    fun applyAdjustYuv(
+        context: Context,
+        frame: YuvFrame,
+        params: AdjustParams,
+        output: Bitmap,
+        priority: Int = RenderPriority.INTERACTIVE
+    ): Boolean {
+        if (output.isRecycled || output.width != frame.width || output.height != frame.height) return false
+        val mask = AdjustParams.buildMask(params)
+        return withPriority(priority) {
+            applyAdjustYuvNative(context, frame, null, output, params.copy(activeMask = mask))
+        }
+    }
+
+    /**
+     * Như trên nhưng ghi kết quả về dạng YUV vào [output] (mặc định ghi đè chính [frame]), vd. trước khi
+     * đưa frame vào encoder. [output] có thể khác layout / color space với [frame], nhưng phải cùng kích thước.
+     */
+    fun applyAdjustYuv(
+        context: Context,
+        frame: YuvFrame,
+        params: AdjustParams,
+        output: YuvFrame = frame,
+        priority: Int = RenderPriority.INTERACTIVE
+    ): Boolean {
+        if (output.width != frame.width || output.height != frame.height) return false
+        val mask = AdjustParams.buildMask(params)
+        return withPriority(priority) {
+            applyAdjustYuvNative(context, frame, output, null, params.copy(activeMask = mask))
+        }
+    }
+
+    /**
+     * Phân tích ảnh trong 1 pass native (song song + lấy mẫu thưa), trả về null nếu bitmap không hợp lệ.
+     */
+    fun analyzeImage(bitmap: Bitmap?): ImageAnalysis? {
+        if (bitmap == null || bitmap.isRecycled || bitmap.config != Bitmap.Config.ARGB_8888) return null
+        val out = ImageAnalysis()
+        return if (analyzeImageNative(bitmap, out)) out else null
     }
 }
@@ -0,0 +1,12 @@
+package com.core.adjust
+
+/**
+ * Đường render số nguyên 16-bit cho LIGHT (không shadows/highlights/whites/blacks),
+ * COLOR (không vibrance) và LUT. Mỗi lần render native tự so với đường float trên
+ * 1 bộ pixel thăm dò và quay về float nếu lệch quá 3 mức 8-bit.
+ */
+object FixedPointMode {
+    const val AUTO = 0 // bật trên armeabi-v7a
+    const val ON = 1   // bật trên mọi ABI (khi tham số cho phép)
+    const val OFF = 2  // luôn dùng float
+}
@@ -0,0 +1,34 @@
+package com.core.adjust
+
+import androidx.annotation.Keep
+
+/**
+ * Kết quả phân tích ảnh 1 pass từ native ([AdjustProcessor.analyzeImage]).
+ * Các giá trị màu/luma ở thang 0..255, các tỉ lệ ở thang 0..1.
+ */
+@Keep
+class ImageAnalysis {
+    var meanR: Float = 0f
+    var meanG: Float = 0f
+    var meanB: Float = 0f
+    var meanLuma: Float = 0f
+
+    /** Độ lệch chuẩn của luma. */
+    var contrast: Float = 0f
+
+    /** (R - B) / 255 trung bình, > 0 là ảnh ấm. */
+    var temperatureBias: Float = 0f
+
+    /** Tỉ lệ pixel "trời xanh" ở nửa trên ảnh. */
+    var skyRatio: Float = 0f
+
+    /** Tỉ lệ pixel "lá cây" trên toàn ảnh. */
+    var foliageRatio: Float = 0f
+
+    var meanSaturation: Float = 0f
+
+    /** Phân bố saturation: [0, .15), [.15, .35), [.35, .6), [.6, 1]. */
+    val saturationBins = FloatArray(4)
+
+    var sampleCount: Long = 0L
+}
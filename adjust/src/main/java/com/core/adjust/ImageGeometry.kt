@@ -0,0 +1,61 @@
+package com.core.adjust
+
+import kotlin.math.abs
+import kotlin.math.cos
+import kotlin.math.roundToInt
+import kotlin.math.sin
+
+/**
+ * Crop / xoay 90° / lật / straighten của [AdjustParams]. Native lấy mẫu ngược từ từng pixel output
+ * ngay trong pass render (không có bitmap xoay trung gian), xem [AdjustProcessor.applyAdjustGeometry].
+ */
+object ImageGeometry {
+    const val BILINEAR = 0 // nhanh hơn ~1.45x, hợp khi kéo straighten
+    const val BICUBIC = 1  // Catmull-Rom, sắc hơn (export)
+
+    fun isActive(p: AdjustParams): Boolean =
+        p.straighten != 0f || (p.rotate90 and 3) != 0 || p.flipHorizontal || p.flipVertical || hasCrop(p.crop)
+
+    private fun hasCrop(c: FloatArray): Boolean =
+        c.size == 4 && c[2] > c[0] && c[3] > c[1] &&
+            (c[0] != 0f || c[1] != 0f || c[2] != 1f || c[3] != 1f)
+
+    /** Kích thước full-res (pixel) của khung crop sau xoay 90°, khớp với native. */
+    fun outputSize(width: Int, height: Int, p: AdjustParams): Pair<Int, Int> {
+        val swap = (p.rotate90 and 1) != 0
+        val fw = if (swap) height else width
+        val fh = if (swap) width else height
+        var l = 0f
+        var t = 0f
+        var r = 1f
+        var b = 1f
+        if (p.crop.size == 4) {
+            val c = p.crop.map { it.coerceIn(0f, 1f) }
+            if (c[2] > c[0] && c[3] > c[1]) {
+                l = c[0]; t = c[1]; r = c[2]; b = c[3]
+            }
+        }
+        return maxOf(1, ((r - l) * fw).roundToInt()) to maxOf(1, ((b - t) * fh).roundToInt())
+    }
+
+    /**
+     * Khung crop lớn nhất, giữ tỉ lệ khung crop hiện tại, căn giữa và nằm trọn trong ảnh đã straighten
+     * (không lộ góc trong suốt). Trả về [l, t, r, b] chuẩn hoá để gán vào [AdjustParams.crop].
+     */
+    fun fitCrop(width: Int, height: Int, p: AdjustParams): FloatArray {
+        val swap = (p.rotate90 and 1) != 0
+        val fw = (if (swap) height else width).toDouble()
+        val fh = (if (swap) width else height).toDouble()
+        val (cw, ch) = outputSize(width, height, p)
+        val th = Math.toRadians(abs(p.straighten.toDouble()))
+        val c = cos(th)
+        val s = sin(th)
+        // Hình chữ nhật w × h xoay góc th nằm trong fw × fh khi w·c + h·s <= fw và w·s + h·c <= fh
+        val k = minOf(fw / (cw * c + ch * s), fh / (cw * s + ch * c))
+        val w = cw * k / fw
+        val h = ch * k / fh
+        val l = (1.0 - w) / 2
+        val t = (1.0 - h) / 2
+        return floatArrayOf(l.toFloat(), t.toFloat(), (l + w).toFloat(), (t + h).toFloat())
+    }
+}
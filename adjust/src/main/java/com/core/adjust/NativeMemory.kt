@@ -0,0 +1,56 @@
+package com.core.adjust
+
+import android.app.ActivityManager
+import android.content.ComponentCallbacks2
+import android.content.Context
+import android.content.res.Configuration
+
+/**
+ * Budget bộ nhớ native theo RAM thiết bị + chuyển tiếp onTrimMemory xuống engine.
+ * Gọi [install] 1 lần (AdjustManager tự gọi); mặc định = RAM / 32 trong [MIN_BUDGET_BYTES, MAX_BUDGET_BYTES]:
+ * máy 3 GB -> 96 MB, 4 GB -> 128 MB.
+ */
+object NativeMemory {
+    const val MIN_BUDGET_BYTES = 48L * 1024 * 1024
+    const val MAX_BUDGET_BYTES = 192L * 1024 * 1024
+    private const val RAM_DIVISOR = 32L
+
+    @Volatile
+    private var installed = false
+
+    private val callbacks = object : ComponentCallbacks2 {
+        override fun onTrimMemory(level: Int) {
+            AdjustProcessor.trimMemory(level)
+        }
+
+        override fun onConfigurationChanged(newConfig: Configuration) = Unit
+
+        @Deprecated("Deprecated in Java")
+        override fun onLowMemory() {
+            AdjustProcessor.trimMemory(ComponentCallbacks2.TRIM_MEMORY_COMPLETE)
+        }
+    }
+
+    /** @param budgetBytes <= 0 = tự chọn theo RAM ([defaultBudgetBytes]). */
+    @Synchronized
+    fun install(context: Context, budgetBytes: Long = 0L) {
+        if (installed && budgetBytes <= 0L) return // giữ budget đã đặt trước đó
+        val app = context.applicationContext
+        AdjustProcessor.setMemoryBudget(if (budgetBytes > 0L) budgetBytes else defaultBudgetBytes(app))
+        if (!installed) {
+            app.registerComponentCallbacks(callbacks)
+            installed = true
+        }
+    }
+
+    fun defaultBudgetBytes(context: Context): Long {
+        val am = context.getSystemService(Context.ACTIVITY_SERVICE) as? ActivityManager
+            ?: return MIN_BUDGET_BYTES
+        val info = ActivityManager.MemoryInfo()
+        am.getMemoryInfo(info)
+        var budget = (info.totalMem / RAM_DIVISOR).coerceIn(MIN_BUDGET_BYTES, MAX_BUDGET_BYTES)
+        // Máy "low RAM" (Android Go): không vượt quá nửa heap Java cho phép
+        if (am.isLowRamDevice) budget = minOf(budget, am.memoryClass * 1024L * 1024L / 2)
+        return budget
+    }
+}
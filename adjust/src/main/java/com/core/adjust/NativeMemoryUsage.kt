@@ -0,0 +1,37 @@
+package com.core.adjust
+
+import androidx.annotation.Keep
+
+/**
+ * Ảnh chụp bộ nhớ native của engine theo từng cache, native điền qua [AdjustProcessor.memoryUsage].
+ * [totalBytes] = tổng các pool + scratch đang được render mượn; chỉ các cache dựng lại được bị tính vào
+ * [budgetBytes] khi evict, session local không bao giờ bị xoá.
+ */
+@Keep
+class NativeMemoryUsage {
+    /** Buffer rảnh arena giữ lại cho frame sau (evict đầu tiên). */
+    var scratchIdleBytes: Long = 0L
+
+    /** Scratch đang được render mượn (không evict được, tự trả về khi render xong). */
+    var scratchInUseBytes: Long = 0L
+
+    var renderCacheBytes: Long = 0L
+
+    var lutCacheBytes: Long = 0L
+
+    /** Mask của các [com.core.adjust.local.LocalAdjustSession] đang mở. */
+    var localSessionBytes: Long = 0L
+
+    var totalBytes: Long = 0L
+
+    var budgetBytes: Long = 0L
+
+    override fun toString(): String =
+        "NativeMemoryUsage(total=${totalBytes / KB} KB / budget=${budgetBytes / KB} KB, " +
+            "scratchIdle=${scratchIdleBytes / KB}, scratchInUse=${scratchInUseBytes / KB}, " +
+            "renderCache=${renderCacheBytes / KB}, lut=${lutCacheBytes / KB}, local=${localSessionBytes / KB})"
+
+    private companion object {
+        const val KB = 1024L
+    }
+}
@@ -0,0 +1,23 @@
+package com.core.adjust
+
+/**
+ * Node của pipeline render, dùng cho [AdjustParams.stageOrder]. Native gộp các stage point-wise liền nhau
+ * vào 1 lần đọc/ghi pixel; DENOISE là stage không gian (cần pixel lân cận) nên tách nhóm, nhóm đứng trước
+ * nó được tính lại trên halo của tile. TONE = light + tone curves. Xem [AdjustProcessor.describePipeline].
+ */
+object PipelineStage {
+    const val DENOISE = 0
+    const val LUT = 1
+    const val TONE = 2
+    const val HSL = 3
+    const val COLOR = 4
+    const val DETAIL = 5
+    const val VIGNETTE = 6
+    const val GRAIN = 7
+
+    /** Thứ tự mặc định (kernel specialize, nhanh nhất): filter trước mọi adjust. */
+    val DEFAULT = intArrayOf(DENOISE, LUT, TONE, HSL, COLOR, DETAIL, VIGNETTE, GRAIN)
+
+    /** Filter áp lên ảnh đã chỉnh, vignette/grain vẫn nằm trên cùng. */
+    val FILTER_AFTER_ADJUSTMENTS = intArrayOf(DENOISE, TONE, HSL, COLOR, DETAIL, LUT, VIGNETTE, GRAIN)
+}
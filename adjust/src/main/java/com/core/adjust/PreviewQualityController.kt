@@ -0,0 +1,57 @@
+package com.core.adjust
+
+import kotlin.math.sqrt
+
+/**
+ * Chọn độ phân giải preview theo thời gian render đo được trong native (theo từng tổ hợp stage):
+ * LUT đơn giản -> preview full-res, HSL + grain + detail trên ảnh 12 MP -> preview nhỏ hơn,
+ * sao cho mỗi frame nằm trong [frameBudgetMs]. Khi người dùng ngừng kéo slider
+ * [idleRefineDelayMs], [AdjustManager] render lại 1 lần ở full-res.
+ */
+class PreviewQualityController(
+    var frameBudgetMs: Float = BUDGET_30_FPS,
+    var idleRefineDelayMs: Long = 250L,
+    /** Không xuống thấp hơn mức này (ảnh quá mờ khi kéo slider). */
+    var minScale: Float = 0.25f
+) {
+    private var lastScale = 1f
+
+    /**
+     * Tỉ lệ preview (0 < scale <= 1) cho ảnh [width] × [height] với [mask] (xem [AdjustParams.buildMask]).
+     * Làm tròn xuống theo bước [SCALE_STEP]; chỉ tăng lại khi dư >= 20% budget để không nhấp nháy
+     * độ nét giữa các frame liên tiếp.
+     */
+    fun chooseScale(mask: Long, width: Int, height: Int): Float {
+        val fullPixels = width.toDouble() * height
+        if (fullPixels <= 0.0) return 1f
+
+        val nsPerPixel = AdjustProcessor.estimateRenderNsPerPixel(mask)
+        val budgetNs = frameBudgetMs * 1_000_000.0
+        val fit = sqrt(budgetNs / (nsPerPixel * fullPixels)).toFloat()
+
+        var scale = quantize(fit)
+        if (scale > lastScale) {
+            val headroomFit = sqrt(budgetNs * 0.8 / (nsPerPixel * fullPixels)).toFloat()
+            scale = maxOf(lastScale, quantize(headroomFit))
+        }
+        lastScale = scale
+        return scale
+    }
+
+    /** Preview vừa render ở full-res (refine hoặc đủ nhanh) -> lần sau tính lại từ đầu. */
+    fun reset() {
+        lastScale = 1f
+    }
+
+    private fun quantize(fit: Float): Float {
+        if (fit >= 1f) return 1f
+        val stepped = (fit / SCALE_STEP).toInt() * SCALE_STEP
+        return stepped.coerceIn(minScale, 1f)
+    }
+
+    companion object {
+        const val BUDGET_60_FPS = 16f
+        const val BUDGET_30_FPS = 33f
+        private const val SCALE_STEP = 0.125f
+    }
+}
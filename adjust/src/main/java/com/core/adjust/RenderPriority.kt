@@ -0,0 +1,11 @@
+package com.core.adjust
+
+/**
+ * Lớp ưu tiên của scheduler native. Worker rảnh luôn lấy task của lớp cao nhất trước;
+ * job lớp thấp được chia nhỏ để preview không phải chờ cả 1 export chạy xong.
+ */
+object RenderPriority {
+    const val INTERACTIVE = 0 // preview khi kéo slider
+    const val THUMBNAIL = 1   // thumbnail filter/LUT
+    const val EXPORT = 2      // lưu ảnh full-res, streaming
+}
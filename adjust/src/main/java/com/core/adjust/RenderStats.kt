@@ -0,0 +1,30 @@
+package com.core.adjust
+
+import androidx.annotation.Keep
+
+/**
+ * Thống kê ảnh output, được native thu thập ngay trong pass render (không cần quét bitmap lần 2).
+ * Chỉ số kênh cho [min]/[max]: 0 = R, 1 = G, 2 = B, 3 = Luma.
+ */
+@Keep
+class RenderStats {
+    val histR = IntArray(256)
+    val histG = IntArray(256)
+    val histB = IntArray(256)
+    val histL = IntArray(256)
+
+    val min = IntArray(4)
+    val max = IntArray(4)
+
+    /** Số pixel có ít nhất 1 kênh = 0. */
+    var clippedShadows: Long = 0L
+
+    /** Số pixel có ít nhất 1 kênh = 255. */
+    var clippedHighlights: Long = 0L
+
+    var pixelCount: Long = 0L
+
+    fun shadowClipRatio(): Float = if (pixelCount > 0) clippedShadows.toFloat() / pixelCount else 0f
+
+    fun highlightClipRatio(): Float = if (pixelCount > 0) clippedHighlights.toFloat() / pixelCount else 0f
+}
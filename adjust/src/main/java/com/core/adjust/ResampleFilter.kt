@@ -0,0 +1,11 @@
+package com.core.adjust
+
+/**
+ * Kernel của [AdjustProcessor.resample]. Khi thu nhỏ, support của kernel giãn theo tỉ lệ nên mọi pixel nguồn
+ * đều góp vào kết quả (không răng cưa như lấy mẫu điểm / `Bitmap.createBitmap` với `Matrix`).
+ */
+object ResampleFilter {
+    const val BOX = 0      // trung bình diện tích: nhanh nhất, hợp cho proxy preview
+    const val BILINEAR = 1 // tam giác: mềm hơn box, ~1.3x thời gian
+    const val LANCZOS3 = 2 // sắc nhất (thumbnail hiển thị), ~2.7x thời gian box
+}
@@ -0,0 +1,65 @@
+package com.core.adjust
+
+import android.content.Context
+import android.graphics.Bitmap
+import androidx.core.content.pm.PackageInfoCompat
+import java.io.File
+
+/**
+ * Cache thumbnail filter/LUT trên đĩa (native), sống qua các lần mở app: mở lại ảnh gần đây thì
+ * dải filter đọc thẳng từ cache (~0.5 ms / thumbnail 300×300) thay vì render lại từng LUT.
+ * Key = hash nội dung ảnh ([AdjustProcessor.contentHashNative]) + LUT (đường dẫn, thời gian sửa, kích thước file;
+ * LUT trong assets: versionCode + thời điểm cài của app) + kích thước thumbnail + engine version. [store] không chờ I/O: ghi đĩa trên luồng riêng của native.
+ */
+object ThumbnailCache {
+    const val DEFAULT_CAP_BYTES = 48L * 1024 * 1024
+    private const val DIR_NAME = "adjust_thumbs"
+
+    @Volatile
+    private var opened = false
+
+    // Phiên bản APK: LUT đóng gói trong assets chỉ đổi khi app được cập nhật
+    @Volatile
+    private var appVersion = ""
+
+    /** Mở cache trong cacheDir của app; gọi lại được (chỉ đổi cap). */
+    @Synchronized
+    fun open(context: Context, capBytes: Long = DEFAULT_CAP_BYTES): Boolean {
+        val app = context.applicationContext
+        appVersion = runCatching {
+            val info = app.packageManager.getPackageInfo(app.packageName, 0)
+            "${PackageInfoCompat.getLongVersionCode(info)}:${info.lastUpdateTime}"
+        }.getOrDefault("")
+        val dir = File(app.cacheDir, DIR_NAME)
+        opened = AdjustProcessor.openThumbnailCacheNative(dir.absolutePath, capBytes)
+        return opened
+    }
+
+    fun isOpen(): Boolean = opened
+
+    // LUT import lại cùng tên -> mtime / size khác -> miss; LUT trong assets (không phải file) -> theo phiên bản app
+    fun lutKey(lutPath: String): String {
+        val file = File(lutPath)
+        return if (file.isFile) "$lutPath@${file.lastModified()}:${file.length()}" else "$lutPath@app:$appVersion"
+    }
+
+    /** Thumbnail [width] × [height] đã cache, hoặc null. */
+    fun load(sourceHash: Long, lutPath: String, width: Int, height: Int): Bitmap? {
+        if (!opened) return null
+        val bitmap = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
+        if (AdjustProcessor.loadThumbnailNative(sourceHash, lutKey(lutPath), bitmap)) return bitmap
+        bitmap.recycle()
+        return null
+    }
+
+    /** Đưa [thumb] vào hàng đợi ghi; [thumb] dùng tiếp / recycle ngay được. */
+    fun store(sourceHash: Long, lutPath: String, thumb: Bitmap): Boolean =
+        opened && AdjustProcessor.storeThumbnailNative(sourceHash, lutKey(lutPath), thumb)
+
+    @Synchronized
+    fun close() {
+        if (!opened) return
+        AdjustProcessor.closeThumbnailCache()
+        opened = false
+    }
+}
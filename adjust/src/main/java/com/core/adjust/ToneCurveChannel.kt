@@ -0,0 +1,12 @@
+package com.core.adjust
+
+/**
+ * Kênh của tone curve ([AdjustParams.curve]). RED/GREEN/BLUE là kênh màu thật của bitmap,
+ * áp sau curve MASTER.
+ */
+object ToneCurveChannel {
+    const val MASTER = 0
+    const val RED = 1
+    const val GREEN = 2
+    const val BLUE = 3
+}
@@ -0,0 +1,17 @@
+package com.core.adjust.frame
+
+/** Layout plane của frame YUV 4:2:0, dùng cho [YuvFrame.wrap] / [YuvFrame.allocate]. */
+object YuvFormat {
+    const val NV21 = 0 // Y + VU xen kẽ (camera1 preview mặc định)
+    const val NV12 = 1 // Y + UV xen kẽ (đa số decoder MediaCodec)
+    const val I420 = 2 // Y + U + V tách rời
+}
+
+/**
+ * Ma trận YUV <-> RGB của frame, giá trị trùng enum YuvColorSpace bên native (adjust_yuv.h).
+ */
+object YuvColorSpace {
+    const val BT601_FULL = 0    // JFIF: camera Android
+    const val BT601_LIMITED = 1 // video SD
+    const val BT709_LIMITED = 2 // video HD
+}
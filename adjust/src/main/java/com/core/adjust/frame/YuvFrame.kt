@@ -0,0 +1,117 @@
+package com.core.adjust.frame
+
+import android.graphics.ImageFormat
+import android.media.Image
+import androidx.annotation.Keep
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Mô tả 1 frame YUV 4:2:0 (NV21 / NV12 / I420 / YUV_420_888) cho [com.core.adjust.AdjustProcessor.applyAdjustYuv].
+ * Mọi plane phải là direct ByteBuffer: native đọc/ghi thẳng, không copy qua JNI.
+ * Tạo 1 lần cho mỗi buffer (vd. mỗi buffer trong pool của camera / decoder) rồi dùng lại qua các frame.
+ *
+ * [uvPixelStride] = 1: U/V là 2 plane riêng; = 2: U/V xen kẽ trong cùng 1 plane ([u] và [v] lệch nhau 1 byte).
+ */
+@Keep
+class YuvFrame(
+    val width: Int,
+    val height: Int,
+    val y: ByteBuffer,
+    val u: ByteBuffer,
+    val v: ByteBuffer,
+    val yStride: Int,
+    val uvStride: Int,
+    val uvPixelStride: Int,
+    val colorSpace: Int = YuvColorSpace.BT601_FULL
+) {
+    init {
+        require(width > 0 && height > 0) { "Kích thước frame không hợp lệ: ${width}x$height" }
+        require(y.isDirect && u.isDirect && v.isDirect) { "YuvFrame cần direct ByteBuffer" }
+        require(uvPixelStride == 1 || uvPixelStride == 2) { "uvPixelStride phải là 1 hoặc 2" }
+    }
+
+    companion object {
+        /** Số byte của 1 frame [width] × [height] không padding (NV21 / NV12 / I420 như nhau). */
+        fun bufferSize(width: Int, height: Int): Int {
+            val chroma = (width + 1) / 2 * ((height + 1) / 2)
+            return width * height + 2 * chroma
+        }
+
+        /**
+         * Bọc [buffer] chứa frame [format] ([YuvFormat]) liền mạch, không padding giữa các hàng
+         * (vd. buffer camera1 / output MediaCodec đã copy sang direct buffer).
+         */
+        fun wrap(
+            buffer: ByteBuffer,
+            width: Int,
+            height: Int,
+            format: Int,
+            colorSpace: Int = YuvColorSpace.BT601_FULL
+        ): YuvFrame {
+            require(buffer.capacity() >= bufferSize(width, height)) { "Buffer nhỏ hơn 1 frame ${width}x$height" }
+            val chromaW = (width + 1) / 2
+            val chromaH = (height + 1) / 2
+            val ySize = width * height
+            val y = slice(buffer, 0, ySize)
+            return when (format) {
+                YuvFormat.I420 -> YuvFrame(
+                    width, height, y,
+                    u = slice(buffer, ySize, chromaW * chromaH),
+                    v = slice(buffer, ySize + chromaW * chromaH, chromaW * chromaH),
+                    yStride = width, uvStride = chromaW, uvPixelStride = 1, colorSpace = colorSpace
+                )
+                YuvFormat.NV12 -> YuvFrame(
+                    width, height, y,
+                    u = slice(buffer, ySize, 2 * chromaW * chromaH),
+                    v = slice(buffer, ySize + 1, 2 * chromaW * chromaH - 1),
+                    yStride = width, uvStride = 2 * chromaW, uvPixelStride = 2, colorSpace = colorSpace
+                )
+                YuvFormat.NV21 -> YuvFrame(
+                    width, height, y,
+                    u = slice(buffer, ySize + 1, 2 * chromaW * chromaH - 1),
+                    v = slice(buffer, ySize, 2 * chromaW * chromaH),
+                    yStride = width, uvStride = 2 * chromaW, uvPixelStride = 2, colorSpace = colorSpace
+                )
+                else -> throw IllegalArgumentException("YuvFormat không hỗ trợ: $format")
+            }
+        }
+
+        /** Cấp phát 1 frame đích (direct buffer) để tái sử dụng cho mọi frame cùng kích thước. */
+        fun allocate(
+            width: Int,
+            height: Int,
+            format: Int,
+            colorSpace: Int = YuvColorSpace.BT601_FULL
+        ): YuvFrame {
+            val buffer = ByteBuffer.allocateDirect(bufferSize(width, height)).order(ByteOrder.nativeOrder())
+            return wrap(buffer, width, height, format, colorSpace)
+        }
+
+        /**
+         * Frame từ [Image] YUV_420_888 (Camera2 ImageReader, MediaCodec.getOutputImage).
+         * Plane của Image chỉ hợp lệ tới khi Image.close(): gọi lại mỗi frame, KHÔNG giữ qua close.
+         */
+        fun fromImage(image: Image, colorSpace: Int = YuvColorSpace.BT601_FULL): YuvFrame {
+            require(image.format == ImageFormat.YUV_420_888) { "Image cần YUV_420_888" }
+            val planes = image.planes
+            return YuvFrame(
+                image.width, image.height,
+                y = planes[0].buffer,
+                u = planes[1].buffer,
+                v = planes[2].buffer,
+                yStride = planes[0].rowStride,
+                uvStride = planes[1].rowStride,
+                uvPixelStride = planes[1].pixelStride,
+                colorSpace = colorSpace
+            )
+        }
+
+        private fun slice(buffer: ByteBuffer, offset: Int, size: Int): ByteBuffer {
+            val dup = buffer.duplicate()
+            dup.position(offset)
+            dup.limit(offset + size)
+            return dup.slice()
+        }
+    }
+}
@@ -0,0 +1,106 @@
+package com.core.adjust.local
+
+import android.content.Context
+import android.graphics.Bitmap
+import android.graphics.Rect
+import com.core.adjust.AdjustMask
+import com.core.adjust.AdjustParams
+import com.core.adjust.AdjustProcessor
+import com.core.adjust.AdjustProgress
+
+/**
+ * Phiên chỉnh sửa local cho 1 ảnh kích thước [width] × [height].
+ *
+ * Mỗi layer có bộ [AdjustParams] riêng, chỉ tác dụng bên trong mask và được trộn theo trọng số mask
+ * lên kết quả của params global. Mask lưu dạng tile 64×64 ở native: tile không bị mask chạm tới bị bỏ qua,
+ * và mỗi thao tác trả về vùng [Rect] cần render lại để truyền vào [render].
+ *
+ * Không thread-safe: gọi tuần tự từ 1 luồng. Nhớ [close] khi không dùng nữa.
+ */
+class LocalAdjustSession(val width: Int, val height: Int) : AutoCloseable {
+
+    private var handle: Long = AdjustProcessor.createLocalSessionNative(width, height)
+
+    /**
+     * Tạo hoặc cập nhật layer [index] (0 until [MAX_LAYERS]). Đổi sang [LocalMask.Brush] trên layer brush sẵn có
+     * giữ nguyên nét đã vẽ.
+     * @return vùng cần render lại (mask cũ ∪ mask mới), null nếu không có gì thay đổi hoặc [index] ngoài giới hạn.
+     */
+    fun setLayer(index: Int, mask: LocalMask, params: AdjustParams): Rect? {
+        if (handle == 0L) return null
+        val geometry = when (mask) {
+            is LocalMask.Radial -> floatArrayOf(mask.cx, mask.cy, mask.rx, mask.ry, mask.angle, mask.feather)
+            is LocalMask.Linear -> floatArrayOf(mask.x0, mask.y0, mask.x1, mask.y1)
+            LocalMask.Brush -> null
+        }
+        val invert = when (mask) {
+            is LocalMask.Radial -> mask.invert
+            is LocalMask.Linear -> mask.invert
+            LocalMask.Brush -> false
+        }
+        // Layer local không áp LUT / denoise (denoise cần halo, chỉ chạy ở pipeline global)
+        val layerMask = AdjustParams.buildMask(params) and (AdjustMask.MASK_LUT or AdjustMask.MASK_DENOISE).inv()
+        return AdjustProcessor.setLocalLayerNative(
+            handle, index, mask.type, geometry, invert, params.copy(activeMask = layerMask)
+        ).toRect()
+    }
+
+    /**
+     * Tô (hoặc xoá khi [erase]) 1 dab tròn lên layer brush [index].
+     * @return vùng tile bị thay đổi, null nếu không đổi gì.
+     */
+    fun paint(
+        index: Int,
+        x: Float,
+        y: Float,
+        radius: Float,
+        hardness: Float = 0.5f,
+        flow: Float = 1f,
+        erase: Boolean = false
+    ): Rect? {
+        if (handle == 0L) return null
+        return AdjustProcessor.paintLocalBrushNative(handle, index, x, y, radius, hardness, flow, erase).toRect()
+    }
+
+    /** @return vùng mask cũ cần render lại, null nếu layer không tồn tại. */
+    fun removeLayer(index: Int): Rect? {
+        if (handle == 0L) return null
+        return AdjustProcessor.removeLocalLayerNative(handle, index).toRect()
+    }
+
+    /**
+     * Render [params] global + mọi layer từ [source] vào [output] (cùng kích thước session, ARGB_8888).
+     * [dirty] khác null: chỉ vẽ lại các tile giao với vùng này, phần còn lại của [output] giữ nguyên
+     * kết quả lần render trước (params global phải không đổi).
+     */
+    fun render(
+        context: Context,
+        source: Bitmap,
+        output: Bitmap,
+        params: AdjustParams,
+        dirty: Rect? = null,
+        progress: AdjustProgress? = null
+    ): Boolean {
+        if (handle == 0L) return false
+        val mask = AdjustParams.buildMask(params)
+        val r = dirty ?: Rect()
+        return AdjustProcessor.renderLocalNative(
+            handle, context, source, output, params.copy(activeMask = mask),
+            r.left, r.top, r.right, r.bottom, progress
+        )
+    }
+
+    override fun close() {
+        if (handle != 0L) {
+            AdjustProcessor.releaseLocalSessionNative(handle)
+            handle = 0L
+        }
+    }
+
+    private fun IntArray?.toRect(): Rect? = this?.let { Rect(it[0], it[1], it[2], it[3]) }
+
+    companion object {
+        /** Số layer tối đa mỗi phiên (kMaxLocalLayers ở native) */
+        const val MAX_LAYERS = 32
+    }
+}
@@ -0,0 +1,46 @@
+package com.core.adjust.local
+
+/**
+ * Hình dạng mask của 1 layer local. Toạ độ tính theo pixel của ảnh gốc.
+ */
+sealed class LocalMask {
+    internal abstract val type: Int
+
+    /**
+     * Ellipse tâm ([cx], [cy]), bán kính ([rx], [ry]), xoay [angle] độ.
+     * [feather] 0..1: phần viền chuyển mượt tính từ mép ellipse vào trong.
+     */
+    data class Radial(
+        val cx: Float,
+        val cy: Float,
+        val rx: Float,
+        val ry: Float,
+        val angle: Float = 0f,
+        val feather: Float = 0.5f,
+        val invert: Boolean = false
+    ) : LocalMask() {
+        override val type: Int get() = TYPE_RADIAL
+    }
+
+    /** Gradient tuyến tính: tác dụng đầy đủ tại ([x0], [y0]), giảm dần về 0 tại ([x1], [y1]). */
+    data class Linear(
+        val x0: Float,
+        val y0: Float,
+        val x1: Float,
+        val y1: Float,
+        val invert: Boolean = false
+    ) : LocalMask() {
+        override val type: Int get() = TYPE_LINEAR
+    }
+
+    /** Mask vẽ tay, bắt đầu trống; tô bằng [LocalAdjustSession.paint]. */
+    object Brush : LocalMask() {
+        override val type: Int get() = TYPE_BRUSH
+    }
+
+    internal companion object {
+        const val TYPE_RADIAL = 0
+        const val TYPE_LINEAR = 1
+        const val TYPE_BRUSH = 2
+    }
+}
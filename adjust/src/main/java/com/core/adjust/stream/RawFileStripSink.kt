@@ -0,0 +1,23 @@
+package com.core.adjust.stream
+
+import java.io.File
+import java.io.FileOutputStream
+import java.nio.ByteBuffer
+
+/**
+ * Ghi tuần tự các dải RGBA_8888 ra file thô (không header), phù hợp làm đầu vào cho encoder ngoài.
+ */
+class RawFileStripSink(file: File) : StripSink {
+
+    private val channel = FileOutputStream(file).channel
+
+    override fun writeStrip(top: Int, rows: Int, buffer: ByteBuffer): Boolean {
+        return runCatching {
+            while (buffer.hasRemaining()) channel.write(buffer)
+        }.isSuccess
+    }
+
+    fun close() {
+        channel.close()
+    }
+}
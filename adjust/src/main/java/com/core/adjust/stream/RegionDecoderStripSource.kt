@@ -0,0 +1,44 @@
+package com.core.adjust.stream
+
+import android.graphics.Bitmap
+import android.graphics.BitmapFactory
+import android.graphics.BitmapRegionDecoder
+import android.graphics.Rect
+import java.nio.ByteBuffer
+
+/**
+ * Đọc ảnh lớn (JPEG/PNG/WebP) từ file theo từng dải bằng [BitmapRegionDecoder],
+ * không bao giờ giữ toàn bộ ảnh trong bộ nhớ. Dữ liệu ra là premultiplied.
+ */
+class RegionDecoderStripSource(private val decoder: BitmapRegionDecoder) : StripSource {
+
+    val width: Int get() = decoder.width
+    val height: Int get() = decoder.height
+
+    private val options = BitmapFactory.Options().apply {
+        inPreferredConfig = Bitmap.Config.ARGB_8888
+    }
+
+    override fun readStrip(top: Int, rows: Int, buffer: ByteBuffer): Boolean {
+        val strip = decoder.decodeRegion(Rect(0, top, decoder.width, top + rows), options) ?: return false
+        return try {
+            if (strip.width != decoder.width || strip.height != rows) return false
+            strip.copyPixelsToBuffer(buffer)
+            true
+        } finally {
+            strip.recycle()
+        }
+    }
+
+    fun close() {
+        decoder.recycle()
+    }
+
+    companion object {
+        fun open(path: String): RegionDecoderStripSource? {
+            @Suppress("DEPRECATION")
+            val decoder = runCatching { BitmapRegionDecoder.newInstance(path, false) }.getOrNull() ?: return null
+            return RegionDecoderStripSource(decoder)
+        }
+    }
+}
@@ -0,0 +1,16 @@
+package com.core.adjust.stream
+
+import androidx.annotation.Keep
+import java.nio.ByteBuffer
+
+/**
+ * Đích nhận các dải đã xử lý (encoder, file writer...). Các dải luôn đến theo thứ tự từ trên xuống.
+ */
+@Keep
+interface StripSink {
+    /**
+     * [buffer] chứa các hàng [top, top + rows) theo layout RGBA_8888, chỉ hợp lệ trong lời gọi này.
+     * @return false để huỷ toàn bộ quá trình.
+     */
+    fun writeStrip(top: Int, rows: Int, buffer: ByteBuffer): Boolean
+}
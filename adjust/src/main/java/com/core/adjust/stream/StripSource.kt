@@ -0,0 +1,17 @@
+package com.core.adjust.stream
+
+import androidx.annotation.Keep
+import java.nio.ByteBuffer
+
+/**
+ * Nguồn pixel theo dải hàng cho [com.core.adjust.AdjustProcessor.processStream].
+ */
+@Keep
+interface StripSource {
+    /**
+     * Ghi các hàng [top, top + rows) vào [buffer] theo layout RGBA_8888 (width * 4 byte / hàng).
+     * [buffer] là DirectByteBuffer trỏ thẳng vào bộ nhớ native, chỉ hợp lệ trong lời gọi này.
+     * @return false để huỷ toàn bộ quá trình.
+     */
+    fun readStrip(top: Int, rows: Int, buffer: ByteBuffer): Boolean
+}
@@ -54,6 +54,12 @@ class ShareAdjustViewModel(val manager: AdjustManager) : ViewModel() {
         applyAdjust()
     }
 
+    /** [points]: [x0, y0, x1, y1, ...] trong 0f..1f, [channel] theo [com.core.adjust.ToneCurveChannel] */
+    fun updateCurve(channel: Int, points: FloatArray) {
+        params.setCurve(channel, points)
+        applyAdjust()
+    }
+
     fun updateLutPath(path: String?) {
         params.lutPath = path
         params.activeMask = params.activeMask or AdjustMask.MASK_LUT
@@ -1,8 +1,9 @@
 package com.core.adjust.utils
 
 import android.graphics.Bitmap
-import androidx.core.graphics.get
 import androidx.exifinterface.media.ExifInterface
+import com.core.adjust.AdjustProcessor
+import com.core.adjust.ImageAnalysis
 import com.google.mlkit.vision.common.InputImage
 import com.google.mlkit.vision.face.FaceDetection
 import com.google.mlkit.vision.face.FaceDetectorOptions
@@ -18,6 +19,7 @@ import kotlin.math.abs
  *  - Low light → add Cinematic.
  *  - Vintage tone (warm yellow) → add Studio.
  *  - Outdoor → add Essentials.
+ *  - Image signals come from a single native pass ([AdjustProcessor.analyzeImage]).
  */
 object FilterSuggestionUtils {
 
@@ -30,11 +32,14 @@ object FilterSuggestionUtils {
     suspend fun suggestGroups(bitmap: Bitmap?, exifPath: String? = null): List<String> {
         val results = mutableListOf<String>()
 
+        // Phân tích ảnh 1 lần duy nhất (native), các helper bên dưới chỉ đọc kết quả
+        val stats = AdjustProcessor.analyzeImage(bitmap)
+
         // 1) Khuôn mặt (ML Kit)
         val hasFaces = detectFaceMLKit(bitmap)
         if (hasFaces) {
             results += listOf("Portrait", "Lifestyle", "Essentials")
-            if (isBrightAndLowContrast(bitmap)) {
+            if (isBrightAndLowContrast(stats)) {
                 results += "Pastel"
             }
         }
@@ -51,7 +56,7 @@ object FilterSuggestionUtils {
 
             ExifConst.SCENE_CAPTURE_TYPE_PORTRAIT -> {
                 results += listOf("Portrait", "Lifestyle", "Essentials")
-                if (isBrightAndLowContrast(bitmap)) results += "Pastel"
+                if (isBrightAndLowContrast(stats)) results += "Pastel"
             }
 
             ExifConst.SCENE_CAPTURE_TYPE_NIGHT_SCENE -> {
@@ -67,13 +72,13 @@ object FilterSuggestionUtils {
         }
 
         // 3) Phân tích nhanh bitmap (không tốn kém)
-        val outdoor = detectOutdoor(bitmap)
+        val outdoor = detectOutdoor(stats)
         if (outdoor) results += listOf("Travel", "Mood & Atmosphere", "Essentials")
 
-        val lowLight = detectLowLight(bitmap)
+        val lowLight = detectLowLight(stats)
         if (lowLight) results += listOf("Urban & Street", "Black & White", "Cinematic")
 
-        val vintage = detectVintageTone(bitmap)
+        val vintage = detectVintageTone(stats)
         if (vintage) results += listOf("Vintage & Film", "Studio")
 
         // Fallback mới: Essentials (trước đây là Misc)
@@ -97,87 +102,34 @@ object FilterSuggestionUtils {
         return faces.isNotEmpty()
     }
 
-    // Ngoài trời: lấy 1 pixel vùng trời phía trên, ưu tiên blue
-    private fun detectOutdoor(bitmap: Bitmap?): Boolean {
-        if (bitmap == null || bitmap.width < 2 || bitmap.height < 2) return false
-        val pixel = bitmap[bitmap.width / 2, bitmap.height / 4]
-        val r = (pixel shr 16) and 0xFF
-        val g = (pixel shr 8) and 0xFF
-        val b = pixel and 0xFF
-        return b > r && b > g
+    // Ngoài trời: đủ "trời xanh" ở nửa trên, hoặc nhiều lá cây trong ảnh không quá tối
+    private fun detectOutdoor(stats: ImageAnalysis?): Boolean {
+        if (stats == null) return false
+        return stats.skyRatio >= 0.12f || (stats.foliageRatio >= 0.2f && stats.meanLuma >= 90f)
     }
 
-    // Ảnh tối: trung bình luma thấp
-    private fun detectLowLight(bitmap: Bitmap?): Boolean {
-        if (bitmap == null) return false
-        val w = bitmap.width
-        val h = bitmap.height
-        if (w <= 0 || h <= 0) return false
-        val stepX = (w / 8).coerceAtLeast(1)
-        val stepY = (h / 8).coerceAtLeast(1)
-        var sum = 0.0
-        var count = 0
-        var y = 0
-        while (y < h) {
-            var x = 0
-            while (x < w) {
-                val p = bitmap[x, y]
-                val r = (p shr 16) and 0xFF
-                val g = (p shr 8) and 0xFF
-                val b = p and 0xFF
-                sum += (r + g + b) / 3.0
-                count++
-                x += stepX
-            }
-            y += stepY
-        }
-        val avg = if (count > 0) sum / count else 255.0
-        return avg < 80
+    // Ảnh tối: trung bình (r + g + b) / 3 thấp
+    private fun detectLowLight(stats: ImageAnalysis?): Boolean {
+        if (stats == null) return false
+        val avg = (stats.meanR + stats.meanG + stats.meanB) / 3f
+        return avg < 80f
     }
 
-    // Tone vàng/ấm → film/vintage (r ≈ g > b)
-    private fun detectVintageTone(bitmap: Bitmap?): Boolean {
-        if (bitmap == null || bitmap.width < 2 || bitmap.height < 2) return false
-        val sample = bitmap[bitmap.width / 2, bitmap.height / 2]
-        val r = (sample shr 16) and 0xFF
-        val g = (sample shr 8) and 0xFF
-        val b = sample and 0xFF
-        return abs(r - g) < 20 && r > b && g > b
+    // Tone vàng/ấm → film/vintage (r ≈ g > b) trên màu trung bình toàn ảnh
+    private fun detectVintageTone(stats: ImageAnalysis?): Boolean {
+        if (stats == null) return false
+        val r = stats.meanR
+        val g = stats.meanG
+        val b = stats.meanB
+        return abs(r - g) < 20f && r > b && g > b
     }
 
     // Ảnh sáng, tương phản thấp, bão hòa nhẹ → hợp Pastel
-    private fun isBrightAndLowContrast(bitmap: Bitmap?): Boolean {
-        if (bitmap == null) return false
-        val w = bitmap.width
-        val h = bitmap.height
-        if (w < 4 || h < 4) return false
-
-        val pts = arrayOf(
-            bitmap[w / 2, h / 2], bitmap[w / 4, h / 4], bitmap[3 * w / 4, h / 4], bitmap[w / 4, 3 * h / 4], bitmap[3 * w / 4, 3 * h / 4]
-        )
-        var lumSum = 0.0
-        var lumSqSum = 0.0
-        var satSum = 0.0
-        for (p in pts) {
-            val r = (p shr 16) and 0xFF
-            val g = (p shr 8) and 0xFF
-            val b = p and 0xFF
-            val mx = maxOf(r, g, b).toDouble()
-            val mn = minOf(r, g, b).toDouble()
-            val luma = (r + g + b) / 3.0
-            val sat = if (mx == 0.0) 0.0 else (mx - mn) / mx
-            lumSum += luma
-            lumSqSum += luma * luma
-            satSum += sat
-        }
-        val n = pts.size
-        val lumAvg = lumSum / n
-        val lumVar = (lumSqSum / n) - (lumAvg * lumAvg)
-        val satAvg = satSum / n
-
-        val bright = lumAvg >= 170.0
-        val lowContrast = lumVar <= 500.0
-        val lowSaturation = satAvg <= 0.25
+    private fun isBrightAndLowContrast(stats: ImageAnalysis?): Boolean {
+        if (stats == null) return false
+        val bright = stats.meanLuma >= 170f
+        val lowContrast = stats.contrast * stats.contrast <= 500f
+        val lowSaturation = stats.meanSaturation <= 0.25f
         return bright && (lowContrast || lowSaturation)
     }
 
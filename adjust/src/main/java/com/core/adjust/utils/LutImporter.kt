@@ -0,0 +1,92 @@
+package com.core.adjust.utils
+
+import android.content.Context
+import android.graphics.Bitmap
+import android.graphics.BitmapFactory
+import android.net.Uri
+import android.util.Log
+import com.core.adjust.AdjustProcessor
+import java.io.File
+import java.security.MessageDigest
+
+/**
+ * Import LUT người dùng (.cube hoặc HaldCLUT .png) sang định dạng .table của engine.
+ *
+ * Mỗi file chỉ convert 1 lần: kết quả lưu trong filesDir/imported_luts, đặt tên theo SHA-1 nội dung,
+ * nên lần sau trả về ngay đường dẫn .table (load nhanh như LUT có sẵn trong assets).
+ * Đường dẫn trả về dùng trực tiếp cho [com.core.adjust.AdjustParams.lutPath].
+ * Nên gọi trên background thread.
+ */
+object LutImporter {
+
+    private const val TAG = "TAG5"
+    private const val DIR = "imported_luts"
+
+    fun import(context: Context, file: File): String? {
+        if (!file.isFile) return null
+        val key = sha1(file) ?: return null
+        return convert(context, file, file.extension, key)
+    }
+
+    /**
+     * Import từ Uri (vd. file picker). [fileName] dùng để nhận biết định dạng qua đuôi file.
+     */
+    fun import(context: Context, uri: Uri, fileName: String): String? {
+        val tmp = File(context.cacheDir, "lut_import_${System.nanoTime()}")
+        return try {
+            val copied = context.contentResolver.openInputStream(uri)?.use { input ->
+                tmp.outputStream().use { input.copyTo(it) }
+            } ?: return null
+            if (copied <= 0L) return null
+            val key = sha1(tmp) ?: return null
+            convert(context, tmp, File(fileName).extension, key)
+        } catch (e: Exception) {
+            Log.e(TAG, "LutImporter: import $fileName failed", e)
+            null
+        } finally {
+            tmp.delete()
+        }
+    }
+
+    private fun convert(context: Context, source: File, extension: String, key: String): String? {
+        val dir = File(context.filesDir, DIR).apply { mkdirs() }
+        val out = File(dir, "$key.table")
+        if (out.isFile && out.length() > 0L) return out.absolutePath
+
+        val ok = when (extension.lowercase()) {
+            "cube" -> AdjustProcessor.convertCubeNative(source.absolutePath, out.absolutePath)
+            "png" -> convertHald(source, out)
+            else -> false
+        }
+        if (!ok) Log.w(TAG, "LutImporter: unsupported or invalid LUT ${source.name}")
+        return if (ok) out.absolutePath else null
+    }
+
+    private fun convertHald(source: File, out: File): Boolean {
+        // Hald phải đọc đúng giá trị gốc: ARGB_8888, không premultiply, không scale theo density
+        val options = BitmapFactory.Options().apply {
+            inPreferredConfig = Bitmap.Config.ARGB_8888
+            inPremultiplied = false
+            inScaled = false
+        }
+        val bitmap = BitmapFactory.decodeFile(source.absolutePath, options) ?: return false
+        return try {
+            AdjustProcessor.convertHaldClutNative(bitmap, out.absolutePath)
+        } finally {
+            bitmap.recycle()
+        }
+    }
+
+    private fun sha1(file: File): String? = runCatching {
+        val digest = MessageDigest.getInstance("SHA-1")
+        file.inputStream().use { input ->
+            val buf = ByteArray(64 * 1024)
+            while (true) {
+                val n = input.read(buf)
+                if (n < 0) break
+                digest.update(buf, 0, n)
+            }
+        }
+        digest.digest().joinToString("") { "%02x".format(it) }
+    }.getOrNull()
+}
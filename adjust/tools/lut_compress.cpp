@@ -0,0 +1,212 @@
+// =============================================================
+// 🗜️ lut_compress — converter host: .table / .cube -> .lutz (xem adjust_lut.h) + báo cáo sai số round-trip
+//
+// Build (máy dev, cần zlib):
+//   g++ -std=c++17 -O2 -I../src/main/cpp lut_compress.cpp ../src/main/cpp/adjust_lut.cpp -lz -o lut_compress
+// Dùng:
+//   ./lut_compress [--step N] [--out DIR] [--report report.csv] [--delete-source] <file.table|file.cube|dir>...
+//   ./lut_compress --out ../src/main/assets/filters --delete-source ../src/main/assets/filters
+//
+// Mỗi file: ghi <tên>.lutz, giải nén lại rồi so với bảng gốc:
+//   maxErr8 / meanErr8 = sai số so với float gốc, đơn vị 1/255 (đã gồm làm tròn uint16 của runtime)
+//   maxErrU16          = sai số so với bảng packed mà .table gốc cho ra lúc render (0 khi step = 1)
+//   decodeUs           = thời gian decodeLutz (inflate + dựng lại lưới packed), lần nhanh nhất / 20
+// File lỗi hoặc sai số vượt ngưỡng (--max-err8, mặc định 0.5) -> exit code 1, không xoá nguồn.
+// =============================================================
+#include "adjust_lut.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Options {
+    int32_t step = 1;
+    double maxErr8 = 0.5;
+    std::string outDir;
+    std::string reportPath;
+    bool deleteSource = false;
+    std::vector<fs::path> inputs;
+};
+
+struct Report {
+    std::string name;
+    int32_t size = 0;
+    uint64_t srcBytes = 0, lutzBytes = 0;
+    double maxErr8 = 0.0, meanErr8 = 0.0;
+    int32_t maxErrU16 = 0;
+    double decodeUs = 0.0;
+};
+
+bool readFile(const fs::path &path, std::vector<uint8_t> &out) {
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    if (!f.is_open()) return false;
+    out.resize(static_cast<size_t>(f.tellg()));
+    f.seekg(0);
+    f.read(reinterpret_cast<char *>(out.data()), static_cast<std::streamsize>(out.size()));
+    return static_cast<bool>(f);
+}
+
+bool loadSource(const fs::path &path, Lut3D &lut, std::string &err) {
+    std::vector<uint8_t> bytes;
+    if (!readFile(path, bytes)) { err = "cannot read"; return false; }
+    if (path.extension() == ".cube") {
+        return parseCube(reinterpret_cast<const char *>(bytes.data()), bytes.size(), lut, &err);
+    }
+    if (bytes.size() < kTableHeaderBytes) { err = "truncated"; return false; }
+    uint32_t header[2];
+    std::memcpy(header, bytes.data(), sizeof(header));
+    lut.size = validateTableHeader(header, bytes.size(), &err);
+    if (lut.size == 0) return false;
+    lut.data.resize((bytes.size() - kTableHeaderBytes) / sizeof(float));
+    std::memcpy(lut.data.data(), bytes.data() + kTableHeaderBytes, lut.data.size() * sizeof(float));
+    return lut.valid();
+}
+
+bool convert(const fs::path &src, const Options &opt, Report &rep, std::string &err) {
+    Lut3D lut;
+    if (!loadSource(src, lut, err)) return false;
+    rep.name = src.filename().string();
+    rep.size = lut.size;
+    rep.srcBytes = fs::file_size(src);
+
+    std::vector<uint8_t> bytes;
+    if (!encodeLutz(lut, opt.step, bytes, &err)) return false;
+    rep.lutzBytes = bytes.size();
+
+    // Lần nhanh nhất: máy dev thường nhiễu, trung bình bị kéo lệch bởi vài lần bị preempt
+    Lut3D decoded;
+    constexpr int32_t kRuns = 20;
+    rep.decodeUs = 1e30;
+    for (int32_t i = 0; i < kRuns; ++i) {
+        const auto t0 = std::chrono::steady_clock::now();
+        if (!decodeLutz(bytes.data(), bytes.size(), decoded, &err)) return false;
+        const auto t1 = std::chrono::steady_clock::now();
+        rep.decodeUs = std::min(rep.decodeUs, std::chrono::duration<double, std::micro>(t1 - t0).count());
+    }
+
+    Lut3D reference = lut;
+    packLut(reference, false);
+    double sum = 0.0;
+    const size_t points = lut.data.size() / 3u;
+    for (size_t i = 0; i < points; ++i) {
+        for (size_t c = 0; c < 3; ++c) {
+            const int32_t u = decoded.packed[i * 4u + c];
+            const double e8 = std::fabs(u / 65535.0 - static_cast<double>(lut.data[i * 3u + c])) * 255.0;
+            rep.maxErr8 = std::max(rep.maxErr8, e8);
+            sum += e8;
+            rep.maxErrU16 = std::max(rep.maxErrU16, std::abs(u - static_cast<int32_t>(reference.packed[i * 4u + c])));
+        }
+    }
+    rep.meanErr8 = sum / static_cast<double>(points * 3u);
+    if (rep.maxErr8 > opt.maxErr8) {
+        err = "round-trip error above --max-err8";
+        return false;
+    }
+
+    const fs::path dir = opt.outDir.empty() ? src.parent_path() : fs::path(opt.outDir);
+    const fs::path dst = dir / src.filename().replace_extension(".lutz");
+    return writeLutzFile(dst.string(), lut, opt.step, &err);
+}
+
+void usage() {
+    std::fprintf(stderr, "usage: lut_compress [--step N] [--max-err8 E] [--out DIR] [--report FILE.csv] "
+                         "[--delete-source] <file.table|file.cube|dir>...\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (a == "--step" && hasValue) opt.step = std::atoi(argv[++i]);
+        else if (a == "--max-err8" && hasValue) opt.maxErr8 = std::atof(argv[++i]);
+        else if (a == "--out" && hasValue) opt.outDir = argv[++i];
+        else if (a == "--report" && hasValue) opt.reportPath = argv[++i];
+        else if (a == "--delete-source") opt.deleteSource = true;
+        else if (!a.empty() && a[0] == '-') { usage(); return 2; }
+        else opt.inputs.emplace_back(a);
+    }
+    if (opt.inputs.empty() || opt.step < 1 || opt.step > kLutzMaxStep) { usage(); return 2; }
+
+    std::vector<fs::path> files;
+    for (const fs::path &in : opt.inputs) {
+        if (fs::is_directory(in)) {
+            for (const auto &e : fs::directory_iterator(in)) {
+                const auto ext = e.path().extension();
+                if (e.is_regular_file() && (ext == ".table" || ext == ".cube")) files.push_back(e.path());
+            }
+        } else {
+            files.push_back(in);
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    if (!opt.outDir.empty()) {
+        std::error_code ec;
+        fs::create_directories(opt.outDir, ec);
+        if (ec) {
+            std::fprintf(stderr, "Cannot create output directory %s: %s\n", opt.outDir.c_str(), ec.message().c_str());
+            return 1;
+        }
+    }
+
+    std::vector<Report> reports;
+    int32_t failed = 0;
+    std::printf("%-28s %4s %10s %8s %7s %8s %8s %6s %9s\n",
+                "file", "size", "src", "lutz", "ratio", "maxErr8", "meanErr8", "dU16", "decodeUs");
+    for (const fs::path &src : files) {
+        Report rep;
+        std::string err;
+        if (!convert(src, opt, rep, err)) {
+            std::fprintf(stderr, "FAIL %s: %s\n", src.string().c_str(), err.c_str());
+            ++failed;
+            continue;
+        }
+        std::printf("%-28s %4d %10llu %8llu %6.1fx %8.4f %8.4f %6d %9.1f\n",
+                    rep.name.c_str(), rep.size, static_cast<unsigned long long>(rep.srcBytes),
+                    static_cast<unsigned long long>(rep.lutzBytes),
+                    static_cast<double>(rep.srcBytes) / static_cast<double>(rep.lutzBytes),
+                    rep.maxErr8, rep.meanErr8, rep.maxErrU16, rep.decodeUs);
+        reports.push_back(rep);
+        if (opt.deleteSource) fs::remove(src);
+    }
+
+    uint64_t srcTotal = 0, lutzTotal = 0;
+    double maxErr8 = 0.0, decodeMax = 0.0, decodeSum = 0.0;
+    for (const Report &r : reports) {
+        srcTotal += r.srcBytes;
+        lutzTotal += r.lutzBytes;
+        maxErr8 = std::max(maxErr8, r.maxErr8);
+        decodeMax = std::max(decodeMax, r.decodeUs);
+        decodeSum += r.decodeUs;
+    }
+    if (!reports.empty()) {
+        std::printf("\n%zu LUT, step %d: %.2f MB -> %.2f MB (%.1fx), max err %.4f/255, decode avg %.1f us, max %.1f us\n",
+                    reports.size(), opt.step, static_cast<double>(srcTotal) / 1e6, static_cast<double>(lutzTotal) / 1e6,
+                    static_cast<double>(srcTotal) / static_cast<double>(lutzTotal), maxErr8,
+                    decodeSum / static_cast<double>(reports.size()), decodeMax);
+    }
+
+    if (!opt.reportPath.empty()) {
+        std::ofstream csv(opt.reportPath, std::ios::trunc);
+        csv << "file,size,srcBytes,lutzBytes,maxErr8,meanErr8,maxErrU16,decodeUs\n";
+        for (const Report &r : reports) {
+            csv << r.name << ',' << r.size << ',' << r.srcBytes << ',' << r.lutzBytes << ',' << r.maxErr8 << ','
+                << r.meanErr8 << ',' << r.maxErrU16 << ',' << r.decodeUs << '\n';
+        }
+    }
+    return failed == 0 ? 0 : 1;
+}